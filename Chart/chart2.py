@@ -1,5 +1,6 @@
 import pandas as pd
 import matplotlib.pyplot as plt
+import sys
 import numpy as np # Для вычисления позиций столбцов
 
 # Данные о производительности процессоров
@@ -121,6 +122,10 @@ data = [
 # Преобразование списка словарей в DataFrame pandas
 df = pd.DataFrame(data)
 
+# Вместо встроенных данных можно передать CSV из `fluminum --bench --chart-csv FILE`
+if len(sys.argv) > 1:
+    df = pd.read_csv(sys.argv[1])
+
 def plot_processor_performance(dataframe, processors_to_plot, time_metric):
     """
     Строит столбчатую диаграмму производительности для выбранных процессоров и метрики времени.
@@ -221,26 +226,28 @@ if __name__ == "__main__":
     print("Построение графика SA_Time для всех процессоров...")
     plot_processor_performance(df, all_processors, 'SA_Time')
 
-    # 3. Построить график OM_Time для выбранных процессоров Intel
-    intel_processors = ['Intel Core i9-13900K', 'Intel Core i5-12400', 'Intel Core i5-10400F']
-    print(f"Построение графика OM_Time для {', '.join(intel_processors)}...")
-    plot_processor_performance(df, intel_processors, 'OM_Time')
-
-    # 4. Построить график SA_Time для выбранных процессоров AMD
-    amd_processors = ['AMD Ryzen 5 7535HS', 'AMD Ryzen 5 7530U']
-    print(f"Построение графика SA_Time для {', '.join(amd_processors)}...")
-    plot_processor_performance(df, amd_processors, 'SA_Time')
-
-    # 5. Построить график OM_Time для одного процессора
-    single_processor = ['Intel Core i9-13900K'] # Должен быть списком для функции
-    print(f"Построение графика OM_Time для {single_processor[0]}...")
-    plot_processor_performance(df, single_processor, 'OM_Time')
-
-    # 6. Построить график SA_Time для одного процессора
-    print(f"Построение графика SA_Time для {single_processor[0]}...")
-    plot_processor_performance(df, single_processor, 'SA_Time')
-
-    # Пример сравнения Intel Core i9-13900K и AMD Ryzen 5 7535HS по OM_Time:
-    custom_comparison = ['Intel Core i9-13900K', 'AMD Ryzen 5 7535HS']
-    print(f"Построение графика OM_Time для {', '.join(custom_comparison)}...")
-    plot_processor_performance(df, custom_comparison, 'OM_Time')
\ No newline at end of file
+    # Примеры с конкретными процессорами имеют смысл только для встроенных данных.
+    if len(sys.argv) == 1:
+        # 3. Построить график OM_Time для выбранных процессоров Intel
+        intel_processors = ['Intel Core i9-13900K', 'Intel Core i5-12400', 'Intel Core i5-10400F']
+        print(f"Построение графика OM_Time для {', '.join(intel_processors)}...")
+        plot_processor_performance(df, intel_processors, 'OM_Time')
+
+        # 4. Построить график SA_Time для выбранных процессоров AMD
+        amd_processors = ['AMD Ryzen 5 7535HS', 'AMD Ryzen 5 7530U']
+        print(f"Построение графика SA_Time для {', '.join(amd_processors)}...")
+        plot_processor_performance(df, amd_processors, 'SA_Time')
+
+        # 5. Построить график OM_Time для одного процессора
+        single_processor = ['Intel Core i9-13900K'] # Должен быть списком для функции
+        print(f"Построение графика OM_Time для {single_processor[0]}...")
+        plot_processor_performance(df, single_processor, 'OM_Time')
+
+        # 6. Построить график SA_Time для одного процессора
+        print(f"Построение графика SA_Time для {single_processor[0]}...")
+        plot_processor_performance(df, single_processor, 'SA_Time')
+
+        # Пример сравнения Intel Core i9-13900K и AMD Ryzen 5 7535HS по OM_Time:
+        custom_comparison = ['Intel Core i9-13900K', 'AMD Ryzen 5 7535HS']
+        print(f"Построение графика OM_Time для {', '.join(custom_comparison)}...")
+        plot_processor_performance(df, custom_comparison, 'OM_Time')
\ No newline at end of file
@@ -3,6 +3,13 @@
 #include "Matrix.h"
 #include "System.h"
 #include "IO.h" // For progress bar
+#include "FixedMatrix.h" // Specialized Strassen base cases
+#include "HardwareCounters.h"
+#include "Trace.h"
+#include "Roofline.h"
+#include "Gemm.h" // Shape kernels for degenerate products
+#include "Morton.h"
+#include <memory>
 
 // --- Result Struct Constructors ---
 MultiplicationResult::MultiplicationResult() :
@@ -24,6 +31,7 @@ ComparisonResult::ComparisonResult() :
 ThreadPool::ThreadPool(size_t threads) : stop(false) {
     for (size_t i = 0; i < threads; ++i) {
         workers.emplace_back([this] {
+            setThreadAllowsParallelEvaluation(false);
             while (true) {
                 std::function<void()> task;
                 {
@@ -47,20 +55,13 @@ ThreadPool::~ThreadPool() {
     }
 }
 
-template<class F, class... Args>
-auto ThreadPool::enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
-    using return_type = std::invoke_result_t<F, Args...>;
-    auto task = std::make_shared<std::packaged_task<return_type()>>(
-        std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-    );
-    std::future<return_type> res = task->get_future();
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        if (stop.load()) throw std::runtime_error("enqueue on stopped ThreadPool");
-        tasks.emplace([task]() { (*task)(); });
-    }
-    condition.notify_one();
-    return res;
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+ThreadPool& getSharedThreadPool() {
+    static ThreadPool shared_pool(getCpuCoreCount());
+    return shared_pool;
 }
 
 // --- Progress Bar Implementation ---
@@ -86,7 +87,10 @@ void display_progress(std::atomic<int>& counter, long long total, std::atomic<bo
             cout << YELLOW << "] " << std::setw(3) << percent << "% (" << current_count << "/" << total << ")" << RESET << std::flush;
             last_percent = percent;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        // Redraw every 150 ms, but notice completion within 10 ms so short runs are not held up.
+        for (int slice = 0; slice < 15 && !done.load(std::memory_order_acquire); ++slice) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
     }
     auto end_time = std::chrono::steady_clock::now();
     double elapsed_sec = std::chrono::duration<double>(end_time - start_time).count();
@@ -96,14 +100,24 @@ void display_progress(std::atomic<int>& counter, long long total, std::atomic<bo
 }
 
 
+// --- Padding Helper ---
+// Returns A itself when it already has the target size, otherwise a padded copy kept in storage.
+static const Matrix& padIfNeeded(const Matrix& A, int targetSize, Matrix& storage) {
+    if (A.rows() == targetSize && A.cols() == targetSize) return A;
+    storage = Matrix::pad(A, targetSize);
+    return storage;
+}
+
+
 // --- Strassen Multiplication ---
-Matrix strassen_recursive_worker(ThreadPool& pool, Matrix A, Matrix B, int threshold,
+Matrix strassen_recursive_worker(ThreadPool& pool, const Matrix& A, const Matrix& B, int threshold,
     bool use_tiling, int tile_size,
-    int current_depth, int max_depth_async, std::atomic<int>& progress_counter);
+    int current_depth, int max_depth_async, bool depth_first, std::atomic<int>& progress_counter,
+    MultiplicationResult* first_level_timings, Matrix* output);
 
 MultiplicationResult multiplyStrassenParallel(const Matrix& A_orig, const Matrix& B_orig, int threshold,
     bool use_tiling_for_base, int tile_size_for_base,
-    unsigned int num_threads_request) {
+    unsigned int num_threads_request, ThreadPool* pool, const StrassenSchedule& schedule, MatrixLayout layout) {
     MultiplicationResult result_obj;
     result_obj.originalRowsA = A_orig.rows();
     result_obj.originalColsA = A_orig.cols();
@@ -113,6 +127,7 @@ MultiplicationResult multiplyStrassenParallel(const Matrix& A_orig, const Matrix
     result_obj.tiling_enabled = use_tiling_for_base;
     result_obj.tile_size = tile_size_for_base;
     result_obj.algorithm_type = "Strassen";
+    MatrixAllocationStats alloc_start = getMatrixAllocationStats();
 
     if (A_orig.cols() != B_orig.rows()) throw std::invalid_argument("Matrix dimensions incompatible (A.cols != B.rows).");
     if (A_orig.isEmpty() || B_orig.isEmpty()) {
@@ -121,29 +136,52 @@ MultiplicationResult multiplyStrassenParallel(const Matrix& A_orig, const Matrix
         result_obj.coresDetected = getCpuCoreCount();
         return result_obj;
     }
+    // Padding a matrix-vector, outer or tall-skinny product to a power-of-two square multiplies
+    // its work many times over; the shape kernels read the operands once instead.
+    if (classifyGemmShape(A_orig.rows(), B_orig.cols(), A_orig.cols()) != GemmShape::General) {
+        return multiplyByShape(A_orig, B_orig, pool ? static_cast<unsigned int>(pool->size()) : num_threads_request, "Strassen");
+    }
 
     unsigned int hardware_cores = getCpuCoreCount();
     result_obj.coresDetected = hardware_cores;
-    result_obj.threadsUsed = (num_threads_request == 0) ? hardware_cores : std::min(num_threads_request, hardware_cores);
+    result_obj.threadsUsed = (num_threads_request == 0) ? getDefaultThreadCount() : std::min(num_threads_request, hardware_cores);
+    if (pool) result_obj.threadsUsed = static_cast<unsigned int>(pool->size());
     if (result_obj.threadsUsed == 0) result_obj.threadsUsed = 1;
 
     int max_orig_dim = std::max({ A_orig.rows(), A_orig.cols(), B_orig.rows(), B_orig.cols() });
     int padded_size = nextPowerOf2(max_orig_dim);
 
+    // The Morton path converts and recurses on a pool of its own when none is given.
+    const bool morton = (layout == MatrixLayout::Morton);
+    result_obj.layout = layout;
+    std::unique_ptr<ThreadPool> own_pool;
+    if (morton && !pool) own_pool = std::make_unique<ThreadPool>(result_obj.threadsUsed);
+    ThreadPool* morton_pool = pool ? pool : own_pool.get();
+
+    HardwareCounterRun counter_run;
     auto total_op_start_chrono = std::chrono::high_resolution_clock::now();
-    LARGE_INTEGER total_op_start_qpc = { 0 };
-    if (g_performanceFrequency.QuadPart != 0) QueryPerformanceCounter(&total_op_start_qpc);
+    long long total_op_start_qpc = readPerformanceCounter();
 
     auto pad_start = std::chrono::high_resolution_clock::now();
-    Matrix Apad = Matrix::pad(A_orig, padded_size);
-    Matrix Bpad = Matrix::pad(B_orig, padded_size);
+    long long rss_pad_start = getCurrentResidentKB();
+    Matrix Apad_storage, Bpad_storage;
+    MortonMatrix Amorton, Bmorton, Cmorton;
+    HardwareCounterScope padding_counters(CounterPhase::Padding);
+    const Matrix& Apad = morton ? Apad_storage : padIfNeeded(A_orig, padded_size, Apad_storage);
+    const Matrix& Bpad = morton ? Bpad_storage : padIfNeeded(B_orig, padded_size, Bpad_storage);
+    if (morton) {
+        const int leaf = chooseMortonLeaf(padded_size, tile_size_for_base);
+        Amorton = toMortonLayout(A_orig, padded_size, leaf, *morton_pool);
+        Bmorton = toMortonLayout(B_orig, padded_size, leaf, *morton_pool);
+        Cmorton = MortonMatrix(padded_size, leaf);
+    }
+    padding_counters.stop();
     auto pad_end = std::chrono::high_resolution_clock::now();
+    long long rss_pad_end = getCurrentResidentKB();
     result_obj.padding_duration_sec = std::chrono::duration<double>(pad_end - pad_start).count();
+    result_obj.padding_rss_delta_mb = residentDeltaMB(rss_pad_start, rss_pad_end);
 
-    Matrix Cpad(padded_size, padded_size);
-    int max_depth_async = (result_obj.threadsUsed > 1) ? static_cast<int>(std::floor(std::log(static_cast<double>(result_obj.threadsUsed)) / std::log(7.0))) : 0;
-    if (max_depth_async < 0) max_depth_async = 0;
-
+    Matrix Cpad;
     std::atomic<int> progress_counter(0);
     std::atomic<bool> multiplication_done(false);
     std::thread progress_thread;
@@ -153,17 +191,24 @@ MultiplicationResult multiplyStrassenParallel(const Matrix& A_orig, const Matrix
 
     if (result_obj.strassen_applied_at_top_level) {
         total_tasks = calculate_total_tasks(padded_size, threshold);
+        result_obj.effective_flops = strassenFlopCount(padded_size, threshold);
         string msg = " Starting parallel Strassen...";
-        if (use_tiling_for_base) msg += " (Tiled Base)";
+        if (morton) msg += " (Morton Layout)";
+        else if (use_tiling_for_base) msg += " (Tiled Base)";
         print_line_in_box(CYAN + msg + RESET, 80, false);
         progress_thread = std::thread(display_progress, std::ref(progress_counter), total_tasks, std::ref(multiplication_done));
 
-        ThreadPool pool(result_obj.threadsUsed);
-        Cpad = strassen_recursive_worker(pool, Apad, Bpad, threshold, use_tiling_for_base, tile_size_for_base, 0, max_depth_async, std::ref(progress_counter));
-
+        if (morton) multiplyMortonStrassen(*morton_pool, Amorton, Bmorton, Cmorton, threshold, &progress_counter, &result_obj, schedule);
+        else if (pool) Cpad = multiplyStrassenPadded(*pool, Apad, Bpad, threshold, use_tiling_for_base, tile_size_for_base, &progress_counter, &result_obj, schedule);
+        else Cpad = multiplyStrassenPadded(Apad, Bpad, threshold, use_tiling_for_base, tile_size_for_base, result_obj.threadsUsed, &progress_counter, &result_obj, schedule);
     }
     else {
-        if (use_tiling_for_base) {
+        HardwareCounterScope base_counters(CounterPhase::BaseMultiply);
+        if (morton) {
+            print_line_in_box(CYAN + " Using Morton blocked multiplication (Size <= Threshold or Threshold=0)..." + RESET, 80, false);
+            multiplyMortonTiled(*morton_pool, Amorton, Bmorton, Cmorton, A_orig.rows(), B_orig.cols(), A_orig.cols());
+        }
+        else if (use_tiling_for_base) {
             print_line_in_box(CYAN + " Using Tiled multiplication (Size <= Threshold or Threshold=0)..." + RESET, 80, false);
             Cpad = Apad.multiply_tiled(Bpad, tile_size_for_base);
         }
@@ -179,82 +224,236 @@ MultiplicationResult multiplyStrassenParallel(const Matrix& A_orig, const Matrix
     }
 
     auto unpad_start = std::chrono::high_resolution_clock::now();
-    result_obj.resultMatrix = Matrix::unpad(Cpad, A_orig.rows(), B_orig.cols());
+    long long rss_unpad_start = getCurrentResidentKB();
+    result_obj.compute_rss_delta_mb = residentDeltaMB(rss_pad_end, rss_unpad_start);
+    {
+        HardwareCounterScope unpad_counters(CounterPhase::Unpad);
+        if (morton) result_obj.resultMatrix = fromMortonLayout(Cmorton, A_orig.rows(), B_orig.cols(), *morton_pool);
+        else result_obj.resultMatrix = Matrix::unpad(std::move(Cpad), A_orig.rows(), B_orig.cols());
+    }
     auto unpad_end = std::chrono::high_resolution_clock::now();
     result_obj.unpadding_duration_sec = std::chrono::duration<double>(unpad_end - unpad_start).count();
+    result_obj.unpadding_rss_delta_mb = residentDeltaMB(rss_unpad_start, getCurrentResidentKB());
 
     auto total_op_end_chrono = std::chrono::high_resolution_clock::now();
-    LARGE_INTEGER total_op_end_qpc = { 0 };
-    if (g_performanceFrequency.QuadPart != 0) QueryPerformanceCounter(&total_op_end_qpc);
+    long long total_op_end_qpc = readPerformanceCounter();
 
     result_obj.durationSeconds_chrono = std::chrono::duration<double>(total_op_end_chrono - total_op_start_chrono).count();
-    if (g_performanceFrequency.QuadPart > 0) {
-        result_obj.durationSeconds_qpc = static_cast<double>(total_op_end_qpc.QuadPart - total_op_start_qpc.QuadPart) / g_performanceFrequency.QuadPart;
-    }
+    result_obj.durationSeconds_qpc = performanceCounterSeconds(total_op_start_qpc, total_op_end_qpc);
+    counter_run.finish(result_obj.hardwareCounters);
+    result_obj.allocationStats = matrixAllocationsSince(alloc_start);
     result_obj.memoryInfo = getProcessMemoryUsage();
     return result_obj;
 }
 
-Matrix strassen_recursive_worker(ThreadPool& pool, Matrix A, Matrix B, int threshold,
+Matrix multiplyStrassenPadded(const Matrix& Apad, const Matrix& Bpad, int threshold,
+    bool use_tiling_for_base, int tile_size_for_base,
+    unsigned int num_threads, std::atomic<int>* progress_counter, MultiplicationResult* first_level_timings,
+    const StrassenSchedule& schedule) {
+    ThreadPool pool(std::max(1u, num_threads));
+    return multiplyStrassenPadded(pool, Apad, Bpad, threshold, use_tiling_for_base, tile_size_for_base, progress_counter, first_level_timings, schedule);
+}
+
+Matrix multiplyStrassenPadded(ThreadPool& pool, const Matrix& Apad, const Matrix& Bpad, int threshold,
+    bool use_tiling_for_base, int tile_size_for_base, std::atomic<int>* progress_counter, MultiplicationResult* first_level_timings,
+    const StrassenSchedule& schedule) {
+    Matrix C;
+    multiplyStrassenPaddedInto(pool, Apad, Bpad, C, threshold, use_tiling_for_base, tile_size_for_base, progress_counter, first_level_timings, schedule);
+    return C;
+}
+
+void multiplyStrassenPaddedInto(ThreadPool& pool, const Matrix& Apad, const Matrix& Bpad, Matrix& C, int threshold,
+    bool use_tiling_for_base, int tile_size_for_base, std::atomic<int>* progress_counter, MultiplicationResult* first_level_timings,
+    const StrassenSchedule& schedule) {
+    if (Apad.rows() != Apad.cols() || Bpad.rows() != Bpad.cols() || Apad.rows() != Bpad.rows() || Apad.rows() != nextPowerOf2(Apad.rows())) {
+        throw std::invalid_argument("Strassen operands must be square with the same power-of-two size.");
+    }
+    size_t num_threads = pool.size();
+    int max_depth_async = (num_threads > 1) ? static_cast<int>(std::floor(std::log(static_cast<double>(num_threads)) / std::log(7.0))) : 0;
+    if (max_depth_async < 0) max_depth_async = 0;
+    if (schedule.maxAsyncDepth >= 0) max_depth_async = std::min(max_depth_async, schedule.maxAsyncDepth);
+
+    std::atomic<int> unused_counter(0);
+    strassen_recursive_worker(pool, Apad, Bpad, threshold, use_tiling_for_base, tile_size_for_base, 0, max_depth_async,
+        schedule.depthFirst, progress_counter ? *progress_counter : unused_counter, first_level_timings, &C);
+}
+
+// Memory-lean node: each product's S operands live only for its recursive call, and every
+// product is folded into the C quadrants as soon as it exists. The additions run in the same
+// order as in the breadth-first node, so results are bit-identical. With an output the product
+// is written there and an empty matrix returned, as for strassen_recursive_worker.
+static Matrix strassenDepthFirstNode(ThreadPool& pool, Matrix& A11, Matrix& A12, Matrix& A21, Matrix& A22,
+    Matrix& B11, Matrix& B12, Matrix& B21, Matrix& B22, int threshold, bool use_tiling, int tile_size,
+    int current_depth, int max_depth_async, std::atomic<int>& progress_counter,
+    MultiplicationResult* first_level_timings, std::chrono::high_resolution_clock::time_point split_start, Matrix* output) {
+    using Clock = std::chrono::high_resolution_clock;
+    const int n = A11.rows() * 2;
+    auto p_tasks_start = Clock::now();
+    TraceScope products_trace("Products", current_depth, n);
+    auto product = [&](const Matrix& X, const Matrix& Y) {
+        return strassen_recursive_worker(pool, X, Y, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async,
+            true, progress_counter, nullptr, nullptr);
+    };
+    // C11 holds P1 alone until P4 arrives, which is after C22 has been started from it.
+    Matrix C11, C12, C21, C22;
+    C11 = product(Matrix(A11 + A22), Matrix(B11 + B22));
+    {
+        Matrix P2 = product(Matrix(A21 + A22), B11);
+        C22 = C11 - P2;
+        C21 = std::move(P2);
+    }
+    {
+        Matrix P3 = product(A11, Matrix(B12 - B22));
+        C22 = C22 + P3;
+        C12 = std::move(P3);
+    }
+    {
+        Matrix P4 = product(A22, Matrix(B21 - B11));
+        C11 = C11 + P4;
+        C21 = C21 + P4;
+    }
+    {
+        Matrix P5 = product(Matrix(A11 + A12), B22);
+        C11 = C11 - P5;
+        C12 = C12 + P5;
+    }
+    {
+        Matrix P6 = product(Matrix(A21 - A11), Matrix(B11 + B12));
+        C22 = C22 + P6;
+    }
+    {
+        Matrix P7 = product(Matrix(A12 - A22), Matrix(B21 + B22));
+        C11 = C11 + P7;
+    }
+    products_trace.stop();
+    A11 = Matrix(); A12 = Matrix(); A21 = Matrix(); A22 = Matrix();
+    B11 = Matrix(); B12 = Matrix(); B21 = Matrix(); B22 = Matrix();
+
+    auto combine_start = Clock::now();
+    HardwareCounterScope combine_counters(CounterPhase::Combine);
+    TraceScope combine_trace("Combine", current_depth, n);
+    Matrix C;
+    Matrix::combine(C11, C12, C21, C22, output ? *output : C);
+    combine_trace.stop();
+    progress_counter.fetch_add(1, std::memory_order_relaxed);
+
+    if (first_level_timings) {
+        // The S sums and C quadrants are interleaved with the products here, so they count as products.
+        first_level_timings->first_level_split_sec = std::chrono::duration<double>(p_tasks_start - split_start).count();
+        first_level_timings->first_level_S_calc_sec = 0.0;
+        first_level_timings->first_level_P_tasks_wall_sec = std::chrono::duration<double>(combine_start - p_tasks_start).count();
+        first_level_timings->first_level_C_quad_calc_sec = 0.0;
+        first_level_timings->first_level_final_combine_sec = std::chrono::duration<double>(Clock::now() - combine_start).count();
+    }
+    return C;
+}
+
+// With an output (the top node of multiplyStrassenPaddedInto) the product is written there,
+// reusing its storage when it already has the size, and an empty matrix is returned.
+Matrix strassen_recursive_worker(ThreadPool& pool, const Matrix& A, const Matrix& B, int threshold,
     bool use_tiling, int tile_size,
-    int current_depth, int max_depth_async, std::atomic<int>& progress_counter) {
-    if (A.rows() <= threshold) {
+    int current_depth, int max_depth_async, bool depth_first, std::atomic<int>& progress_counter,
+    MultiplicationResult* first_level_timings, Matrix* output) {
+    const int n = A.rows();
+    TraceScope node_trace("StrassenNode", current_depth, n);
+    if (n <= threshold) {
         progress_counter.fetch_add(1, std::memory_order_relaxed);
-        if (use_tiling) {
-            return A.multiply_tiled(B, tile_size);
-        }
-        else {
-            return A.multiply_naive(B);
+        HardwareCounterScope base_counters(CounterPhase::BaseMultiply);
+        TraceScope base_trace("BaseMultiply", current_depth, n);
+        if (const FixedKernelSet* fixed = getFixedKernels(n)) {
+            Matrix C;
+            Matrix& target = output ? *output : C;
+            if (target.rows() != n || target.cols() != B.cols()) target = Matrix(n, B.cols());
+            fixed->multiply(A.getRawData().data(), A.cols(), B.getRawData().data(), B.cols(), target.getRawData().data(), target.cols());
+            return C;
         }
+        Matrix C = use_tiling ? A.multiply_tiled(B, tile_size) : A.multiply_naive(B);
+        if (!output) return C;
+        *output = std::move(C);
+        return Matrix();
     }
 
+    using Clock = std::chrono::high_resolution_clock;
+    auto split_start = Clock::now();
+    HardwareCounterScope split_counters(CounterPhase::Split);
+    TraceScope split_trace("Split", current_depth, n);
     Matrix A11, A12, A21, A22, B11, B12, B21, B22;
     Matrix::split(A, B, A11, A12, A21, A22, B11, B12, B21, B22);
+    split_trace.stop();
+
+    if (depth_first && current_depth >= max_depth_async) {
+        split_counters.stop();
+        return strassenDepthFirstNode(pool, A11, A12, A21, A22, B11, B12, B21, B22, threshold, use_tiling, tile_size,
+            current_depth, max_depth_async, progress_counter, first_level_timings, split_start, output);
+    }
 
+    auto s_calc_start = Clock::now();
+    TraceScope s_calc_trace("SCalc", current_depth, n);
     Matrix S1 = B12 - B22; Matrix S2 = A11 + A12; Matrix S3 = A21 + A22;
     Matrix S4 = B21 - B11; Matrix S5 = A11 + A22; Matrix S6 = B11 + B22;
     Matrix S7 = A12 - A22; Matrix S8 = B21 + B22; Matrix S9 = A21 - A11;
     Matrix S10 = B11 + B12;
+    s_calc_trace.stop();
+    split_counters.stop();
 
+    auto p_tasks_start = Clock::now();
+    TraceScope products_trace("Products", current_depth, n);
+    Matrix P1, P2, P3, P4, P5, P6, P7;
     bool launch_async_here = (current_depth < max_depth_async);
 
     if (launch_async_here) {
-        auto fP1 = pool.enqueue(strassen_recursive_worker, std::ref(pool), S5, S6, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, std::ref(progress_counter));
-        auto fP2 = pool.enqueue(strassen_recursive_worker, std::ref(pool), S3, B11, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, std::ref(progress_counter));
-        auto fP3 = pool.enqueue(strassen_recursive_worker, std::ref(pool), A11, S1, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, std::ref(progress_counter));
-        auto fP4 = pool.enqueue(strassen_recursive_worker, std::ref(pool), A22, S4, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, std::ref(progress_counter));
-        auto fP5 = pool.enqueue(strassen_recursive_worker, std::ref(pool), S2, B22, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, std::ref(progress_counter));
-        auto fP6 = pool.enqueue(strassen_recursive_worker, std::ref(pool), S9, S10, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, std::ref(progress_counter));
-        auto fP7 = pool.enqueue(strassen_recursive_worker, std::ref(pool), S7, S8, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, std::ref(progress_counter));
-
-        Matrix P1 = fP1.get(); Matrix P2 = fP2.get(); Matrix P3 = fP3.get(); Matrix P4 = fP4.get();
-        Matrix P5 = fP5.get(); Matrix P6 = fP6.get(); Matrix P7 = fP7.get();
-
-        Matrix C11 = P1 + P4 - P5 + P7; Matrix C12 = P3 + P5;
-        Matrix C21 = P2 + P4;           Matrix C22 = P1 - P2 + P3 + P6;
-        progress_counter.fetch_add(1, std::memory_order_relaxed);
-        return Matrix::combine(C11, C12, C21, C22);
-
+        auto fP1 = pool.enqueue(strassen_recursive_worker, std::ref(pool), std::cref(S5), std::cref(S6), threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, std::ref(progress_counter), nullptr, nullptr);
+        auto fP2 = pool.enqueue(strassen_recursive_worker, std::ref(pool), std::cref(S3), std::cref(B11), threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, std::ref(progress_counter), nullptr, nullptr);
+        auto fP3 = pool.enqueue(strassen_recursive_worker, std::ref(pool), std::cref(A11), std::cref(S1), threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, std::ref(progress_counter), nullptr, nullptr);
+        auto fP4 = pool.enqueue(strassen_recursive_worker, std::ref(pool), std::cref(A22), std::cref(S4), threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, std::ref(progress_counter), nullptr, nullptr);
+        auto fP5 = pool.enqueue(strassen_recursive_worker, std::ref(pool), std::cref(S2), std::cref(B22), threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, std::ref(progress_counter), nullptr, nullptr);
+        auto fP6 = pool.enqueue(strassen_recursive_worker, std::ref(pool), std::cref(S9), std::cref(S10), threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, std::ref(progress_counter), nullptr, nullptr);
+        auto fP7 = pool.enqueue(strassen_recursive_worker, std::ref(pool), std::cref(S7), std::cref(S8), threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, std::ref(progress_counter), nullptr, nullptr);
+
+        waitForAll(fP1, fP2, fP3, fP4, fP5, fP6, fP7);
+        P1 = fP1.get(); P2 = fP2.get(); P3 = fP3.get(); P4 = fP4.get();
+        P5 = fP5.get(); P6 = fP6.get(); P7 = fP7.get();
     }
     else {
-        Matrix P1 = strassen_recursive_worker(pool, S5, S6, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, progress_counter);
-        Matrix P2 = strassen_recursive_worker(pool, S3, B11, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, progress_counter);
-        Matrix P3 = strassen_recursive_worker(pool, A11, S1, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, progress_counter);
-        Matrix P4 = strassen_recursive_worker(pool, A22, S4, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, progress_counter);
-        Matrix P5 = strassen_recursive_worker(pool, S2, B22, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, progress_counter);
-        Matrix P6 = strassen_recursive_worker(pool, S9, S10, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, progress_counter);
-        Matrix P7 = strassen_recursive_worker(pool, S7, S8, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, progress_counter);
-
-        Matrix C11 = P1 + P4 - P5 + P7; Matrix C12 = P3 + P5;
-        Matrix C21 = P2 + P4;           Matrix C22 = P1 - P2 + P3 + P6;
-        progress_counter.fetch_add(1, std::memory_order_relaxed);
-        return Matrix::combine(C11, C12, C21, C22);
+        P1 = strassen_recursive_worker(pool, S5, S6, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, progress_counter, nullptr, nullptr);
+        P2 = strassen_recursive_worker(pool, S3, B11, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, progress_counter, nullptr, nullptr);
+        P3 = strassen_recursive_worker(pool, A11, S1, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, progress_counter, nullptr, nullptr);
+        P4 = strassen_recursive_worker(pool, A22, S4, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, progress_counter, nullptr, nullptr);
+        P5 = strassen_recursive_worker(pool, S2, B22, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, progress_counter, nullptr, nullptr);
+        P6 = strassen_recursive_worker(pool, S9, S10, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, progress_counter, nullptr, nullptr);
+        P7 = strassen_recursive_worker(pool, S7, S8, threshold, use_tiling, tile_size, current_depth + 1, max_depth_async, depth_first, progress_counter, nullptr, nullptr);
+    }
+    products_trace.stop();
+
+    auto c_quad_start = Clock::now();
+    HardwareCounterScope combine_counters(CounterPhase::Combine);
+    TraceScope c_quad_trace("CQuadCalc", current_depth, n);
+    Matrix C11 = P1 + P4 - P5 + P7; Matrix C12 = P3 + P5;
+    Matrix C21 = P2 + P4;           Matrix C22 = P1 - P2 + P3 + P6;
+    c_quad_trace.stop();
+
+    auto combine_start = Clock::now();
+    TraceScope combine_trace("Combine", current_depth, n);
+    Matrix C;
+    Matrix::combine(C11, C12, C21, C22, output ? *output : C);
+    combine_trace.stop();
+    progress_counter.fetch_add(1, std::memory_order_relaxed);
+
+    if (first_level_timings) {
+        auto combine_end = Clock::now();
+        first_level_timings->first_level_split_sec = std::chrono::duration<double>(s_calc_start - split_start).count();
+        first_level_timings->first_level_S_calc_sec = std::chrono::duration<double>(p_tasks_start - s_calc_start).count();
+        first_level_timings->first_level_P_tasks_wall_sec = std::chrono::duration<double>(c_quad_start - p_tasks_start).count();
+        first_level_timings->first_level_C_quad_calc_sec = std::chrono::duration<double>(combine_start - c_quad_start).count();
+        first_level_timings->first_level_final_combine_sec = std::chrono::duration<double>(combine_end - combine_start).count();
     }
+    return C;
 }
 
 
 // --- NEW: Tiled Parallel Multiplication ---
-MultiplicationResult multiplyTiledParallel(const Matrix& A, const Matrix& B, int tileSize, unsigned int num_threads_request) {
+MultiplicationResult multiplyTiledParallel(const Matrix& A, const Matrix& B, int tileSize, unsigned int num_threads_request, ThreadPool* pool,
+    MatrixLayout layout) {
     MultiplicationResult result_obj;
     result_obj.originalRowsA = A.rows();
     result_obj.originalColsA = A.cols();
@@ -263,54 +462,103 @@ MultiplicationResult multiplyTiledParallel(const Matrix& A, const Matrix& B, int
     result_obj.tiling_enabled = true;
     result_obj.tile_size = tileSize;
     result_obj.algorithm_type = "Tiled Parallel";
+    result_obj.layout = layout;
+    MatrixAllocationStats alloc_start = getMatrixAllocationStats();
 
     if (A.cols() != B.rows()) throw std::invalid_argument("Matrix dimensions incompatible (A.cols != B.rows).");
+    // Row stripes leave threads idle when C has few rows, and scalar loops waste the bandwidth
+    // a matrix-vector product is bound by.
+    if (classifyGemmShape(A.rows(), B.cols(), A.cols()) != GemmShape::General) {
+        return multiplyByShape(A, B, pool ? static_cast<unsigned int>(pool->size()) : num_threads_request, "Tiled Parallel");
+    }
 
     unsigned int hardware_cores = getCpuCoreCount();
     result_obj.coresDetected = hardware_cores;
-    result_obj.threadsUsed = (num_threads_request == 0) ? hardware_cores : std::min(num_threads_request, hardware_cores);
+    result_obj.threadsUsed = (num_threads_request == 0) ? getDefaultThreadCount() : std::min(num_threads_request, hardware_cores);
+    if (pool) result_obj.threadsUsed = static_cast<unsigned int>(pool->size());
     if (result_obj.threadsUsed == 0) result_obj.threadsUsed = 1;
 
     auto total_op_start_chrono = std::chrono::high_resolution_clock::now();
-
-    Matrix C(A.rows(), B.cols());
-    ThreadPool pool(result_obj.threadsUsed);
-    std::vector<std::future<void>> futures;
-
-    int M = A.rows();
-
-    // We parallelize the outermost loop (the rows of the result matrix C)
-    for (int i_block = 0; i_block < M; i_block += tileSize) {
-        futures.emplace_back(pool.enqueue([&A, &B, &C, i_block, tileSize] {
-            int M = A.rows();
-            int N = A.cols();
-            int P = B.cols();
-
-            // Each thread computes a horizontal "stripe" of the result matrix C.
-            // The loops are j_block, k_block, i, j, k to compute the assigned stripe.
-            for (int j_block = 0; j_block < P; j_block += tileSize) {
-                for (int k_block = 0; k_block < N; k_block += tileSize) {
-                    for (int i = i_block; i < std::min(i_block + tileSize, M); ++i) {
-                        for (int j = j_block; j < std::min(j_block + tileSize, P); ++j) {
-                            double sum = C(i, j);
-                            for (int k = k_block; k < std::min(k_block + tileSize, N); ++k) {
-                                sum += A(i, k) * B(k, j);
+    long long total_op_start_qpc = readPerformanceCounter();
+    long long rss_start = getCurrentResidentKB();
+    HardwareCounterRun counter_run;
+
+    std::unique_ptr<ThreadPool> own_pool;
+    if (!pool) own_pool = std::make_unique<ThreadPool>(result_obj.threadsUsed);
+    ThreadPool& workers = pool ? *pool : *own_pool;
+
+    Matrix C;
+    if (layout == MatrixLayout::Morton) {
+        // Both operands converted (timed as padding), multiplied block by block in Z-order and
+        // the result converted back (timed as unpadding).
+        auto pad_start = std::chrono::high_resolution_clock::now();
+        const int max_dim = std::max({ A.rows(), A.cols(), B.cols() });
+        const int leaf = chooseMortonLeaf(max_dim, tileSize);
+        const int size = mortonPaddedSize(max_dim, leaf);
+        MortonMatrix Amorton, Bmorton;
+        {
+            HardwareCounterScope padding_counters(CounterPhase::Padding);
+            Amorton = toMortonLayout(A, size, leaf, workers);
+            Bmorton = toMortonLayout(B, size, leaf, workers);
+        }
+        MortonMatrix Cmorton(size, leaf);
+        auto compute_start = std::chrono::high_resolution_clock::now();
+        result_obj.padding_duration_sec = std::chrono::duration<double>(compute_start - pad_start).count();
+        multiplyMortonTiled(workers, Amorton, Bmorton, Cmorton, A.rows(), B.cols(), A.cols());
+        auto unpad_start = std::chrono::high_resolution_clock::now();
+        {
+            HardwareCounterScope unpad_counters(CounterPhase::Unpad);
+            C = fromMortonLayout(Cmorton, A.rows(), B.cols(), workers);
+        }
+        result_obj.unpadding_duration_sec = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - unpad_start).count();
+    }
+    else {
+        C = Matrix(A.rows(), B.cols());
+        std::vector<std::future<void>> futures;
+
+        int M = A.rows();
+
+        // We parallelize the outermost loop (the rows of the result matrix C)
+        for (int i_block = 0; i_block < M; i_block += tileSize) {
+            futures.emplace_back(workers.enqueue([&A, &B, &C, i_block, tileSize] {
+                HardwareCounterScope base_counters(CounterPhase::BaseMultiply);
+                TraceScope trace("TileStripe", 0, i_block);
+                int M = A.rows();
+                int N = A.cols();
+                int P = B.cols();
+
+                // Each thread computes a horizontal "stripe" of the result matrix C.
+                // The loops are j_block, k_block, i, j, k to compute the assigned stripe.
+                for (int j_block = 0; j_block < P; j_block += tileSize) {
+                    for (int k_block = 0; k_block < N; k_block += tileSize) {
+                        for (int i = i_block; i < std::min(i_block + tileSize, M); ++i) {
+                            for (int j = j_block; j < std::min(j_block + tileSize, P); ++j) {
+                                double sum = C(i, j);
+                                for (int k = k_block; k < std::min(k_block + tileSize, N); ++k) {
+                                    sum += A(i, k) * B(k, j);
+                                }
+                                C(i, j) = sum;
                             }
-                            C(i, j) = sum;
                         }
                     }
                 }
-            }
-            }));
-    }
+                }));
+        }
 
-    for (auto& f : futures) {
-        f.get(); // Wait for all threads to complete
+        waitForAll(futures);
+        for (auto& f : futures) {
+            f.get(); // Rethrows the first failure once every stripe is done with C
+        }
     }
 
     auto total_op_end_chrono = std::chrono::high_resolution_clock::now();
+    long long total_op_end_qpc = readPerformanceCounter();
     result_obj.durationSeconds_chrono = std::chrono::duration<double>(total_op_end_chrono - total_op_start_chrono).count();
-    result_obj.resultMatrix = C;
+    result_obj.durationSeconds_qpc = performanceCounterSeconds(total_op_start_qpc, total_op_end_qpc);
+    result_obj.compute_rss_delta_mb = residentDeltaMB(rss_start, getCurrentResidentKB());
+    counter_run.finish(result_obj.hardwareCounters);
+    result_obj.resultMatrix = std::move(C);
+    result_obj.allocationStats = matrixAllocationsSince(alloc_start);
     result_obj.memoryInfo = getProcessMemoryUsage();
     return result_obj;
 }
@@ -325,6 +573,7 @@ ComparisonResult compareMatricesParallel(const Matrix& A_orig, const Matrix& B_o
     result_obj.originalCols = A_orig.cols();
     result_obj.comparisonThreshold = threshold;
     result_obj.epsilon = epsilon;
+    MatrixAllocationStats alloc_start = getMatrixAllocationStats();
 
     if (A_orig.rows() != B_orig.rows() || A_orig.cols() != B_orig.cols()) {
         throw std::invalid_argument("Matrix dimensions must be identical for comparison.");
@@ -338,22 +587,27 @@ ComparisonResult compareMatricesParallel(const Matrix& A_orig, const Matrix& B_o
 
     unsigned int hardware_cores = getCpuCoreCount();
     result_obj.coresDetected = hardware_cores;
-    result_obj.threadsUsed = (num_threads_request == 0) ? hardware_cores : std::min(num_threads_request, hardware_cores);
+    result_obj.threadsUsed = (num_threads_request == 0) ? getDefaultThreadCount() : std::min(num_threads_request, hardware_cores);
     if (result_obj.threadsUsed == 0) result_obj.threadsUsed = 1;
 
+    // Padding to keep the recursive structure simple; both padded copies must fit the memory budget.
+    int max_orig_dim = std::max(A_orig.rows(), A_orig.cols());
+    int padded_size = nextPowerOf2(max_orig_dim);
+    const double operands_mb = 2.0 * A_orig.elementCount() * sizeof(double) / (1024.0 * 1024.0);
+    const bool needs_padding = A_orig.rows() != padded_size || A_orig.cols() != padded_size;
+    requireMemoryBudget(operands_mb + (needs_padding ? 2.0 * padded_size * padded_size * sizeof(double) / (1024.0 * 1024.0) : 0.0),
+        operands_mb, "Comparison");
+
     ThreadPool pool(result_obj.threadsUsed);
     int max_depth_async_comp = (result_obj.threadsUsed > 1) ? static_cast<int>(std::floor(std::log(static_cast<double>(result_obj.threadsUsed)) / std::log(4.0))) : 0;
     if (max_depth_async_comp < 0) max_depth_async_comp = 0;
 
     auto start_time_chrono = std::chrono::high_resolution_clock::now();
-    LARGE_INTEGER start_time_qpc = { 0 };
-    if (g_performanceFrequency.QuadPart != 0) QueryPerformanceCounter(&start_time_qpc);
+    long long start_time_qpc = readPerformanceCounter();
 
-    // Padding to keep the recursive structure simple.
-    int max_orig_dim = std::max(A_orig.rows(), A_orig.cols());
-    int padded_size = nextPowerOf2(max_orig_dim);
-    Matrix Apad = Matrix::pad(A_orig, padded_size);
-    Matrix Bpad = Matrix::pad(B_orig, padded_size);
+    Matrix Apad_storage, Bpad_storage;
+    const Matrix& Apad = padIfNeeded(A_orig, padded_size, Apad_storage);
+    const Matrix& Bpad = padIfNeeded(B_orig, padded_size, Bpad_storage);
 
     long long total_matches_padded = compareMatricesInternal(pool, Apad, Bpad, threshold, epsilon, 0, max_depth_async_comp);
 
@@ -365,21 +619,21 @@ ComparisonResult compareMatricesParallel(const Matrix& A_orig, const Matrix& B_o
 
 
     auto end_time_chrono = std::chrono::high_resolution_clock::now();
-    LARGE_INTEGER end_time_qpc = { 0 };
-    if (g_performanceFrequency.QuadPart != 0) QueryPerformanceCounter(&end_time_qpc);
+    long long end_time_qpc = readPerformanceCounter();
 
     result_obj.durationSeconds_chrono = std::chrono::duration<double>(end_time_chrono - start_time_chrono).count();
-    if (g_performanceFrequency.QuadPart > 0) {
-        result_obj.durationSeconds_qpc = static_cast<double>(end_time_qpc.QuadPart - start_time_qpc.QuadPart) / g_performanceFrequency.QuadPart;
-    }
+    result_obj.durationSeconds_qpc = performanceCounterSeconds(start_time_qpc, end_time_qpc);
+    result_obj.allocationStats = matrixAllocationsSince(alloc_start);
     result_obj.memoryInfo = getProcessMemoryUsage();
     return result_obj;
 }
 
 long long compareMatricesInternal(ThreadPool& pool, const Matrix& A_rec, const Matrix& B_rec, int threshold, double epsilon, int current_depth, int max_depth_async_comp) {
     if (A_rec.rows() <= threshold || A_rec.isEmpty()) {
+        TraceScope trace("CompareChunk", current_depth, A_rec.rows());
         return A_rec.compare_naive(B_rec, epsilon);
     }
+    TraceScope trace("CompareNode", current_depth, A_rec.rows());
 
     Matrix A11, A12, A21, A22, B11, B12, B21, B22;
     Matrix::split(A_rec, B_rec, A11, A12, A21, A22, B11, B12, B21, B22);
@@ -391,6 +645,7 @@ long long compareMatricesInternal(ThreadPool& pool, const Matrix& A_rec, const M
         auto f_c12 = pool.enqueue(compareMatricesInternal, std::ref(pool), std::cref(A12), std::cref(B12), threshold, epsilon, current_depth + 1, max_depth_async_comp);
         auto f_c21 = pool.enqueue(compareMatricesInternal, std::ref(pool), std::cref(A21), std::cref(B21), threshold, epsilon, current_depth + 1, max_depth_async_comp);
         auto f_c22 = pool.enqueue(compareMatricesInternal, std::ref(pool), std::cref(A22), std::cref(B22), threshold, epsilon, current_depth + 1, max_depth_async_comp);
+        waitForAll(f_c11, f_c12, f_c21, f_c22);
         return f_c11.get() + f_c12.get() + f_c21.get() + f_c22.get();
     }
     else {
@@ -10,6 +10,8 @@ public:
     template<class F, class... Args>
     auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>;
 
+    size_t size() const;
+
 private:
     std::vector<std::thread> workers;
     std::queue<std::function<void()>> tasks;
@@ -18,16 +20,84 @@ private:
     std::atomic<bool> stop;
 };
 
+// The template is defined here so that every module can submit work to a pool.
+template<class F, class... Args>
+auto ThreadPool::enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+    using return_type = std::invoke_result_t<F, Args...>;
+    auto task = std::make_shared<std::packaged_task<return_type()>>(
+        std::bind(std::forward<F>(f), std::forward<Args>(args)...)
+    );
+    std::future<return_type> res = task->get_future();
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        if (stop.load()) throw std::runtime_error("enqueue on stopped ThreadPool");
+        tasks.emplace([task]() { (*task)(); });
+    }
+    condition.notify_one();
+    return res;
+}
+
+// Blocks until every future is ready, without rethrowing. Call it before the first get() when
+// the tasks refer to the caller's locals: a get() that throws would otherwise unwind them while
+// tasks still queued behind it go on to use them.
+template<class... Futures>
+void waitForAll(Futures&... futures) {
+    (futures.wait(), ...);
+}
+
+template<class T>
+void waitForAll(std::vector<std::future<T>>& futures) {
+    for (auto& f : futures) f.wait();
+}
+
+// Process-wide pool sized to the hardware. Used by entry points that are called many times
+// with little work each, where building a pool per call would dominate the runtime.
+ThreadPool& getSharedThreadPool();
+
 // --- Core Algorithms ---
 
+// How much of a Strassen recursion is alive at once. The defaults fan out the top log7(threads)
+// levels and keep every S and P block of a node until its C quadrants are formed. Under a
+// memory budget fewer levels fan out, and depth-first nodes form each product's operands just
+// before it and fold the product into C at once (3.75 instead of 6.25 n^2 per node).
+struct StrassenSchedule {
+    int maxAsyncDepth = -1;     // -1 = log7(threads)
+    bool depthFirst = false;    // Applies to the levels below the async ones
+};
+
 // Strassen's Algorithm, now with a flag to enable tiling for its base cases.
+// With a pool, the run uses it (and its size as the thread count) instead of building one.
+// MatrixLayout::Morton converts the operands to the Morton layout instead of padding them and
+// recurses on quadrant slices (multiplyMortonStrassen); its base cases are always blocked.
 MultiplicationResult multiplyStrassenParallel(const Matrix& A_orig, const Matrix& B_orig, int threshold,
     bool use_tiling_for_base, int tile_size_for_base,
-    unsigned int num_threads_request = 0);
+    unsigned int num_threads_request = 0, ThreadPool* pool = nullptr, const StrassenSchedule& schedule = StrassenSchedule(),
+    MatrixLayout layout = MatrixLayout::RowMajor);
+
+// Strassen core without padding, progress output or result bookkeeping. Both operands must be
+// square with the same power-of-two size. Used by multiplyStrassenParallel and gemm.
+// When first_level_timings is given, its first_level_* fields receive the top node's phase times.
+Matrix multiplyStrassenPadded(const Matrix& Apad, const Matrix& Bpad, int threshold,
+    bool use_tiling_for_base, int tile_size_for_base,
+    unsigned int num_threads, std::atomic<int>* progress_counter = nullptr,
+    MultiplicationResult* first_level_timings = nullptr, const StrassenSchedule& schedule = StrassenSchedule());
+
+// Same, on a caller-owned pool so repeated products (e.g. matrix powers) do not rebuild it.
+Matrix multiplyStrassenPadded(ThreadPool& pool, const Matrix& Apad, const Matrix& Bpad, int threshold,
+    bool use_tiling_for_base, int tile_size_for_base, std::atomic<int>* progress_counter = nullptr,
+    MultiplicationResult* first_level_timings = nullptr, const StrassenSchedule& schedule = StrassenSchedule());
+
+// Same, writing the product into C. The top node combines its quadrants straight into C's
+// storage when C already has the operands' size, so repeated products can rotate preallocated
+// buffers. C must not alias Apad or Bpad.
+void multiplyStrassenPaddedInto(ThreadPool& pool, const Matrix& Apad, const Matrix& Bpad, Matrix& C, int threshold,
+    bool use_tiling_for_base, int tile_size_for_base, std::atomic<int>* progress_counter = nullptr,
+    MultiplicationResult* first_level_timings = nullptr, const StrassenSchedule& schedule = StrassenSchedule());
 
 // NEW: A standalone, fully parallelized tiled multiplication algorithm.
+// MatrixLayout::Morton runs multiplyMortonTiled on converted copies instead of row stripes.
 MultiplicationResult multiplyTiledParallel(const Matrix& A, const Matrix& B, int tileSize,
-    unsigned int num_threads_request);
+    unsigned int num_threads_request, ThreadPool* pool = nullptr, MatrixLayout layout = MatrixLayout::RowMajor);
 
 
 ComparisonResult compareMatricesParallel(const Matrix& A_orig, const Matrix& B_orig, int threshold, double epsilon,
@@ -0,0 +1,222 @@
+#define NOMINMAX
+#include "AutoTune.h"
+#include "Algorithm.h"
+#include "CacheTopology.h"
+#include "Matrix.h"
+#include "Random.h"
+#include "Roofline.h"
+#include "System.h"
+#include <filesystem>
+
+// --- Cache Key ---
+namespace {
+TunedParameters g_tunedParameters;
+
+// Size and modification time of the executable: any rebuild changes it.
+string binaryVersion() {
+    const string path = getExecutablePath();
+    std::error_code error;
+    const auto size = path.empty() ? 0 : std::filesystem::file_size(path, error);
+    if (path.empty() || error) return "unknown";
+    const auto stamp = std::filesystem::last_write_time(path, error);
+    if (error) return "unknown";
+    return std::to_string(size) + "-" + std::to_string(stamp.time_since_epoch().count());
+}
+
+void applyParameters(const TunedParameters& params) {
+    G_OPTIMAL_TILE_SIZE = params.tileSize;
+    G_OPTIMAL_STRASSEN_THRESHOLD = params.strassenThreshold;
+    G_OPTIMAL_THREAD_COUNT = params.threads;
+    G_TUNED_GEMM_KERNEL = params.kernel;
+    g_tunedParameters = params;
+}
+
+// Starting point and fallback: the analytic blocking of the detected cache topology.
+TunedParameters analyticParameters() {
+    TunedParameters params;
+    params.tileSize = getAnalyticBlocking().tileSize;
+    params.strassenThreshold = getAnalyticBlocking().strassenThreshold;
+    return params;
+}
+
+string describe(const TunedParameters& params) {
+    std::stringstream ss;
+    ss << "tile " << params.tileSize << ", Strassen threshold " << params.strassenThreshold << ", "
+        << ((params.threads == 0) ? getCpuCoreCount() : params.threads) << " threads, "
+        << getGemmEngineName(params.kernel) << " kernel";
+    if (params.streamBandwidthGBs > 0.0) ss << ", " << std::fixed << std::setprecision(1) << params.streamBandwidthGBs << " GB/s";
+    return ss.str();
+}
+
+
+// --- Cache File ---
+// One line per key: cpu, cores, binary, tile, threshold, threads, kernel, STREAM GB/s (tab
+// separated). Lines written before the bandwidth column existed still load, without it.
+bool loadCachedParameters(const string& key, TunedParameters& params) {
+    std::ifstream file(TUNING_CACHE_FILE);
+    string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#' || line.compare(0, key.size() + 1, key + "\t") != 0) continue;
+        std::stringstream values(line.substr(key.size() + 1));
+        string kernel;
+        if (!(values >> params.tileSize >> params.strassenThreshold >> params.threads >> kernel)) return false;
+        if (params.tileSize <= 0 || params.strassenThreshold <= 0) return false;
+        params.kernel = (kernel == getGemmEngineName(GemmEngine::Tiled)) ? GemmEngine::Tiled : GemmEngine::Simd;
+        if (!(values >> params.streamBandwidthGBs)) params.streamBandwidthGBs = 0.0;
+        params.loadedFromCache = true;
+        return true;
+    }
+    return false;
+}
+
+void storeCachedParameters(const string& key, const TunedParameters& params) {
+    // Keep entries for other machines and binaries; replace ours.
+    std::vector<string> lines;
+    {
+        std::ifstream file(TUNING_CACHE_FILE);
+        string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line[0] != '#' && line.compare(0, key.size() + 1, key + "\t") != 0) lines.push_back(line);
+        }
+    }
+    std::ofstream file(TUNING_CACHE_FILE, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        cerr << RED << "Warning: Could not write tuning cache " << TUNING_CACHE_FILE << "." << RESET << endl;
+        return;
+    }
+    file << "# Fluminum tuning cache: cpu, cores, binary, tile, strassen threshold, threads, kernel, stream GB/s\n";
+    for (const string& line : lines) file << line << "\n";
+    file << key << "\t" << params.tileSize << "\t" << params.strassenThreshold << "\t" << params.threads << "\t"
+        << getGemmEngineName(params.kernel) << "\t" << params.streamBandwidthGBs << "\n";
+}
+
+
+// --- Measurements ---
+// Best of `runs` timings after one warm-up call.
+template <class F>
+double bestSeconds(F&& run, int runs = 2) {
+    run();
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+TunedParameters runTuning() {
+    auto tuning_start = std::chrono::high_resolution_clock::now();
+    const int n = TUNING_PROBLEM_SIZE;
+    const unsigned int cores = getCpuCoreCount();
+    Matrix A = Matrix::generateRandom(n, n, RANDOM_BENCHMARK_SEED, 0);
+    Matrix B = Matrix::generateRandom(n, n, RANDOM_BENCHMARK_SEED, 1);
+    Matrix C(n, n);
+    // The analytic model gives the starting point; the search only looks around it.
+    const AnalyticBlocking& analytic = getAnalyticBlocking();
+    TunedParameters params = analyticParameters();
+
+    auto time_gemm = [&](GemmEngine engine, int tile, unsigned int threads) {
+        GemmOptions options;
+        options.engine = engine;
+        options.tileSize = tile;
+        options.threads = threads;
+        return bestSeconds([&] { gemm(Transpose::None, Transpose::None, 1.0, A, B, 0.0, C, options); });
+    };
+
+    // 1. Tile size of the cache-blocked engine, on all cores.
+    cout << " Tile size: " << std::flush;
+    double best_tiled = std::numeric_limits<double>::max();
+    const int t = analytic.tileSize;
+    for (int tile : { t / 2, t * 3 / 4, t, t * 3 / 2, t * 2 }) {
+        tile = std::max(8, tile / 8 * 8);
+        cout << tile << "... " << std::flush;
+        double seconds = time_gemm(GemmEngine::Tiled, tile, cores);
+        if (seconds < best_tiled) { best_tiled = seconds; params.tileSize = tile; }
+    }
+    cout << GREEN << params.tileSize << RESET << endl;
+
+    // 2. Micro-kernel: packed AVX blocks against the tuned tiles.
+    params.kernel = GemmEngine::Tiled;
+    double best_kernel = best_tiled;
+#ifdef HAS_AVX
+    double simd = time_gemm(GemmEngine::Simd, params.tileSize, cores);
+    if (simd < best_tiled) { params.kernel = GemmEngine::Simd; best_kernel = simd; }
+#endif
+    cout << " Kernel: " << GREEN << getGemmEngineName(params.kernel) << RESET << endl;
+
+    // 3. Strassen cut-over, with the tuned tiles in the base cases.
+    cout << " Strassen threshold: " << std::flush;
+    double best_strassen = std::numeric_limits<double>::max();
+    const int s = analytic.strassenThreshold;
+    for (int threshold : { s / 2, s, s * 2 }) {
+        cout << threshold << "... " << std::flush;
+        double seconds = bestSeconds([&] { multiplyStrassenPadded(A, B, threshold, true, params.tileSize, cores); });
+        if (seconds < best_strassen) { best_strassen = seconds; params.strassenThreshold = threshold; }
+    }
+    cout << GREEN << params.strassenThreshold << RESET << endl;
+
+    // 4. Thread count: memory-bound machines can run faster on fewer cores than they have.
+    if (cores > 1) {
+        cout << " Threads: " << std::flush;
+        unsigned int best_threads = cores;
+        double best_seconds = best_kernel;
+        for (unsigned int threads = cores / 2; threads >= 1 && threads >= cores / 8; threads /= 2) {
+            cout << threads << "... " << std::flush;
+            double seconds = time_gemm(params.kernel, params.tileSize, threads);
+            if (seconds < 0.97 * best_seconds) { best_seconds = seconds; best_threads = threads; }
+            if (threads == 1) break;
+        }
+        params.threads = (best_threads == cores) ? 0 : best_threads;
+        cout << GREEN << best_threads << RESET << endl;
+    }
+
+    // 5. Memory bandwidth, the slope of the roofline.
+    cout << " STREAM triad: " << std::flush;
+    params.streamBandwidthGBs = measureStreamBandwidth(cores);
+    cout << GREEN << std::fixed << std::setprecision(1) << params.streamBandwidthGBs << " GB/s" << RESET << endl;
+
+    params.tuningSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tuning_start).count();
+    return params;
+}
+}
+
+
+// --- Public Interface ---
+string getTuningCacheKey() {
+    return getCpuModelName() + "\t" + std::to_string(getCpuCoreCount()) + "\t" + binaryVersion();
+}
+
+const TunedParameters& getTunedParameters() {
+    return g_tunedParameters;
+}
+
+bool loadTunedParameters() {
+    TunedParameters params;
+    bool cached = loadCachedParameters(getTuningCacheKey(), params);
+    applyParameters(cached ? params : analyticParameters());
+    return cached;
+}
+
+TunedParameters autoTuneParameters(bool force_retune) {
+    const string key = getTuningCacheKey();
+    TunedParameters params;
+    if (!force_retune && loadCachedParameters(key, params)) {
+        applyParameters(params);
+        cout << GREEN << "Loaded tuned parameters (" << describe(params) << ") from " << TUNING_CACHE_FILE << "." << RESET << endl << endl;
+        return params;
+    }
+
+    cout << CYAN << (force_retune ? "Re-tuning" : "Performing one-time hardware tuning") << " for " << getCpuModelName()
+        << " (" << getCpuCoreCount() << " cores, " << TUNING_PROBLEM_SIZE << "x" << TUNING_PROBLEM_SIZE << " parallel runs)..." << RESET << endl;
+    const AnalyticBlocking& analytic = getAnalyticBlocking();
+    cout << " Caches (" << getCacheTopology().source << "): " << describeCacheTopology(getCacheTopology()) << endl;
+    cout << " Analytic model: mc " << analytic.mc << ", kc " << analytic.kc << ", nc " << analytic.nc
+        << ", tile " << analytic.tileSize << ", Strassen threshold " << analytic.strassenThreshold << endl;
+    params = runTuning();
+    applyParameters(params);
+    storeCachedParameters(key, params);
+    cout << GREEN << "Auto-tuning complete in " << std::fixed << std::setprecision(1) << params.tuningSeconds << "s: "
+        << describe(params) << ". Saved to " << TUNING_CACHE_FILE << "." << RESET << endl << endl;
+    return params;
+}
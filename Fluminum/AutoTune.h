@@ -0,0 +1,37 @@
+#pragma once
+#include "Common.h"
+#include "Gemm.h"
+
+// --- Persistent Auto-Tuning ---
+// Tile size, Strassen threshold, default thread count and the dense gemm kernel are tuned
+// together with parallel runs at a representative size, searching around the analytic blocking
+// of the detected cache topology (CacheTopology.h), then cached in TUNING_CACHE_FILE.
+// Entries are keyed by CPU model, core count and the executable (size and timestamp), so a
+// rebuilt binary or another machine re-tunes, while later starts load the result instantly.
+
+const string TUNING_CACHE_FILE = "fluminum_tuning.cache";
+const int TUNING_PROBLEM_SIZE = 512;
+
+struct TunedParameters {
+    int tileSize = 32;
+    int strassenThreshold = GEMM_DEFAULT_STRASSEN_THRESHOLD;
+    unsigned int threads = 0;                 // 0 = all cores
+    GemmEngine kernel = GemmEngine::Simd;     // Simd or Tiled
+    bool loadedFromCache = false;
+    double tuningSeconds = 0.0;               // 0 when loaded from the cache
+    double streamBandwidthGBs = 0.0;          // STREAM triad on all cores (see Roofline.h)
+};
+
+// Loads the cached parameters for this machine and binary, or tunes and stores them when
+// there are none or `force_retune` is set (--retune). Applies the result to the global defaults.
+TunedParameters autoTuneParameters(bool force_retune = false);
+
+// For headless runs: applies the cached parameters if there are any, else the analytic
+// blocking of the cache topology, without measuring anything. Returns whether the cache had them.
+bool loadTunedParameters();
+
+// The last parameters applied by autoTuneParameters (defaults before it has run).
+const TunedParameters& getTunedParameters();
+
+// "<cpu model>\t<cores>\t<binary version>": the cache key of this process.
+string getTuningCacheKey();
@@ -0,0 +1,545 @@
+#define NOMINMAX
+#include "Batch.h"
+#include "Algorithm.h"
+#include "Chain.h"
+#include "CostModel.h"
+#include "IO.h"
+#include "Gemm.h"
+#include "Morton.h"
+#include "Power.h"
+#include "Random.h"
+#include "ResultCache.h"
+#include "Sparse.h"
+#include "System.h"
+#include <deque>
+#include <map>
+#include <memory>
+
+// --- Job Parsing ---
+namespace {
+const std::vector<string> BATCH_ALGORITHMS = { "auto", "naive", "tiled", "tiled-parallel", "strassen", "sparse" };
+
+bool parseOperation(const string& name, BatchOperation& operation) {
+    if (name == "multiply") operation = BatchOperation::Multiply;
+    else if (name == "compare") operation = BatchOperation::Compare;
+    else if (name == "power") operation = BatchOperation::Power;
+    else if (name == "chain") operation = BatchOperation::Chain;
+    else return false;
+    return true;
+}
+
+std::vector<string> splitList(const string& list) {
+    std::vector<string> items;
+    std::stringstream ss(list);
+    string item;
+    while (std::getline(ss, item, ',')) if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+// Integral options take whole numbers only ("2.5" and "1e3" are rejected, not truncated).
+template <class T>
+T parseNumber(const string& key, const string& value, T minimum) {
+    try {
+        size_t used = 0;
+        if constexpr (std::is_integral_v<T>) {
+            long long parsed = std::stoll(value, &used);
+            if (used == value.size() && parsed >= static_cast<long long>(minimum)
+                && static_cast<unsigned long long>(parsed) <= static_cast<unsigned long long>(std::numeric_limits<T>::max())) {
+                return static_cast<T>(parsed);
+            }
+        }
+        else {
+            double parsed = std::stod(value, &used);
+            if (used == value.size() && parsed >= static_cast<double>(minimum)) return static_cast<T>(parsed);
+        }
+    }
+    catch (const std::exception&) {}
+    throw std::invalid_argument("invalid value '" + value + "' for " + key);
+}
+
+void applyJobOption(BatchJob& job, const string& key, const string& value) {
+    if (key == "a") { if (job.inputs.size() < 1) job.inputs.resize(1); job.inputs[0] = value; }
+    else if (key == "b") { if (job.inputs.size() < 2) job.inputs.resize(2); job.inputs[1] = value; }
+    else if (key == "inputs") job.inputs = splitList(value);
+    else if (key == "algorithm") {
+        if (std::find(BATCH_ALGORITHMS.begin(), BATCH_ALGORITHMS.end(), value) == BATCH_ALGORITHMS.end()) {
+            throw std::invalid_argument("unknown algorithm '" + value + "'");
+        }
+        job.algorithm = value;
+    }
+    else if (key == "threads") job.threads = parseNumber<unsigned int>(key, value, 0u);
+    else if (key == "threshold") job.threshold = parseNumber<int>(key, value, 0);
+    else if (key == "tile") job.tileSize = parseNumber<int>(key, value, 0);
+    else if (key == "k") job.exponent = parseNumber<long long>(key, value, 0LL);
+    else if (key == "epsilon") job.epsilon = parseNumber<double>(key, value, 0.0);
+    else if (key == "seed") {
+        job.seed = parseRandomSeed(value);
+        job.hasSeed = true;
+    }
+    else if (key == "layout") {
+        if (!parseMatrixLayout(value, job.layout)) throw std::invalid_argument("unknown layout '" + value + "'");
+    }
+    else if (key == "out") job.output = value;
+    else if (key == "log") job.log = value;
+    else throw std::invalid_argument("unknown key '" + key + "'");
+}
+
+bool usesRandomInputs(const BatchJob& job) {
+    return std::any_of(job.inputs.begin(), job.inputs.end(), isRandomMatrixSource);
+}
+
+void validateJob(const BatchJob& job) {
+    for (const string& input : job.inputs) {
+        if (input.empty()) throw std::invalid_argument("empty input file name");
+        if (isRandomMatrixSource(input)) parseRandomMatrixSource(input);
+    }
+    if (job.hasSeed && !usesRandomInputs(job)) throw std::invalid_argument("seed= only applies to random: inputs");
+    switch (job.operation) {
+    case BatchOperation::Multiply:
+    case BatchOperation::Compare:
+        if (job.inputs.size() != 2) throw std::invalid_argument(getBatchOperationName(job.operation) + " needs a= and b=");
+        break;
+    case BatchOperation::Power:
+        if (job.inputs.size() != 1) throw std::invalid_argument("power needs a=");
+        if (job.exponent < 0) throw std::invalid_argument("power needs k=");
+        break;
+    case BatchOperation::Chain:
+        if (job.inputs.size() < 2) throw std::invalid_argument("chain needs at least two inputs=");
+        if (!job.log.empty()) throw std::invalid_argument("chain jobs have no CSV log");
+        break;
+    }
+    if (job.operation == BatchOperation::Compare && !job.output.empty()) throw std::invalid_argument("compare produces no matrix for out=");
+    if (job.operation != BatchOperation::Multiply && job.algorithm != "auto") {
+        throw std::invalid_argument("algorithm= only applies to multiply");
+    }
+    if (job.layout == MatrixLayout::Morton && job.algorithm != "strassen" && job.algorithm != "tiled-parallel") {
+        throw std::invalid_argument("layout=morton only applies to multiply with algorithm=strassen or tiled-parallel");
+    }
+}
+
+
+// --- Execution Helpers ---
+struct LoadedInputs {
+    std::vector<Matrix> matrices;
+    std::vector<MatrixFileInfo> infos;
+    bool generated = false;             // At least one random: input, generated from job.seed
+};
+
+// Input i of a random: source is stream i under the job's seed, so equal sources still differ.
+LoadedInputs loadInputs(const BatchJob& job) {
+    LoadedInputs loaded;
+    loaded.infos.resize(job.inputs.size());
+    for (size_t i = 0; i < job.inputs.size(); ++i) {
+        if (!isRandomMatrixSource(job.inputs[i])) {
+            loaded.matrices.push_back(readMatrixFromFile(job.inputs[i], &loaded.infos[i], false));
+            continue;
+        }
+        loaded.matrices.push_back(generateRandomMatrix(parseRandomMatrixSource(job.inputs[i]), job.seed, static_cast<unsigned int>(i)));
+        MatrixFileInfo& info = loaded.infos[i];
+        info.nonZeroCount = countNonZeros(loaded.matrices.back());
+        info.totalElements = static_cast<long long>(loaded.matrices.back().elementCount());
+        info.density = (info.totalElements > 0) ? static_cast<double>(info.nonZeroCount) / info.totalElements : 0.0;
+        info.sparseCandidate = isSparseCandidate(info.nonZeroCount, info.totalElements);
+        loaded.generated = true;
+    }
+    return loaded;
+}
+
+// One pool per thread count, kept for the whole batch.
+class PoolCache {
+public:
+    ThreadPool& get(unsigned int threads) {
+        std::unique_ptr<ThreadPool>& pool = pools_[threads];
+        if (!pool) pool = std::make_unique<ThreadPool>(threads);
+        return *pool;
+    }
+
+private:
+    std::map<unsigned int, std::unique_ptr<ThreadPool>> pools_;
+};
+
+struct PendingWrite {
+    string path;
+    int jobIndex;
+    std::future<void> done;
+};
+
+// Background result files; errors are charged to the job that produced the file.
+class ResultWriter {
+public:
+    explicit ResultWriter(std::vector<BatchJobReport>& reports) : reports_(reports) {}
+
+    void write(int job_index, Matrix matrix, const string& path) {
+        waitFor(path);
+        while (pending_.size() >= static_cast<size_t>(BATCH_MAX_PENDING_WRITES)) finishOldest();
+        auto shared = std::make_shared<Matrix>(std::move(matrix));
+        pending_.push_back({ path, job_index, std::async(std::launch::async, [shared, path] { saveMatrixToFile(*shared, path, false); }) });
+    }
+
+    // A later job reads this file: its write has to land first.
+    void waitFor(const string& path) {
+        while (std::any_of(pending_.begin(), pending_.end(), [&](const PendingWrite& w) { return w.path == path; })) finishOldest();
+    }
+
+    bool isPending(const string& path) const {
+        return std::any_of(pending_.begin(), pending_.end(), [&](const PendingWrite& w) { return w.path == path; });
+    }
+
+    void finishAll() {
+        while (!pending_.empty()) finishOldest();
+    }
+
+private:
+    void finishOldest() {
+        PendingWrite write = std::move(pending_.front());
+        pending_.pop_front();
+        try {
+            write.done.get();
+        }
+        catch (const std::exception& e) {
+            BatchJobReport& report = reports_[write.jobIndex];
+            report.succeeded = false;
+            report.error = e.what();
+        }
+    }
+
+    std::vector<BatchJobReport>& reports_;
+    std::deque<PendingWrite> pending_;
+};
+
+string jsonEscape(const string& text) {
+    string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) { escaped += ' '; continue; }
+        escaped += c;
+    }
+    return escaped;
+}
+
+void printJobLine(const BatchJobReport& report) {
+    std::stringstream ss;
+    ss << "JOB " << report.index << " " << (report.succeeded ? "OK" : "FAILED")
+        << " op=" << getBatchOperationName(report.job.operation);
+    if (report.job.line > 0) ss << " line=" << report.job.line;
+    if (!report.algorithm.empty()) ss << " algorithm=\"" << report.algorithm << "\"";
+    ss << std::fixed << std::setprecision(6) << " compute_s=" << report.computeSeconds << " wait_s=" << report.waitSeconds;
+    if (!report.detail.empty()) ss << " " << report.detail;
+    if (!report.job.output.empty()) ss << " out=" << report.job.output;
+    if (!report.succeeded) ss << " error=\"" << jsonEscape(report.error) << "\"";
+    cout << (report.succeeded ? GREEN : RED) << ss.str() << RESET << endl;
+}
+
+bool writeStatusFile(const string& filename, const std::vector<BatchJobReport>& reports, int exit_code, double total_seconds) {
+    std::ofstream out(filename, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        cerr << RED << "Error: Could not open status file: " << filename << RESET << endl;
+        return false;
+    }
+    int succeeded = static_cast<int>(std::count_if(reports.begin(), reports.end(), [](const BatchJobReport& r) { return r.succeeded; }));
+    out << std::fixed << std::setprecision(6);
+    out << "{\"exitCode\":" << exit_code << ",\"jobs\":" << reports.size() << ",\"succeeded\":" << succeeded
+        << ",\"failed\":" << reports.size() - succeeded << ",\"totalSeconds\":" << total_seconds << ",\"results\":[\n";
+    for (size_t i = 0; i < reports.size(); ++i) {
+        const BatchJobReport& r = reports[i];
+        out << "{\"index\":" << r.index << ",\"line\":" << r.job.line << ",\"operation\":\"" << getBatchOperationName(r.job.operation)
+            << "\",\"status\":\"" << (r.succeeded ? "ok" : "failed") << "\",\"algorithm\":\"" << jsonEscape(r.algorithm)
+            << "\",\"computeSeconds\":" << r.computeSeconds << ",\"waitSeconds\":" << r.waitSeconds
+            << ",\"output\":\"" << jsonEscape(r.job.output) << "\",\"detail\":\"" << jsonEscape(r.detail)
+            << "\",\"error\":\"" << jsonEscape(r.error) << "\"}" << (i + 1 < reports.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+    return true;
+}
+
+void printUsage() {
+    cout << "Usage: fluminum --jobs FILE [--threads N] [--log FILE.csv] [--status FILE.json]\n"
+        << "                [--cache [--cache-dir DIR] [--cache-memory-mb N] [--cache-disk-mb N]]\n"
+        << "       fluminum --op multiply|compare|power|chain [--a FILE] [--b FILE] [--inputs F1,F2,...]\n"
+        << "                [--algorithm auto|naive|tiled|tiled-parallel|strassen|sparse] [--threads N]\n"
+        << "                [--threshold N] [--tile N] [--k N] [--epsilon X] [--seed N] [--out FILE]\n"
+        << "                [--layout row-major|morton] [--log FILE.csv] [--status FILE.json]\n"
+        << "An input may be random:ROWSxCOLS[:DISTRIBUTION[:DENSITY]] instead of a file, with DISTRIBUTION\n"
+        << "one of uniform (default), normal, integer, sparse, symmetric, diagonal-dominant; seed= makes\n"
+        << "it reproducible, and without it every job draws a seed and reports it.\n"
+        << "layout=morton runs strassen or tiled-parallel on operands converted to a recursive block\n"
+        << "(Z-order) layout.\n"
+        << "Both forms accept --memory-budget SIZE (e.g. 4096, 512M, 8G): algorithms are shrunk or replaced\n"
+        << "to stay under it, and jobs that cannot fit fail before they start.\n"
+        << "Job files hold one job per line as '<op> key=value ...' with the keys above (a, b, inputs,\n"
+        << "algorithm, threads, threshold, tile, k, epsilon, seed, layout, out, log). Exit status: "
+        << BATCH_EXIT_SUCCESS << " all jobs succeeded, " << BATCH_EXIT_JOB_FAILED << " a job failed, "
+        << BATCH_EXIT_USAGE << " usage error." << endl;
+}
+
+// The job described by --op and its companion options.
+BatchJob jobFromOptions(const ArgParser& parser) {
+    BatchJob job;
+    if (!parseOperation(parser.getOption("--op"), job.operation)) throw std::invalid_argument("unknown operation '" + parser.getOption("--op") + "'");
+    for (const char* key : { "a", "b", "inputs", "algorithm", "threshold", "tile", "k", "epsilon", "seed", "layout", "out" }) {
+        const string option = string("--") + key;
+        if (parser.optionExists(option)) applyJobOption(job, key, parser.getOption(option));
+    }
+    validateJob(job);
+    return job;
+}
+
+
+// --- Job Execution ---
+// cache=, layout=, shape=, memory_limit_mb= and memory_adaptation= fields of a multiply or power job.
+string resultDetail(const MultiplicationResult& r) {
+    std::stringstream ss;
+    if (!r.cache_status.empty()) ss << " cache=" << r.cache_status;
+    if (r.layout != MatrixLayout::RowMajor) ss << " layout=" << getMatrixLayoutName(r.layout);
+    if (!r.shape_path.empty()) ss << " shape=\"" << r.shape_path << "\"";
+    if (r.memory_budget_mb > 0.0) ss << std::fixed << std::setprecision(0) << " memory_limit_mb=" << r.memory_budget_mb;
+    if (!r.memory_adaptation.empty()) ss << " memory_adaptation=\"" << r.memory_adaptation << "\"";
+    return ss.str().empty() ? "" : ss.str().substr(1);
+}
+
+// Everything that can change the bits of a multiply or power result, for the result cache.
+// fitted describes the candidate that will actually run (describeCandidate), which a memory
+// budget can make differ from the requested one.
+string cacheParameters(const BatchJob& job, const ThreadPool& pool, const string& fitted = "") {
+    std::stringstream ss;
+    ss << getBatchOperationName(job.operation) << " algorithm=" << job.algorithm << " threads=" << pool.size()
+        << " threshold=" << job.threshold << " tile=" << job.tileSize << " k=" << job.exponent
+        << " layout=" << getMatrixLayoutName(job.layout)
+        << " tuned_tile=" << G_OPTIMAL_TILE_SIZE << " tuned_threshold=" << G_OPTIMAL_STRASSEN_THRESHOLD
+        << " kernel=" << getGemmEngineName(G_TUNED_GEMM_KERNEL) << " memory_budget_mb=" << getMemoryBudget().enforcedMB;
+    if (!fitted.empty()) ss << " fitted=\"" << fitted << "\"";
+    return ss.str();
+}
+
+void runJob(BatchJobReport& report, LoadedInputs& inputs, ThreadPool& pool, Matrix& result) {
+    const BatchJob& job = report.job;
+    auto start = std::chrono::high_resolution_clock::now();
+    switch (job.operation) {
+    case BatchOperation::Multiply: {
+        const Matrix& A = inputs.matrices[0];
+        const Matrix& B = inputs.matrices[1];
+        // The candidate is planned and fitted to the memory budget before the cache lookup, so
+        // the key names what will run rather than what was asked for.
+        AlgorithmPlan plan;
+        AlgorithmCandidate candidate;
+        string fitted;
+        if (job.algorithm == "auto") {
+            if (planAutomaticMultiplication(A, B, job.threads, &pool, &inputs.infos[0], &inputs.infos[1], plan)) fitted = describeCandidate(plan.chosen);
+        }
+        else if (job.algorithm != "sparse") {
+            candidate.algorithm = (job.algorithm == "naive") ? MultiplyAlgorithm::Naive
+                : (job.algorithm == "tiled") ? MultiplyAlgorithm::Tiled
+                : (job.algorithm == "strassen") ? MultiplyAlgorithm::Strassen : MultiplyAlgorithm::TiledParallel;
+            candidate.strassenThreshold = job.threshold;
+            candidate.tileSize = job.tileSize;
+            candidate.threads = job.threads;
+            candidate.layout = job.layout;
+            candidate = fitCandidateToProduct(A, B, candidate, &pool);
+            fitted = describeCandidate(candidate);
+        }
+        MultiplicationResult r = computeWithResultCache({ &A, &B }, cacheParameters(job, pool, fitted), [&] {
+            if (job.algorithm == "auto") return multiplyAutomatic(A, B, job.threads, false, &pool, &inputs.infos[0], &inputs.infos[1], fitted.empty() ? nullptr : &plan);
+            if (job.algorithm == "sparse") return multiplySparsityAware(A, B, job.tileSize > 0 ? job.tileSize : G_OPTIMAL_TILE_SIZE, job.threads, &inputs.infos[0], &inputs.infos[1]);
+            return multiplyWithAlgorithm(A, B, candidate, &pool);
+            }, job.threads);
+        r.random_operands = inputs.generated;
+        r.random_seed = job.seed;
+        report.algorithm = r.algorithm_type;
+        report.detail = resultDetail(r);
+        if (!job.log.empty()) logMultiplicationResultToCSV(r, job.log);
+        result = std::move(r.resultMatrix);
+        break;
+    }
+    case BatchOperation::Compare: {
+        const int threshold = (job.threshold > 0) ? job.threshold : std::max(1, G_OPTIMAL_STRASSEN_THRESHOLD);
+        ComparisonResult r = compareMatricesParallel(inputs.matrices[0], inputs.matrices[1], threshold, job.epsilon, job.threads);
+        report.algorithm = "Comparison";
+        long long total = static_cast<long long>(r.originalRows) * r.originalCols;
+        report.detail = "matches=" + std::to_string(r.matchCount) + " mismatches=" + std::to_string(total - r.matchCount);
+        if (!job.log.empty()) logComparisonResultToCSV(r, job.log);
+        break;
+    }
+    case BatchOperation::Power: {
+        const int threshold = (job.threshold > 0) ? job.threshold : std::max(1, G_OPTIMAL_STRASSEN_THRESHOLD);
+        const int tile = (job.tileSize > 0) ? job.tileSize : std::max(1, G_OPTIMAL_TILE_SIZE);
+        const Matrix& A = inputs.matrices[0];
+        MultiplicationResult r = computeWithResultCache({ &A }, cacheParameters(job, pool),
+            [&] { return matrixPowerParallel(A, job.exponent, threshold, true, tile, job.threads, &pool); }, job.threads);
+        r.random_operands = inputs.generated;
+        r.random_seed = job.seed;
+        report.algorithm = r.algorithm_type;
+        report.detail = resultDetail(r);
+        if (!job.log.empty()) logMultiplicationResultToCSV(r, job.log);
+        result = std::move(r.resultMatrix);
+        break;
+    }
+    case BatchOperation::Chain: {
+        ChainMultiplicationResult r = multiplyChain(inputs.matrices, job.threads);
+        report.algorithm = "Chain " + r.plan;
+        result = std::move(r.resultMatrix);
+        break;
+    }
+    }
+    if (inputs.generated) report.detail = "seed=" + std::to_string(job.seed) + (report.detail.empty() ? "" : " " + report.detail);
+    report.computeSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+}
+
+string getBatchOperationName(BatchOperation operation) {
+    switch (operation) {
+    case BatchOperation::Multiply: return "multiply";
+    case BatchOperation::Compare: return "compare";
+    case BatchOperation::Power: return "power";
+    case BatchOperation::Chain: return "chain";
+    }
+    return "unknown";
+}
+
+bool isBatchInvocation(const ArgParser& parser) {
+    return parser.optionExists("--jobs") || parser.optionExists("--op") || parser.optionExists("--help");
+}
+
+std::vector<BatchJob> parseJobFile(const string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) throw std::invalid_argument("Could not open job file: " + filename);
+    std::vector<BatchJob> jobs;
+    string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        line = line.substr(0, line.find('#'));
+        std::stringstream tokens(line);
+        string operation;
+        if (!(tokens >> operation)) continue;
+        try {
+            BatchJob job;
+            job.line = line_number;
+            if (!parseOperation(operation, job.operation)) throw std::invalid_argument("unknown operation '" + operation + "'");
+            string token;
+            while (tokens >> token) {
+                size_t equals = token.find('=');
+                if (equals == string::npos || equals == 0) throw std::invalid_argument("expected key=value, got '" + token + "'");
+                applyJobOption(job, token.substr(0, equals), token.substr(equals + 1));
+            }
+            validateJob(job);
+            jobs.push_back(job);
+        }
+        catch (const std::invalid_argument& e) {
+            throw std::invalid_argument(filename + ":" + std::to_string(line_number) + ": " + e.what());
+        }
+    }
+    return jobs;
+}
+
+
+// --- Batch Driver ---
+int runBatchMode(const ArgParser& parser) {
+    if (parser.optionExists("--help")) {
+        printUsage();
+        return BATCH_EXIT_SUCCESS;
+    }
+
+    std::vector<BatchJob> jobs;
+    try {
+        if (parser.optionExists("--jobs")) jobs = parseJobFile(parser.getOption("--jobs"));
+        if (parser.optionExists("--op")) jobs.push_back(jobFromOptions(parser));
+        // Batch-wide defaults for jobs that do not set their own.
+        unsigned int default_threads = parser.optionExists("--threads") ? parseNumber<unsigned int>("--threads", parser.getOption("--threads"), 0u) : 0;
+        string default_log = parser.optionExists("--log") ? parser.getOption("--log") : "";
+        if (parser.optionExists("--cache")) {
+            ResultCacheSettings cache;
+            cache.enabled = true;
+            if (parser.optionExists("--cache-dir")) cache.directory = parser.getOption("--cache-dir");
+            if (parser.optionExists("--cache-memory-mb")) cache.memoryLimitMB = parseNumber<double>("--cache-memory-mb", parser.getOption("--cache-memory-mb"), 0.0);
+            if (parser.optionExists("--cache-disk-mb")) cache.diskLimitMB = parseNumber<double>("--cache-disk-mb", parser.getOption("--cache-disk-mb"), 0.0);
+            configureResultCache(cache);
+        }
+        for (BatchJob& job : jobs) {
+            if (job.threads == 0) job.threads = default_threads;
+            if (job.log.empty() && job.operation != BatchOperation::Chain) job.log = default_log;
+            if (!job.hasSeed && usesRandomInputs(job)) job.seed = newRandomSeed();
+        }
+    }
+    catch (const std::exception& e) {
+        cerr << RED << "Error: " << e.what() << RESET << endl;
+        printUsage();
+        return BATCH_EXIT_USAGE;
+    }
+    if (jobs.empty()) {
+        cerr << RED << "Error: no jobs to run." << RESET << endl;
+        return BATCH_EXIT_USAGE;
+    }
+
+    auto batch_start = std::chrono::high_resolution_clock::now();
+    std::vector<BatchJobReport> reports(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        reports[i].index = static_cast<int>(i) + 1;
+        reports[i].job = jobs[i];
+    }
+    PoolCache pools;
+    ResultWriter writer(reports);
+
+    // Inputs produced by an earlier job of the batch cannot be read ahead of it.
+    std::vector<string> produced;
+    auto can_prefetch = [&](const BatchJob& job) {
+        return std::none_of(job.inputs.begin(), job.inputs.end(),
+            [&](const string& input) { return std::find(produced.begin(), produced.end(), input) != produced.end(); });
+    };
+
+    size_t next_to_print = 0;
+    std::future<LoadedInputs> next_inputs;
+    if (can_prefetch(jobs[0])) next_inputs = std::async(std::launch::async, loadInputs, std::cref(jobs[0]));
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        BatchJobReport& report = reports[i];
+        const BatchJob& job = jobs[i];
+        try {
+            auto wait_start = std::chrono::high_resolution_clock::now();
+            LoadedInputs inputs;
+            if (next_inputs.valid()) inputs = next_inputs.get();
+            else {
+                for (const string& input : job.inputs) writer.waitFor(input);
+                inputs = loadInputs(job);
+            }
+            report.waitSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - wait_start).count();
+
+            if (!job.output.empty()) produced.push_back(job.output);
+            if (i + 1 < jobs.size() && can_prefetch(jobs[i + 1])) {
+                next_inputs = std::async(std::launch::async, loadInputs, std::cref(jobs[i + 1]));
+            }
+
+            const unsigned int threads = (job.threads == 0) ? getDefaultThreadCount() : std::min(job.threads, getCpuCoreCount());
+            Matrix result;
+            report.succeeded = true;
+            runJob(report, inputs, pools.get(std::max(1u, threads)), result);
+            if (!job.output.empty()) writer.write(static_cast<int>(i), std::move(result), job.output);
+        }
+        catch (const std::exception& e) {
+            report.succeeded = false;
+            report.error = e.what();
+            // The prefetch for the next job may not have started; it loads synchronously then.
+            if (!job.output.empty() && std::find(produced.begin(), produced.end(), job.output) == produced.end()) produced.push_back(job.output);
+        }
+        // Lines come out in job order, each once the job's result file (if any) has been written.
+        while (next_to_print <= i && (!reports[next_to_print].succeeded || reports[next_to_print].job.output.empty()
+            || !writer.isPending(reports[next_to_print].job.output))) {
+            printJobLine(reports[next_to_print++]);
+        }
+    }
+    writer.finishAll();
+    while (next_to_print < reports.size()) printJobLine(reports[next_to_print++]);
+
+    const int failed = static_cast<int>(std::count_if(reports.begin(), reports.end(), [](const BatchJobReport& r) { return !r.succeeded; }));
+    const int exit_code = (failed == 0) ? BATCH_EXIT_SUCCESS : BATCH_EXIT_JOB_FAILED;
+    const double total_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - batch_start).count();
+    cout << "BATCH " << (failed == 0 ? "OK" : "FAILED") << " jobs=" << reports.size() << " failed=" << failed
+        << std::fixed << std::setprecision(6) << " total_s=" << total_seconds;
+    if (getResultCacheSettings().enabled) {
+        ResultCacheStats cache = getResultCacheStats();
+        cout << " cache_hits=" << cache.hits << " cache_misses=" << cache.misses;
+    }
+    if (getMemoryBudget().enforcedMB > 0.0) cout << std::setprecision(0) << " memory_budget_mb=" << getMemoryBudget().enforcedMB;
+    cout << " exit=" << exit_code << endl;
+    if (parser.optionExists("--status")) writeStatusFile(parser.getOption("--status"), reports, exit_code, total_seconds);
+    return exit_code;
+}
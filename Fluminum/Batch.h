@@ -0,0 +1,67 @@
+#pragma once
+#include "Common.h"
+#include "ArgParser.h"
+
+// --- Headless Batch Mode ---
+// Runs jobs without prompts, from a job file (--jobs FILE) or as one job given by options
+// (--op multiply --a A.csv --b B.csv --out C.csv ...). A job file holds one job per line:
+//   multiply a=A.csv b=B.csv algorithm=auto threads=8 out=C.csv log=results.csv
+//   compare  a=A.csv b=B.csv epsilon=1e-9 log=compare.csv
+//   power    a=A.csv k=16 out=A16.csv
+//   chain    inputs=A1.csv,A2.csv,A3.csv out=P.csv
+//   multiply a=random:4000x4000 b=random:4000x4000:normal seed=42 log=results.csv
+//   multiply a=A.csv b=B.csv algorithm=strassen layout=morton
+// random:ROWSxCOLS[:DISTRIBUTION[:DENSITY]] inputs are generated (see Random.h) from seed=, or
+// from a fresh seed that the job line and the CSV log report. '#' starts a comment. Jobs run
+// back to back on warm thread pools, the next job's inputs are read while the current one
+// computes, and result files are written in the background.
+// Every job prints one "JOB <n> OK|FAILED key=value..." line; --status FILE adds a JSON summary.
+
+// Process exit status in batch mode.
+const int BATCH_EXIT_SUCCESS = 0;       // Every job succeeded
+const int BATCH_EXIT_JOB_FAILED = 1;    // At least one job failed (the others still ran)
+const int BATCH_EXIT_USAGE = 2;         // Bad options or job file; nothing ran
+
+// Background result writes allowed in flight before the next one waits for the oldest.
+const int BATCH_MAX_PENDING_WRITES = 4;
+
+enum class BatchOperation { Multiply, Compare, Power, Chain };
+
+struct BatchJob {
+    int line = 0;                       // Line in the job file; 0 for a job given as options
+    BatchOperation operation = BatchOperation::Multiply;
+    std::vector<string> inputs;
+    string algorithm = "auto";          // auto, naive, tiled, tiled-parallel, strassen, sparse
+    unsigned int threads = 0;           // 0 = getDefaultThreadCount()
+    int threshold = 0;                  // Strassen / comparison threshold; 0 = tuned default
+    int tileSize = 0;                   // 0 = G_OPTIMAL_TILE_SIZE
+    long long exponent = -1;            // power only
+    double epsilon = 0.0;               // compare only
+    unsigned long long seed = 0;        // Seed of random: inputs; drawn per job unless hasSeed
+    bool hasSeed = false;
+    MatrixLayout layout = MatrixLayout::RowMajor; // strassen and tiled-parallel only (see Morton.h)
+    string output;                      // Result matrix file (optional)
+    string log;                         // CSV log (optional; --log gives the default)
+};
+
+struct BatchJobReport {
+    int index = 0;                      // 1-based position in the batch
+    BatchJob job;
+    bool succeeded = false;
+    string error;
+    string algorithm;                   // What actually ran
+    double waitSeconds = 0.0;           // Time spent waiting for inputs not prefetched in time
+    double computeSeconds = 0.0;
+    string detail;                      // e.g. mismatch count of a comparison
+};
+
+string getBatchOperationName(BatchOperation operation);
+
+// True when the arguments ask for headless operation (--jobs, --op or --help).
+bool isBatchInvocation(const ArgParser& parser);
+
+// Throws std::invalid_argument naming the line of the first malformed job.
+std::vector<BatchJob> parseJobFile(const string& filename);
+
+// Runs the jobs and returns one of the BATCH_EXIT_* codes.
+int runBatchMode(const ArgParser& parser);
@@ -0,0 +1,161 @@
+#define NOMINMAX
+#include "Batched.h"
+#include "FixedMatrix.h"
+#include "Matrix.h"
+#include "Algorithm.h"
+#include "System.h"
+
+// --- Micro-Kernels ---
+// Generic i-k-j kernel: the inner loop is a contiguous axpy over one row of B and C.
+static void batch_kernel_generic(const double* a, const double* b, double* c, int M, int N, int P) {
+    for (int i = 0; i < M; ++i) {
+        double* c_row = c + static_cast<size_t>(i) * P;
+        for (int j = 0; j < P; ++j) c_row[j] = 0.0;
+        for (int k = 0; k < N; ++k) {
+            const double aik = a[static_cast<size_t>(i) * N + k];
+            const double* b_row = b + static_cast<size_t>(k) * P;
+            for (int j = 0; j < P; ++j) c_row[j] += aik * b_row[j];
+        }
+    }
+}
+
+// Square problems with a compile-time specialization use the fixed-size kernel table.
+static const FixedKernelSet* selectFixedKernels(int M, int N, int P) {
+    return (M == N && N == P) ? getFixedKernels(M) : nullptr;
+}
+
+string getBatchKernelName(int M, int N, int P) {
+    if (!selectFixedKernels(M, N, P)) return "Generic";
+    string name = "Fixed " + std::to_string(M) + "x" + std::to_string(M);
+#ifdef HAS_AVX
+    if (M % 4 == 0) name += " (AVX)";
+#endif
+    return name;
+}
+
+
+// --- Batch Driver ---
+static void validateBatchShape(int M, int N, int P, int batchCount) {
+    if (M <= 0 || N <= 0 || P <= 0) throw std::invalid_argument("Batched multiplication requires positive dimensions.");
+    if (batchCount < 0) throw std::invalid_argument("Batch count cannot be negative.");
+}
+
+// Runs `batchCount` problems, handing each worker one contiguous range of whole problems.
+// `operands(b, a, bm, c)` resolves the pointers of problem b.
+template<class OperandAt>
+static BatchedMultiplicationResult runBatch(int M, int N, int P, int batchCount, unsigned int num_threads_request, OperandAt operands) {
+    BatchedMultiplicationResult result_obj;
+    result_obj.batchCount = batchCount;
+    result_obj.rowsA = M;
+    result_obj.colsA = N;
+    result_obj.colsB = P;
+    result_obj.kernel_used = getBatchKernelName(M, N, P);
+
+    unsigned int hardware_cores = getCpuCoreCount();
+    result_obj.coresDetected = hardware_cores;
+    result_obj.threadsUsed = (num_threads_request == 0) ? getDefaultThreadCount() : std::min(num_threads_request, hardware_cores);
+    if (result_obj.threadsUsed == 0) result_obj.threadsUsed = 1;
+    if (static_cast<int>(result_obj.threadsUsed) > batchCount) result_obj.threadsUsed = std::max(1, batchCount);
+
+    const FixedKernelSet* fixed = selectFixedKernels(M, N, P);
+    auto run_range = [&](int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+            const double* a = nullptr;
+            const double* bm = nullptr;
+            double* c = nullptr;
+            operands(b, a, bm, c);
+            if (fixed) fixed->multiply(a, N, bm, P, c, P);
+            else batch_kernel_generic(a, bm, c, M, N, P);
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    if (result_obj.threadsUsed <= 1) {
+        run_range(0, batchCount);
+    }
+    else {
+        // Must not be called from a task already running on the shared pool.
+        ThreadPool& pool = getSharedThreadPool();
+        int workers = static_cast<int>(result_obj.threadsUsed);
+        std::vector<std::future<void>> futures;
+        futures.reserve(workers);
+        for (int w = 0; w < workers; ++w) {
+            int begin = static_cast<int>(static_cast<long long>(batchCount) * w / workers);
+            int end = static_cast<int>(static_cast<long long>(batchCount) * (w + 1) / workers);
+            futures.emplace_back(pool.enqueue(run_range, begin, end));
+        }
+        for (auto& f : futures) f.get();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    result_obj.durationSeconds_chrono = std::chrono::duration<double>(end - start).count();
+    if (result_obj.durationSeconds_chrono > 0.0) {
+        result_obj.problemsPerSecond = batchCount / result_obj.durationSeconds_chrono;
+        result_obj.gflops = 2.0 * M * N * P * static_cast<double>(batchCount) / result_obj.durationSeconds_chrono / 1e9;
+    }
+    return result_obj;
+}
+
+
+// --- Public Entry Points ---
+BatchedMultiplicationResult multiplyBatchedStrided(const double* A, long long strideA,
+    const double* B, long long strideB,
+    double* C, long long strideC,
+    int M, int N, int P, int batchCount,
+    unsigned int num_threads_request) {
+    validateBatchShape(M, N, P, batchCount);
+    if (batchCount > 1 && (strideA < 0 || strideB < 0 || strideC < static_cast<long long>(M) * P)) {
+        throw std::invalid_argument("Invalid batch strides (output problems must not overlap).");
+    }
+    if (batchCount > 0 && (!A || !B || !C)) throw std::invalid_argument("Null operand pointer in batched multiplication.");
+
+    return runBatch(M, N, P, batchCount, num_threads_request,
+        [=](int b, const double*& a, const double*& bm, double*& c) {
+            a = A + b * strideA;
+            bm = B + b * strideB;
+            c = C + b * strideC;
+        });
+}
+
+BatchedMultiplicationResult multiplyBatchedPointers(const double* const* A, const double* const* B, double* const* C,
+    int M, int N, int P, int batchCount,
+    unsigned int num_threads_request) {
+    validateBatchShape(M, N, P, batchCount);
+    if (batchCount > 0 && (!A || !B || !C)) throw std::invalid_argument("Null operand array in batched multiplication.");
+
+    return runBatch(M, N, P, batchCount, num_threads_request,
+        [=](int b, const double*& a, const double*& bm, double*& c) {
+            a = A[b];
+            bm = B[b];
+            c = C[b];
+        });
+}
+
+BatchedMultiplicationResult multiplyBatched(const std::vector<Matrix>& As, const std::vector<Matrix>& Bs,
+    std::vector<double>& output,
+    unsigned int num_threads_request) {
+    if (As.size() != Bs.size()) throw std::invalid_argument("Batched multiplication needs the same number of A and B operands.");
+    if (As.empty()) return BatchedMultiplicationResult();
+
+    const int M = As[0].rows();
+    const int N = As[0].cols();
+    const int P = Bs[0].cols();
+    for (size_t b = 0; b < As.size(); ++b) {
+        if (As[b].rows() != M || As[b].cols() != N || Bs[b].rows() != N || Bs[b].cols() != P) {
+            throw std::invalid_argument("All problems in a batch must share the same shapes (problem " + std::to_string(b) + ").");
+        }
+    }
+
+    const int batchCount = static_cast<int>(As.size());
+    const size_t problem_size = static_cast<size_t>(M) * P;
+    if (output.size() < problem_size * batchCount) output.resize(problem_size * batchCount);
+    double* out = output.data();
+
+    validateBatchShape(M, N, P, batchCount);
+    return runBatch(M, N, P, batchCount, num_threads_request,
+        [&As, &Bs, out, problem_size](int b, const double*& a, const double*& bm, double*& c) {
+            a = As[b].getRawData().data();
+            bm = Bs[b].getRawData().data();
+            c = out + problem_size * b;
+        });
+}
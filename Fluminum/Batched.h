@@ -0,0 +1,29 @@
+#pragma once
+#include "Common.h"
+
+// --- Batched Small-Matrix Multiplication ---
+// Every problem in a batch has the same shape: C_b (M x P) = A_b (M x N) * B_b (N x P), all row-major.
+// Whole problems are distributed across the shared thread pool, and square sizes with a
+// fixed-size kernel (see FixedMatrix.h) skip the generic loops entirely.
+
+// Strided layout: problem b reads A + b * strideA and B + b * strideB and writes C + b * strideC.
+// C must point at caller-owned storage for at least (batchCount - 1) * strideC + M * P doubles.
+BatchedMultiplicationResult multiplyBatchedStrided(const double* A, long long strideA,
+    const double* B, long long strideB,
+    double* C, long long strideC,
+    int M, int N, int P, int batchCount,
+    unsigned int num_threads_request = 0);
+
+// Pointer-array layout: A[b], B[b] and C[b] each point at one contiguous row-major operand.
+BatchedMultiplicationResult multiplyBatchedPointers(const double* const* A, const double* const* B, double* const* C,
+    int M, int N, int P, int batchCount,
+    unsigned int num_threads_request = 0);
+
+// Array-of-Matrix convenience wrapper. All pairs must share shapes. The results are written
+// back to back into `output` (problem b at offset b * M * P), which is resized only if too small.
+BatchedMultiplicationResult multiplyBatched(const std::vector<Matrix>& As, const std::vector<Matrix>& Bs,
+    std::vector<double>& output,
+    unsigned int num_threads_request = 0);
+
+// Name of the kernel a batch of the given shape would use (for reporting).
+string getBatchKernelName(int M, int N, int P);
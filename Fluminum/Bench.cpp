@@ -0,0 +1,448 @@
+#define NOMINMAX
+#include "Bench.h"
+#include "Algorithm.h"
+#include "Gemm.h"
+#include "IO.h"
+#include "Matrix.h"
+#include "Random.h"
+#include "System.h"
+#include <filesystem>
+#include <map>
+
+// --- Statistics ---
+namespace {
+// Two-sided 95% Student-t quantiles for 1..30 degrees of freedom.
+const double T_QUANTILES_95[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    double position = p * (sorted.size() - 1);
+    size_t below = static_cast<size_t>(position);
+    if (below + 1 >= sorted.size()) return sorted.back();
+    return sorted[below] + (position - below) * (sorted[below + 1] - sorted[below]);
+}
+}
+
+BenchStatistics summarizeSamples(std::vector<double> samples) {
+    BenchStatistics stats;
+    stats.repetitions = static_cast<int>(samples.size());
+    if (samples.empty()) return stats;
+    std::sort(samples.begin(), samples.end());
+    stats.minSeconds = samples.front();
+    stats.medianSeconds = percentile(samples, 0.5);
+    stats.p5Seconds = percentile(samples, 0.05);
+    stats.p95Seconds = percentile(samples, 0.95);
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    stats.meanSeconds = sum / samples.size();
+    double squares = 0.0;
+    for (double s : samples) squares += (s - stats.meanSeconds) * (s - stats.meanSeconds);
+    stats.stddevSeconds = (samples.size() > 1) ? std::sqrt(squares / (samples.size() - 1)) : 0.0;
+    const size_t df = samples.size() - 1;
+    const double t = (df == 0) ? 0.0 : (df <= 30) ? T_QUANTILES_95[df - 1] : 1.96;
+    const double half_width = t * stats.stddevSeconds / std::sqrt(static_cast<double>(samples.size()));
+    stats.ci95LowSeconds = stats.meanSeconds - half_width;
+    stats.ci95HighSeconds = stats.meanSeconds + half_width;
+    return stats;
+}
+
+
+// --- Options ---
+namespace {
+const std::vector<string> BENCH_ENGINES = { "naive", "tiled", "tiled-parallel", "tiled-parallel-morton", "strassen", "strassen-morton",
+    "gemm", "compare", "csv-read", "csv-write" };
+
+struct Shape {
+    int M, K, N;
+};
+
+struct BenchOptions {
+    std::vector<string> engines = BENCH_ENGINES;
+    std::vector<Shape> shapes;
+    std::vector<unsigned int> threads;
+    int warmup = BENCH_DEFAULT_WARMUP;
+    int repetitions = BENCH_DEFAULT_REPETITIONS;
+    double tolerance = BENCH_DEFAULT_TOLERANCE;
+    unsigned long long seed = RANDOM_BENCHMARK_SEED;
+};
+
+std::vector<string> splitList(const string& list) {
+    std::vector<string> items;
+    std::stringstream ss(list);
+    string item;
+    while (std::getline(ss, item, ',')) if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+int parseAtLeast(const string& what, const string& text, int minimum) {
+    try {
+        size_t used = 0;
+        int value = std::stoi(text, &used);
+        if (used == text.size() && value >= minimum) return value;
+    }
+    catch (const std::exception&) {}
+    throw std::invalid_argument("invalid " + what + " '" + text + "'");
+}
+
+int parsePositive(const string& what, const string& text) {
+    return parseAtLeast(what, text, 1);
+}
+
+BenchOptions parseOptions(const ArgParser& parser) {
+    BenchOptions options;
+    if (parser.optionExists("--engines")) {
+        options.engines = splitList(parser.getOption("--engines"));
+        for (const string& engine : options.engines) {
+            if (std::find(BENCH_ENGINES.begin(), BENCH_ENGINES.end(), engine) == BENCH_ENGINES.end()) throw std::invalid_argument("unknown engine '" + engine + "'");
+        }
+    }
+    const string sizes = parser.optionExists("--sizes") ? parser.getOption("--sizes") : (parser.optionExists("--shapes") ? "" : "128,256,512");
+    for (const string& size : splitList(sizes)) {
+        int n = parsePositive("size", size);
+        options.shapes.push_back({ n, n, n });
+    }
+    if (parser.optionExists("--shapes")) {
+        for (const string& shape : splitList(parser.getOption("--shapes"))) {
+            std::vector<string> dims;
+            std::stringstream ss(shape);
+            string dim;
+            while (std::getline(ss, dim, 'x')) dims.push_back(dim);
+            if (dims.size() != 3) throw std::invalid_argument("shape '" + shape + "' is not MxKxN");
+            options.shapes.push_back({ parsePositive("shape", dims[0]), parsePositive("shape", dims[1]), parsePositive("shape", dims[2]) });
+        }
+    }
+    if (parser.optionExists("--threads")) {
+        for (const string& t : splitList(parser.getOption("--threads"))) options.threads.push_back(static_cast<unsigned int>(parsePositive("thread count", t)));
+    }
+    else {
+        options.threads.push_back(1);
+        if (getCpuCoreCount() > 1) options.threads.push_back(getCpuCoreCount());
+    }
+    if (parser.optionExists("--warmup")) options.warmup = parseAtLeast("warm-up count", parser.getOption("--warmup"), 0);
+    if (parser.optionExists("--reps")) options.repetitions = parsePositive("repetition count", parser.getOption("--reps"));
+    if (parser.optionExists("--tolerance")) options.tolerance = std::stod(parser.getOption("--tolerance"));
+    if (parser.optionExists("--seed")) options.seed = parseRandomSeed(parser.getOption("--seed"));
+    if (options.warmup < 0 || options.tolerance < 0.0) throw std::invalid_argument("--warmup and --tolerance cannot be negative");
+    if (options.shapes.empty()) throw std::invalid_argument("no sizes or shapes to run");
+    return options;
+}
+
+bool isSerialEngine(const string& engine) {
+    return engine == "naive" || engine == "tiled" || engine == "csv-read" || engine == "csv-write";
+}
+
+
+// --- Measurement ---
+// The engines report progress on cout; the timed runs send it nowhere.
+class QuietCout {
+public:
+    QuietCout() : saved_(cout.rdbuf(sink_.rdbuf())) {}
+    ~QuietCout() { cout.rdbuf(saved_); }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf* saved_;
+};
+
+BenchStatistics measure(const std::function<void()>& run, int warmup, int repetitions) {
+    std::vector<double> samples;
+    QuietCout quiet;
+    for (int i = 0; i < warmup; ++i) run();
+    for (int i = 0; i < repetitions; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        samples.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return summarizeSamples(samples);
+}
+
+// The timed body for one case, or nullptr when the engine does not apply to the shape.
+std::function<void()> makeRun(const string& engine, const Shape& shape, unsigned int threads,
+    const Matrix& A, const Matrix& B, const Matrix& A_copy, Matrix& C, const string& scratch_file) {
+    const int tile = std::max(1, G_OPTIMAL_TILE_SIZE);
+    const int threshold = std::max(1, G_OPTIMAL_STRASSEN_THRESHOLD);
+    if (engine == "naive") {
+        if (static_cast<double>(shape.M) * shape.K * shape.N > BENCH_NAIVE_MAX_OPERATIONS) return nullptr;
+        return [&] { C = A.multiply_naive(B); };
+    }
+    if (engine == "tiled") return [&, tile] { C = A.multiply_tiled(B, tile); };
+    if (engine == "tiled-parallel") return [&, tile, threads] { C = multiplyTiledParallel(A, B, tile, threads).resultMatrix; };
+    if (engine == "strassen") return [&, tile, threshold, threads] { C = multiplyStrassenParallel(A, B, threshold, true, tile, threads).resultMatrix; };
+    if (engine == "tiled-parallel-morton") {
+        return [&, tile, threads] { C = multiplyTiledParallel(A, B, tile, threads, nullptr, MatrixLayout::Morton).resultMatrix; };
+    }
+    if (engine == "strassen-morton") {
+        return [&, tile, threshold, threads] {
+            C = multiplyStrassenParallel(A, B, threshold, true, tile, threads, nullptr, StrassenSchedule(), MatrixLayout::Morton).resultMatrix;
+        };
+    }
+    if (engine == "gemm") {
+        return [&, threads] {
+            GemmOptions options;
+            options.threads = threads;
+            gemm(Transpose::None, Transpose::None, 1.0, A, B, 0.0, C, options);
+        };
+    }
+    if (engine == "compare") return [&, threshold, threads] { compareMatricesParallel(A, A_copy, threshold, 0.0, threads); };
+    if (engine == "csv-write") return [&] { saveMatrixToFile(A, scratch_file, false); };
+    if (engine == "csv-read") return [&] { readMatrixFromFile(scratch_file, nullptr, false); };
+    return nullptr;
+}
+
+double caseFlops(const BenchCase& c) {
+    if (c.engine == "compare" || c.engine == "csv-read" || c.engine == "csv-write") return 0.0;
+    return 2.0 * c.M * c.K * c.N;
+}
+
+
+// --- Reports ---
+string caseKey(const string& engine, int M, int K, int N, unsigned int threads) {
+    return engine + " " + std::to_string(M) + "x" + std::to_string(K) + "x" + std::to_string(N) + " t" + std::to_string(threads);
+}
+
+bool writeCsv(const string& filename, const std::vector<BenchCase>& cases) {
+    std::ofstream out(filename, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        cerr << RED << "Error: Could not open benchmark CSV file: " << filename << RESET << endl;
+        return false;
+    }
+    out << "Processor,Engine,M,K,N,Threads,Reps,MinSeconds,MedianSeconds,P5Seconds,P95Seconds,"
+        << "MeanSeconds,StdDevSeconds,CI95LowSeconds,CI95HighSeconds,GFLOPS\n";
+    out << std::setprecision(9);
+    for (const BenchCase& c : cases) {
+        const BenchStatistics& s = c.stats;
+        out << "\"" << getCpuModelName() << "\"," << c.engine << "," << c.M << "," << c.K << "," << c.N << "," << c.threads << ","
+            << s.repetitions << "," << s.minSeconds << "," << s.medianSeconds << "," << s.p5Seconds << "," << s.p95Seconds << ","
+            << s.meanSeconds << "," << s.stddevSeconds << "," << s.ci95LowSeconds << "," << s.ci95HighSeconds << "," << c.gflops << "\n";
+    }
+    return true;
+}
+
+bool writeJson(const string& filename, const std::vector<BenchCase>& cases, const BenchOptions& options) {
+    std::ofstream out(filename, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        cerr << RED << "Error: Could not open benchmark JSON file: " << filename << RESET << endl;
+        return false;
+    }
+    out << std::setprecision(9);
+    out << "{\"processor\":\"" << getCpuModelName() << "\",\"cores\":" << getCpuCoreCount()
+        << ",\"seed\":" << options.seed << ",\"warmup\":" << options.warmup << ",\"repetitions\":" << options.repetitions
+        << ",\"tileSize\":" << G_OPTIMAL_TILE_SIZE << ",\"strassenThreshold\":" << G_OPTIMAL_STRASSEN_THRESHOLD << ",\"results\":[\n";
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const BenchCase& c = cases[i];
+        const BenchStatistics& s = c.stats;
+        out << "{\"engine\":\"" << c.engine << "\",\"M\":" << c.M << ",\"K\":" << c.K << ",\"N\":" << c.N << ",\"threads\":" << c.threads
+            << ",\"reps\":" << s.repetitions << ",\"min\":" << s.minSeconds << ",\"median\":" << s.medianSeconds
+            << ",\"p5\":" << s.p5Seconds << ",\"p95\":" << s.p95Seconds << ",\"mean\":" << s.meanSeconds
+            << ",\"stddev\":" << s.stddevSeconds << ",\"ci95\":[" << s.ci95LowSeconds << "," << s.ci95HighSeconds << "]"
+            << ",\"gflops\":" << c.gflops << "}" << (i + 1 < cases.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+    return true;
+}
+
+// Same layout as Chart/performance_data.csv: naive (OM) against Strassen (SA) per thread count.
+bool writeChartCsv(const string& filename, const std::vector<BenchCase>& cases) {
+    int size = 0;
+    for (const BenchCase& c : cases) {
+        if (c.engine == "naive" && c.M == c.K && c.K == c.N) size = std::max(size, c.M);
+    }
+    const BenchCase* naive = nullptr;
+    for (const BenchCase& c : cases) if (c.engine == "naive" && c.M == size && c.K == size && c.N == size) naive = &c;
+    if (naive == nullptr) {
+        cerr << RED << "Error: --chart-csv needs the naive and strassen engines on a square size." << RESET << endl;
+        return false;
+    }
+    std::ofstream out(filename, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        cerr << RED << "Error: Could not open chart CSV file: " << filename << RESET << endl;
+        return false;
+    }
+    out << "Processor,Threads,OM_Time,SA_Time\n" << std::setprecision(6);
+    for (const BenchCase& c : cases) {
+        if (c.engine != "strassen" || c.M != size || c.K != size || c.N != size) continue;
+        out << getCpuModelName() << "," << c.threads << "," << naive->stats.medianSeconds << "," << c.stats.medianSeconds << "\n";
+    }
+    return true;
+}
+
+struct BaselineEntry {
+    double median = 0.0;
+    double ciLow = 0.0;
+    double ciHigh = 0.0;
+};
+
+std::vector<string> splitCsvLine(const string& line) {
+    std::vector<string> fields;
+    string field;
+    bool quoted = false;
+    for (char c : line) {
+        if (c == '"') quoted = !quoted;
+        else if (c == ',' && !quoted) { fields.push_back(field); field.clear(); }
+        else if (c != '\r') field += c;
+    }
+    fields.push_back(field);
+    return fields;
+}
+
+std::map<string, BaselineEntry> readBaseline(const string& filename) {
+    std::ifstream in(filename);
+    if (!in.is_open()) throw std::invalid_argument("Could not open baseline file: " + filename);
+    string line;
+    if (!std::getline(in, line)) throw std::invalid_argument("baseline file " + filename + " is empty");
+    std::vector<string> header = splitCsvLine(line);
+    auto column = [&](const string& name) {
+        auto it = std::find(header.begin(), header.end(), name);
+        if (it == header.end()) throw std::invalid_argument("baseline file " + filename + " has no " + name + " column");
+        return static_cast<size_t>(it - header.begin());
+    };
+    const size_t engine = column("Engine"), m = column("M"), k = column("K"), n = column("N"), threads = column("Threads");
+    const size_t median = column("MedianSeconds"), low = column("CI95LowSeconds"), high = column("CI95HighSeconds");
+    std::map<string, BaselineEntry> baseline;
+    while (std::getline(in, line)) {
+        std::vector<string> f = splitCsvLine(line);
+        if (f.size() < header.size()) continue;
+        baseline[caseKey(f[engine], std::stoi(f[m]), std::stoi(f[k]), std::stoi(f[n]), static_cast<unsigned int>(std::stoul(f[threads])))] =
+            { std::stod(f[median]), std::stod(f[low]), std::stod(f[high]) };
+    }
+    return baseline;
+}
+
+// Prints the per-case comparison and returns the number of regressions.
+int compareWithBaseline(const std::vector<BenchCase>& cases, const std::map<string, BaselineEntry>& baseline, double tolerance) {
+    int regressions = 0;
+    print_header_box("Baseline Comparison", 100);
+    std::stringstream header;
+    header << " " << std::left << std::setw(42) << "Case" << std::setw(14) << "Baseline" << std::setw(14) << "Current"
+        << std::setw(11) << "Change" << "Status";
+    print_line_in_box(header.str(), 100);
+    print_separator_line(100);
+    for (const BenchCase& c : cases) {
+        const string key = caseKey(c.engine, c.M, c.K, c.N, c.threads);
+        auto it = baseline.find(key);
+        std::stringstream row;
+        row << " " << std::left << std::setw(42) << key;
+        if (it == baseline.end()) {
+            row << std::setw(14) << "-" << std::setw(14) << "-" << std::setw(11) << "-" << YELLOW << "new";
+            print_line_in_box(row.str(), 100, false);
+            continue;
+        }
+        const BaselineEntry& base = it->second;
+        const double change = (base.median > 0.0) ? c.stats.medianSeconds / base.median - 1.0 : 0.0;
+        // Slower beyond the tolerance and not explained by run-to-run noise.
+        const bool regressed = change > tolerance && c.stats.ci95LowSeconds > base.ciHigh;
+        const bool improved = change < -tolerance && c.stats.ci95HighSeconds < base.ciLow;
+        if (regressed) ++regressions;
+        std::stringstream base_ss, current_ss, change_ss;
+        base_ss << std::fixed << std::setprecision(6) << base.median << "s";
+        current_ss << std::fixed << std::setprecision(6) << c.stats.medianSeconds << "s";
+        change_ss << std::showpos << std::fixed << std::setprecision(1) << change * 100.0 << "%";
+        row << std::setw(14) << base_ss.str() << std::setw(14) << current_ss.str() << std::setw(11) << change_ss.str()
+            << (regressed ? RED + string("REGRESSION") : improved ? GREEN + string("improved") : string("ok"));
+        print_line_in_box(row.str(), 100, false);
+    }
+    print_footer_box(100);
+    return regressions;
+}
+
+void printUsage() {
+    cout << "Usage: fluminum --bench [--engines naive,tiled,tiled-parallel,strassen,gemm,compare,csv-read,csv-write]\n"
+        << "                 [--sizes N,...] [--shapes MxKxN,...] [--threads T,...] [--warmup N] [--reps N]\n"
+        << "                 [--seed N] [--csv FILE] [--json FILE] [--chart-csv FILE] [--baseline FILE.csv [--tolerance X]]\n"
+        << "Exit status: " << BENCH_EXIT_SUCCESS << " ok, " << BENCH_EXIT_REGRESSION << " regression against the baseline, "
+        << BENCH_EXIT_USAGE << " usage error." << endl;
+}
+}
+
+
+// --- Driver ---
+int runBenchmarkSuite(const ArgParser& parser) {
+    BenchOptions options;
+    std::map<string, BaselineEntry> baseline;
+    try {
+        options = parseOptions(parser);
+        if (parser.optionExists("--baseline")) baseline = readBaseline(parser.getOption("--baseline"));
+    }
+    catch (const std::exception& e) {
+        cerr << RED << "Error: " << e.what() << RESET << endl;
+        printUsage();
+        return BENCH_EXIT_USAGE;
+    }
+
+    const string scratch_file = (std::filesystem::temp_directory_path() / "fluminum_bench_matrix.csv").string();
+    cout << CYAN << "Benchmarking on " << getCpuModelName() << " (" << getCpuCoreCount() << " cores): "
+        << options.warmup << " warm-up and " << options.repetitions << " timed runs per case, tile "
+        << G_OPTIMAL_TILE_SIZE << ", Strassen threshold " << G_OPTIMAL_STRASSEN_THRESHOLD << ", operand seed " << options.seed << "." << RESET << endl;
+
+    std::vector<BenchCase> cases;
+    for (const Shape& shape : options.shapes) {
+        Matrix A = Matrix::generateRandom(shape.M, shape.K, options.seed, 0);
+        Matrix B = Matrix::generateRandom(shape.K, shape.N, options.seed, 1);
+        Matrix A_copy = A;
+        Matrix C(shape.M, shape.N);
+        for (const string& engine : options.engines) {
+            if (engine == "csv-read") saveMatrixToFile(A, scratch_file, false);
+            std::vector<unsigned int> thread_counts = isSerialEngine(engine) ? std::vector<unsigned int>{ 1 } : options.threads;
+            for (unsigned int threads : thread_counts) {
+                std::function<void()> run = makeRun(engine, shape, threads, A, B, A_copy, C, scratch_file);
+                if (!run) continue;
+                BenchCase c;
+                c.engine = engine;
+                c.M = shape.M;
+                c.K = shape.K;
+                c.N = shape.N;
+                c.threads = threads;
+                cout << " " << std::left << std::setw(42) << caseKey(engine, shape.M, shape.K, shape.N, threads) << std::flush;
+                c.stats = measure(run, options.warmup, options.repetitions);
+                c.gflops = (c.stats.medianSeconds > 0.0) ? caseFlops(c) / c.stats.medianSeconds / 1e9 : 0.0;
+                cout << "median " << std::fixed << std::setprecision(6) << c.stats.medianSeconds << "s" << endl;
+                cases.push_back(c);
+            }
+        }
+    }
+    std::error_code error;
+    std::filesystem::remove(scratch_file, error);
+
+    cout << endl;
+    print_header_box("Benchmark Results", 100);
+    std::stringstream header;
+    header << " " << std::left << std::setw(42) << "Case" << std::setw(12) << "Median" << std::setw(24) << "p5 - p95"
+        << std::setw(12) << "+/- CI95" << "GFLOP/s";
+    print_line_in_box(header.str(), 100);
+    print_separator_line(100);
+    for (const BenchCase& c : cases) {
+        std::stringstream row, median, range, ci, gflops;
+        median << std::fixed << std::setprecision(6) << c.stats.medianSeconds << "s";
+        range << std::fixed << std::setprecision(6) << c.stats.p5Seconds << " - " << c.stats.p95Seconds;
+        ci << std::fixed << std::setprecision(6) << (c.stats.ci95HighSeconds - c.stats.meanSeconds);
+        if (c.gflops > 0.0) gflops << std::fixed << std::setprecision(2) << c.gflops;
+        row << " " << std::left << std::setw(42) << caseKey(c.engine, c.M, c.K, c.N, c.threads) << std::setw(12) << median.str()
+            << std::setw(24) << range.str() << std::setw(12) << ci.str() << gflops.str();
+        print_line_in_box(row.str(), 100);
+    }
+    print_footer_box(100);
+
+    if (parser.optionExists("--csv") && writeCsv(parser.getOption("--csv"), cases)) {
+        cout << GREEN << "Benchmark results written to " << parser.getOption("--csv") << RESET << endl;
+    }
+    if (parser.optionExists("--json") && writeJson(parser.getOption("--json"), cases, options)) {
+        cout << GREEN << "Benchmark results written to " << parser.getOption("--json") << RESET << endl;
+    }
+    if (parser.optionExists("--chart-csv") && writeChartCsv(parser.getOption("--chart-csv"), cases)) {
+        cout << GREEN << "Chart data written to " << parser.getOption("--chart-csv") << RESET << endl;
+    }
+
+    if (baseline.empty()) return BENCH_EXIT_SUCCESS;
+    cout << endl;
+    const int regressions = compareWithBaseline(cases, baseline, options.tolerance);
+    if (regressions > 0) {
+        cerr << RED << regressions << " case(s) regressed by more than " << options.tolerance * 100.0 << "% against "
+            << parser.getOption("--baseline") << "." << RESET << endl;
+        return BENCH_EXIT_REGRESSION;
+    }
+    cout << GREEN << "No regressions against " << parser.getOption("--baseline") << "." << RESET << endl;
+    return BENCH_EXIT_SUCCESS;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "Common.h"
+#include "ArgParser.h"
+
+// --- Benchmark Suite ---
+// fluminum --bench sweeps engines, shapes and thread counts with warm-up runs and repeated,
+// timed repetitions, and reports robust statistics for every case:
+//   --engines naive,tiled,tiled-parallel,strassen,gemm,compare,csv-read,csv-write  (default: all)
+//                              plus tiled-parallel-morton and strassen-morton (Morton layout)
+//   --sizes 128,256,512        Square sizes        --shapes 300x500x200   M x K x N shapes
+//   --threads 1,4,8            (default: 1 and all cores; serial engines always run on 1)
+//   --warmup N --reps N        (defaults 1 and 7)
+//   --seed N                   Seed of the random operands (default RANDOM_BENCHMARK_SEED)
+//   --csv FILE --json FILE     Full results
+//   --chart-csv FILE           Processor,Threads,OM_Time,SA_Time rows for the Chart scripts
+//                              (OM = naive, SA = Strassen, at the largest square size)
+//   --baseline FILE --tolerance X
+//                              Compares medians with an earlier --csv file; a case regresses
+//                              when its median is more than X (default 0.10) slower and the
+//                              95% confidence intervals do not overlap.
+
+const int BENCH_EXIT_SUCCESS = 0;
+const int BENCH_EXIT_REGRESSION = 1;
+const int BENCH_EXIT_USAGE = 2;
+
+const int BENCH_DEFAULT_WARMUP = 1;
+const int BENCH_DEFAULT_REPETITIONS = 7;
+const double BENCH_DEFAULT_TOLERANCE = 0.10;
+
+// Naive runs above this many multiply-adds are skipped; they would dominate the sweep.
+const double BENCH_NAIVE_MAX_OPERATIONS = 512.0 * 512.0 * 512.0;
+
+struct BenchStatistics {
+    int repetitions = 0;
+    double minSeconds = 0.0;
+    double medianSeconds = 0.0;
+    double p5Seconds = 0.0;
+    double p95Seconds = 0.0;
+    double meanSeconds = 0.0;
+    double stddevSeconds = 0.0;
+    double ci95LowSeconds = 0.0;        // Student-t interval of the mean
+    double ci95HighSeconds = 0.0;
+};
+
+struct BenchCase {
+    string engine;
+    int M = 0, K = 0, N = 0;
+    unsigned int threads = 1;
+    BenchStatistics stats;
+    double gflops = 0.0;                // From the median; 0 for engines that do no arithmetic
+};
+
+// Percentiles use linear interpolation between order statistics.
+BenchStatistics summarizeSamples(std::vector<double> samples);
+
+int runBenchmarkSuite(const ArgParser& parser);
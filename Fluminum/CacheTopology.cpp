@@ -0,0 +1,221 @@
+#define NOMINMAX
+#include "CacheTopology.h"
+#include "Gemm.h"
+#include "System.h"
+
+#if !defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define FLUMINUM_HAS_CPUID
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define FLUMINUM_HAS_CPUID
+#endif
+
+long long CacheLevel::sets() const {
+    if (associativity <= 0 || lineBytes <= 0) return 1;
+    return std::max(1LL, sizeBytes / (static_cast<long long>(associativity) * lineBytes));
+}
+
+const CacheLevel* CacheTopology::dataCache(int level) const {
+    for (const CacheLevel& cache : levels) {
+        if (cache.level == level && cache.type != "Instruction") return &cache;
+    }
+    return nullptr;
+}
+
+// --- Detection ---
+namespace {
+#ifdef FLUMINUM_HAS_CPUID
+void cpuidCount(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned int>(info[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Deterministic cache parameters: leaf 4 on Intel, 0x8000001D on AMD (same layout).
+bool detectFromCpuid(CacheTopology& topology) {
+    unsigned int regs[4];
+    cpuidCount(0, 0, regs);
+    const unsigned int max_leaf = regs[0];
+    const bool amd = (regs[1] == 0x68747541);  // "Auth"enticAMD
+    cpuidCount(0x80000000, 0, regs);
+    const unsigned int max_extended_leaf = regs[0];
+
+    unsigned int leaf = 4;
+    if (amd && max_extended_leaf >= 0x8000001D) leaf = 0x8000001D;
+    else if (max_leaf < 4) return false;
+
+    for (unsigned int index = 0; index < 16; ++index) {
+        cpuidCount(leaf, index, regs);
+        const unsigned int type = regs[0] & 0x1F;
+        if (type == 0) break;
+        CacheLevel cache;
+        cache.level = static_cast<int>((regs[0] >> 5) & 0x7);
+        cache.type = (type == 1) ? "Data" : (type == 2) ? "Instruction" : "Unified";
+        cache.sharedByLogicalCpus = static_cast<int>(((regs[0] >> 14) & 0xFFF) + 1);
+        cache.lineBytes = static_cast<int>((regs[1] & 0xFFF) + 1);
+        const long long partitions = ((regs[1] >> 12) & 0x3FF) + 1;
+        const long long ways = ((regs[1] >> 22) & 0x3FF) + 1;
+        const long long sets = static_cast<long long>(regs[2]) + 1;
+        cache.associativity = ((regs[0] >> 9) & 1) ? 0 : static_cast<int>(ways);
+        cache.sizeBytes = ways * partitions * cache.lineBytes * sets;
+        topology.levels.push_back(cache);
+    }
+    if (topology.levels.empty()) return false;
+    topology.source = "cpuid";
+    return true;
+}
+#endif
+
+#ifndef _WIN32
+string readSysfsValue(const string& path) {
+    std::ifstream file(path);
+    string value;
+    std::getline(file, value);
+    return value;
+}
+
+// "32K", "1024K", "32M"
+long long parseCacheSize(const string& text) {
+    if (text.empty()) return 0;
+    long long value = std::atoll(text.c_str());
+    switch (text.back()) {
+    case 'K': return value * 1024;
+    case 'M': return value * 1024 * 1024;
+    case 'G': return value * 1024 * 1024 * 1024;
+    default: return value;
+    }
+}
+
+// "0-3,8-11" -> 8
+int countCpuList(const string& list) {
+    int count = 0;
+    std::stringstream ss(list);
+    string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        if (dash == string::npos) ++count;
+        else count += std::atoi(range.c_str() + dash + 1) - std::atoi(range.c_str()) + 1;
+    }
+    return std::max(1, count);
+}
+
+bool detectFromSysfs(CacheTopology& topology) {
+    const string base = "/sys/devices/system/cpu/cpu0/cache/index";
+    for (int index = 0; index < 16; ++index) {
+        const string dir = base + std::to_string(index) + "/";
+        const string level = readSysfsValue(dir + "level");
+        if (level.empty()) break;
+        CacheLevel cache;
+        cache.level = std::atoi(level.c_str());
+        cache.type = readSysfsValue(dir + "type");
+        cache.sizeBytes = parseCacheSize(readSysfsValue(dir + "size"));
+        const string line = readSysfsValue(dir + "coherency_line_size");
+        if (!line.empty()) cache.lineBytes = std::atoi(line.c_str());
+        const string ways = readSysfsValue(dir + "ways_of_associativity");
+        if (!ways.empty()) cache.associativity = std::atoi(ways.c_str());
+        cache.sharedByLogicalCpus = countCpuList(readSysfsValue(dir + "shared_cpu_list"));
+        if (cache.sizeBytes > 0) topology.levels.push_back(cache);
+    }
+    if (topology.levels.empty()) return false;
+    topology.source = "sysfs";
+    return true;
+}
+#endif
+
+// A common desktop hierarchy for machines where nothing can be read.
+void useDefaultTopology(CacheTopology& topology) {
+    topology.levels.clear();
+    topology.levels.push_back({ 1, "Data", 32 * 1024, 64, 8, 2 });
+    topology.levels.push_back({ 2, "Unified", 512 * 1024, 64, 8, 2 });
+    topology.levels.push_back({ 3, "Unified", 8 * 1024 * 1024, 64, 16, static_cast<int>(getCpuCoreCount()) });
+    topology.source = "defaults";
+}
+}
+
+const CacheTopology& getCacheTopology() {
+    static const CacheTopology topology = [] {
+        CacheTopology detected;
+        bool found = false;
+#ifndef _WIN32
+        found = detectFromSysfs(detected);
+#endif
+#ifdef FLUMINUM_HAS_CPUID
+        if (!found) found = detectFromCpuid(detected);
+#endif
+        if (!found || detected.dataCache(1) == nullptr) useDefaultTopology(detected);
+        std::sort(detected.levels.begin(), detected.levels.end(),
+            [](const CacheLevel& a, const CacheLevel& b) { return a.level < b.level; });
+        return detected;
+    }();
+    return topology;
+}
+
+
+// --- Analytic Model ---
+AnalyticBlocking deriveBlockingParameters(const CacheTopology& topology, int mr, int nr) {
+    const long long element = sizeof(double);
+    AnalyticBlocking blocking;
+    const CacheLevel* l1 = topology.dataCache(1);
+    const CacheLevel* l2 = topology.dataCache(2);
+    const CacheLevel* l3 = topology.dataCache(3);
+
+    // kc: the kc x NR sliver of B is reused by every MR-row strip of A streaming past it, so
+    // one L1 way is kept free and the rest is split in the MR:NR ratio (Low et al., eq. 2).
+    const int l1_ways = (l1 && l1->associativity > 1) ? l1->associativity : 8;
+    const long long l1_way_bytes = l1 ? l1->sets() * l1->lineBytes : 4096;
+    const int a_ways = std::max(1, static_cast<int>((l1_ways - 1) / (1.0 + static_cast<double>(nr) / mr)));
+    blocking.kc = static_cast<int>(a_ways * l1_way_bytes / (mr * element));
+    blocking.kc = std::max(64, std::min(1024, blocking.kc / 8 * 8));
+
+    // mc: the packed A block fills L2 except one way and the B sliver streaming through.
+    const long long l2_bytes = l2 ? l2->sizeBytes : 256 * 1024;
+    const int l2_ways = (l2 && l2->associativity > 1) ? l2->associativity : 8;
+    const long long a_block_bytes = l2_bytes * (l2_ways - 1) / l2_ways - static_cast<long long>(blocking.kc) * nr * element;
+    blocking.mc = static_cast<int>(a_block_bytes / (blocking.kc * element));
+    blocking.mc = std::max(mr, std::min(2048, blocking.mc / mr * mr));
+
+    // nc: the packed B panel (shared by all workers) takes half of L3, the rest is left for
+    // the C rows and the other cores' traffic. Without an L3 it gets a few times L2.
+    const long long l3_bytes = l3 ? l3->sizeBytes : 4 * l2_bytes;
+    const int l3_ways = (l3 && l3->associativity > 1) ? l3->associativity : 16;
+    blocking.nc = static_cast<int>(l3_bytes * (l3_ways - 1) / l3_ways / 2 / (blocking.kc * element));
+    blocking.nc = std::max(nr, std::min(8192, blocking.nc / nr * nr));
+
+    // Square tiles: three of them (A, B and C) in L1.
+    const long long l1_bytes = l1 ? l1->sizeBytes : 32 * 1024;
+    blocking.tileSize = static_cast<int>(std::sqrt(static_cast<double>(l1_bytes) / (3 * element)));
+    blocking.tileSize = std::max(8, blocking.tileSize / 8 * 8);
+
+    // Strassen base case: three threshold-sized operands of the tiled multiply in L2.
+    blocking.strassenThreshold = 32;
+    while (blocking.strassenThreshold < 512 &&
+        3 * element * (2LL * blocking.strassenThreshold) * (2LL * blocking.strassenThreshold) <= l2_bytes) {
+        blocking.strassenThreshold *= 2;
+    }
+    return blocking;
+}
+
+const AnalyticBlocking& getAnalyticBlocking() {
+    static const AnalyticBlocking blocking = deriveBlockingParameters(getCacheTopology(), GEMM_SIMD_MR, GEMM_SIMD_NR);
+    return blocking;
+}
+
+string describeCacheTopology(const CacheTopology& topology) {
+    std::stringstream ss;
+    bool first = true;
+    for (const CacheLevel& cache : topology.levels) {
+        if (cache.type == "Instruction") continue;
+        ss << (first ? "" : ", ") << "L" << cache.level << (cache.type == "Data" ? "d " : " ");
+        if (cache.sizeBytes >= 1024 * 1024 && cache.sizeBytes % (1024 * 1024) == 0) ss << cache.sizeBytes / (1024 * 1024) << "M";
+        else ss << cache.sizeBytes / 1024 << "K";
+        if (cache.associativity > 0) ss << " " << cache.associativity << "-way";
+        if (cache.sharedByLogicalCpus > 2) ss << " (shared by " << cache.sharedByLogicalCpus << ")";
+        first = false;
+    }
+    return ss.str();
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "Common.h"
+
+// --- Cache Topology ---
+// The data cache hierarchy of the first CPU, from sysfs (cache/index*) on Linux or cpuid
+// (leaf 4, or 0x8000001D on AMD) elsewhere, and the blocking parameters derived from it.
+
+struct CacheLevel {
+    int level = 0;                // 1, 2, 3...
+    string type;                  // "Data", "Instruction" or "Unified"
+    long long sizeBytes = 0;
+    int lineBytes = 64;
+    int associativity = 8;        // Ways; 0 when fully associative or unknown
+    int sharedByLogicalCpus = 1;
+
+    long long sets() const;
+};
+
+struct CacheTopology {
+    std::vector<CacheLevel> levels;   // Sorted by level
+    string source;                    // "sysfs", "cpuid" or "defaults"
+
+    // Data or unified cache of the given level, nullptr when absent.
+    const CacheLevel* dataCache(int level) const;
+};
+
+// Blocking derived from the topology with the analytic model of Low et al. (2016):
+// kc so that an MR x kc sliver of A plus a kc x NR sliver of B stay in L1, mc so that the
+// packed mc x kc block of A stays in L2, nc so that the packed kc x nc panel of B stays in L3.
+struct AnalyticBlocking {
+    int mc = 0;
+    int kc = 0;
+    int nc = 0;
+    int tileSize = 0;             // Square tile with three tiles in L1 (tiled engine, Strassen base)
+    int strassenThreshold = 0;    // Largest power of two with three operands in L2
+};
+
+// Detected once and cached.
+const CacheTopology& getCacheTopology();
+
+AnalyticBlocking deriveBlockingParameters(const CacheTopology& topology, int mr, int nr);
+
+// deriveBlockingParameters for this machine and the SIMD micro-kernel, computed once.
+const AnalyticBlocking& getAnalyticBlocking();
+
+// e.g. "L1d 32K 8-way, L2 1M 16-way, L3 32M 11-way (shared by 16)"
+string describeCacheTopology(const CacheTopology& topology);
@@ -0,0 +1,256 @@
+#define NOMINMAX
+#include "Chain.h"
+#include "Matrix.h"
+#include "Algorithm.h"
+#include "CostModel.h"
+#include "Gemm.h"
+#include "System.h"
+#include <memory>
+
+// --- Planning ---
+struct ChainPlan {
+    std::vector<std::vector<double>> seconds;   // Predicted time of the best plan for A_i..A_j
+    std::vector<std::vector<long long>> flops;  // FLOPs of that plan
+    std::vector<std::vector<int>> split;        // A_i..A_s times A_{s+1}..A_j
+};
+
+// dims has k + 1 entries: A_i is dims[i] x dims[i + 1].
+static ChainPlan planChain(const std::vector<int>& dims, unsigned int threads) {
+    const int k = static_cast<int>(dims.size()) - 1;
+    ChainPlan plan;
+    plan.seconds.assign(k, std::vector<double>(k, 0.0));
+    plan.flops.assign(k, std::vector<long long>(k, 0));
+    plan.split.assign(k, std::vector<int>(k, -1));
+
+    for (int length = 2; length <= k; ++length) {
+        for (int i = 0; i + length - 1 < k; ++i) {
+            const int j = i + length - 1;
+            plan.seconds[i][j] = std::numeric_limits<double>::max();
+            for (int s = i; s < j; ++s) {
+                double step_seconds = 0.0;
+                selectFastestGemmEngine(dims[i], dims[j + 1], dims[s + 1], threads, &step_seconds);
+                double total = plan.seconds[i][s] + plan.seconds[s + 1][j] + step_seconds;
+                if (total < plan.seconds[i][j]) {
+                    plan.seconds[i][j] = total;
+                    plan.split[i][j] = s;
+                    plan.flops[i][j] = plan.flops[i][s] + plan.flops[s + 1][j] + 2LL * dims[i] * dims[s + 1] * dims[j + 1];
+                }
+            }
+        }
+    }
+    return plan;
+}
+
+
+// --- Plan Tree ---
+struct ChainNode {
+    int left = -1, right = -1;  // Child nodes; -1 for inputs
+    int rows = 0, cols = 0, inner = 0;
+    int height = 0;             // 0 for inputs; a product runs after all lower heights
+    int buffer = -1;            // Intermediate buffer holding this product, if any
+    string expression;
+    ConstMatrixView view;       // Where the value lives once computed
+};
+
+static int buildChainTree(const ChainPlan& plan, const std::vector<const Matrix*>& chain, int i, int j, std::vector<ChainNode>& nodes) {
+    ChainNode node;
+    if (i == j) {
+        node.rows = chain[i]->rows();
+        node.cols = chain[i]->cols();
+        node.expression = "A" + std::to_string(i + 1);
+        node.view = ConstMatrixView(*chain[i]);
+    }
+    else {
+        const int s = plan.split[i][j];
+        node.left = buildChainTree(plan, chain, i, s, nodes);
+        node.right = buildChainTree(plan, chain, s + 1, j, nodes);
+        const ChainNode& l = nodes[node.left];
+        const ChainNode& r = nodes[node.right];
+        node.rows = l.rows;
+        node.cols = r.cols;
+        node.inner = l.cols;
+        node.height = std::max(l.height, r.height) + 1;
+        node.expression = "(" + l.expression + "*" + r.expression + ")";
+    }
+    nodes.push_back(node);
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+
+// --- Intermediate Buffers ---
+// Best-fit recycling: a product takes the smallest free buffer that is large enough.
+class ChainBufferPool {
+public:
+    int acquire(size_t elements) {
+        int best = -1;
+        for (size_t b = 0; b < buffers_.size(); ++b) {
+            if (!in_use_[b] && buffers_[b].capacity() >= elements &&
+                (best < 0 || buffers_[b].capacity() < buffers_[best].capacity())) {
+                best = static_cast<int>(b);
+            }
+        }
+        if (best >= 0) {
+            ++reused_;
+        }
+        else {
+            buffers_.emplace_back();
+            in_use_.push_back(false);
+            best = static_cast<int>(buffers_.size()) - 1;
+            ++allocated_;
+        }
+        buffers_[best].resize(elements);
+        in_use_[best] = true;
+        return best;
+    }
+
+    void release(int buffer) {
+        if (buffer >= 0) in_use_[buffer] = false;
+    }
+
+    double* data(int buffer) { return buffers_[buffer].data(); }
+    int allocated() const { return allocated_; }
+    int reused() const { return reused_; }
+
+private:
+    std::vector<std::vector<double>> buffers_;
+    std::vector<bool> in_use_;
+    int allocated_ = 0;
+    int reused_ = 0;
+};
+
+
+// --- Execution ---
+ChainMultiplicationResult multiplyChain(const std::vector<const Matrix*>& chain, unsigned int num_threads_request) {
+    if (chain.empty()) throw std::invalid_argument("Matrix chain must contain at least one matrix.");
+    for (size_t i = 0; i < chain.size(); ++i) {
+        if (!chain[i]) throw std::invalid_argument("Null matrix in chain at position " + std::to_string(i + 1) + ".");
+        if (i > 0 && chain[i - 1]->cols() != chain[i]->rows()) {
+            throw std::invalid_argument("Matrix chain dimensions incompatible between A" + std::to_string(i) + " and A" + std::to_string(i + 1) + ".");
+        }
+    }
+
+    ChainMultiplicationResult result_obj;
+    MatrixAllocationStats alloc_start = getMatrixAllocationStats();
+    unsigned int hardware_cores = getCpuCoreCount();
+    result_obj.coresDetected = hardware_cores;
+    result_obj.threadsUsed = (num_threads_request == 0) ? getDefaultThreadCount() : std::min(num_threads_request, hardware_cores);
+    if (result_obj.threadsUsed == 0) result_obj.threadsUsed = 1;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // --- Plan ---
+    std::vector<int> dims;
+    for (const Matrix* m : chain) dims.push_back(m->rows());
+    dims.push_back(chain.back()->cols());
+    const int k = static_cast<int>(chain.size());
+
+    ChainPlan plan = planChain(dims, result_obj.threadsUsed);
+    for (int j = 1; j < k; ++j) {
+        double step_seconds = 0.0;
+        selectFastestGemmEngine(dims[0], dims[j + 1], dims[j], result_obj.threadsUsed, &step_seconds);
+        result_obj.leftToRightPredictedSeconds += step_seconds;
+        result_obj.leftToRightFlops += 2LL * dims[0] * dims[j] * dims[j + 1];
+    }
+    result_obj.plannedFlops = plan.flops[0][k - 1];
+
+    std::vector<ChainNode> nodes;
+    nodes.reserve(2 * k);
+    const int root = buildChainTree(plan, chain, 0, k - 1, nodes);
+    result_obj.plan = nodes[root].expression;
+    result_obj.planningSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    if (k == 1) {
+        result_obj.resultMatrix = *chain[0];
+        result_obj.durationSeconds_chrono = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        result_obj.allocationStats = matrixAllocationsSince(alloc_start);
+        result_obj.memoryInfo = getProcessMemoryUsage();
+        return result_obj;
+    }
+
+    // --- Execute in waves: every product of one height only depends on lower heights ---
+    result_obj.resultMatrix = Matrix(nodes[root].rows, nodes[root].cols);
+    ChainBufferPool buffers;
+    std::vector<std::vector<int>> waves(nodes[root].height + 1);
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        if (nodes[n].height > 0) waves[nodes[n].height].push_back(static_cast<int>(n));
+    }
+    size_t widest = 1;
+    for (const auto& wave : waves) widest = std::max(widest, wave.size());
+    std::unique_ptr<ThreadPool> wave_pool;
+    if (widest > 1 && result_obj.threadsUsed > 1) {
+        wave_pool = std::make_unique<ThreadPool>(std::min<size_t>(widest, result_obj.threadsUsed));
+    }
+
+    for (size_t h = 1; h < waves.size(); ++h) {
+        const std::vector<int>& wave = waves[h];
+        const unsigned int threads_per_product = std::max(1u, result_obj.threadsUsed / static_cast<unsigned int>(wave.size()));
+        std::vector<ChainStepReport> reports(wave.size());
+        std::vector<MatrixView> outputs(wave.size());
+        std::vector<GemmEngine> engines(wave.size());
+
+        double wave_predicted = 0.0;
+        for (size_t w = 0; w < wave.size(); ++w) {
+            ChainNode& node = nodes[wave[w]];
+            if (wave[w] == root) {
+                outputs[w] = MatrixView(result_obj.resultMatrix);
+            }
+            else {
+                node.buffer = buffers.acquire(static_cast<size_t>(node.rows) * node.cols);
+                outputs[w] = MatrixView(buffers.data(node.buffer), node.rows, node.cols, node.cols);
+            }
+            node.view = outputs[w];
+
+            ChainStepReport& report = reports[w];
+            report.expression = node.expression;
+            report.M = node.rows;
+            report.N = node.cols;
+            report.K = node.inner;
+            report.threads = threads_per_product;
+            engines[w] = selectFastestGemmEngine(node.rows, node.cols, node.inner, threads_per_product, &report.predictedSeconds);
+            report.engine = getGemmEngineName(engines[w]);
+            wave_predicted = std::max(wave_predicted, report.predictedSeconds);
+        }
+        result_obj.predictedSeconds += wave_predicted;
+
+        auto run_product = [&](size_t w) {
+            const ChainNode& node = nodes[wave[w]];
+            GemmOptions options;
+            options.engine = engines[w];
+            options.threads = threads_per_product;
+            GemmResult r = gemm(Transpose::None, Transpose::None, 1.0, nodes[node.left].view, nodes[node.right].view, 0.0, outputs[w], options);
+            reports[w].actualSeconds = r.durationSeconds_chrono;
+        };
+
+        if (wave.size() == 1 || !wave_pool) {
+            for (size_t w = 0; w < wave.size(); ++w) run_product(w);
+        }
+        else {
+            std::vector<std::future<void>> futures;
+            for (size_t w = 0; w < wave.size(); ++w) futures.emplace_back(wave_pool->enqueue(run_product, w));
+            waitForAll(futures);
+            for (auto& f : futures) f.get();
+        }
+
+        // Operands consumed by this wave are free for the next one.
+        for (int n : wave) {
+            buffers.release(nodes[nodes[n].left].buffer);
+            buffers.release(nodes[nodes[n].right].buffer);
+        }
+        for (ChainStepReport& report : reports) result_obj.steps.push_back(std::move(report));
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    result_obj.durationSeconds_chrono = std::chrono::duration<double>(end - start).count();
+    result_obj.buffersAllocated = buffers.allocated();
+    result_obj.buffersReused = buffers.reused();
+    result_obj.allocationStats = matrixAllocationsSince(alloc_start);
+    result_obj.memoryInfo = getProcessMemoryUsage();
+    return result_obj;
+}
+
+ChainMultiplicationResult multiplyChain(const std::vector<Matrix>& chain, unsigned int num_threads_request) {
+    std::vector<const Matrix*> pointers;
+    pointers.reserve(chain.size());
+    for (const Matrix& m : chain) pointers.push_back(&m);
+    return multiplyChain(pointers, num_threads_request);
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "Common.h"
+
+// --- Matrix-Chain Multiplication ---
+// Computes A1 * A2 * ... * Ak. The parenthesization is chosen by dynamic programming over the
+// predicted time of every sub-product (see CostModel.h), so both the FLOP count and the
+// measured speed of each engine at each shape are taken into account. Sub-products that do
+// not depend on each other run concurrently, and intermediate results live in a small pool
+// of buffers that are recycled once consumed.
+
+ChainMultiplicationResult multiplyChain(const std::vector<const Matrix*>& chain, unsigned int num_threads_request = 0);
+ChainMultiplicationResult multiplyChain(const std::vector<Matrix>& chain, unsigned int num_threads_request = 0);
@@ -1,7 +1,14 @@
 #pragma once
 
-// --- Standard Library Includes ---
+// --- Platform Headers ---
+#ifdef _WIN32
 #include <windows.h>
+#pragma comment(lib, "Psapi.lib")
+#else
+#include <cstring>
+#endif
+
+// --- Standard Library Includes ---
 #include <iostream>
 #include <vector>
 #include <string>
@@ -40,8 +47,6 @@ const int SIMD_VECTOR_SIZE_DOUBLE = 2;
 const int SIMD_VECTOR_SIZE_DOUBLE = 1;
 #endif
 
-#pragma comment(lib, "Psapi.lib")
-
 // --- Global Using Declarations ---
 using std::string;
 using std::cout;
@@ -78,21 +83,68 @@ enum class Alignment { Left, Center, Right };
 // Forward declaration of Matrix class to resolve dependencies
 class Matrix;
 
+// Matrix buffer traffic, counted process-wide by Matrix's constructors and assignments.
+// Results hold the difference between the counters at the start and end of a run.
+struct MatrixAllocationStats {
+    long long allocations = 0;
+    long long allocatedBytes = 0;
+    long long copies = 0;      // Deep copies of a whole Matrix (copy construction or assignment)
+    long long copiedBytes = 0;
+    long long moves = 0;
+};
+
 // Structs for system info and results
 struct SystemMemoryInfo {
     unsigned long long totalPhysicalMB;
     unsigned long long availablePhysicalMB;
 };
 
+// Snapshot of this process. Peak/current are the working set on Windows and VmHWM/VmRSS on Linux.
 struct ProcessMemoryInfo {
     size_t peakWorkingSetMB;
+    size_t currentWorkingSetMB = 0;
+    long long pageFaults = 0;       // All page faults since process start
+    long long majorPageFaults = 0;  // Faults that needed I/O (Linux only)
+};
+
+// The hard memory cap set with --memory-budget (see System.h).
+struct MemoryBudget {
+    double requestedMB = 0.0;       // 0 = no budget
+    double enforcedMB = 0.0;        // The request, capped by the cgroup limit and physical memory
+    string limitedBy;               // "--memory-budget", "cgroup limit" or "physical memory"
+};
+
+// Phases a run is broken into for hardware counters. Total covers the whole call on every thread.
+enum class CounterPhase { Total, Padding, Split, BaseMultiply, Combine, Unpad };
+const int COUNTER_PHASE_COUNT = 6;
+
+// Hardware event counts of one phase (perf_event_open on Linux). -1 means the event was not measured.
+struct HardwareCounterValues {
+    bool valid = false;
+    long long cycles = -1;
+    long long instructions = -1;
+    long long l1dMisses = -1;
+    long long llcMisses = -1;
+    long long dtlbMisses = -1;
+    long long fpOps = -1;   // Double-precision FLOPs from FP_ARITH_INST_RETIRED (Intel only)
+};
+
+// Filled in by readMatrixFromFile so callers can pick the sparse path without rescanning.
+struct MatrixFileInfo {
+    long long nonZeroCount = 0;
+    long long totalElements = 0;
+    double density = 1.0;
+    bool sparseCandidate = false;
 };
 
+// Storage of the operands while Strassen or the parallel tiled engine runs (see Morton.h).
+enum class MatrixLayout { RowMajor, Morton };
+
 struct MultiplicationResult {
     Matrix resultMatrix;
     double durationSeconds_chrono;
     long long durationNanoseconds_chrono;
-    double durationSeconds_qpc;
+    double durationSeconds_qpc; // Platform high-resolution counter (QPC / CLOCK_MONOTONIC_RAW)
     unsigned int threadsUsed;
     unsigned int coresDetected;
     ProcessMemoryInfo memoryInfo;
@@ -107,6 +159,11 @@ struct MultiplicationResult {
     double padding_duration_sec = 0.0;
     double unpadding_duration_sec = 0.0;
 
+    // Resident-set growth per phase in MB (negative when memory went back to the OS)
+    double padding_rss_delta_mb = 0.0;
+    double compute_rss_delta_mb = 0.0;
+    double unpadding_rss_delta_mb = 0.0;
+
     // Strassen-specific detailed timings
     bool strassen_applied_at_top_level = false;
     double first_level_split_sec = 0.0;
@@ -115,10 +172,132 @@ struct MultiplicationResult {
     double first_level_C_quad_calc_sec = 0.0;
     double first_level_final_combine_sec = 0.0;
 
+    // Sparse engine statistics (zero for dense algorithms)
+    bool sparse_path_used = false;
+    long long nnzA = 0;
+    long long nnzB = 0;
+    long long nnzResult = 0;
+    long long effective_flops = 0; // Multiply-adds actually performed, counted as 2 FLOPs each
+
+    // Set by the automatic algorithm selection (zero otherwise), logged next to the actual figures
+    double predicted_seconds = 0.0;
+    double predicted_peak_memory_mb = 0.0;
+
+    // Degenerate shapes (matrix-vector, outer product, ...) routed to their streaming kernels
+    // instead of the requested algorithm; empty for general products
+    string shape_path;
+
+    // Operands generated from random: sources (see Random.h) instead of read from files, and the
+    // seed that reproduces them
+    bool random_operands = false;
+    unsigned long long random_seed = 0;
+
+    // Operands converted to the Morton layout for the computation (conversions timed as padding
+    // and unpadding)
+    MatrixLayout layout = MatrixLayout::RowMajor;
+
+    // Memory budget: what this product was allowed to use (0 without --memory-budget), and how
+    // the algorithm was shrunk or replaced to stay under it (empty when it fitted as asked)
+    double memory_budget_mb = 0.0;
+    string memory_adaptation;
+
+    // Result cache (see ResultCache.h): "hit" or "miss", empty when the cache is off
+    string cache_status;
+    string cache_key;
+    double cache_lookup_seconds = 0.0;      // Operand hashing plus the memory or disk lookup
+    double cached_compute_seconds = 0.0;    // On a hit, how long the stored result took to compute
+
+    // Matrix power statistics (zero for single products)
+    long long power_exponent = 0;
+    int power_squarings = 0;
+    int power_multiplies = 0;
+    bool symmetric_path_used = false;
+
+    MatrixAllocationStats allocationStats;
+
+    // Indexed by CounterPhase; all invalid when counters are off or not permitted.
+    HardwareCounterValues hardwareCounters[COUNTER_PHASE_COUNT];
+
     MultiplicationResult(); // Constructor defined in Algorithms.cpp
 };
 
 
+struct BatchedMultiplicationResult {
+    int batchCount = 0;
+    int rowsA = 0, colsA = 0, colsB = 0;
+    double durationSeconds_chrono = 0.0;
+    unsigned int threadsUsed = 0;
+    unsigned int coresDetected = 0;
+    string kernel_used;
+    double problemsPerSecond = 0.0;
+    double gflops = 0.0;
+};
+
+// One multiplication inside a chain product, in execution order.
+struct ChainStepReport {
+    string expression;
+    int M = 0, N = 0, K = 0;
+    string engine;
+    unsigned int threads = 0;
+    double predictedSeconds = 0.0;
+    double actualSeconds = 0.0;
+};
+
+struct ChainMultiplicationResult {
+    Matrix resultMatrix;
+    string plan;                        // e.g. "((A1*A2)*(A3*A4))"
+    long long plannedFlops = 0;
+    long long leftToRightFlops = 0;
+    double predictedSeconds = 0.0;
+    double leftToRightPredictedSeconds = 0.0;
+    double planningSeconds = 0.0;
+    double durationSeconds_chrono = 0.0;
+    unsigned int threadsUsed = 0;
+    unsigned int coresDetected = 0;
+    int buffersAllocated = 0;
+    int buffersReused = 0;
+    std::vector<ChainStepReport> steps;
+    MatrixAllocationStats allocationStats;
+    ProcessMemoryInfo memoryInfo = { 0 };
+};
+
+// Algorithms the automatic selection chooses between (see CostModel.h).
+enum class MultiplyAlgorithm { Naive, Tiled, TiledParallel, Strassen };
+
+struct AlgorithmCandidate {
+    MultiplyAlgorithm algorithm = MultiplyAlgorithm::TiledParallel;
+    int strassenThreshold = 0;          // Strassen only
+    int tileSize = 0;
+    unsigned int threads = 1;
+    int strassenAsyncDepth = -1;        // Strassen levels that fan out; -1 = log7(threads)
+    bool depthFirst = false;            // Strassen serial levels in the memory-lean order
+    MatrixLayout layout = MatrixLayout::RowMajor; // Strassen and TiledParallel only
+    double predictedSeconds = 0.0;
+    double predictedPeakMemoryMB = 0.0; // Operands and result included
+    bool feasible = true;               // Predicted peak fits the memory limit
+    string memoryAdaptation;            // How it was shrunk to fit the limit (fitCandidateToMemory)
+    bool fittedToProduct = false;       // Set by fitCandidateToProduct; multiplyWithAlgorithm runs it as is
+    double memoryLimitMB = 0.0;         // The budget it was fitted to (0 without one)
+};
+
+struct AlgorithmPlan {
+    int M = 0, N = 0, K = 0;
+    AlgorithmCandidate chosen;
+    std::vector<AlgorithmCandidate> candidates;   // In evaluation order
+    double memoryLimitMB = 0.0;
+};
+
+struct GemmResult {
+    string engine_used;
+    string shape;                       // getGemmShapeName of the product
+    int M = 0, N = 0, K = 0;
+    double durationSeconds_chrono = 0.0;
+    unsigned int threadsUsed = 0;
+    unsigned int coresDetected = 0;
+    double gflops = 0.0;
+    MatrixAllocationStats allocationStats;
+};
+
 struct ComparisonResult {
     long long matchCount;
     double durationSeconds_chrono;
@@ -130,6 +309,7 @@ struct ComparisonResult {
     int comparisonThreshold;
     double epsilon;
     int originalRows, originalCols;
+    MatrixAllocationStats allocationStats;
 
     ComparisonResult(); // Constructor defined in Algorithms.cpp
 };
\ No newline at end of file
@@ -0,0 +1,647 @@
+#define NOMINMAX
+#include "CostModel.h"
+#include "Matrix.h"
+#include "Random.h"
+#include "System.h"
+#include "HardwareCounters.h"
+#include "IO.h"
+#include "Morton.h"
+#include "Sparse.h"
+
+// --- Calibration State ---
+namespace {
+struct EngineCalibration {
+    std::once_flag once;
+    bool calibrated = false;
+    unsigned int threads = 1;
+    std::vector<EngineSpeedSample> tiled;
+    std::vector<EngineSpeedSample> simd;
+    std::vector<EngineSpeedSample> strassen;
+};
+
+EngineCalibration& calibrationState() {
+    static EngineCalibration state;
+    return state;
+}
+
+// Strassen only pays off once the padded problem spans a few base cases.
+const int STRASSEN_MIN_MODEL_SIZE = 2 * GEMM_DEFAULT_STRASSEN_THRESHOLD;
+
+double timeGemm(GemmEngine engine, int n) {
+    Matrix A = Matrix::generateRandom(n, n, RANDOM_BENCHMARK_SEED, 0);
+    Matrix B = Matrix::generateRandom(n, n, RANDOM_BENCHMARK_SEED, 1);
+    Matrix C(n, n);
+    GemmOptions options;
+    options.engine = engine;
+    double best = std::numeric_limits<double>::max();
+    for (int run = 0; run < 2; ++run) {
+        GemmResult r = gemm(Transpose::None, Transpose::None, 1.0, A, B, 0.0, C, options);
+        best = std::min(best, r.durationSeconds_chrono);
+    }
+    return best;
+}
+
+std::vector<EngineSpeedSample> measure(GemmEngine engine, const std::vector<int>& sizes, bool verbose) {
+    std::vector<EngineSpeedSample> samples;
+    for (int n : sizes) {
+        double seconds = std::max(timeGemm(engine, n), 1e-9);
+        samples.push_back({ n, 2.0 * n * n * static_cast<double>(n) / seconds / 1e9 });
+        if (verbose) cout << getGemmEngineName(engine) << "@" << n << "... " << std::flush;
+    }
+    return samples;
+}
+
+double interpolateGflops(const std::vector<EngineSpeedSample>& samples, double size) {
+    if (samples.empty()) return 1.0;
+    if (size <= samples.front().size) return samples.front().gflops;
+    if (size >= samples.back().size) return samples.back().gflops;
+    for (size_t i = 1; i < samples.size(); ++i) {
+        if (size <= samples[i].size) {
+            double x0 = std::log(static_cast<double>(samples[i - 1].size));
+            double x1 = std::log(static_cast<double>(samples[i].size));
+            double t = (std::log(size) - x0) / (x1 - x0);
+            return samples[i - 1].gflops + t * (samples[i].gflops - samples[i - 1].gflops);
+        }
+    }
+    return samples.back().gflops;
+}
+}
+
+void calibrateEngineSpeeds(bool verbose) {
+    EngineCalibration& state = calibrationState();
+    std::call_once(state.once, [&state, verbose] {
+        if (verbose) cout << CYAN << "Calibrating multiplication engine speeds..." << RESET << endl << "Benchmarking: ";
+        state.threads = getCpuCoreCount();
+        state.tiled = measure(GemmEngine::Tiled, { 32, 96, 256 }, verbose);
+#ifdef HAS_AVX
+        state.simd = measure(GemmEngine::Simd, { 32, 96, 256 }, verbose);
+#else
+        state.simd = state.tiled;
+#endif
+        state.strassen = measure(GemmEngine::Strassen, { STRASSEN_MIN_MODEL_SIZE, 2 * STRASSEN_MIN_MODEL_SIZE }, verbose);
+        state.calibrated = true;
+        if (verbose) cout << endl << GREEN << "Engine calibration complete." << RESET << endl << endl;
+    });
+}
+
+bool isEngineSpeedCalibrated() {
+    return calibrationState().calibrated;
+}
+
+const std::vector<EngineSpeedSample>& getEngineSpeedSamples(GemmEngine engine) {
+    calibrateEngineSpeeds(false);
+    EngineCalibration& state = calibrationState();
+    switch (engine) {
+    case GemmEngine::Tiled: return state.tiled;
+    case GemmEngine::Strassen: return state.strassen;
+    default: return state.simd;
+    }
+}
+
+
+// --- Prediction ---
+double predictGemmSeconds(GemmEngine engine, int M, int N, int K, unsigned int threads) {
+    if (M <= 0 || N <= 0 || K <= 0) return 0.0;
+    calibrateEngineSpeeds(false);
+    const EngineCalibration& state = calibrationState();
+
+    double flops;
+    double size;
+    if (engine == GemmEngine::Strassen) {
+        size = nextPowerOf2(std::max({ M, N, K }));
+        flops = 2.0 * size * size * size;
+    }
+    else {
+        size = std::cbrt(static_cast<double>(M) * N * K);
+        flops = 2.0 * M * N * static_cast<double>(K);
+    }
+    double gflops = std::max(interpolateGflops(getEngineSpeedSamples(engine), size), 1e-3);
+
+    // Assume linear scaling between the calibrated thread count and the one requested.
+    unsigned int cores = getCpuCoreCount();
+    unsigned int used = (threads == 0) ? getDefaultThreadCount() : std::min(threads, cores);
+    double thread_scale = static_cast<double>(std::max(1u, state.threads)) / std::max(1u, used);
+    return flops / (gflops * 1e9) * std::max(1.0, thread_scale);
+}
+
+GemmEngine selectFastestGemmEngine(int M, int N, int K, unsigned int threads, double* predicted_seconds) {
+    // Degenerate shapes always take their streaming kernels (predicted at the SIMD engine's speed).
+    if (classifyGemmShape(M, N, K) != GemmShape::General) {
+        if (predicted_seconds) *predicted_seconds = predictGemmSeconds(GemmEngine::Shape, M, N, K, threads);
+        return GemmEngine::Shape;
+    }
+    GemmEngine best = (selectGemmEngine(M, N, K, Transpose::None, Transpose::None, 1.0, 0.0) == GemmEngine::Fixed)
+        ? GemmEngine::Fixed : GemmEngine::Tiled;
+    double best_seconds = predictGemmSeconds(best, M, N, K, threads);
+
+    std::vector<GemmEngine> candidates;
+#ifdef HAS_AVX
+    candidates.push_back(GemmEngine::Simd);
+#endif
+    if (std::min({ M, N, K }) >= STRASSEN_MIN_MODEL_SIZE) candidates.push_back(GemmEngine::Strassen);
+    for (GemmEngine engine : candidates) {
+        double seconds = predictGemmSeconds(engine, M, N, K, threads);
+        if (seconds < best_seconds) {
+            best_seconds = seconds;
+            best = engine;
+        }
+    }
+    if (predicted_seconds) *predicted_seconds = best_seconds;
+    return best;
+}
+
+
+// --- Algorithm Calibration ---
+namespace {
+struct AlgorithmCalibration {
+    std::once_flag once;
+    std::vector<EngineSpeedSample> naive;           // Serial GFLOP/s
+    std::vector<EngineSpeedSample> tiled;
+    std::vector<EngineSpeedSample> tiledParallel;   // One worker
+    unsigned int parallelThreads = 1;
+    double parallelEfficiency = 1.0;                // Speedup / threads at the largest sample
+    double copySecondsPerElement = 1e-9;            // Block additions and copies
+    double strassenCorrection = 1.0;                // Measured / modelled Strassen time
+};
+
+AlgorithmCalibration& algorithmState() {
+    static AlgorithmCalibration state;
+    return state;
+}
+
+const std::vector<int> ALGORITHM_CALIBRATION_SIZES = { 64, 192, 384 };
+const int STRASSEN_CALIBRATION_SIZE = 512;
+
+// Live blocks per Strassen node relative to its size squared: 8 quadrants, S1..S10 and
+// P1..P7 are quarter-size (2 + 2.5 + 1.75).
+const double STRASSEN_NODE_WORKSPACE = 6.25;
+// A depth-first node keeps the 8 quadrants, one S pair, one P block and the 4 C quadrants (2 + 0.5 + 0.25 + 1).
+const double STRASSEN_DEPTH_FIRST_NODE_WORKSPACE = 3.75;
+// Quarter-size block operations per node: 8 split copies, 10 S sums, 8 C sums, 4 combine copies.
+const double STRASSEN_NODE_BLOCK_OPS = 30.0;
+
+template <class F>
+double bestOfTwo(F&& run) {
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < 2; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return std::max(best, 1e-9);
+}
+
+int resolveTileSize(int tile_size) {
+    return (tile_size > 0) ? tile_size : std::max(1, G_OPTIMAL_TILE_SIZE);
+}
+
+int resolveStrassenThreshold(int threshold) {
+    return (threshold > 0) ? threshold : std::max(1, G_OPTIMAL_STRASSEN_THRESHOLD);
+}
+
+unsigned int resolveThreads(unsigned int threads) {
+    return (threads == 0) ? getDefaultThreadCount() : std::max(1u, std::min(threads, getCpuCoreCount()));
+}
+
+// Levels of recursion above the base case (the padded size halves until it reaches the threshold).
+int strassenLevels(int n, int threshold) {
+    int levels = 0;
+    while (n > threshold && threshold > 0) { n /= 2; ++levels; }
+    return levels;
+}
+
+int strassenAsyncDepth(unsigned int threads) {
+    return (threads > 1) ? static_cast<int>(std::floor(std::log(static_cast<double>(threads)) / std::log(7.0))) : 0;
+}
+
+double serialSeconds(const std::vector<EngineSpeedSample>& samples, int M, int N, int K) {
+    double flops = 2.0 * M * N * static_cast<double>(K);
+    return flops / (std::max(interpolateGflops(samples, std::cbrt(static_cast<double>(M) * N * K)), 1e-3) * 1e9);
+}
+
+double strassenModelSeconds(int n, int threshold, unsigned int threads, int async_depth = -1) {
+    const AlgorithmCalibration& state = algorithmState();
+    const int levels = strassenLevels(n, threshold);
+    const int base = n >> levels;
+    double seconds = std::pow(7.0, levels) * serialSeconds(state.tiled, base, base, base);
+    for (int level = 0; level < levels; ++level) {
+        double half = static_cast<double>(n >> (level + 1));
+        seconds += std::pow(7.0, level) * STRASSEN_NODE_BLOCK_OPS * half * half * state.copySecondsPerElement;
+    }
+    // Only the first log7(threads) levels fan out; below them every subtree runs serially.
+    int async_levels = std::min(strassenAsyncDepth(threads), levels);
+    if (async_depth >= 0) async_levels = std::min(async_levels, async_depth);
+    if (async_levels > 0) {
+        double speedup = std::min(static_cast<double>(threads), std::pow(7.0, async_levels));
+        seconds /= std::max(1.0, 1.0 + (speedup - 1.0) * state.parallelEfficiency);
+    }
+    return seconds;
+}
+}
+
+void calibrateAlgorithmSpeeds(bool verbose) {
+    AlgorithmCalibration& state = algorithmState();
+    std::call_once(state.once, [&state, verbose] {
+        if (verbose) cout << CYAN << "Calibrating multiplication algorithms..." << RESET << endl << "Benchmarking: ";
+        for (int n : ALGORITHM_CALIBRATION_SIZES) {
+            Matrix A = Matrix::generateRandom(n, n, RANDOM_BENCHMARK_SEED, 0);
+            Matrix B = Matrix::generateRandom(n, n, RANDOM_BENCHMARK_SEED, 1);
+            const double flops = 2.0 * n * n * static_cast<double>(n);
+            const int tile = resolveTileSize(0);
+            state.naive.push_back({ n, flops / bestOfTwo([&] { A.multiply_naive(B); }) / 1e9 });
+            state.tiled.push_back({ n, flops / bestOfTwo([&] { A.multiply_tiled(B, tile); }) / 1e9 });
+            state.tiledParallel.push_back({ n, flops / bestOfTwo([&] { multiplyTiledParallel(A, B, tile, 1); }) / 1e9 });
+            if (verbose) cout << "@" << n << "... " << std::flush;
+        }
+
+        // Parallel efficiency at the largest size, where every worker gets several stripes.
+        state.parallelThreads = getDefaultThreadCount();
+        if (state.parallelThreads > 1) {
+            const int n = ALGORITHM_CALIBRATION_SIZES.back();
+            Matrix A = Matrix::generateRandom(n, n, RANDOM_BENCHMARK_SEED, 0);
+            Matrix B = Matrix::generateRandom(n, n, RANDOM_BENCHMARK_SEED, 1);
+            double parallel = bestOfTwo([&] { multiplyTiledParallel(A, B, resolveTileSize(0), state.parallelThreads); });
+            double serial = 2.0 * n * n * static_cast<double>(n) / (state.tiledParallel.back().gflops * 1e9);
+            state.parallelEfficiency = std::max(0.05, std::min(1.0, serial / parallel / state.parallelThreads));
+            if (verbose) cout << state.parallelThreads << " threads... " << std::flush;
+        }
+
+        // Block additions, then one Strassen run to correct the model as a whole.
+        const int n = STRASSEN_CALIBRATION_SIZE;
+        Matrix A = Matrix::generateRandom(n, n, RANDOM_BENCHMARK_SEED, 0);
+        Matrix B = Matrix::generateRandom(n, n, RANDOM_BENCHMARK_SEED, 1);
+        state.copySecondsPerElement = bestOfTwo([&] { Matrix sum = A + B; }) / (static_cast<double>(n) * n);
+        const int threshold = resolveStrassenThreshold(0);
+        double measured = bestOfTwo([&] { multiplyStrassenPadded(A, B, threshold, true, resolveTileSize(0), state.parallelThreads); });
+        double modelled = strassenModelSeconds(n, threshold, state.parallelThreads);
+        if (strassenLevels(n, threshold) > 0 && modelled > 0.0) state.strassenCorrection = std::max(0.25, std::min(4.0, measured / modelled));
+        if (verbose) cout << "Strassen@" << n << "... " << endl << GREEN << "Algorithm calibration complete." << RESET << endl << endl;
+    });
+}
+
+string getMultiplyAlgorithmName(MultiplyAlgorithm algorithm) {
+    switch (algorithm) {
+    case MultiplyAlgorithm::Naive: return "Naive";
+    case MultiplyAlgorithm::Tiled: return "Tiled";
+    case MultiplyAlgorithm::TiledParallel: return "Tiled Parallel";
+    case MultiplyAlgorithm::Strassen: return "Strassen";
+    }
+    return "Unknown";
+}
+
+
+// --- Algorithm Prediction ---
+double predictAlgorithmSeconds(MultiplyAlgorithm algorithm, int M, int N, int K, unsigned int threads,
+    int strassen_threshold, int tile_size, int strassen_async_depth) {
+    if (M <= 0 || N <= 0 || K <= 0) return 0.0;
+    calibrateAlgorithmSpeeds(false);
+    const AlgorithmCalibration& state = algorithmState();
+    const unsigned int used = resolveThreads(threads);
+
+    switch (algorithm) {
+    case MultiplyAlgorithm::Naive:
+        return serialSeconds(state.naive, M, N, K);
+    case MultiplyAlgorithm::Tiled:
+        return serialSeconds(state.tiled, M, N, K);
+    case MultiplyAlgorithm::TiledParallel: {
+        // Workers share row stripes of one tile each, so short results cannot use every thread.
+        const int tile = resolveTileSize(tile_size);
+        const double workers = std::min<double>(used, (M + tile - 1) / tile);
+        return serialSeconds(state.tiledParallel, M, N, K) / std::max(1.0, 1.0 + (workers - 1.0) * state.parallelEfficiency);
+    }
+    case MultiplyAlgorithm::Strassen: {
+        const int n = nextPowerOf2(std::max({ M, N, K }));
+        const int threshold = resolveStrassenThreshold(strassen_threshold);
+        // Padding copies both operands; unpadding copies the result.
+        double copies = (2.0 * n * n + static_cast<double>(M) * N) * state.copySecondsPerElement;
+        if (strassenLevels(n, threshold) == 0) return copies + serialSeconds(state.tiled, n, n, n);
+        return copies + strassenModelSeconds(n, threshold, used, strassen_async_depth) * state.strassenCorrection;
+    }
+    }
+    return 0.0;
+}
+
+double predictAlgorithmPeakMemoryMB(MultiplyAlgorithm algorithm, int M, int N, int K, unsigned int threads,
+    int strassen_threshold, int strassen_async_depth, bool depth_first) {
+    const double mb = sizeof(double) / (1024.0 * 1024.0);
+    double elements = static_cast<double>(M) * K + static_cast<double>(K) * N + static_cast<double>(M) * N;
+    if (algorithm == MultiplyAlgorithm::Strassen) {
+        const double n = nextPowerOf2(std::max({ M, N, K }));
+        if (M != n || K != n) elements += n * n;      // Padded A
+        if (K != n || N != n) elements += n * n;      // Padded B
+        elements += n * n;                            // Padded result
+        const int levels = strassenLevels(static_cast<int>(n), resolveStrassenThreshold(strassen_threshold));
+        if (levels > 0) {
+            // Serial descent keeps one node per level alive (a geometric series in 1/4). On the
+            // async levels all 7 children of a node are alive at once.
+            int async_levels = std::min(strassenAsyncDepth(resolveThreads(threads)), levels);
+            if (strassen_async_depth >= 0) async_levels = std::min(async_levels, strassen_async_depth);
+            const double serial_node = depth_first ? STRASSEN_DEPTH_FIRST_NODE_WORKSPACE : STRASSEN_NODE_WORKSPACE;
+            double workspace = 0.0;
+            for (int level = 0; level < async_levels; ++level) workspace += std::pow(7.0 / 4.0, level) * STRASSEN_NODE_WORKSPACE;
+            workspace += std::pow(7.0 / 4.0, async_levels) * serial_node * 4.0 / 3.0;
+            elements += workspace * n * n;
+        }
+    }
+    return elements * mb;
+}
+
+AlgorithmPlan planMultiplication(int M, int N, int K, unsigned int threads, double memory_limit_mb) {
+    if (M <= 0 || N <= 0 || K <= 0) throw std::invalid_argument("planMultiplication: dimensions must be positive.");
+    AlgorithmPlan plan;
+    plan.M = M;
+    plan.N = N;
+    plan.K = K;
+    plan.memoryLimitMB = (memory_limit_mb > 0.0) ? memory_limit_mb : 0.8 * getSystemMemoryInfo().availablePhysicalMB;
+
+    const unsigned int used = resolveThreads(threads);
+    const int tile = resolveTileSize(0);
+    auto add = [&](MultiplyAlgorithm algorithm, unsigned int candidate_threads, int threshold) {
+        AlgorithmCandidate candidate;
+        candidate.algorithm = algorithm;
+        candidate.threads = candidate_threads;
+        candidate.tileSize = tile;
+        candidate.strassenThreshold = threshold;
+        candidate.predictedSeconds = predictAlgorithmSeconds(algorithm, M, N, K, candidate_threads, threshold, tile);
+        candidate.predictedPeakMemoryMB = predictAlgorithmPeakMemoryMB(algorithm, M, N, K, candidate_threads, threshold);
+        candidate.feasible = candidate.predictedPeakMemoryMB <= plan.memoryLimitMB;
+        plan.candidates.push_back(candidate);
+    };
+    add(MultiplyAlgorithm::Naive, 1, 0);
+    add(MultiplyAlgorithm::Tiled, 1, 0);
+    add(MultiplyAlgorithm::TiledParallel, used, 0);
+    const int padded = nextPowerOf2(std::max({ M, N, K }));
+    const int tuned = resolveStrassenThreshold(0);
+    for (int threshold : { tuned / 2, tuned, tuned * 2 }) {
+        if (threshold < 16 || padded <= threshold) continue;
+        add(MultiplyAlgorithm::Strassen, used, threshold);
+        // Too big as it is: also rank the shallower or depth-first schedule that fits.
+        AlgorithmCandidate fitted = fitCandidateToMemory(plan.candidates.back(), M, N, K, plan.memoryLimitMB);
+        if (fitted.feasible && fitted.algorithm == MultiplyAlgorithm::Strassen && !fitted.memoryAdaptation.empty()) {
+            fitted.predictedSeconds = predictAlgorithmSeconds(fitted.algorithm, M, N, K, fitted.threads, threshold, tile, fitted.strassenAsyncDepth);
+            plan.candidates.push_back(fitted);
+        }
+    }
+
+    const AlgorithmCandidate* best = nullptr;
+    for (const AlgorithmCandidate& candidate : plan.candidates) {
+        if (candidate.feasible && (!best || candidate.predictedSeconds < best->predictedSeconds)) best = &candidate;
+    }
+    if (!best) {
+        std::stringstream ss;
+        ss << "No algorithm fits in " << std::fixed << std::setprecision(0) << plan.memoryLimitMB
+            << " MB for a " << M << "x" << K << " by " << K << "x" << N << " product";
+        if (getMemoryBudget().enforcedMB > 0.0) ss << " (memory budget: " << describeMemoryBudget(getMemoryBudget()) << ")";
+        ss << ".";
+        throw std::runtime_error(ss.str());
+    }
+    plan.chosen = *best;
+    return plan;
+}
+
+AlgorithmCandidate fitCandidateToMemory(const AlgorithmCandidate& candidate, int M, int N, int K, double memory_limit_mb) {
+    auto estimate = [&](AlgorithmCandidate& c) {
+        c.predictedPeakMemoryMB = predictAlgorithmPeakMemoryMB(c.algorithm, M, N, K, c.threads, c.strassenThreshold,
+            c.strassenAsyncDepth, c.depthFirst);
+        c.feasible = c.predictedPeakMemoryMB <= memory_limit_mb;
+    };
+    AlgorithmCandidate fitted = candidate;
+    estimate(fitted);
+    if (fitted.feasible) return fitted;
+
+    std::vector<string> steps;
+    if (candidate.algorithm == MultiplyAlgorithm::Strassen) {
+        // 1. Fewer levels fan out; threads beyond 7^depth would have no subtree to run.
+        const unsigned int threads = resolveThreads(candidate.threads);
+        const int start_depth = (candidate.strassenAsyncDepth >= 0) ? std::min(candidate.strassenAsyncDepth, strassenAsyncDepth(threads))
+            : strassenAsyncDepth(threads);
+        int depth = start_depth;
+        while (!fitted.feasible && depth > 0) {
+            fitted.strassenAsyncDepth = --depth;
+            fitted.threads = std::min(threads, static_cast<unsigned int>(std::lround(std::pow(7.0, depth))));
+            estimate(fitted);
+        }
+        if (depth != start_depth) {
+            steps.push_back("async depth " + std::to_string(start_depth) + "->" + std::to_string(depth));
+            steps.push_back("threads " + std::to_string(threads) + "->" + std::to_string(fitted.threads));
+        }
+        // 2. Memory-lean order on the serial levels.
+        if (!fitted.feasible && !fitted.depthFirst) {
+            fitted.depthFirst = true;
+            estimate(fitted);
+            steps.push_back("depth-first");
+        }
+    }
+    // 3. The tiled-parallel engine writes straight into the result: operands and result only.
+    if (!fitted.feasible && candidate.algorithm == MultiplyAlgorithm::Strassen) {
+        fitted = candidate;
+        fitted.algorithm = MultiplyAlgorithm::TiledParallel;
+        fitted.strassenThreshold = 0;
+        estimate(fitted);
+        steps.assign(1, getMultiplyAlgorithmName(candidate.algorithm) + " -> " + getMultiplyAlgorithmName(fitted.algorithm));
+    }
+    for (size_t i = 0; i < steps.size(); ++i) fitted.memoryAdaptation += (i ? "; " : "") + steps[i];
+    return fitted;
+}
+
+
+// --- Automatic Multiplication ---
+// The serial kernels have no result wrapper of their own.
+static MultiplicationResult multiplySerial(const Matrix& A, const Matrix& B, MultiplyAlgorithm algorithm, int tileSize) {
+    MultiplicationResult result_obj;
+    result_obj.originalRowsA = A.rows();
+    result_obj.originalColsA = A.cols();
+    result_obj.originalRowsB = B.rows();
+    result_obj.originalColsB = B.cols();
+    result_obj.tiling_enabled = (algorithm == MultiplyAlgorithm::Tiled);
+    result_obj.tile_size = result_obj.tiling_enabled ? tileSize : 0;
+    result_obj.algorithm_type = getMultiplyAlgorithmName(algorithm);
+    result_obj.coresDetected = getCpuCoreCount();
+    result_obj.threadsUsed = 1;
+    MatrixAllocationStats alloc_start = getMatrixAllocationStats();
+
+    auto start_chrono = std::chrono::high_resolution_clock::now();
+    long long start_qpc = readPerformanceCounter();
+    long long rss_start = getCurrentResidentKB();
+    HardwareCounterRun counter_run;
+    {
+        HardwareCounterScope base_counters(CounterPhase::BaseMultiply);
+        result_obj.resultMatrix = result_obj.tiling_enabled ? A.multiply_tiled(B, tileSize) : A.multiply_naive(B);
+    }
+    auto end_chrono = std::chrono::high_resolution_clock::now();
+    long long end_qpc = readPerformanceCounter();
+    result_obj.durationSeconds_chrono = std::chrono::duration<double>(end_chrono - start_chrono).count();
+    result_obj.durationSeconds_qpc = performanceCounterSeconds(start_qpc, end_qpc);
+    result_obj.compute_rss_delta_mb = residentDeltaMB(rss_start, getCurrentResidentKB());
+    counter_run.finish(result_obj.hardwareCounters);
+    result_obj.allocationStats = matrixAllocationsSince(alloc_start);
+    result_obj.memoryInfo = getProcessMemoryUsage();
+    return result_obj;
+}
+
+static double operandsMB(const Matrix& A, const Matrix& B) {
+    return (A.elementCount() + B.elementCount()) * sizeof(double) / (1024.0 * 1024.0);
+}
+
+// C in MB, the only workspace of the shape kernels.
+static double resultMB(const Matrix& A, const Matrix& B) {
+    return static_cast<double>(A.rows()) * B.cols() * sizeof(double) / (1024.0 * 1024.0);
+}
+
+// Morton copies of A, B and C in MB, on top of what the row-major run of the candidate needs.
+static double mortonCopiesMB(const AlgorithmCandidate& candidate, int M, int N, int K) {
+    const int max_dim = std::max({ M, N, K });
+    int size = nextPowerOf2(max_dim);
+    if (candidate.algorithm == MultiplyAlgorithm::TiledParallel) {
+        size = mortonPaddedSize(max_dim, chooseMortonLeaf(max_dim, resolveTileSize(candidate.tileSize)));
+    }
+    return 3.0 * size * size * sizeof(double) / (1024.0 * 1024.0);
+}
+
+AlgorithmCandidate fitCandidateToProduct(const Matrix& A, const Matrix& B, const AlgorithmCandidate& requested, ThreadPool* pool) {
+    // The parallel algorithms hand degenerate shapes to the shape kernels (see multiplyByShape),
+    // which need no workspace beyond C, so the budget only has to hold that.
+    AlgorithmCandidate candidate = requested;
+    const double limit_mb = hasMemoryBudget() ? productMemoryLimitMB(operandsMB(A, B)) : 0.0;
+    const bool shaped = (candidate.algorithm == MultiplyAlgorithm::TiledParallel || candidate.algorithm == MultiplyAlgorithm::Strassen)
+        && A.cols() == B.rows() && classifyGemmShape(A.rows(), B.cols(), A.cols()) != GemmShape::General;
+    if (shaped && hasMemoryBudget()) requireMemoryBudget(operandsMB(A, B) + resultMB(A, B), operandsMB(A, B), getMultiplyAlgorithmName(candidate.algorithm));
+    // Under a memory budget the candidate is shrunk (or replaced) before any work starts.
+    if (!shaped && hasMemoryBudget() && A.cols() == B.rows() && !A.isEmpty() && !B.isEmpty()) {
+        if (candidate.algorithm == MultiplyAlgorithm::Strassen) candidate.strassenThreshold = resolveStrassenThreshold(candidate.strassenThreshold);
+        if (pool && candidate.threads == 0) candidate.threads = static_cast<unsigned int>(pool->size());
+        candidate = fitCandidateToMemory(candidate, A.rows(), B.cols(), A.cols(), limit_mb);
+        if (!candidate.feasible) {
+            std::stringstream ss;
+            ss << std::fixed << std::setprecision(1) << getMultiplyAlgorithmName(candidate.algorithm) << " needs about "
+                << candidate.predictedPeakMemoryMB << " MB but the memory budget leaves " << limit_mb << " MB ("
+                << describeMemoryBudget(getMemoryBudget()) << ").";
+            throw std::runtime_error(ss.str());
+        }
+        // The Morton layout is an optimization, never a requirement: without room for the
+        // copies the product runs row-major.
+        if (candidate.layout == MatrixLayout::Morton && (candidate.algorithm == MultiplyAlgorithm::Strassen || candidate.algorithm == MultiplyAlgorithm::TiledParallel)
+            && candidate.predictedPeakMemoryMB + mortonCopiesMB(candidate, A.rows(), B.cols(), A.cols()) > limit_mb) {
+            candidate.layout = MatrixLayout::RowMajor;
+            candidate.memoryAdaptation += string(candidate.memoryAdaptation.empty() ? "" : "; ") + "morton -> row-major";
+        }
+    }
+    candidate.fittedToProduct = true;
+    candidate.memoryLimitMB = limit_mb;
+    return candidate;
+}
+
+string describeCandidate(const AlgorithmCandidate& candidate) {
+    std::stringstream ss;
+    ss << getMultiplyAlgorithmName(candidate.algorithm) << " threshold=" << candidate.strassenThreshold << " tile=" << candidate.tileSize
+        << " threads=" << candidate.threads << " async_depth=" << candidate.strassenAsyncDepth << " depth_first=" << candidate.depthFirst
+        << " layout=" << getMatrixLayoutName(candidate.layout);
+    return ss.str();
+}
+
+MultiplicationResult multiplyWithAlgorithm(const Matrix& A, const Matrix& B, const AlgorithmCandidate& requested, ThreadPool* pool) {
+    const AlgorithmCandidate candidate = requested.fittedToProduct ? requested : fitCandidateToProduct(A, B, requested, pool);
+    const double limit_mb = candidate.memoryLimitMB;
+    // A shrunk Strassen runs on a pool of its own size rather than the caller's larger one.
+    if (pool && candidate.strassenAsyncDepth >= 0 && candidate.threads < pool->size()) pool = nullptr;
+
+    const int tile = resolveTileSize(candidate.tileSize);
+    MultiplicationResult result_obj;
+    switch (candidate.algorithm) {
+    case MultiplyAlgorithm::TiledParallel:
+        result_obj = multiplyTiledParallel(A, B, tile, candidate.threads, pool, candidate.layout);
+        break;
+    case MultiplyAlgorithm::Strassen: {
+        StrassenSchedule schedule;
+        schedule.maxAsyncDepth = candidate.strassenAsyncDepth;
+        schedule.depthFirst = candidate.depthFirst;
+        result_obj = multiplyStrassenParallel(A, B, resolveStrassenThreshold(candidate.strassenThreshold), true, tile, candidate.threads, pool, schedule,
+            candidate.layout);
+        break;
+    }
+    default:
+        result_obj = multiplySerial(A, B, candidate.algorithm, tile);
+        break;
+    }
+    result_obj.memory_budget_mb = limit_mb;
+    result_obj.memory_adaptation = candidate.memoryAdaptation;
+    return result_obj;
+}
+
+bool planAutomaticMultiplication(const Matrix& A, const Matrix& B, unsigned int num_threads_request, ThreadPool* pool,
+    const MatrixFileInfo* infoA, const MatrixFileInfo* infoB, AlgorithmPlan& plan) {
+    if (A.cols() != B.rows()) throw std::invalid_argument("Matrix dimensions incompatible (A.cols != B.rows).");
+    if (A.isEmpty() || B.isEmpty()) return false;
+    if ((infoA && infoA->sparseCandidate) || (infoB && infoB->sparseCandidate)) return false;
+    if (classifyGemmShape(A.rows(), B.cols(), A.cols()) != GemmShape::General) return false;
+
+    if (pool) num_threads_request = static_cast<unsigned int>(pool->size());
+    calibrateAlgorithmSpeeds(false);
+    // Under a budget even an exhausted one is a limit; 0 would mean the default.
+    const double limit_mb = hasMemoryBudget() ? std::max(productMemoryLimitMB(operandsMB(A, B)), std::numeric_limits<double>::min()) : 0.0;
+    plan = planMultiplication(A.rows(), B.cols(), A.cols(), num_threads_request, limit_mb);
+    plan.chosen = fitCandidateToProduct(A, B, plan.chosen, pool);
+    return true;
+}
+
+MultiplicationResult multiplyAutomatic(const Matrix& A, const Matrix& B, unsigned int num_threads_request, bool verbose, ThreadPool* pool,
+    const MatrixFileInfo* infoA, const MatrixFileInfo* infoB, const AlgorithmPlan* planned) {
+    if (A.cols() != B.rows()) throw std::invalid_argument("Matrix dimensions incompatible (A.cols != B.rows).");
+    if (A.isEmpty() || B.isEmpty()) return multiplySerial(A, B, MultiplyAlgorithm::Naive, 0);
+
+    if (pool) num_threads_request = static_cast<unsigned int>(pool->size());
+    // Mostly-zero operands: the dense cost model does not apply, the sparse kernels only touch
+    // the non-zeros (CSR/CSC copies of the sparse operands, a dense result).
+    if ((infoA && infoA->sparseCandidate) || (infoB && infoB->sparseCandidate)) {
+        if (hasMemoryBudget()) requireMemoryBudget(operandsMB(A, B) + resultMB(A, B), operandsMB(A, B), "The sparse product");
+        if (verbose) {
+            cout << CYAN << " Sparse operand detected (density " << std::fixed << std::setprecision(4)
+                << (infoA ? infoA->density : 1.0) << " x " << (infoB ? infoB->density : 1.0) << "): using the sparse engine." << RESET << endl;
+        }
+        const double limit_mb = hasMemoryBudget() ? productMemoryLimitMB(operandsMB(A, B)) : 0.0;
+        MultiplicationResult result_obj = multiplySparsityAware(A, B, resolveTileSize(0), num_threads_request, infoA, infoB);
+        result_obj.algorithm_type = "Auto: " + result_obj.algorithm_type;
+        result_obj.memory_budget_mb = limit_mb;
+        return result_obj;
+    }
+    // Degenerate shapes have one right answer, so nothing needs calibrating or planning.
+    const GemmShape shape = classifyGemmShape(A.rows(), B.cols(), A.cols());
+    if (shape != GemmShape::General) {
+        if (hasMemoryBudget()) requireMemoryBudget(operandsMB(A, B) + resultMB(A, B), operandsMB(A, B), "The " + getGemmShapeName(shape) + " product");
+        if (verbose) {
+            cout << CYAN << " " << A.rows() << "x" << A.cols() << " by " << B.rows() << "x" << B.cols() << " is a " << getGemmShapeName(shape)
+                << " product: using its streaming kernel, without padding." << RESET << endl;
+        }
+        const double limit_mb = hasMemoryBudget() ? productMemoryLimitMB(operandsMB(A, B)) : 0.0;
+        MultiplicationResult result_obj = multiplyByShape(A, B, num_threads_request, "");
+        result_obj.algorithm_type = "Auto: " + result_obj.algorithm_type;
+        result_obj.memory_budget_mb = limit_mb;
+        return result_obj;
+    }
+
+    AlgorithmPlan plan;
+    if (planned) plan = *planned;
+    else {
+        calibrateAlgorithmSpeeds(verbose);
+        // Under a budget even an exhausted one is a limit; 0 would mean the default.
+        const double limit_mb = hasMemoryBudget() ? std::max(productMemoryLimitMB(operandsMB(A, B)), std::numeric_limits<double>::min()) : 0.0;
+        plan = planMultiplication(A.rows(), B.cols(), A.cols(), num_threads_request, limit_mb);
+    }
+    if (verbose) displayAlgorithmPlan(plan);
+
+    const AlgorithmCandidate& chosen = plan.chosen;
+    MultiplicationResult result_obj = multiplyWithAlgorithm(A, B, chosen, pool);
+    result_obj.algorithm_type = "Auto: " + result_obj.algorithm_type;
+    result_obj.predicted_seconds = chosen.predictedSeconds;
+    result_obj.predicted_peak_memory_mb = chosen.predictedPeakMemoryMB;
+
+    if (verbose) {
+        double error = (chosen.predictedSeconds > 0.0) ? (result_obj.durationSeconds_chrono / chosen.predictedSeconds - 1.0) * 100.0 : 0.0;
+        cout << std::fixed << std::setprecision(4) << " Predicted " << chosen.predictedSeconds << "s, actual "
+            << (std::abs(error) <= 25.0 ? GREEN : YELLOW) << result_obj.durationSeconds_chrono << "s" << RESET
+            << std::setprecision(1) << std::showpos << " (" << error << "%)" << std::noshowpos
+            << "; peak memory predicted " << chosen.predictedPeakMemoryMB << " MB, process peak "
+            << result_obj.memoryInfo.peakWorkingSetMB << " MB" << endl;
+    }
+    return result_obj;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "Common.h"
+#include "Gemm.h"
+#include "Algorithm.h"
+
+// --- Engine Speed Model ---
+// Each gemm engine is timed once per process on a few square sizes. Predictions interpolate
+// the measured GFLOP/s on log(size) and clamp outside the measured range. Strassen is charged
+// for its padded power-of-two problem, the others for 2 * M * N * K FLOPs.
+
+struct EngineSpeedSample {
+    int size;
+    double gflops;
+};
+
+// Times the engines with all cores. Runs at most once; later calls return immediately.
+// Predictions calibrate lazily (quietly) if this has not been called.
+void calibrateEngineSpeeds(bool verbose = true);
+bool isEngineSpeedCalibrated();
+const std::vector<EngineSpeedSample>& getEngineSpeedSamples(GemmEngine engine);
+
+// Predicted wall time of one gemm with the given engine on `threads` threads (0 = all cores).
+double predictGemmSeconds(GemmEngine engine, int M, int N, int K, unsigned int threads = 0);
+
+// The engine with the lowest predicted time for an M x K times K x N product (alpha = 1, beta = 0).
+GemmEngine selectFastestGemmEngine(int M, int N, int K, unsigned int threads = 0, double* predicted_seconds = nullptr);
+
+// --- Algorithm Selection ---
+// The interactive algorithms (naive, tiled, tiled-parallel, Strassen) have their own calibration:
+// serial GFLOP/s versus size for each kernel and the parallel efficiency of the tiled-parallel
+// engine. Strassen is modelled as 7^L tiled base products plus its block additions at the
+// measured copy bandwidth, run in parallel only on the async levels (log7 of the threads), and
+// scaled by one measured run. Shapes enter through cbrt(M * N * K) and the number of row
+// stripes the workers can share.
+
+// Runs at most once; predictions calibrate lazily (quietly) if this has not been called.
+void calibrateAlgorithmSpeeds(bool verbose = true);
+string getMultiplyAlgorithmName(MultiplyAlgorithm algorithm);
+
+// threads 0 = getDefaultThreadCount(); strassen_threshold / tile_size 0 = the tuned defaults;
+// strassen_async_depth -1 = log7(threads) (see StrassenSchedule).
+double predictAlgorithmSeconds(MultiplyAlgorithm algorithm, int M, int N, int K, unsigned int threads = 0,
+    int strassen_threshold = 0, int tile_size = 0, int strassen_async_depth = -1);
+
+// Peak memory of one product in MB: operands, padded copies, recursion workspace and result.
+double predictAlgorithmPeakMemoryMB(MultiplyAlgorithm algorithm, int M, int N, int K, unsigned int threads = 0,
+    int strassen_threshold = 0, int strassen_async_depth = -1, bool depth_first = false);
+
+// Shrinks a candidate until its predicted peak fits memory_limit_mb: Strassen first fans out
+// fewer levels (with only the threads those use), then runs depth-first, and finally gives way
+// to the tiled-parallel engine, which needs nothing beyond operands and result. Steps taken go
+// to memoryAdaptation; feasible is false when even the last step does not fit. Does not
+// calibrate, so predictedSeconds is left as it was.
+AlgorithmCandidate fitCandidateToMemory(const AlgorithmCandidate& candidate, int M, int N, int K, double memory_limit_mb);
+
+// Ranks every algorithm (Strassen with a few thresholds around the tuned one) and picks the
+// fastest whose predicted peak fits memory_limit_mb (0 = 80% of the available physical memory).
+// Throws std::runtime_error when nothing fits.
+AlgorithmPlan planMultiplication(int M, int N, int K, unsigned int threads = 0, double memory_limit_mb = 0.0);
+
+// The candidate multiplyWithAlgorithm runs for A * B at this moment: under a memory budget it
+// is fitted to what the budget leaves now (throwing std::runtime_error when nothing fits).
+// The result is marked as fitted, so multiplyWithAlgorithm runs it without fitting it again;
+// fitting first lets a caller key a result cache on what will actually run.
+AlgorithmCandidate fitCandidateToProduct(const Matrix& A, const Matrix& B, const AlgorithmCandidate& requested,
+    ThreadPool* pool = nullptr);
+
+// Algorithm, threshold, tile, threads, Strassen schedule and layout, e.g. "Strassen threshold=128
+// tile=64 threads=8 async_depth=-1 depth_first=0 layout=row-major".
+string describeCandidate(const AlgorithmCandidate& candidate);
+
+// Runs one candidate (a plan's choice, or one built by hand). The parallel algorithms use the
+// given pool instead of building their own; its size then overrides candidate.threads. Under a
+// memory budget the candidate is first fitted to it (throwing std::runtime_error, before any
+// work, when nothing fits); the result records the limit and the adaptation.
+MultiplicationResult multiplyWithAlgorithm(const Matrix& A, const Matrix& B, const AlgorithmCandidate& candidate,
+    ThreadPool* pool = nullptr);
+
+// What multiplyAutomatic would run for A * B at this moment: false when it hands the product to
+// the sparse or shape kernels, otherwise true with the plan, whose chosen candidate has been
+// fitted by fitCandidateToProduct.
+bool planAutomaticMultiplication(const Matrix& A, const Matrix& B, unsigned int num_threads_request, ThreadPool* pool,
+    const MatrixFileInfo* infoA, const MatrixFileInfo* infoB, AlgorithmPlan& plan);
+
+// Plans, shows the plan when verbose, runs the chosen algorithm and records the predictions
+// in the result so they are logged next to the actual time and memory. Operands whose file
+// info (readMatrixFromFile) marks them as sparse candidates skip planning and go to
+// multiplySparsityAware. A plan from planAutomaticMultiplication is run instead of a fresh one.
+MultiplicationResult multiplyAutomatic(const Matrix& A, const Matrix& B, unsigned int num_threads_request = 0,
+    bool verbose = true, ThreadPool* pool = nullptr, const MatrixFileInfo* infoA = nullptr, const MatrixFileInfo* infoB = nullptr,
+    const AlgorithmPlan* plan = nullptr);
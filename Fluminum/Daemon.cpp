@@ -0,0 +1,591 @@
+#define NOMINMAX
+#include "Daemon.h"
+#include "Algorithm.h"
+#include "AutoTune.h"
+#include "CacheTopology.h"
+#include "Gemm.h"
+#include "Matrix.h"
+#include "System.h"
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// --- Shared Memory Operands ---
+namespace {
+std::atomic<bool> g_daemonSignalled(false);
+
+void onDaemonSignal(int) {
+    g_daemonSignalled.store(true);
+}
+
+string systemError() {
+    return std::strerror(errno);
+}
+
+// A mapped POSIX shared memory segment, unmapped on destruction.
+class SharedSegment {
+public:
+    SharedSegment(const string& name, size_t bytes, bool writable) : bytes_(bytes) {
+        int fd = shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+        if (fd < 0) throw std::invalid_argument("cannot open segment " + name + ": " + systemError());
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            const string error = systemError();
+            close(fd);
+            throw std::invalid_argument("cannot inspect segment " + name + ": " + error);
+        }
+        if (static_cast<size_t>(info.st_size) < bytes) {
+            close(fd);
+            throw std::invalid_argument("segment " + name + " holds " + std::to_string(info.st_size) + " bytes, needs " + std::to_string(bytes));
+        }
+        device_ = info.st_dev;
+        inode_ = info.st_ino;
+        void* mapped = mmap(nullptr, bytes, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) throw std::invalid_argument("cannot map segment " + name + ": " + systemError());
+        data_ = static_cast<double*>(mapped);
+    }
+    ~SharedSegment() { munmap(data_, bytes_); }
+    SharedSegment(const SharedSegment&) = delete;
+    SharedSegment& operator=(const SharedSegment&) = delete;
+
+    double* data() const { return data_; }
+    // Whether both map the same segment, whatever names they were opened under.
+    bool sameSegment(const SharedSegment& other) const { return device_ == other.device_ && inode_ == other.inode_; }
+
+private:
+    double* data_ = nullptr;
+    size_t bytes_;
+    dev_t device_ = 0;
+    ino_t inode_ = 0;
+};
+
+
+// --- Jobs ---
+enum class JobState { Queued, Running, Done, Failed, Cancelled };
+
+string getJobStateName(JobState state) {
+    switch (state) {
+    case JobState::Queued: return "queued";
+    case JobState::Running: return "running";
+    case JobState::Done: return "done";
+    case JobState::Failed: return "failed";
+    case JobState::Cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+bool isFinished(JobState state) {
+    return state == JobState::Done || state == JobState::Failed || state == JobState::Cancelled;
+}
+
+struct DaemonJob {
+    long long id = 0;
+    JobState state = JobState::Queued;
+    int M = 0, N = 0, K = 0;
+    Transpose transA = Transpose::None;
+    Transpose transB = Transpose::None;
+    double alpha = 1.0;
+    double beta = 0.0;
+    GemmOptions options;
+    std::unique_ptr<SharedSegment> a, b, c;
+    std::atomic<bool> cancel{ false };
+    std::chrono::steady_clock::time_point submitted;
+    double queueSeconds = 0.0;
+    double runSeconds = 0.0;
+    GemmResult result;
+    string error;
+};
+
+std::map<string, string> parseFields(std::stringstream& tokens) {
+    std::map<string, string> fields;
+    string token;
+    while (tokens >> token) {
+        size_t equals = token.find('=');
+        if (equals == string::npos || equals == 0) throw std::invalid_argument("expected key=value, got '" + token + "'");
+        fields[token.substr(0, equals)] = token.substr(equals + 1);
+    }
+    return fields;
+}
+
+double parseField(const std::map<string, string>& fields, const string& key, double fallback, double minimum) {
+    auto it = fields.find(key);
+    if (it == fields.end()) return fallback;
+    try {
+        size_t used = 0;
+        double value = std::stod(it->second, &used);
+        if (used == it->second.size() && value >= minimum) return value;
+    }
+    catch (const std::exception&) {}
+    throw std::invalid_argument("invalid value '" + it->second + "' for " + key);
+}
+
+// Whole numbers only: "3.7" or "1e3" is rejected instead of truncated, and so is anything
+// outside [minimum, maximum].
+long long parseIntegerField(const std::map<string, string>& fields, const string& key, long long fallback,
+    long long minimum, long long maximum) {
+    auto it = fields.find(key);
+    if (it == fields.end()) return fallback;
+    try {
+        size_t used = 0;
+        long long value = std::stoll(it->second, &used);
+        if (used == it->second.size() && value >= minimum && value <= maximum) return value;
+    }
+    catch (const std::exception&) {}
+    throw std::invalid_argument("invalid value '" + it->second + "' for " + key + " (expected an integer in ["
+        + std::to_string(minimum) + ", " + std::to_string(maximum) + "])");
+}
+
+GemmEngine parseEngine(const string& name) {
+    if (name == "auto") return GemmEngine::Auto;
+    if (name == "simd") return GemmEngine::Simd;
+    if (name == "tiled") return GemmEngine::Tiled;
+    if (name == "strassen") return GemmEngine::Strassen;
+    if (name == "fixed") return GemmEngine::Fixed;
+    if (name == "shape") return GemmEngine::Shape;
+    throw std::invalid_argument("unknown engine '" + name + "'");
+}
+
+
+// --- Server ---
+class DaemonServer {
+public:
+    explicit DaemonServer(unsigned int default_threads) : defaultThreads_(default_threads), started_(std::chrono::steady_clock::now()) {
+        worker_ = std::thread([this] { workerLoop(); });
+    }
+
+    ~DaemonServer() { stop(); }
+
+    bool stopping() const { return stopping_.load(); }
+
+    // Cancels queued jobs and waits for the running one.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_.exchange(true)) return;
+            while (!queue_.empty()) {
+                finish(queue_.front(), JobState::Cancelled);
+                queue_.pop_front();
+            }
+        }
+        changed_.notify_all();
+        if (worker_.joinable()) worker_.join();
+    }
+
+    string handle(const string& line) {
+        std::stringstream tokens(line);
+        string command;
+        if (!(tokens >> command)) return "ERROR empty request";
+        try {
+            std::map<string, string> fields = parseFields(tokens);
+            if (command == "PING") return "OK pong";
+            if (command == "SUBMIT") return submit(fields);
+            if (command == "STATUS" || command == "WAIT" || command == "CANCEL") {
+                long long id = parseIntegerField(fields, "id", -1, 0, std::numeric_limits<long long>::max());
+                if (id < 0) throw std::invalid_argument(command + " needs id=");
+                if (command == "STATUS") return status(id, false);
+                if (command == "WAIT") return status(id, true);
+                return cancel(id);
+            }
+            if (command == "QUEUE") return queueInfo();
+            if (command == "SHUTDOWN") {
+                shutdownRequested_.store(true);
+                return "OK shutting_down=1";
+            }
+            return "ERROR unknown command '" + command + "'";
+        }
+        catch (const std::exception& e) {
+            return string("ERROR ") + e.what();
+        }
+    }
+
+    bool shutdownRequested() const { return shutdownRequested_.load(); }
+
+private:
+    string submit(const std::map<string, string>& fields) {
+        for (const auto& field : fields) {
+            static const std::vector<string> known = { "a", "b", "c", "m", "n", "k", "transa", "transb", "alpha", "beta", "engine", "threads" };
+            if (std::find(known.begin(), known.end(), field.first) == known.end()) throw std::invalid_argument("unknown key '" + field.first + "'");
+        }
+        for (const char* key : { "a", "b", "c", "m", "n", "k" }) {
+            if (!fields.count(key)) throw std::invalid_argument(string("SUBMIT needs ") + key + "=");
+        }
+        auto job = std::make_shared<DaemonJob>();
+        const long long max_dimension = std::numeric_limits<int>::max();
+        job->M = static_cast<int>(parseIntegerField(fields, "m", 0, 1, max_dimension));
+        job->N = static_cast<int>(parseIntegerField(fields, "n", 0, 1, max_dimension));
+        job->K = static_cast<int>(parseIntegerField(fields, "k", 0, 1, max_dimension));
+        job->transA = (parseIntegerField(fields, "transa", 0, 0, 1) != 0) ? Transpose::Transposed : Transpose::None;
+        job->transB = (parseIntegerField(fields, "transb", 0, 0, 1) != 0) ? Transpose::Transposed : Transpose::None;
+        job->alpha = parseField(fields, "alpha", 1.0, -std::numeric_limits<double>::max());
+        job->beta = parseField(fields, "beta", 0.0, -std::numeric_limits<double>::max());
+        job->options.engine = fields.count("engine") ? parseEngine(fields.at("engine")) : GemmEngine::Auto;
+        job->options.threads = static_cast<unsigned int>(parseIntegerField(fields, "threads", defaultThreads_, 0, std::numeric_limits<int>::max()));
+        job->options.cancel = &job->cancel;
+
+        auto segment_bytes = [](int rows, int cols) {
+            const unsigned long long elements = static_cast<unsigned long long>(rows) * static_cast<unsigned long long>(cols);
+            if (elements > std::numeric_limits<size_t>::max() / sizeof(double)) {
+                throw std::invalid_argument("a " + std::to_string(rows) + "x" + std::to_string(cols) + " matrix does not fit in memory");
+            }
+            return static_cast<size_t>(elements) * sizeof(double);
+        };
+        const size_t a_bytes = segment_bytes(job->M, job->K);
+        const size_t b_bytes = segment_bytes(job->K, job->N);
+        const size_t c_bytes = segment_bytes(job->M, job->N);
+        job->a = std::make_unique<SharedSegment>(fields.at("a"), a_bytes, false);
+        job->b = std::make_unique<SharedSegment>(fields.at("b"), b_bytes, false);
+        job->c = std::make_unique<SharedSegment>(fields.at("c"), c_bytes, true);
+        // Each name is mapped at its own address, so gemm cannot see that C overwrites an operand.
+        if (job->c->sameSegment(*job->a) || job->c->sameSegment(*job->b)) throw std::invalid_argument("c= must not name the segment of a= or b=");
+
+        size_t depth;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_.load() || shutdownRequested_.load()) throw std::runtime_error("daemon is shutting down");
+            job->id = nextId_++;
+            job->submitted = std::chrono::steady_clock::now();
+            jobs_[job->id] = job;
+            queue_.push_back(job);
+            depth = queue_.size();
+        }
+        changed_.notify_all();
+        return "OK id=" + std::to_string(job->id) + " depth=" + std::to_string(depth);
+    }
+
+    string status(long long id, bool wait) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) return "ERROR unknown job " + std::to_string(id);
+        std::shared_ptr<DaemonJob> job = it->second;
+        if (wait) changed_.wait(lock, [&] { return isFinished(job->state); });
+        return describe(*job);
+    }
+
+    string cancel(long long id) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end()) return "ERROR unknown job " + std::to_string(id);
+        std::shared_ptr<DaemonJob> job = it->second;
+        if (isFinished(job->state)) return "ERROR job " + std::to_string(id) + " already " + getJobStateName(job->state);
+        job->cancel.store(true);
+        if (job->state == JobState::Queued) {
+            queue_.erase(std::find(queue_.begin(), queue_.end(), job));
+            finish(job, JobState::Cancelled);
+            const string reply = describe(*job);
+            lock.unlock();
+            changed_.notify_all();
+            return reply;
+        }
+        return describe(*job);
+    }
+
+    string queueInfo() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::stringstream ss;
+        ss << "OK depth=" << queue_.size() << " running=" << (running_ ? std::to_string(running_->id) : "none")
+            << " done=" << doneCount_ << " failed=" << failedCount_ << " cancelled=" << cancelledCount_
+            << std::fixed << std::setprecision(3) << " uptime_s="
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+        return ss.str();
+    }
+
+    // Caller holds mutex_.
+    string describe(const DaemonJob& job) const {
+        std::stringstream ss;
+        ss << "OK id=" << job.id << " state=" << getJobStateName(job.state);
+        if (job.state == JobState::Queued) {
+            ss << " position=" << (std::find_if(queue_.begin(), queue_.end(), [&](const std::shared_ptr<DaemonJob>& j) { return j->id == job.id; }) - queue_.begin());
+        }
+        if (isFinished(job.state) && job.state != JobState::Cancelled) {
+            ss << std::fixed << std::setprecision(6) << " queue_s=" << job.queueSeconds << " run_s=" << job.runSeconds;
+        }
+        if (job.state == JobState::Done) {
+            ss << " engine=" << job.result.engine_used << " shape=" << job.result.shape << " threads=" << job.result.threadsUsed
+                << std::setprecision(3) << " gflops=" << job.result.gflops;
+        }
+        if (job.state == JobState::Failed) ss << " error=\"" << job.error << "\"";
+        return ss.str();
+    }
+
+    // Caller holds mutex_. Releases the segments and keeps a bounded history of finished jobs.
+    void finish(const std::shared_ptr<DaemonJob>& job, JobState state) {
+        job->state = state;
+        job->a.reset();
+        job->b.reset();
+        job->c.reset();
+        if (state == JobState::Done) ++doneCount_;
+        else if (state == JobState::Failed) ++failedCount_;
+        else ++cancelledCount_;
+        finishedOrder_.push_back(job->id);
+        while (finishedOrder_.size() > static_cast<size_t>(DAEMON_MAX_FINISHED_JOBS)) {
+            jobs_.erase(finishedOrder_.front());
+            finishedOrder_.pop_front();
+        }
+    }
+
+    void workerLoop() {
+        while (true) {
+            std::shared_ptr<DaemonJob> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                changed_.wait(lock, [&] { return stopping_.load() || !queue_.empty(); });
+                if (queue_.empty()) return;
+                job = queue_.front();
+                queue_.pop_front();
+                job->state = JobState::Running;
+                running_ = job;
+            }
+            auto start = std::chrono::steady_clock::now();
+            job->queueSeconds = std::chrono::duration<double>(start - job->submitted).count();
+            JobState outcome = JobState::Done;
+            try {
+                const int a_rows = (job->transA == Transpose::None) ? job->M : job->K;
+                const int a_cols = (job->transA == Transpose::None) ? job->K : job->M;
+                const int b_rows = (job->transB == Transpose::None) ? job->K : job->N;
+                const int b_cols = (job->transB == Transpose::None) ? job->N : job->K;
+                job->result = gemm(job->transA, job->transB, job->alpha,
+                    ConstMatrixView(job->a->data(), a_rows, a_cols, a_cols), ConstMatrixView(job->b->data(), b_rows, b_cols, b_cols),
+                    job->beta, MatrixView(job->c->data(), job->M, job->N, job->N), job->options);
+            }
+            catch (const std::exception& e) {
+                outcome = job->cancel.load() ? JobState::Cancelled : JobState::Failed;
+                job->error = e.what();
+            }
+            job->runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                running_.reset();
+                finish(job, outcome);
+            }
+            changed_.notify_all();
+        }
+    }
+
+    const unsigned int defaultThreads_;
+    const std::chrono::steady_clock::time_point started_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<std::shared_ptr<DaemonJob>> queue_;
+    std::map<long long, std::shared_ptr<DaemonJob>> jobs_;
+    std::deque<long long> finishedOrder_;
+    std::shared_ptr<DaemonJob> running_;
+    long long nextId_ = 1;
+    long long doneCount_ = 0, failedCount_ = 0, cancelledCount_ = 0;
+    std::atomic<bool> stopping_{ false };
+    std::atomic<bool> shutdownRequested_{ false };
+    std::thread worker_;
+};
+
+
+// --- Connections ---
+bool writeAll(int fd, const string& text) {
+    size_t sent = 0;
+    while (sent < text.size()) {
+        ssize_t n = send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Answers request lines until the client hangs up or the daemon stops.
+void serveConnection(int fd, DaemonServer& server) {
+    string buffer;
+    char chunk[4096];
+    while (!server.stopping() && !server.shutdownRequested()) {
+        pollfd entry = { fd, POLLIN, 0 };
+        int ready = poll(&entry, 1, 200);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready < 0) break;
+        if (ready == 0) continue;
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        buffer.append(chunk, static_cast<size_t>(n));
+        size_t newline;
+        bool open = true;
+        while (open && (newline = buffer.find('\n')) != string::npos) {
+            string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            open = writeAll(fd, server.handle(line) + "\n");
+        }
+        if (!open) break;
+        if (buffer.size() > DAEMON_MAX_REQUEST_BYTES) {
+            writeAll(fd, "ERROR request too long\n");
+            break;
+        }
+    }
+    close(fd);
+}
+
+struct Connection {
+    std::thread thread;
+    std::shared_ptr<std::atomic<bool>> finished;
+};
+
+sockaddr_un socketAddress(const string& path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) throw std::invalid_argument("socket path too long: " + path);
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return address;
+}
+
+int connectTo(const string& path) {
+    sockaddr_un address = socketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Binds the listening socket, replacing a stale socket file but never a live daemon.
+int listenOn(const string& path) {
+    int existing = connectTo(path);
+    if (existing >= 0) {
+        close(existing);
+        throw std::runtime_error("another daemon is already listening on " + path);
+    }
+    unlink(path.c_str());
+    sockaddr_un address = socketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw std::runtime_error("socket: " + systemError());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 64) != 0) {
+        string error = systemError();
+        close(fd);
+        throw std::runtime_error("cannot listen on " + path + ": " + error);
+    }
+    return fd;
+}
+
+// Pool threads, packing buffers and kernel code are touched once so the first request is warm.
+void warmUp(unsigned int threads) {
+    getSharedThreadPool();
+    getAnalyticBlocking();
+    const int n = 256;
+    Matrix A = Matrix::generateRandom(n, n);
+    Matrix B = Matrix::generateRandom(n, n);
+    Matrix C(n, n);
+    GemmOptions options;
+    options.threads = threads;
+    gemm(Transpose::None, Transpose::None, 1.0, A, B, 0.0, C, options);
+}
+}
+
+
+// --- Public Interface ---
+int runDaemonMode(const ArgParser& parser) {
+    const string path = parser.optionExists("--socket") ? parser.getOption("--socket") : DAEMON_DEFAULT_SOCKET;
+    unsigned int threads = 0;
+    try {
+        if (parser.optionExists("--threads")) threads = static_cast<unsigned int>(std::stoul(parser.getOption("--threads")));
+    }
+    catch (const std::exception&) {
+        cerr << RED << "Error: invalid value for --threads." << RESET << endl;
+        return 2;
+    }
+
+    if (parser.optionExists("--retune")) autoTuneParameters(true);
+    else loadTunedParameters();
+
+    int listen_fd;
+    try {
+        listen_fd = listenOn(path);
+    }
+    catch (const std::exception& e) {
+        cerr << RED << "Error: " << e.what() << RESET << endl;
+        return 2;
+    }
+    std::signal(SIGINT, onDaemonSignal);
+    std::signal(SIGTERM, onDaemonSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    warmUp(threads);
+    DaemonServer server(threads);
+    cout << GREEN << "Fluminum daemon listening on " << path << " (pid " << getpid() << ", "
+        << ((threads == 0) ? getDefaultThreadCount() : threads) << " threads, tile " << G_OPTIMAL_TILE_SIZE
+        << ", Strassen threshold " << G_OPTIMAL_STRASSEN_THRESHOLD << ")." << RESET << endl;
+
+    std::list<Connection> connections;
+    while (!g_daemonSignalled.load() && !server.shutdownRequested()) {
+        pollfd entry = { listen_fd, POLLIN, 0 };
+        int ready = poll(&entry, 1, 200);
+        // Reap connections whose clients have gone.
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (it->finished->load()) { it->thread.join(); it = connections.erase(it); }
+            else ++it;
+        }
+        if (ready <= 0) continue;
+        int client = accept(listen_fd, nullptr, nullptr);
+        if (client < 0) continue;
+        auto finished = std::make_shared<std::atomic<bool>>(false);
+        connections.push_back({ std::thread([client, finished, &server] { serveConnection(client, server); finished->store(true); }), finished });
+    }
+
+    cout << YELLOW << "Fluminum daemon shutting down..." << RESET << endl;
+    close(listen_fd);
+    unlink(path.c_str());
+    server.stop();
+    for (Connection& connection : connections) connection.thread.join();
+    return 0;
+}
+
+int runDaemonCommand(const string& socket_path, const string& request) {
+    int fd;
+    try {
+        fd = connectTo(socket_path);
+    }
+    catch (const std::exception& e) {
+        cerr << RED << "Error: " << e.what() << RESET << endl;
+        return 2;
+    }
+    if (fd < 0) {
+        cerr << RED << "Error: no daemon listening on " << socket_path << " (" << systemError() << ")." << RESET << endl;
+        return 2;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    string reply;
+    char c;
+    bool ok = writeAll(fd, request + "\n");
+    while (ok && recv(fd, &c, 1, 0) == 1 && c != '\n') reply += c;
+    close(fd);
+    if (!ok || reply.empty()) {
+        cerr << RED << "Error: the daemon closed the connection without a reply." << RESET << endl;
+        return 2;
+    }
+    cout << reply << endl;
+    return (reply.compare(0, 2, "OK") == 0) ? 0 : 1;
+}
+
+#else
+
+int runDaemonMode(const ArgParser&) {
+    cerr << RED << "Error: daemon mode needs Unix domain sockets and POSIX shared memory, which this build does not have." << RESET << endl;
+    return 2;
+}
+
+int runDaemonCommand(const string&, const string&) {
+    cerr << RED << "Error: daemon mode needs Unix domain sockets and POSIX shared memory, which this build does not have." << RESET << endl;
+    return 2;
+}
+
+#endif
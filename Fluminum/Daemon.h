@@ -0,0 +1,37 @@
+#pragma once
+#include "Common.h"
+#include "ArgParser.h"
+
+// --- Daemon Mode ---
+// fluminum --daemon [--socket PATH] [--threads N] keeps the thread pool, tuned parameters and
+// kernels warm and serves products over a local Unix domain socket. Operands never travel
+// through the socket: the client places them in POSIX shared memory segments (shm_open) as
+// row-major doubles, creates the result segment, and names the three segments in a request.
+// The daemon maps them and gemm reads A and B and writes C in place.
+//
+// The protocol is one text line per request and one per reply ("OK key=value..." or
+// "ERROR message"):
+//   PING
+//   SUBMIT a=/A b=/B c=/C m=M n=N k=K [transa=0|1] [transb=0|1] [alpha=X] [beta=X]
+//          [engine=auto|simd|tiled|strassen|shape] [threads=N] -> OK id=<n> depth=<queued>
+//   STATUS id=<n>     State of a job without blocking
+//   WAIT id=<n>       Blocks until the job is done, failed or cancelled
+//   CANCEL id=<n>     Drops a queued job; a running SIMD product stops at its next panel
+//   QUEUE             Queue depth, running job and totals
+//   SHUTDOWN          Cancels queued jobs, finishes the running one and exits
+// op(A) is M x K, op(B) is K x N and C is M x N; each segment must be at least that large.
+
+const char* const DAEMON_DEFAULT_SOCKET = "/tmp/fluminum.sock";
+
+// Finished jobs kept for STATUS/WAIT; older ones are forgotten first.
+const int DAEMON_MAX_FINISHED_JOBS = 1024;
+
+// Longest request line accepted.
+const size_t DAEMON_MAX_REQUEST_BYTES = 4096;
+
+// Serves requests until SHUTDOWN, SIGINT or SIGTERM. Returns the process exit status.
+int runDaemonMode(const ArgParser& parser);
+
+// Client side for scripts: sends one request line to a running daemon and prints the reply.
+// Returns 0 for an OK reply, 1 for an ERROR reply and 2 when the daemon cannot be reached.
+int runDaemonCommand(const string& socket_path, const string& request);
@@ -0,0 +1,743 @@
+#define NOMINMAX
+#include "Distributed.h"
+#include "AutoTune.h"
+#include "Gemm.h"
+#include "IO.h"
+#include "Matrix.h"
+#include "System.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// --- Transport ---
+void DistributedTransport::send(int destination, const void* data, size_t bytes) {
+    const unsigned long long length = bytes;
+    writeBytes(destination, &length, sizeof(length));
+    if (bytes > 0) writeBytes(destination, data, bytes);
+    bytesSent_ += static_cast<double>(sizeof(length) + bytes);
+}
+
+void DistributedTransport::receive(int source, void* data, size_t bytes) {
+    unsigned long long length = 0;
+    readBytes(source, &length, sizeof(length));
+    if (length != bytes) {
+        throw std::runtime_error("rank " + std::to_string(rank_) + " expected " + std::to_string(bytes) + " bytes from rank "
+            + std::to_string(source) + " but the message holds " + std::to_string(length));
+    }
+    if (bytes > 0) readBytes(source, data, bytes);
+    bytesReceived_ += static_cast<double>(sizeof(length) + bytes);
+}
+
+#ifndef _WIN32
+namespace {
+string systemError() {
+    return std::strerror(errno);
+}
+
+// One stream socket pair per pair of ranks: sockets_[i][j] is rank i's end of the i-j pair.
+class SocketTransport : public DistributedTransport {
+public:
+    explicit SocketTransport(int ranks) : DistributedTransport(ranks), sockets_(ranks, std::vector<int>(ranks, -1)) {
+        for (int i = 0; i < ranks; ++i) {
+            for (int j = i + 1; j < ranks; ++j) {
+                int pair[2];
+                if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                    closeAll();
+                    throw std::runtime_error("socketpair: " + systemError());
+                }
+                sockets_[i][j] = pair[0];
+                sockets_[j][i] = pair[1];
+            }
+        }
+    }
+
+    ~SocketTransport() override { closeAll(); }
+
+    string name() const override { return "socket"; }
+
+    void bindRank(int rank) override {
+        rank_ = rank;
+        for (int i = 0; i < size_; ++i) {
+            if (i == rank) continue;
+            for (int& fd : sockets_[i]) {
+                if (fd >= 0) close(fd);
+                fd = -1;
+            }
+        }
+    }
+
+    // Shutting the sockets down wakes any send or recv blocked on them.
+    void abort() override {
+        aborted_.store(true);
+        for (int fd : sockets_[rank_]) if (fd >= 0) shutdown(fd, SHUT_RDWR);
+    }
+
+protected:
+    void writeBytes(int destination, const void* data, size_t bytes) override {
+        const char* p = static_cast<const char*>(data);
+        while (bytes > 0) {
+            ssize_t n = ::send(peer(destination), p, bytes, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw std::runtime_error("send to rank " + std::to_string(destination) + " failed: " + (aborted_.load() ? string("aborted") : systemError()));
+            p += n;
+            bytes -= static_cast<size_t>(n);
+        }
+    }
+
+    void readBytes(int source, void* data, size_t bytes) override {
+        char* p = static_cast<char*>(data);
+        while (bytes > 0) {
+            ssize_t n = recv(peer(source), p, bytes, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n == 0 || aborted_.load()) throw std::runtime_error("rank " + std::to_string(source) + " closed its connection");
+            if (n < 0) throw std::runtime_error("receive from rank " + std::to_string(source) + " failed: " + systemError());
+            p += n;
+            bytes -= static_cast<size_t>(n);
+        }
+    }
+
+private:
+    int peer(int other) const {
+        if (other < 0 || other >= size_ || other == rank_) throw std::invalid_argument("no channel from rank " + std::to_string(rank_) + " to rank " + std::to_string(other));
+        return sockets_[rank_][other];
+    }
+
+    void closeAll() {
+        for (auto& row : sockets_) for (int& fd : row) if (fd >= 0) { close(fd); fd = -1; }
+    }
+
+    std::vector<std::vector<int>> sockets_;
+    std::atomic<bool> aborted_{ false };
+};
+
+
+// A single-producer, single-consumer ring in a shared mapping. The counters only move under the
+// process-shared mutex; the copies happen outside it, since each side owns its half of the ring.
+struct SharedChannel {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    unsigned long long written;
+    unsigned long long read;
+    char data[DISTRIBUTED_SHM_CHANNEL_BYTES];
+};
+
+struct SharedRegionHeader {
+    std::atomic<int> aborted;
+};
+
+// Rings for every ordered pair of ranks in one anonymous shared mapping, inherited across fork.
+class SharedMemoryTransport : public DistributedTransport {
+public:
+    explicit SharedMemoryTransport(int ranks) : DistributedTransport(ranks) {
+        channelStride_ = (sizeof(SharedChannel) + 63) / 64 * 64;
+        regionBytes_ = 64 + channelStride_ * static_cast<size_t>(ranks) * ranks;
+        void* mapped = mmap(nullptr, regionBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapped == MAP_FAILED) throw std::runtime_error("cannot map " + std::to_string(regionBytes_ >> 20) + " MB of shared memory: " + systemError());
+        region_ = static_cast<char*>(mapped);
+        new (region_) SharedRegionHeader{};
+
+        pthread_mutexattr_t mutex_attr;
+        pthread_mutexattr_init(&mutex_attr);
+        pthread_mutexattr_setpshared(&mutex_attr, PTHREAD_PROCESS_SHARED);
+        pthread_condattr_t cond_attr;
+        pthread_condattr_init(&cond_attr);
+        pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+        pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+        for (int i = 0; i < ranks; ++i) {
+            for (int j = 0; j < ranks; ++j) {
+                if (i == j) continue;
+                SharedChannel& c = channel(i, j);
+                pthread_mutex_init(&c.mutex, &mutex_attr);
+                pthread_cond_init(&c.changed, &cond_attr);
+                c.written = 0;
+                c.read = 0;
+            }
+        }
+        pthread_condattr_destroy(&cond_attr);
+        pthread_mutexattr_destroy(&mutex_attr);
+    }
+
+    ~SharedMemoryTransport() override { munmap(region_, regionBytes_); }
+
+    string name() const override { return "shm"; }
+
+    void bindRank(int rank) override { rank_ = rank; }
+
+    // Blocked waits notice the flag at their next timeout.
+    void abort() override { header().aborted.store(1); }
+
+protected:
+    void writeBytes(int destination, const void* data, size_t bytes) override {
+        SharedChannel& c = channel(rank_, checkedPeer(destination));
+        const char* p = static_cast<const char*>(data);
+        while (bytes > 0) {
+            unsigned long long position;
+            size_t chunk;
+            pthread_mutex_lock(&c.mutex);
+            waitWhile(c, [&] { return c.written - c.read == DISTRIBUTED_SHM_CHANNEL_BYTES; }, destination);
+            position = c.written % DISTRIBUTED_SHM_CHANNEL_BYTES;
+            chunk = std::min<size_t>({ bytes, static_cast<size_t>(DISTRIBUTED_SHM_CHANNEL_BYTES - (c.written - c.read)),
+                static_cast<size_t>(DISTRIBUTED_SHM_CHANNEL_BYTES - position) });
+            pthread_mutex_unlock(&c.mutex);
+
+            std::memcpy(c.data + position, p, chunk);
+
+            pthread_mutex_lock(&c.mutex);
+            c.written += chunk;
+            pthread_cond_broadcast(&c.changed);
+            pthread_mutex_unlock(&c.mutex);
+            p += chunk;
+            bytes -= chunk;
+        }
+    }
+
+    void readBytes(int source, void* data, size_t bytes) override {
+        SharedChannel& c = channel(checkedPeer(source), rank_);
+        char* p = static_cast<char*>(data);
+        while (bytes > 0) {
+            unsigned long long position;
+            size_t chunk;
+            pthread_mutex_lock(&c.mutex);
+            waitWhile(c, [&] { return c.written == c.read; }, source);
+            position = c.read % DISTRIBUTED_SHM_CHANNEL_BYTES;
+            chunk = std::min<size_t>({ bytes, static_cast<size_t>(c.written - c.read), static_cast<size_t>(DISTRIBUTED_SHM_CHANNEL_BYTES - position) });
+            pthread_mutex_unlock(&c.mutex);
+
+            std::memcpy(p, c.data + position, chunk);
+
+            pthread_mutex_lock(&c.mutex);
+            c.read += chunk;
+            pthread_cond_broadcast(&c.changed);
+            pthread_mutex_unlock(&c.mutex);
+            p += chunk;
+            bytes -= chunk;
+        }
+    }
+
+private:
+    SharedRegionHeader& header() const { return *reinterpret_cast<SharedRegionHeader*>(region_); }
+
+    SharedChannel& channel(int from, int to) const {
+        return *reinterpret_cast<SharedChannel*>(region_ + 64 + channelStride_ * (static_cast<size_t>(from) * size_ + to));
+    }
+
+    int checkedPeer(int other) const {
+        if (other < 0 || other >= size_ || other == rank_) throw std::invalid_argument("no channel from rank " + std::to_string(rank_) + " to rank " + std::to_string(other));
+        return other;
+    }
+
+    // Caller holds c.mutex; it is released on the way out of a throw.
+    template<class Predicate>
+    void waitWhile(SharedChannel& c, Predicate blocked, int peer) {
+        while (blocked()) {
+            if (header().aborted.load()) {
+                pthread_mutex_unlock(&c.mutex);
+                throw std::runtime_error("rank " + std::to_string(rank_) + " stopped waiting for rank " + std::to_string(peer) + ": another rank failed");
+            }
+            timespec deadline;
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_nsec += 100 * 1000 * 1000;
+            if (deadline.tv_nsec >= 1000 * 1000 * 1000) {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000 * 1000 * 1000;
+            }
+            pthread_cond_timedwait(&c.changed, &c.mutex, &deadline);
+        }
+    }
+
+    char* region_ = nullptr;
+    size_t regionBytes_ = 0;
+    size_t channelStride_ = 0;
+};
+}
+
+std::unique_ptr<DistributedTransport> createLocalTransport(const string& kind, int ranks) {
+    if (ranks < 1 || ranks > DISTRIBUTED_MAX_RANKS) throw std::invalid_argument("rank count must be between 1 and " + std::to_string(DISTRIBUTED_MAX_RANKS));
+    if (kind == "shm") return std::make_unique<SharedMemoryTransport>(ranks);
+    if (kind == "socket") return std::make_unique<SocketTransport>(ranks);
+    throw std::invalid_argument("unknown transport '" + kind + "' (shm or socket)");
+}
+#else
+std::unique_ptr<DistributedTransport> createLocalTransport(const string&, int) {
+    throw std::runtime_error("local transports need POSIX shared memory and Unix domain sockets, which this build does not have");
+}
+#endif
+
+
+// --- Process Grid ---
+std::pair<int, int> chooseProcessGrid(int ranks) {
+    int rows = 1;
+    for (int r = 1; r * r <= ranks; ++r) if (ranks % r == 0) rows = r;
+    return { rows, ranks / rows };
+}
+
+namespace {
+// The part of [0, n) that block `index` of `parts` owns.
+std::pair<int, int> blockRange(int n, int parts, int index) {
+    const long long begin = static_cast<long long>(n) * index / parts;
+    const long long end = static_cast<long long>(n) * (index + 1) / parts;
+    return { static_cast<int>(begin), static_cast<int>(end) };
+}
+
+// The block of [0, n) split into `parts` that holds position k.
+int blockOwning(int n, int parts, int k) {
+    int owner = static_cast<int>(static_cast<long long>(k) * parts / n);
+    while (blockRange(n, parts, owner).first > k) --owner;
+    while (blockRange(n, parts, owner).second <= k) ++owner;
+    return owner;
+}
+
+struct SummaPlan {
+    int M = 0, K = 0, N = 0;
+    int gridRows = 1, gridCols = 1;
+    int panel = 0;
+    unsigned int threads = 1;
+};
+
+// Row-major copy of a block of `source`, as sent over the transport.
+std::vector<double> packBlock(ConstMatrixView source, int row, int col, int rows, int cols) {
+    std::vector<double> packed(static_cast<size_t>(rows) * cols);
+    for (int r = 0; r < rows; ++r) {
+        std::copy(source.data() + (row + r) * source.stride() + col, source.data() + (row + r) * source.stride() + col + cols,
+            packed.begin() + static_cast<size_t>(r) * cols);
+    }
+    return packed;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// One rank of SUMMA. Rank 0 passes the full operands and receives the full product in C;
+// the other ranks pass empty views.
+DistributedRankStats runSummaRank(DistributedTransport& transport, const SummaPlan& plan,
+    ConstMatrixView A, ConstMatrixView B, MatrixView C) {
+    const auto rank_start = std::chrono::steady_clock::now();
+    const int rank = transport.rank();
+    DistributedRankStats stats;
+    stats.rank = rank;
+    stats.gridRow = rank / plan.gridCols;
+    stats.gridCol = rank % plan.gridCols;
+    auto rank_at = [&](int row, int col) { return row * plan.gridCols + col; };
+
+    // A is split M by rows and K by columns of the grid; B is split K by rows and N by columns.
+    const std::pair<int, int> my_rows = blockRange(plan.M, plan.gridRows, stats.gridRow);
+    const std::pair<int, int> my_cols = blockRange(plan.N, plan.gridCols, stats.gridCol);
+    const std::pair<int, int> my_a_k = blockRange(plan.K, plan.gridCols, stats.gridCol);
+    const std::pair<int, int> my_b_k = blockRange(plan.K, plan.gridRows, stats.gridRow);
+    const int mi = my_rows.second - my_rows.first;
+    const int nj = my_cols.second - my_cols.first;
+    const int a_width = my_a_k.second - my_a_k.first;
+    const int b_height = my_b_k.second - my_b_k.first;
+    stats.rows = mi;
+    stats.cols = nj;
+
+    // --- Scatter ---
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> local_a, local_b;
+    if (rank == 0) {
+        for (int q = transport.size() - 1; q >= 0; --q) {
+            const int qr = q / plan.gridCols, qc = q % plan.gridCols;
+            const std::pair<int, int> rows = blockRange(plan.M, plan.gridRows, qr);
+            const std::pair<int, int> cols = blockRange(plan.N, plan.gridCols, qc);
+            const std::pair<int, int> a_k = blockRange(plan.K, plan.gridCols, qc);
+            const std::pair<int, int> b_k = blockRange(plan.K, plan.gridRows, qr);
+            std::vector<double> a = packBlock(A, rows.first, a_k.first, rows.second - rows.first, a_k.second - a_k.first);
+            std::vector<double> b = packBlock(B, b_k.first, cols.first, b_k.second - b_k.first, cols.second - cols.first);
+            if (q == 0) {
+                local_a = std::move(a);
+                local_b = std::move(b);
+                continue;
+            }
+            transport.send(q, a.data(), a.size() * sizeof(double));
+            transport.send(q, b.data(), b.size() * sizeof(double));
+        }
+    }
+    else {
+        local_a.resize(static_cast<size_t>(mi) * a_width);
+        local_b.resize(static_cast<size_t>(b_height) * nj);
+        transport.receive(0, local_a.data(), local_a.size() * sizeof(double));
+        transport.receive(0, local_b.data(), local_b.size() * sizeof(double));
+    }
+    stats.scatterSeconds = secondsSince(start);
+
+    // --- Panel Broadcasts and Local Updates ---
+    std::vector<double> local_c(static_cast<size_t>(mi) * nj, 0.0);
+    std::vector<double> a_panel, b_panel;
+    GemmOptions options;
+    options.engine = GemmEngine::Tiled;
+    options.threads = plan.threads;
+    for (int k = 0; k < plan.K;) {
+        // Panels never straddle the K split of either operand, so each has one owner.
+        const int a_owner = blockOwning(plan.K, plan.gridCols, k);
+        const int b_owner = blockOwning(plan.K, plan.gridRows, k);
+        const int end = std::min({ plan.K, k + plan.panel, blockRange(plan.K, plan.gridCols, a_owner).second,
+            blockRange(plan.K, plan.gridRows, b_owner).second });
+        const int width = end - k;
+
+        start = std::chrono::steady_clock::now();
+        // The A panel travels along this grid row, the B panel along this grid column.
+        ConstMatrixView a_view, b_view;
+        if (stats.gridCol == a_owner) {
+            a_view = ConstMatrixView(local_a.data() + (k - my_a_k.first), mi, width, std::max(1, a_width));
+            if (plan.gridCols > 1) {
+                a_panel = packBlock(a_view, 0, 0, mi, width);
+                for (int c = 0; c < plan.gridCols; ++c) {
+                    if (c != stats.gridCol) transport.send(rank_at(stats.gridRow, c), a_panel.data(), a_panel.size() * sizeof(double));
+                }
+            }
+        }
+        else {
+            a_panel.resize(static_cast<size_t>(mi) * width);
+            transport.receive(rank_at(stats.gridRow, a_owner), a_panel.data(), a_panel.size() * sizeof(double));
+            a_view = ConstMatrixView(a_panel.data(), mi, width, width);
+        }
+        if (stats.gridRow == b_owner) {
+            // Whole rows of the local B block, so the panel is already contiguous.
+            b_view = ConstMatrixView(local_b.data() + static_cast<size_t>(k - my_b_k.first) * nj, width, nj, std::max(1, nj));
+            for (int r = 0; r < plan.gridRows; ++r) {
+                if (r != stats.gridRow) transport.send(rank_at(r, stats.gridCol), b_view.data(), static_cast<size_t>(width) * nj * sizeof(double));
+            }
+        }
+        else {
+            b_panel.resize(static_cast<size_t>(width) * nj);
+            transport.receive(rank_at(b_owner, stats.gridCol), b_panel.data(), b_panel.size() * sizeof(double));
+            b_view = ConstMatrixView(b_panel.data(), width, nj, std::max(1, nj));
+        }
+        stats.commSeconds += secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        if (mi > 0 && nj > 0) {
+            gemm(Transpose::None, Transpose::None, 1.0, a_view, b_view, 1.0, MatrixView(local_c.data(), mi, nj, nj), options);
+        }
+        stats.computeSeconds += secondsSince(start);
+        ++stats.panels;
+        k = end;
+    }
+
+    // --- Gather ---
+    start = std::chrono::steady_clock::now();
+    if (rank == 0) {
+        for (int q = 0; q < transport.size(); ++q) {
+            const std::pair<int, int> rows = blockRange(plan.M, plan.gridRows, q / plan.gridCols);
+            const std::pair<int, int> cols = blockRange(plan.N, plan.gridCols, q % plan.gridCols);
+            const int block_cols = cols.second - cols.first;
+            std::vector<double> block;
+            if (q == 0) block = std::move(local_c);
+            else {
+                block.resize(static_cast<size_t>(rows.second - rows.first) * block_cols);
+                transport.receive(q, block.data(), block.size() * sizeof(double));
+            }
+            for (int r = rows.first; r < rows.second; ++r) {
+                std::copy(block.begin() + static_cast<size_t>(r - rows.first) * block_cols, block.begin() + static_cast<size_t>(r - rows.first + 1) * block_cols,
+                    C.data() + r * C.stride() + cols.first);
+            }
+        }
+    }
+    else {
+        transport.send(0, local_c.data(), local_c.size() * sizeof(double));
+    }
+    stats.gatherSeconds = secondsSince(start);
+    stats.bytesSent = transport.bytesSent();
+    stats.bytesReceived = transport.bytesReceived();
+    stats.totalSeconds = secondsSince(rank_start);
+    return stats;
+}
+
+// Ranks report their statistics to rank 0 as a fixed array of doubles.
+const int STATS_FIELDS = 13;
+
+void encodeStats(const DistributedRankStats& s, double* out) {
+    const double fields[STATS_FIELDS] = { static_cast<double>(s.rank), static_cast<double>(s.gridRow), static_cast<double>(s.gridCol),
+        static_cast<double>(s.rows), static_cast<double>(s.cols), static_cast<double>(s.panels), s.scatterSeconds, s.commSeconds,
+        s.computeSeconds, s.gatherSeconds, s.totalSeconds, s.bytesSent, s.bytesReceived };
+    std::copy(fields, fields + STATS_FIELDS, out);
+}
+
+DistributedRankStats decodeStats(const double* in) {
+    DistributedRankStats s;
+    s.rank = static_cast<int>(in[0]);
+    s.gridRow = static_cast<int>(in[1]);
+    s.gridCol = static_cast<int>(in[2]);
+    s.rows = static_cast<int>(in[3]);
+    s.cols = static_cast<int>(in[4]);
+    s.panels = static_cast<int>(in[5]);
+    s.scatterSeconds = in[6];
+    s.commSeconds = in[7];
+    s.computeSeconds = in[8];
+    s.gatherSeconds = in[9];
+    s.totalSeconds = in[10];
+    s.bytesSent = in[11];
+    s.bytesReceived = in[12];
+    return s;
+}
+
+
+// --- Reporting ---
+void printRankTable(const std::vector<DistributedRankStats>& ranks) {
+    cout << " Rank  Grid   Block of C      Panels  Scatter s  Comm s     Compute s  Gather s   Sent MB   Recv MB" << endl;
+    for (const DistributedRankStats& s : ranks) {
+        std::stringstream block, grid;
+        block << s.rows << "x" << s.cols;
+        grid << s.gridRow << "," << s.gridCol;
+        cout << " " << std::left << std::setw(6) << s.rank << std::setw(7) << grid.str() << std::setw(16) << block.str()
+            << std::setw(8) << s.panels << std::right << std::fixed << std::setprecision(4)
+            << std::setw(9) << s.scatterSeconds << "  " << std::setw(9) << s.commSeconds << "  "
+            << std::setw(9) << s.computeSeconds << "  " << std::setw(9) << s.gatherSeconds << "  "
+            << std::setprecision(2) << std::setw(8) << s.bytesSent / 1e6 << "  " << std::setw(8) << s.bytesReceived / 1e6 << endl;
+    }
+}
+
+bool appendRankCsv(const string& filename, const SummaPlan& plan, const string& transport, const std::vector<DistributedRankStats>& ranks) {
+    const bool write_header = !std::ifstream(filename).good();
+    std::ofstream out(filename, std::ios::app);
+    if (!out) return false;
+    if (write_header) {
+        out << "Timestamp,Transport,Ranks,Grid,M,K,N,Panel,ThreadsPerRank,Rank,GridRow,GridCol,BlockRows,BlockCols,Panels,"
+            << "ScatterSeconds,CommSeconds,ComputeSeconds,GatherSeconds,TotalSeconds,BytesSent,BytesReceived\n";
+    }
+    const string timestamp = std::to_string(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    for (const DistributedRankStats& s : ranks) {
+        out << timestamp << "," << transport << "," << ranks.size() << "," << plan.gridRows << "x" << plan.gridCols << ","
+            << plan.M << "," << plan.K << "," << plan.N << "," << plan.panel << "," << plan.threads << ","
+            << s.rank << "," << s.gridRow << "," << s.gridCol << "," << s.rows << "," << s.cols << "," << s.panels << ","
+            << std::fixed << std::setprecision(6) << s.scatterSeconds << "," << s.commSeconds << "," << s.computeSeconds << ","
+            << s.gatherSeconds << "," << s.totalSeconds << "," << std::setprecision(0) << s.bytesSent << "," << s.bytesReceived << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+void printUsage() {
+    cout << "Usage: fluminum --distributed N --a FILE --b FILE [--out FILE] [--grid RxC] [--transport shm|socket]\n"
+        << "                [--panel W] [--threads T] [--verify] [--csv FILE]\n"
+        << "Runs one product as SUMMA across N local worker processes (at most " << DISTRIBUTED_MAX_RANKS << ") and reports\n"
+        << "compute and communication time per rank. Exit status: " << DISTRIBUTED_EXIT_SUCCESS << " success, "
+        << DISTRIBUTED_EXIT_FAILED << " a rank failed or verification found a mismatch, " << DISTRIBUTED_EXIT_USAGE << " usage error." << endl;
+}
+
+int parsePositiveOption(const ArgParser& parser, const string& option, int fallback) {
+    if (!parser.optionExists(option)) return fallback;
+    try {
+        size_t used = 0;
+        int value = std::stoi(parser.getOption(option), &used);
+        if (used == parser.getOption(option).size() && value > 0) return value;
+    }
+    catch (const std::exception&) {}
+    throw std::invalid_argument("invalid value '" + parser.getOption(option) + "' for " + option);
+}
+}
+
+
+// --- Public Interface ---
+#ifndef _WIN32
+int runDistributedMode(const ArgParser& parser) {
+    int ranks;
+    SummaPlan plan;
+    string transport_kind = "shm";
+    try {
+        ranks = parsePositiveOption(parser, "--distributed", 0);
+        if (ranks > DISTRIBUTED_MAX_RANKS) throw std::invalid_argument("--distributed allows at most " + std::to_string(DISTRIBUTED_MAX_RANKS) + " ranks");
+        if (!parser.optionExists("--a") || !parser.optionExists("--b")) throw std::invalid_argument("--distributed needs --a and --b");
+        std::tie(plan.gridRows, plan.gridCols) = chooseProcessGrid(ranks);
+        if (parser.optionExists("--grid")) {
+            const string grid = parser.getOption("--grid");
+            size_t x = grid.find('x');
+            int r = 0, c = 0;
+            try {
+                r = std::stoi(grid.substr(0, x));
+                c = std::stoi(grid.substr(x + 1));
+            }
+            catch (const std::exception&) {}
+            if (x == string::npos || r <= 0 || c <= 0 || r * c != ranks) {
+                throw std::invalid_argument("--grid must be RxC with R * C = " + std::to_string(ranks) + ", got '" + grid + "'");
+            }
+            plan.gridRows = r;
+            plan.gridCols = c;
+        }
+        if (parser.optionExists("--transport")) transport_kind = parser.getOption("--transport");
+        loadTunedParameters();
+        plan.panel = parsePositiveOption(parser, "--panel", 4 * std::max(1, G_OPTIMAL_TILE_SIZE));
+        plan.threads = static_cast<unsigned int>(parsePositiveOption(parser, "--threads",
+            static_cast<int>(std::max(1u, getDefaultThreadCount() / static_cast<unsigned int>(ranks)))));
+    }
+    catch (const std::invalid_argument& e) {
+        cerr << RED << "Error: " << e.what() << RESET << endl;
+        printUsage();
+        return DISTRIBUTED_EXIT_USAGE;
+    }
+
+    // The workers are forked before anything starts a thread, so each builds its own pool.
+    std::unique_ptr<DistributedTransport> transport;
+    try {
+        transport = createLocalTransport(transport_kind, ranks);
+    }
+    catch (const std::invalid_argument& e) {
+        cerr << RED << "Error: " << e.what() << RESET << endl;
+        return DISTRIBUTED_EXIT_USAGE;
+    }
+    catch (const std::runtime_error& e) {
+        cerr << RED << "Error: " << e.what() << RESET << endl;
+        return DISTRIBUTED_EXIT_FAILED;
+    }
+    cout.flush();
+    std::signal(SIGPIPE, SIG_IGN);
+    std::vector<pid_t> workers;
+    for (int rank = 1; rank < ranks; ++rank) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            cerr << RED << "Error: fork failed for rank " << rank << " (" << std::strerror(errno) << ")." << RESET << endl;
+            transport->abort();
+            for (pid_t worker : workers) waitpid(worker, nullptr, 0);
+            return DISTRIBUTED_EXIT_FAILED;
+        }
+        if (pid == 0) {
+            // Workers learn the shape from rank 0 and leave with _exit, skipping the parent's exit handlers.
+            int status = 0;
+            try {
+                transport->bindRank(rank);
+                int shape[3];
+                transport->receive(0, shape, sizeof(shape));
+                if (shape[0] >= 0) {
+                    SummaPlan worker_plan = plan;
+                    worker_plan.M = shape[0];
+                    worker_plan.K = shape[1];
+                    worker_plan.N = shape[2];
+                    DistributedRankStats stats = runSummaRank(*transport, worker_plan, ConstMatrixView(), ConstMatrixView(), MatrixView());
+                    double encoded[STATS_FIELDS];
+                    encodeStats(stats, encoded);
+                    transport->send(0, encoded, sizeof(encoded));
+                }
+            }
+            catch (const std::exception& e) {
+                cerr << RED << "Error: rank " << rank << ": " << e.what() << RESET << endl;
+                transport->abort();
+                status = DISTRIBUTED_EXIT_FAILED;
+            }
+            cout.flush();
+            cerr.flush();
+            _exit(status);
+        }
+        workers.push_back(pid);
+    }
+    transport->bindRank(0);
+
+    // A worker that dies stops the others instead of leaving them blocked on it.
+    std::atomic<bool> worker_failed(false);
+    std::thread watcher([&] {
+        std::vector<bool> reaped(workers.size(), false);
+        size_t remaining = workers.size();
+        while (remaining > 0) {
+            for (size_t i = 0; i < workers.size(); ++i) {
+                int status = 0;
+                if (reaped[i] || waitpid(workers[i], &status, WNOHANG) != workers[i]) continue;
+                reaped[i] = true;
+                --remaining;
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                    worker_failed.store(true);
+                    transport->abort();
+                }
+            }
+            if (remaining > 0) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    });
+
+    int exit_code = DISTRIBUTED_EXIT_SUCCESS;
+    try {
+        Matrix A, B;
+        int shape[3] = { -1, -1, -1 };
+        try {
+            A = readMatrixFromFile(parser.getOption("--a"), nullptr, false);
+            B = readMatrixFromFile(parser.getOption("--b"), nullptr, false);
+            if (A.isEmpty() || B.isEmpty()) throw std::invalid_argument("empty input matrix");
+            if (A.cols() != B.rows()) {
+                throw std::invalid_argument("A is " + std::to_string(A.rows()) + "x" + std::to_string(A.cols()) + " but B is "
+                    + std::to_string(B.rows()) + "x" + std::to_string(B.cols()));
+            }
+        }
+        catch (const std::exception&) {
+            // Releases the workers before reporting the error.
+            for (int rank = 1; rank < ranks; ++rank) transport->send(rank, shape, sizeof(shape));
+            throw;
+        }
+        plan.M = A.rows();
+        plan.K = A.cols();
+        plan.N = B.cols();
+        shape[0] = plan.M;
+        shape[1] = plan.K;
+        shape[2] = plan.N;
+        cout << CYAN << "SUMMA: " << plan.M << "x" << plan.K << " by " << plan.K << "x" << plan.N << " on " << ranks << " ranks ("
+            << plan.gridRows << "x" << plan.gridCols << " grid, " << transport->name() << " transport, panel " << plan.panel << ", "
+            << plan.threads << " thread" << (plan.threads == 1 ? "" : "s") << " per rank)..." << RESET << endl;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int rank = 1; rank < ranks; ++rank) transport->send(rank, shape, sizeof(shape));
+        Matrix C(plan.M, plan.N);
+        std::vector<DistributedRankStats> stats = { runSummaRank(*transport, plan, A, B, C) };
+        for (int rank = 1; rank < ranks; ++rank) {
+            double encoded[STATS_FIELDS];
+            transport->receive(rank, encoded, sizeof(encoded));
+            stats.push_back(decodeStats(encoded));
+        }
+        const double wall_seconds = secondsSince(start);
+        watcher.join();
+
+        printRankTable(stats);
+        double compute = 0.0, comm = 0.0;
+        for (const DistributedRankStats& s : stats) {
+            compute = std::max(compute, s.computeSeconds);
+            comm = std::max(comm, s.commSeconds + s.scatterSeconds + s.gatherSeconds);
+        }
+        const double flops = 2.0 * plan.M * plan.K * plan.N;
+        cout << GREEN << "SUMMA finished in " << std::fixed << std::setprecision(4) << wall_seconds << "s ("
+            << std::setprecision(2) << flops / wall_seconds / 1e9 << " GFLOP/s); slowest rank spent " << std::setprecision(4)
+            << compute << "s computing and " << comm << "s communicating." << RESET << endl;
+
+        if (parser.optionExists("--verify")) {
+            Matrix reference(plan.M, plan.N);
+            gemm(Transpose::None, Transpose::None, 1.0, A, B, 0.0, reference);
+            double max_difference = 0.0, max_magnitude = 0.0;
+            for (int r = 0; r < plan.M; ++r) {
+                for (int c = 0; c < plan.N; ++c) {
+                    max_difference = std::max(max_difference, std::abs(C(r, c) - reference(r, c)));
+                    max_magnitude = std::max(max_magnitude, std::abs(reference(r, c)));
+                }
+            }
+            // Panels change the summation order, so the results agree to rounding, not bit for bit.
+            const double tolerance = 1e-12 * std::max(1.0, max_magnitude) * plan.K;
+            if (max_difference <= tolerance) {
+                cout << GREEN << "Verified against single-process gemm: max difference " << std::scientific << std::setprecision(2) << max_difference << "." << RESET << endl;
+            }
+            else {
+                cerr << RED << "Verification failed: max difference " << std::scientific << std::setprecision(2) << max_difference
+                    << " exceeds " << tolerance << "." << RESET << endl;
+                exit_code = DISTRIBUTED_EXIT_FAILED;
+            }
+            cout << std::defaultfloat;
+        }
+        if (parser.optionExists("--out")) saveMatrixToFile(C, parser.getOption("--out"), false);
+        if (parser.optionExists("--csv") && !appendRankCsv(parser.getOption("--csv"), plan, transport->name(), stats)) {
+            cerr << RED << "Error: cannot write " << parser.getOption("--csv") << "." << RESET << endl;
+            exit_code = DISTRIBUTED_EXIT_FAILED;
+        }
+    }
+    catch (const std::exception& e) {
+        transport->abort();
+        if (watcher.joinable()) watcher.join();
+        cerr << RED << "Error: " << (worker_failed.load() ? "a worker rank failed; " : "") << e.what() << RESET << endl;
+        return DISTRIBUTED_EXIT_FAILED;
+    }
+    return worker_failed.load() ? DISTRIBUTED_EXIT_FAILED : exit_code;
+}
+#else
+int runDistributedMode(const ArgParser&) {
+    cerr << RED << "Error: distributed mode needs fork, POSIX shared memory and Unix domain sockets, which this build does not have." << RESET << endl;
+    return DISTRIBUTED_EXIT_USAGE;
+}
+#endif
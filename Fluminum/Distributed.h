@@ -0,0 +1,90 @@
+#pragma once
+#include "Common.h"
+#include "ArgParser.h"
+#include <memory>
+
+// --- Distributed SUMMA ---
+// fluminum --distributed N --a A.csv --b B.csv [--out C.csv] runs one product across N worker
+// processes arranged in a process grid (--grid RxC; default the squarest factorization of N).
+// Each rank owns one 2D block of A, B and C. Rank 0 reads the operands, scatters the blocks
+// and gathers C; in between, every panel of the inner dimension is broadcast along the grid
+// rows (the A panel) and columns (the B panel), and each rank adds the panel product to its
+// block of C with the tiled gemm engine (SUMMA, van de Geijn and Watts).
+//   --transport shm|socket     Shared memory rings (default) or Unix domain socket pairs
+//   --panel W                  Panel width (default: the tuned tile size x 4)
+//   --threads T                Threads per rank (default: all cores / N)
+//   --verify                   Checks C against a single-process gemm
+//   --csv FILE                 Appends one row per rank
+// Compute, communication, scatter and gather times are reported for every rank.
+
+const int DISTRIBUTED_EXIT_SUCCESS = 0;
+const int DISTRIBUTED_EXIT_FAILED = 1;   // A rank failed, or --verify found a mismatch
+const int DISTRIBUTED_EXIT_USAGE = 2;
+
+const int DISTRIBUTED_MAX_RANKS = 64;
+
+// Capacity of each shared memory ring (one per ordered pair of ranks); larger messages stream
+// through it in pieces.
+const size_t DISTRIBUTED_SHM_CHANNEL_BYTES = 256 * 1024;
+
+// --- Transport ---
+// Ordered, reliable byte messages between the ranks of one run. Messages between a pair of
+// ranks arrive in the order they were sent, and send may block until the receiver has made
+// room. A transport that reaches other hosts only needs writeBytes, readBytes and bindRank.
+class DistributedTransport {
+public:
+    virtual ~DistributedTransport() = default;
+
+    virtual string name() const = 0;
+    int rank() const { return rank_; }
+    int size() const { return size_; }
+
+    // Called once in every process after the launcher has started it, before any message.
+    virtual void bindRank(int rank) = 0;
+
+    // Makes every blocked or later send and receive throw; used when another rank has failed.
+    virtual void abort() = 0;
+
+    // Each message carries its length; receive throws std::runtime_error when it differs.
+    void send(int destination, const void* data, size_t bytes);
+    void receive(int source, void* data, size_t bytes);
+
+    double bytesSent() const { return bytesSent_; }
+    double bytesReceived() const { return bytesReceived_; }
+
+protected:
+    explicit DistributedTransport(int size) : size_(size) {}
+    virtual void writeBytes(int destination, const void* data, size_t bytes) = 0;
+    virtual void readBytes(int source, void* data, size_t bytes) = 0;
+
+    int rank_ = 0;
+    const int size_;
+
+private:
+    double bytesSent_ = 0.0;
+    double bytesReceived_ = 0.0;
+};
+
+// "shm" or "socket": the channels of `ranks` processes on this host. Must be created before the
+// processes are forked, which then each call bindRank. Throws std::invalid_argument for an
+// unknown kind and std::runtime_error when the channels cannot be created.
+std::unique_ptr<DistributedTransport> createLocalTransport(const string& kind, int ranks);
+
+struct DistributedRankStats {
+    int rank = 0;
+    int gridRow = 0, gridCol = 0;
+    int rows = 0, cols = 0;             // Block of C this rank owns
+    int panels = 0;
+    double scatterSeconds = 0.0;        // Receiving (or, on rank 0, sending) the blocks of A and B
+    double commSeconds = 0.0;           // Panel broadcasts, packing included
+    double computeSeconds = 0.0;        // Local gemm updates
+    double gatherSeconds = 0.0;
+    double totalSeconds = 0.0;
+    double bytesSent = 0.0;
+    double bytesReceived = 0.0;
+};
+
+// Splits `ranks` into the most nearly square R x C grid, R <= C.
+std::pair<int, int> chooseProcessGrid(int ranks);
+
+int runDistributedMode(const ArgParser& parser);
@@ -0,0 +1,50 @@
+#define NOMINMAX
+#include "FixedMatrix.h"
+
+// --- Runtime Dispatch Table ---
+template<int N>
+static void fixed_multiply_square(const double* a, long long lda, const double* b, long long ldb, double* c, long long ldc) {
+    fixed_kernels::multiply<double, N, N, N>(a, lda, b, ldb, c, ldc);
+}
+
+template<int N>
+static void fixed_add_square(const double* a, long long lda, const double* b, long long ldb, double* c, long long ldc) {
+    fixed_kernels::add<double, N, N>(a, lda, b, ldb, c, ldc);
+}
+
+template<int N>
+static void fixed_transpose_square(const double* a, long long lda, double* out, long long ldo) {
+    fixed_kernels::transpose<double, N, N>(a, lda, out, ldo);
+}
+
+template<int N>
+static constexpr FixedKernelSet makeFixedKernelSet() {
+    return { N, fixed_multiply_square<N>, fixed_add_square<N>, fixed_transpose_square<N> };
+}
+
+static constexpr FixedKernelSet FIXED_KERNEL_TABLE[] = {
+    makeFixedKernelSet<2>(),  makeFixedKernelSet<3>(),  makeFixedKernelSet<4>(),  makeFixedKernelSet<5>(),
+    makeFixedKernelSet<6>(),  makeFixedKernelSet<7>(),  makeFixedKernelSet<8>(),  makeFixedKernelSet<9>(),
+    makeFixedKernelSet<10>(), makeFixedKernelSet<11>(), makeFixedKernelSet<12>(), makeFixedKernelSet<13>(),
+    makeFixedKernelSet<14>(), makeFixedKernelSet<15>(), makeFixedKernelSet<16>(),
+    makeFixedKernelSet<32>(), makeFixedKernelSet<64>(), makeFixedKernelSet<128>(),
+};
+
+const FixedKernelSet* getFixedKernels(int n) {
+    if (n >= 2 && n <= 16) return &FIXED_KERNEL_TABLE[n - 2];
+    switch (n) {
+    case 32: return &FIXED_KERNEL_TABLE[15];
+    case 64: return &FIXED_KERNEL_TABLE[16];
+    case 128: return &FIXED_KERNEL_TABLE[17];
+    default: return nullptr;
+    }
+}
+
+bool multiplyFixedSize(ConstMatrixView A, ConstMatrixView B, MatrixView C) {
+    int n = A.rows();
+    if (A.cols() != n || B.rows() != n || B.cols() != n || C.rows() != n || C.cols() != n) return false;
+    const FixedKernelSet* kernels = getFixedKernels(n);
+    if (!kernels) return false;
+    kernels->multiply(A.data(), A.stride(), B.data(), B.stride(), C.data(), C.stride());
+    return true;
+}
@@ -0,0 +1,238 @@
+#pragma once
+#include "Common.h"
+#include "Matrix.h"
+#include <array>
+#include <utility>
+
+// --- Compile-Time Sized Kernels ---
+// All sizes are template parameters, so loops over small dimensions are unrolled completely
+// and the accumulators live in registers. Kernels work on raw pointers with leading
+// dimensions so they can run directly on Matrix storage and on MatrixView windows.
+namespace fixed_kernels {
+
+// Calls f(std::integral_constant<int, I>) for I = 0 .. N-1, expanded at compile time.
+template<class F, int... I>
+inline void unroll_impl(F&& f, std::integer_sequence<int, I...>) {
+    (f(std::integral_constant<int, I>{}), ...);
+}
+
+template<int N, class F>
+inline void unroll(F&& f) {
+    unroll_impl(std::forward<F>(f), std::make_integer_sequence<int, N>{});
+}
+
+// Products with more than this many multiply-adds per row use constant-bound loops instead.
+constexpr int FULL_UNROLL_LIMIT = 256;
+
+#ifdef HAS_AVX
+inline __m256d fmadd(__m256d a, __m256d b, __m256d c) {
+#if defined(__FMA__) || defined(__AVX2__)
+    return _mm256_fmadd_pd(a, b, c);
+#else
+    return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+}
+
+// C (R x P) = A (R x N) * B (N x P) for double with P a multiple of 4.
+// A strip of up to 16 columns of one C row is held in 4 registers for the whole k loop.
+template<int R, int N, int P>
+inline void multiply_avx(const double* a, long long lda, const double* b, long long ldb, double* c, long long ldc) {
+    constexpr int W = (P >= 16) ? 16 : P;
+    constexpr int V = W / 4;
+    for (int i = 0; i < R; ++i) {
+        const double* a_row = a + i * lda;
+        for (int jb = 0; jb < P; jb += W) {
+            __m256d acc[V];
+            unroll<V>([&](auto v) { acc[v] = _mm256_setzero_pd(); });
+            if constexpr (N <= 16) {
+                unroll<N>([&](auto k) {
+                    const __m256d aik = _mm256_broadcast_sd(a_row + k);
+                    const double* b_row = b + k * ldb + jb;
+                    unroll<V>([&](auto v) { acc[v] = fmadd(aik, _mm256_loadu_pd(b_row + 4 * v), acc[v]); });
+                });
+            }
+            else {
+                for (int k = 0; k < N; ++k) {
+                    const __m256d aik = _mm256_broadcast_sd(a_row + k);
+                    const double* b_row = b + k * ldb + jb;
+                    unroll<V>([&](auto v) { acc[v] = fmadd(aik, _mm256_loadu_pd(b_row + 4 * v), acc[v]); });
+                }
+            }
+            unroll<V>([&](auto v) { _mm256_storeu_pd(c + i * ldc + jb + 4 * v, acc[v]); });
+        }
+    }
+}
+
+// 4x4 in-register transpose of doubles.
+inline void transpose4x4_avx(const double* a, long long lda, double* out, long long ldo) {
+    __m256d r0 = _mm256_loadu_pd(a);
+    __m256d r1 = _mm256_loadu_pd(a + lda);
+    __m256d r2 = _mm256_loadu_pd(a + 2 * lda);
+    __m256d r3 = _mm256_loadu_pd(a + 3 * lda);
+    __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(out, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(out + ldo, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(out + 2 * ldo, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(out + 3 * ldo, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+#endif
+
+// C = A * B (overwrites C).
+template<typename T, int R, int N, int P>
+inline void multiply(const T* a, long long lda, const T* b, long long ldb, T* c, long long ldc) {
+#ifdef HAS_AVX
+    if constexpr (std::is_same_v<T, double> && P % 4 == 0) {
+        multiply_avx<R, N, P>(a, lda, b, ldb, c, ldc);
+        return;
+    }
+#endif
+    for (int i = 0; i < R; ++i) {
+        const T* a_row = a + i * lda;
+        T acc[P] = {};
+        if constexpr (N * P <= FULL_UNROLL_LIMIT) {
+            unroll<N>([&](auto k) {
+                const T aik = a_row[k];
+                unroll<P>([&](auto j) { acc[j] += aik * b[k * ldb + j]; });
+            });
+        }
+        else {
+            for (int k = 0; k < N; ++k) {
+                const T aik = a_row[k];
+                const T* b_row = b + k * ldb;
+                for (int j = 0; j < P; ++j) acc[j] += aik * b_row[j];
+            }
+        }
+        for (int j = 0; j < P; ++j) c[i * ldc + j] = acc[j];
+    }
+}
+
+// C = A + B.
+template<typename T, int R, int Cols>
+inline void add(const T* a, long long lda, const T* b, long long ldb, T* c, long long ldc) {
+    for (int i = 0; i < R; ++i) {
+        if constexpr (Cols <= 16) {
+            unroll<Cols>([&](auto j) { c[i * ldc + j] = a[i * lda + j] + b[i * ldb + j]; });
+        }
+        else {
+            for (int j = 0; j < Cols; ++j) c[i * ldc + j] = a[i * lda + j] + b[i * ldb + j];
+        }
+    }
+}
+
+// Out (Cols x R) = A^T (A is R x Cols). Out must not alias A.
+template<typename T, int R, int Cols>
+inline void transpose(const T* a, long long lda, T* out, long long ldo) {
+#ifdef HAS_AVX
+    if constexpr (std::is_same_v<T, double> && R % 4 == 0 && Cols % 4 == 0) {
+        for (int i = 0; i < R; i += 4) {
+            for (int j = 0; j < Cols; j += 4) transpose4x4_avx(a + i * lda + j, lda, out + j * ldo + i, ldo);
+        }
+        return;
+    }
+#endif
+    for (int i = 0; i < R; ++i) {
+        for (int j = 0; j < Cols; ++j) out[j * ldo + i] = a[i * lda + j];
+    }
+}
+
+} // namespace fixed_kernels
+
+
+// --- Fixed-Size Matrix ---
+// Value type with compile-time dimensions and no bounds checks. Storage is row-major and
+// aligned for AVX loads, so it can be copied to and from Matrix / MatrixView blocks cheaply.
+template<typename T, int R, int C>
+class FixedMatrix {
+    static_assert(R > 0 && C > 0, "FixedMatrix dimensions must be positive.");
+
+public:
+    FixedMatrix() { data_.fill(T(0)); }
+
+    static constexpr int rows() { return R; }
+    static constexpr int cols() { return C; }
+
+    T& operator()(int r, int c) { return data_[r * C + c]; }
+    const T& operator()(int r, int c) const { return data_[r * C + c]; }
+    T* data() { return data_.data(); }
+    const T* data() const { return data_.data(); }
+
+    // --- Interop with Matrix / MatrixView ---
+    static FixedMatrix load(ConstMatrixView view) {
+        if (view.rows() != R || view.cols() != C) throw std::invalid_argument("FixedMatrix::load: view shape does not match.");
+        FixedMatrix result;
+        for (int i = 0; i < R; ++i) {
+            for (int j = 0; j < C; ++j) result.data_[i * C + j] = static_cast<T>(view(i, j));
+        }
+        return result;
+    }
+
+    static FixedMatrix load(const Matrix& m, int row = 0, int col = 0) {
+        return load(ConstMatrixView(m).block(row, col, R, C));
+    }
+
+    void store(MatrixView view) const {
+        if (view.rows() != R || view.cols() != C) throw std::invalid_argument("FixedMatrix::store: view shape does not match.");
+        for (int i = 0; i < R; ++i) {
+            for (int j = 0; j < C; ++j) view(i, j) = static_cast<double>(data_[i * C + j]);
+        }
+    }
+
+    Matrix toMatrix() const {
+        Matrix m(R, C);
+        store(MatrixView(m));
+        return m;
+    }
+
+    // --- Arithmetic ---
+    template<int P>
+    FixedMatrix<T, R, P> operator*(const FixedMatrix<T, C, P>& other) const {
+        FixedMatrix<T, R, P> result;
+        fixed_kernels::multiply<T, R, C, P>(data(), C, other.data(), P, result.data(), P);
+        return result;
+    }
+
+    FixedMatrix operator+(const FixedMatrix& other) const {
+        FixedMatrix result;
+        fixed_kernels::add<T, R, C>(data(), C, other.data(), C, result.data(), C);
+        return result;
+    }
+
+    FixedMatrix operator-(const FixedMatrix& other) const {
+        FixedMatrix result;
+        for (int i = 0; i < R * C; ++i) result.data_[i] = data_[i] - other.data_[i];
+        return result;
+    }
+
+    FixedMatrix<T, C, R> transposed() const {
+        FixedMatrix<T, C, R> result;
+        fixed_kernels::transpose<T, R, C>(data(), C, result.data(), R);
+        return result;
+    }
+
+private:
+    alignas(32) std::array<T, static_cast<size_t>(R) * C> data_;
+};
+
+
+// --- Runtime Dispatch Table (square double kernels) ---
+// Sizes 2-16 are fully unrolled; 32, 64 and 128 cover the power-of-two Strassen base cases.
+typedef void (*FixedMultiplyKernel)(const double* a, long long lda, const double* b, long long ldb, double* c, long long ldc);
+typedef void (*FixedAddKernel)(const double* a, long long lda, const double* b, long long ldb, double* c, long long ldc);
+typedef void (*FixedTransposeKernel)(const double* a, long long lda, double* out, long long ldo);
+
+struct FixedKernelSet {
+    int size;
+    FixedMultiplyKernel multiply;
+    FixedAddKernel add;
+    FixedTransposeKernel transpose;
+};
+
+// Returns the kernel set for an n x n problem, or nullptr if no specialization exists.
+const FixedKernelSet* getFixedKernels(int n);
+
+// C = A * B through the table when all three views are the same supported square size.
+// Returns false (and leaves C untouched) when the generic engines must be used instead.
+bool multiplyFixedSize(ConstMatrixView A, ConstMatrixView B, MatrixView C);
@@ -0,0 +1,633 @@
+#define NOMINMAX
+#include "Gemm.h"
+#include "Algorithm.h"
+#include "CacheTopology.h"
+#include "CostModel.h"
+#include "FixedMatrix.h"
+#include "HardwareCounters.h"
+#include "Trace.h"
+#include "System.h"
+
+GemmEngine G_TUNED_GEMM_KERNEL = GemmEngine::Simd;
+
+// --- Operand Access ---
+// op(X)(i, k) lives at data[i * row_step + k * col_step]; a transpose just swaps the steps.
+struct GemmOperand {
+    const double* data;
+    long long row_step;
+    long long col_step;
+
+    GemmOperand(ConstMatrixView X, Transpose t)
+        : data(X.data()),
+        row_step(t == Transpose::None ? X.stride() : 1),
+        col_step(t == Transpose::None ? 1 : X.stride()) {
+    }
+    GemmOperand(const double* d, long long rows, long long cols) : data(d), row_step(rows), col_step(cols) {}
+
+    double operator()(long long i, long long k) const { return data[i * row_step + k * col_step]; }
+    // The operand whose (0, 0) is this one's (i, k).
+    GemmOperand at(long long i, long long k) const { return GemmOperand(data + i * row_step + k * col_step, row_step, col_step); }
+};
+
+static bool viewsOverlap(ConstMatrixView a, ConstMatrixView b) {
+    if (a.rows() == 0 || a.cols() == 0 || b.rows() == 0 || b.cols() == 0) return false;
+    const double* a_end = a.data() + (a.rows() - 1) * a.stride() + a.cols();
+    const double* b_end = b.data() + (b.rows() - 1) * b.stride() + b.cols();
+    return a.data() < b_end && b.data() < a_end;
+}
+
+// Runs body(begin, end) over contiguous row ranges of [0, rows) on the shared pool.
+static void parallelRows(int rows, unsigned int threads, const std::function<void(int, int)>& body) {
+    if (threads <= 1 || rows <= 1) {
+        body(0, rows);
+        return;
+    }
+    ThreadPool& pool = getSharedThreadPool();
+    int workers = static_cast<int>(std::min<unsigned int>(threads, static_cast<unsigned int>(rows)));
+    std::vector<std::future<void>> futures;
+    futures.reserve(workers);
+    for (int w = 0; w < workers; ++w) {
+        int begin = static_cast<int>(static_cast<long long>(rows) * w / workers);
+        int end = static_cast<int>(static_cast<long long>(rows) * (w + 1) / workers);
+        futures.emplace_back(pool.enqueue([&body](int row_begin, int row_end) {
+            HardwareCounterScope counters(CounterPhase::BaseMultiply);
+            TraceScope trace("GemmRows", 0, row_begin);
+            body(row_begin, row_end);
+            }, begin, end));
+    }
+    waitForAll(futures);
+    for (auto& f : futures) f.get();
+}
+
+// C = beta * C for rows [begin, end). beta == 0 clears C without reading it.
+static void scaleRows(MatrixView C, double beta, int begin, int end) {
+    if (beta == 1.0) return;
+    for (int i = begin; i < end; ++i) {
+        double* c_row = C.data() + i * C.stride();
+        if (beta == 0.0) std::fill(c_row, c_row + C.cols(), 0.0);
+        else for (int j = 0; j < C.cols(); ++j) c_row[j] *= beta;
+    }
+}
+
+
+// --- Tiled Engine ---
+static void gemmTiled(const GemmOperand& A, const GemmOperand& B, double alpha, double beta, MatrixView C,
+    int K, int tileSize, unsigned int threads) {
+    const int M = C.rows();
+    const int N = C.cols();
+    parallelRows(M, threads, [&](int row_begin, int row_end) {
+        scaleRows(C, beta, row_begin, row_end);
+        for (int i_block = row_begin; i_block < row_end; i_block += tileSize) {
+            const int i_end = std::min(i_block + tileSize, row_end);
+            for (int k_block = 0; k_block < K; k_block += tileSize) {
+                const int k_end = std::min(k_block + tileSize, K);
+                for (int j_block = 0; j_block < N; j_block += tileSize) {
+                    const int j_end = std::min(j_block + tileSize, N);
+                    for (int i = i_block; i < i_end; ++i) {
+                        double* c_row = C.data() + i * C.stride();
+                        for (int k = k_block; k < k_end; ++k) {
+                            const double aik = alpha * A(i, k);
+                            for (int j = j_block; j < j_end; ++j) c_row[j] += aik * B(k, j);
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+
+// --- SIMD Engine ---
+// Goto-style blocking: op(B) is packed one kc x nc panel at a time into NR-wide slivers with
+// alpha folded in, and each worker packs mc x kc blocks of op(A) into MR-row slivers, both
+// k-major so the micro-kernel reads them sequentially. The block sizes come from the cache
+// topology: a B sliver stays in L1, the A block in L2 and the B panel in L3.
+// The micro-kernel keeps a 4 x 8 block of C in eight AVX registers.
+
+// C (rows x cols, at most MR x NR) += Apack sliver (kc x MR) * Bpack sliver (kc x NR)
+static void gemmSimdMicroKernel(const double* a_pack, const double* b_pack, int kc, double* c, long long ldc, int rows, int cols) {
+#ifdef HAS_AVX
+    __m256d acc[GEMM_SIMD_MR][2];
+    for (int r = 0; r < GEMM_SIMD_MR; ++r) acc[r][0] = acc[r][1] = _mm256_setzero_pd();
+    for (int k = 0; k < kc; ++k) {
+        const __m256d b0 = _mm256_loadu_pd(b_pack + k * GEMM_SIMD_NR);
+        const __m256d b1 = _mm256_loadu_pd(b_pack + k * GEMM_SIMD_NR + 4);
+        const double* a_col = a_pack + k * GEMM_SIMD_MR;
+        for (int r = 0; r < GEMM_SIMD_MR; ++r) {
+            const __m256d a = _mm256_broadcast_sd(a_col + r);
+            acc[r][0] = fixed_kernels::fmadd(a, b0, acc[r][0]);
+            acc[r][1] = fixed_kernels::fmadd(a, b1, acc[r][1]);
+        }
+    }
+    if (rows == GEMM_SIMD_MR && cols == GEMM_SIMD_NR) {
+        for (int r = 0; r < GEMM_SIMD_MR; ++r) {
+            double* c_row = c + r * ldc;
+            _mm256_storeu_pd(c_row, _mm256_add_pd(_mm256_loadu_pd(c_row), acc[r][0]));
+            _mm256_storeu_pd(c_row + 4, _mm256_add_pd(_mm256_loadu_pd(c_row + 4), acc[r][1]));
+        }
+        return;
+    }
+    // Edge block: the packs are zero-padded, so only the stores need clipping.
+    alignas(32) double tile[GEMM_SIMD_MR][GEMM_SIMD_NR];
+    for (int r = 0; r < GEMM_SIMD_MR; ++r) {
+        _mm256_store_pd(tile[r], acc[r][0]);
+        _mm256_store_pd(tile[r] + 4, acc[r][1]);
+    }
+#else
+    double tile[GEMM_SIMD_MR][GEMM_SIMD_NR] = {};
+    for (int k = 0; k < kc; ++k) {
+        for (int r = 0; r < GEMM_SIMD_MR; ++r) {
+            for (int j = 0; j < GEMM_SIMD_NR; ++j) tile[r][j] += a_pack[k * GEMM_SIMD_MR + r] * b_pack[k * GEMM_SIMD_NR + j];
+        }
+    }
+#endif
+    for (int r = 0; r < rows; ++r) {
+        for (int j = 0; j < cols; ++j) c[r * ldc + j] += tile[r][j];
+    }
+}
+
+static void gemmSimd(const GemmOperand& A, const GemmOperand& B, double alpha, double beta, MatrixView C,
+    int K, const GemmOptions& options, unsigned int threads) {
+    const int M = C.rows();
+    const int N = C.cols();
+    const AnalyticBlocking& analytic = getAnalyticBlocking();
+    const int kc_max = (options.kc > 0) ? options.kc : analytic.kc;
+    const int nc_max = (options.nc > 0) ? (options.nc + GEMM_SIMD_NR - 1) / GEMM_SIMD_NR * GEMM_SIMD_NR : analytic.nc;
+    const int mc_max = (options.mc > 0) ? (options.mc + GEMM_SIMD_MR - 1) / GEMM_SIMD_MR * GEMM_SIMD_MR : analytic.mc;
+    parallelRows(M, threads, [&](int row_begin, int row_end) { scaleRows(C, beta, row_begin, row_end); });
+
+    std::vector<double> b_pack(static_cast<size_t>(std::min(K, kc_max)) * std::min(nc_max, (N + GEMM_SIMD_NR - 1) / GEMM_SIMD_NR * GEMM_SIMD_NR));
+    for (int j0 = 0; j0 < N; j0 += nc_max) {
+        const int nc = std::min(nc_max, N - j0);
+        for (int k0 = 0; k0 < K; k0 += kc_max) {
+            if (options.cancel && options.cancel->load()) throw std::runtime_error("gemm: cancelled.");
+            const int kc = std::min(kc_max, K - k0);
+            for (int jr = 0; jr < nc; jr += GEMM_SIMD_NR) {
+                double* sliver = b_pack.data() + static_cast<size_t>(jr) * kc;
+                const int cols = std::min(GEMM_SIMD_NR, nc - jr);
+                for (int k = 0; k < kc; ++k) {
+                    for (int j = 0; j < GEMM_SIMD_NR; ++j) sliver[k * GEMM_SIMD_NR + j] = (j < cols) ? alpha * B(k0 + k, j0 + jr + j) : 0.0;
+                }
+            }
+
+            parallelRows(M, threads, [&](int row_begin, int row_end) {
+                // Reused across panels; sized for the largest block this thread has seen.
+                thread_local std::vector<double> a_pack;
+                const int mc_rows = std::min(mc_max, (row_end - row_begin + GEMM_SIMD_MR - 1) / GEMM_SIMD_MR * GEMM_SIMD_MR);
+                if (a_pack.size() < static_cast<size_t>(mc_rows) * kc) a_pack.resize(static_cast<size_t>(mc_rows) * kc);
+
+                for (int i0 = row_begin; i0 < row_end; i0 += mc_max) {
+                    const int mc = std::min(mc_max, row_end - i0);
+                    for (int ir = 0; ir < mc; ir += GEMM_SIMD_MR) {
+                        double* sliver = a_pack.data() + static_cast<size_t>(ir) * kc;
+                        const int rows = std::min(GEMM_SIMD_MR, mc - ir);
+                        for (int k = 0; k < kc; ++k) {
+                            for (int r = 0; r < GEMM_SIMD_MR; ++r) sliver[k * GEMM_SIMD_MR + r] = (r < rows) ? A(i0 + ir + r, k0 + k) : 0.0;
+                        }
+                    }
+                    for (int jr = 0; jr < nc; jr += GEMM_SIMD_NR) {
+                        const double* b_sliver = b_pack.data() + static_cast<size_t>(jr) * kc;
+                        const int cols = std::min(GEMM_SIMD_NR, nc - jr);
+                        for (int ir = 0; ir < mc; ir += GEMM_SIMD_MR) {
+                            gemmSimdMicroKernel(a_pack.data() + static_cast<size_t>(ir) * kc, b_sliver, kc,
+                                C.data() + (i0 + ir) * C.stride() + j0 + jr, C.stride(), std::min(GEMM_SIMD_MR, mc - ir), cols);
+                        }
+                    }
+                }
+            });
+        }
+    }
+}
+
+
+// --- Strassen Engine ---
+// Copies op(X) into the top-left corner of a zeroed n x n matrix.
+static Matrix packPadded(const GemmOperand& X, int rows, int cols, int n) {
+    Matrix padded(n, n);
+    double* out = padded.getRawData().data();
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) out[static_cast<size_t>(i) * n + j] = X(i, j);
+    }
+    return padded;
+}
+
+static void gemmStrassen(const GemmOperand& A, const GemmOperand& B, double alpha, double beta, MatrixView C,
+    int K, const GemmOptions& options, int tileSize, unsigned int threads, const StrassenSchedule& schedule) {
+    const int M = C.rows();
+    const int N = C.cols();
+    const int n = nextPowerOf2(std::max({ M, N, K }));
+    Matrix product = multiplyStrassenPadded(packPadded(A, M, K, n), packPadded(B, K, N, n),
+        (options.strassenThreshold > 0) ? options.strassenThreshold : std::max(1, G_OPTIMAL_STRASSEN_THRESHOLD), true, tileSize, threads,
+        nullptr, nullptr, schedule);
+
+    const double* p = product.getRawData().data();
+    parallelRows(M, threads, [&](int row_begin, int row_end) {
+        for (int i = row_begin; i < row_end; ++i) {
+            double* c_row = C.data() + i * C.stride();
+            const double* p_row = p + static_cast<size_t>(i) * n;
+            if (beta == 0.0) for (int j = 0; j < N; ++j) c_row[j] = alpha * p_row[j];
+            else for (int j = 0; j < N; ++j) c_row[j] = alpha * p_row[j] + beta * c_row[j];
+        }
+    });
+}
+
+
+// --- Shape Kernels ---
+// Matrix-vector and vector-matrix products reduce to two streaming loops over a row-major
+// array X: dot products of its rows with x, or sums of its rows weighted by x. A transposed
+// operand just swaps which of the two applies, so both always read X with unit stride.
+
+// Columns handled by one worker of a weighted row sum; below this many per thread the
+// reduction dimension is split instead.
+const int SHAPE_MIN_COLUMNS_PER_THREAD = 256;
+// Output columns a weighted row sum keeps in L1 while it streams the rows of X.
+const int SHAPE_AXPY_BLOCK = 1024;
+
+static double dotContiguous(const double* x, const double* y, int n) {
+    int k = 0;
+    double sum = 0.0;
+#ifdef HAS_AVX
+    __m256d acc[4] = { _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd() };
+    for (; k + 16 <= n; k += 16) {
+        for (int v = 0; v < 4; ++v) acc[v] = fixed_kernels::fmadd(_mm256_loadu_pd(x + k + 4 * v), _mm256_loadu_pd(y + k + 4 * v), acc[v]);
+    }
+    for (; k + 4 <= n; k += 4) acc[0] = fixed_kernels::fmadd(_mm256_loadu_pd(x + k), _mm256_loadu_pd(y + k), acc[0]);
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, _mm256_add_pd(_mm256_add_pd(acc[0], acc[1]), _mm256_add_pd(acc[2], acc[3])));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; k < n; ++k) sum += x[k] * y[k];
+    return sum;
+}
+
+// y += a * x over n contiguous doubles.
+static void axpyContiguous(double a, const double* x, double* y, int n) {
+    int j = 0;
+#ifdef HAS_AVX
+    const __m256d av = _mm256_set1_pd(a);
+    for (; j + 8 <= n; j += 8) {
+        _mm256_storeu_pd(y + j, fixed_kernels::fmadd(av, _mm256_loadu_pd(x + j), _mm256_loadu_pd(y + j)));
+        _mm256_storeu_pd(y + j + 4, fixed_kernels::fmadd(av, _mm256_loadu_pd(x + j + 4), _mm256_loadu_pd(y + j + 4)));
+    }
+    for (; j + 4 <= n; j += 4) _mm256_storeu_pd(y + j, fixed_kernels::fmadd(av, _mm256_loadu_pd(x + j), _mm256_loadu_pd(y + j)));
+#endif
+    for (; j < n; ++j) y[j] += a * x[j];
+}
+
+// y = a * x + beta * y over n contiguous doubles; y is not read when beta == 0.
+static void scaledCopyContiguous(double a, const double* x, double beta, double* y, int n) {
+    int j = 0;
+#ifdef HAS_AVX
+    const __m256d av = _mm256_set1_pd(a);
+    const __m256d bv = _mm256_set1_pd(beta);
+    for (; j + 4 <= n; j += 4) {
+        const __m256d ax = _mm256_mul_pd(av, _mm256_loadu_pd(x + j));
+        _mm256_storeu_pd(y + j, (beta == 0.0) ? ax : fixed_kernels::fmadd(bv, _mm256_loadu_pd(y + j), ax));
+    }
+#endif
+    for (; j < n; ++j) y[j] = (beta == 0.0) ? a * x[j] : a * x[j] + beta * y[j];
+}
+
+// out[i] = sum_k x[k] * X(i, k) for the rows x cols array X (leading dimension ld). Rows are
+// split across threads; with fewer rows than threads each dot product is split instead.
+static void rowDots(const double* X, long long ld, int rows, int cols, const double* x, double* out, unsigned int threads) {
+    if (rows >= static_cast<int>(threads) || threads <= 1) {
+        parallelRows(rows, threads, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) out[i] = dotContiguous(X + i * ld, x, cols);
+        });
+        return;
+    }
+    const int parts = static_cast<int>(std::min<unsigned int>(threads, static_cast<unsigned int>(std::max(1, cols / SHAPE_MIN_COLUMNS_PER_THREAD))));
+    std::vector<double> partial(static_cast<size_t>(parts) * rows, 0.0);
+    parallelRows(parts, threads, [&](int begin, int end) {
+        for (int p = begin; p < end; ++p) {
+            const int k0 = static_cast<int>(static_cast<long long>(cols) * p / parts);
+            const int k1 = static_cast<int>(static_cast<long long>(cols) * (p + 1) / parts);
+            for (int i = 0; i < rows; ++i) partial[static_cast<size_t>(p) * rows + i] = dotContiguous(X + i * ld + k0, x + k0, k1 - k0);
+        }
+    });
+    for (int i = 0; i < rows; ++i) {
+        double sum = 0.0;
+        for (int p = 0; p < parts; ++p) sum += partial[static_cast<size_t>(p) * rows + i];
+        out[i] = sum;
+    }
+}
+
+// out[j] = sum_k x[k] * X(k, j) for the rows x cols array X (leading dimension ld). Column
+// ranges are split across threads; when there are too few columns the rows are split and the
+// per-thread sums added up.
+static void weightedRowSums(const double* X, long long ld, int rows, int cols, const double* x, double* out, unsigned int threads) {
+    auto accumulate = [&](int k0, int k1, int j0, int j1, double* y) {
+        for (int jb = j0; jb < j1; jb += SHAPE_AXPY_BLOCK) {
+            const int width = std::min(SHAPE_AXPY_BLOCK, j1 - jb);
+            for (int k = k0; k < k1; ++k) axpyContiguous(x[k], X + k * ld + jb, y + jb - j0, width);
+        }
+    };
+    if (cols >= static_cast<int>(threads) * SHAPE_MIN_COLUMNS_PER_THREAD || threads <= 1 || rows < 2) {
+        const int ranges = std::max(1, std::min(static_cast<int>(threads), cols / std::max(1, SHAPE_MIN_COLUMNS_PER_THREAD / 4)));
+        std::fill(out, out + cols, 0.0);
+        parallelRows(ranges, threads, [&](int begin, int end) {
+            for (int r = begin; r < end; ++r) {
+                const int j0 = static_cast<int>(static_cast<long long>(cols) * r / ranges);
+                const int j1 = static_cast<int>(static_cast<long long>(cols) * (r + 1) / ranges);
+                accumulate(0, rows, j0, j1, out + j0);
+            }
+        });
+        return;
+    }
+    const int parts = static_cast<int>(std::min<unsigned int>(threads, static_cast<unsigned int>(rows)));
+    std::vector<double> partial(static_cast<size_t>(parts) * cols, 0.0);
+    parallelRows(parts, threads, [&](int begin, int end) {
+        for (int p = begin; p < end; ++p) {
+            const int k0 = static_cast<int>(static_cast<long long>(rows) * p / parts);
+            const int k1 = static_cast<int>(static_cast<long long>(rows) * (p + 1) / parts);
+            accumulate(k0, k1, 0, cols, partial.data() + static_cast<size_t>(p) * cols);
+        }
+    });
+    std::copy(partial.begin(), partial.begin() + cols, out);
+    for (int p = 1; p < parts; ++p) axpyContiguous(1.0, partial.data() + static_cast<size_t>(p) * cols, out, cols);
+}
+
+// y = op(X) v for an n-vector v with alpha folded in, whichever storage order op(X) has.
+// op(X) is rows x n; the result has `rows` entries.
+static std::vector<double> applyToVector(const GemmOperand& X, int rows, int n, const std::vector<double>& v, unsigned int threads) {
+    std::vector<double> y(rows);
+    if (X.col_step == 1) rowDots(X.data, X.row_step, rows, n, v.data(), y.data(), threads);
+    else weightedRowSums(X.data, X.col_step, n, rows, v.data(), y.data(), threads);
+    return y;
+}
+
+static void gemmShape(GemmShape shape, const GemmOperand& A, const GemmOperand& B, double alpha, double beta, MatrixView C,
+    int K, const GemmOptions& options, int tileSize, unsigned int threads) {
+    const int M = C.rows();
+    const int N = C.cols();
+    switch (shape) {
+    case GemmShape::MatrixVector: {
+        std::vector<double> x(K);
+        for (int k = 0; k < K; ++k) x[k] = alpha * B(k, 0);
+        const std::vector<double> y = applyToVector(A, M, K, x, threads);
+        for (int i = 0; i < M; ++i) {
+            double& c = C.data()[i * C.stride()];
+            c = (beta == 0.0) ? y[i] : y[i] + beta * c;
+        }
+        break;
+    }
+    case GemmShape::VectorMatrix: {
+        // y^T = x^T op(B) is op(B)^T x, and op(B)^T swaps the steps of op(B).
+        std::vector<double> x(K);
+        for (int k = 0; k < K; ++k) x[k] = alpha * A(0, k);
+        const std::vector<double> y = applyToVector(GemmOperand(B.data, B.col_step, B.row_step), N, K, x, threads);
+        scaledCopyContiguous(1.0, y.data(), beta, C.data(), N);
+        break;
+    }
+    case GemmShape::OuterProduct: {
+        std::vector<double> b(N);
+        for (int j = 0; j < N; ++j) b[j] = alpha * B(0, j);
+        parallelRows(M, threads, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) scaledCopyContiguous(A(i, 0), b.data(), beta, C.data() + i * C.stride(), N);
+        });
+        break;
+    }
+    default: {
+        // Tall-skinny: the largest of M and N is split across threads, each running the serial
+        // blocked kernel on its slice; when both are too short, K is split and partial products summed.
+#ifdef HAS_AVX
+        (void)tileSize;
+        auto serial = [&](const GemmOperand& a, const GemmOperand& b, double part_beta, MatrixView c, int depth) {
+            gemmSimd(a, b, alpha, part_beta, c, depth, options, 1);
+        };
+#else
+        (void)options;
+        auto serial = [&](const GemmOperand& a, const GemmOperand& b, double part_beta, MatrixView c, int depth) {
+            gemmTiled(a, b, alpha, part_beta, c, depth, tileSize, 1);
+        };
+#endif
+        const int min_slice = GEMM_SIMD_NR * 4;
+        if (M >= N && M >= static_cast<int>(threads) * min_slice) {
+            parallelRows(M, threads, [&](int begin, int end) {
+                serial(A.at(begin, 0), B, beta, C.block(begin, 0, end - begin, N), K);
+            });
+        }
+        else if (N > M && N >= static_cast<int>(threads) * min_slice) {
+            parallelRows(N, threads, [&](int begin, int end) {
+                serial(A, B.at(0, begin), beta, C.block(0, begin, M, end - begin), K);
+            });
+        }
+        else {
+            const int parts = static_cast<int>(std::max(1u, std::min<unsigned int>(threads, static_cast<unsigned int>(K / min_slice))));
+            std::vector<std::vector<double>> partial(parts);
+            parallelRows(parts, threads, [&](int begin, int end) {
+                for (int p = begin; p < end; ++p) {
+                    const int k0 = static_cast<int>(static_cast<long long>(K) * p / parts);
+                    const int k1 = static_cast<int>(static_cast<long long>(K) * (p + 1) / parts);
+                    partial[p].assign(static_cast<size_t>(M) * N, 0.0);
+                    serial(A.at(0, k0), B.at(k0, 0), 0.0, MatrixView(partial[p].data(), M, N, N), k1 - k0);
+                }
+            });
+            for (int i = 0; i < M; ++i) {
+                double* c_row = C.data() + i * C.stride();
+                scaledCopyContiguous(1.0, partial[0].data() + static_cast<size_t>(i) * N, beta, c_row, N);
+                for (int p = 1; p < parts; ++p) axpyContiguous(1.0, partial[p].data() + static_cast<size_t>(i) * N, c_row, N);
+            }
+        }
+        break;
+    }
+    }
+}
+
+
+// --- Dispatch ---
+static bool fixedKernelApplies(int M, int N, int K, Transpose transA, Transpose transB, double alpha, double beta) {
+    return M == N && N == K && transA == Transpose::None && transB == Transpose::None &&
+        alpha == 1.0 && beta == 0.0 && getFixedKernels(M) != nullptr;
+}
+
+GemmShape classifyGemmShape(int M, int N, int K) {
+    if (M <= 0 || N <= 0 || K <= 0) return GemmShape::General;
+    if (N == 1) return GemmShape::MatrixVector;
+    if (M == 1) return GemmShape::VectorMatrix;
+    if (K == 1) return GemmShape::OuterProduct;
+    const int smallest = std::min({ M, N, K });
+    const int largest = std::max({ M, N, K });
+    if (smallest <= GEMM_SKINNY_MAX_DIM && static_cast<long long>(smallest) * GEMM_SKINNY_MIN_ASPECT <= largest) return GemmShape::TallSkinny;
+    return GemmShape::General;
+}
+
+string getGemmShapeName(GemmShape shape) {
+    switch (shape) {
+    case GemmShape::General: return "general";
+    case GemmShape::MatrixVector: return "matrix-vector";
+    case GemmShape::VectorMatrix: return "vector-matrix";
+    case GemmShape::OuterProduct: return "outer product";
+    case GemmShape::TallSkinny: return "tall-skinny";
+    }
+    return "unknown";
+}
+
+GemmEngine selectGemmEngine(int M, int N, int K, Transpose transA, Transpose transB, double alpha, double beta) {
+    if (fixedKernelApplies(M, N, K, transA, transB, alpha, beta)) return GemmEngine::Fixed;
+    if (classifyGemmShape(M, N, K) != GemmShape::General) return GemmEngine::Shape;
+    if (std::min({ M, N, K }) >= GEMM_STRASSEN_MIN_SIZE) {
+        // Only worth it when padding to a power of two adds little work.
+        double padded = static_cast<double>(nextPowerOf2(std::max({ M, N, K })));
+        if (padded * padded * padded <= 1.5 * static_cast<double>(M) * N * K) return GemmEngine::Strassen;
+    }
+#ifdef HAS_AVX
+    return G_TUNED_GEMM_KERNEL;
+#else
+    return GemmEngine::Tiled;
+#endif
+}
+
+string getGemmEngineName(GemmEngine engine) {
+    switch (engine) {
+    case GemmEngine::Auto: return "Auto";
+    case GemmEngine::Fixed: return "Fixed";
+    case GemmEngine::Tiled: return "Tiled";
+    case GemmEngine::Simd: return "SIMD";
+    case GemmEngine::Strassen: return "Strassen";
+    case GemmEngine::Shape: return "Shape";
+    }
+    return "Unknown";
+}
+
+GemmResult gemm(Transpose transA, Transpose transB, double alpha, ConstMatrixView A, ConstMatrixView B,
+    double beta, MatrixView C, const GemmOptions& options) {
+    const int M = (transA == Transpose::None) ? A.rows() : A.cols();
+    const int K = (transA == Transpose::None) ? A.cols() : A.rows();
+    const int K_B = (transB == Transpose::None) ? B.rows() : B.cols();
+    const int N = (transB == Transpose::None) ? B.cols() : B.rows();
+    if (K != K_B) throw std::invalid_argument("gemm: inner dimensions of op(A) and op(B) do not match.");
+    if (C.rows() != M || C.cols() != N) throw std::invalid_argument("gemm: C must be " + std::to_string(M) + "x" + std::to_string(N) + ".");
+    if (viewsOverlap(C, A) || viewsOverlap(C, B)) throw std::invalid_argument("gemm: C must not overlap A or B.");
+    if (options.strassenThreshold < 0) throw std::invalid_argument("gemm: Strassen threshold cannot be negative.");
+    if (options.mc < 0 || options.kc < 0 || options.nc < 0) throw std::invalid_argument("gemm: cache block sizes cannot be negative.");
+
+    GemmResult result_obj;
+    result_obj.M = M;
+    result_obj.N = N;
+    result_obj.K = K;
+    MatrixAllocationStats alloc_start = getMatrixAllocationStats();
+
+    unsigned int hardware_cores = getCpuCoreCount();
+    result_obj.coresDetected = hardware_cores;
+    result_obj.threadsUsed = (options.threads == 0) ? getDefaultThreadCount() : std::min(options.threads, hardware_cores);
+    if (result_obj.threadsUsed == 0) result_obj.threadsUsed = 1;
+    const int tileSize = (options.tileSize > 0) ? options.tileSize : std::max(1, G_OPTIMAL_TILE_SIZE);
+
+    const GemmShape shape = classifyGemmShape(M, N, K);
+    result_obj.shape = getGemmShapeName(shape);
+    GemmEngine engine = options.engine;
+    if (engine == GemmEngine::Auto) engine = selectGemmEngine(M, N, K, transA, transB, alpha, beta);
+    if (engine == GemmEngine::Fixed && !fixedKernelApplies(M, N, K, transA, transB, alpha, beta)) {
+        throw std::invalid_argument("gemm: the fixed-size engine needs a supported square size, no transposes, alpha = 1 and beta = 0.");
+    }
+    if (engine == GemmEngine::Shape && shape == GemmShape::General) {
+        throw std::invalid_argument("gemm: the shape engine needs a matrix-vector, vector-matrix, outer or tall-skinny product.");
+    }
+    // Padding a degenerate shape to a power-of-two square would multiply its work many times over.
+    if (engine == GemmEngine::Strassen && shape != GemmShape::General) engine = GemmEngine::Shape;
+
+    // Under a memory budget the Strassen workspace must fit next to the caller's operands; if no
+    // schedule of it does, the in-place SIMD engine takes over.
+    StrassenSchedule schedule;
+    unsigned int strassen_threads = result_obj.threadsUsed;
+    if (engine == GemmEngine::Strassen && hasMemoryBudget()) {
+        const double operands_mb = (static_cast<double>(M) * K + static_cast<double>(K) * N + static_cast<double>(M) * N) * sizeof(double) / (1024.0 * 1024.0);
+        const double limit_mb = productMemoryLimitMB(operands_mb);
+        AlgorithmCandidate candidate;
+        candidate.algorithm = MultiplyAlgorithm::Strassen;
+        candidate.strassenThreshold = (options.strassenThreshold > 0) ? options.strassenThreshold : std::max(1, G_OPTIMAL_STRASSEN_THRESHOLD);
+        candidate.threads = result_obj.threadsUsed;
+        candidate = fitCandidateToMemory(candidate, M, N, K, limit_mb);
+        if (candidate.algorithm != MultiplyAlgorithm::Strassen) engine = GemmEngine::Simd;
+        schedule.maxAsyncDepth = candidate.strassenAsyncDepth;
+        schedule.depthFirst = candidate.depthFirst;
+        strassen_threads = candidate.threads;
+    }
+#ifndef HAS_AVX
+    if (engine == GemmEngine::Simd) engine = GemmEngine::Tiled;
+#endif
+    result_obj.engine_used = getGemmEngineName(engine);
+
+    const GemmOperand opA(A, transA);
+    const GemmOperand opB(B, transB);
+
+    if (options.cancel && options.cancel->load()) throw std::runtime_error("gemm: cancelled.");
+    auto start = std::chrono::high_resolution_clock::now();
+    if (M > 0 && N > 0) {
+        if (K == 0 || alpha == 0.0) {
+            parallelRows(M, result_obj.threadsUsed, [&](int begin, int end) { scaleRows(C, beta, begin, end); });
+        }
+        else {
+            switch (engine) {
+            case GemmEngine::Fixed:
+                getFixedKernels(M)->multiply(A.data(), A.stride(), B.data(), B.stride(), C.data(), C.stride());
+                break;
+            case GemmEngine::Strassen:
+                gemmStrassen(opA, opB, alpha, beta, C, K, options, tileSize, strassen_threads, schedule);
+                break;
+            case GemmEngine::Simd:
+                gemmSimd(opA, opB, alpha, beta, C, K, options, result_obj.threadsUsed);
+                break;
+            case GemmEngine::Shape:
+                gemmShape(shape, opA, opB, alpha, beta, C, K, options, tileSize, result_obj.threadsUsed);
+                break;
+            default:
+                gemmTiled(opA, opB, alpha, beta, C, K, tileSize, result_obj.threadsUsed);
+                break;
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    result_obj.durationSeconds_chrono = std::chrono::duration<double>(end - start).count();
+    if (result_obj.durationSeconds_chrono > 0.0) {
+        result_obj.gflops = 2.0 * M * N * static_cast<double>(K) / result_obj.durationSeconds_chrono / 1e9;
+    }
+    result_obj.allocationStats = matrixAllocationsSince(alloc_start);
+    return result_obj;
+}
+
+MultiplicationResult multiplyByShape(const Matrix& A, const Matrix& B, unsigned int num_threads_request, const string& requested) {
+    if (A.cols() != B.rows()) throw std::invalid_argument("Matrix dimensions incompatible (A.cols != B.rows).");
+    const GemmShape shape = classifyGemmShape(A.rows(), B.cols(), A.cols());
+    if (shape == GemmShape::General) throw std::invalid_argument("multiplyByShape: " + std::to_string(A.rows()) + "x" + std::to_string(A.cols())
+        + " by " + std::to_string(B.rows()) + "x" + std::to_string(B.cols()) + " is not a degenerate shape.");
+
+    MultiplicationResult result_obj;
+    result_obj.originalRowsA = A.rows();
+    result_obj.originalColsA = A.cols();
+    result_obj.originalRowsB = B.rows();
+    result_obj.originalColsB = B.cols();
+    result_obj.shape_path = getGemmShapeName(shape);
+    result_obj.algorithm_type = (requested.empty() ? "" : requested + " -> ") + result_obj.shape_path + " kernel";
+    MatrixAllocationStats alloc_start = getMatrixAllocationStats();
+
+    auto start_chrono = std::chrono::high_resolution_clock::now();
+    long long start_qpc = readPerformanceCounter();
+    long long rss_start = getCurrentResidentKB();
+    HardwareCounterRun counter_run;
+    Matrix C(A.rows(), B.cols());
+    GemmOptions options;
+    options.engine = GemmEngine::Shape;
+    options.threads = num_threads_request;
+    GemmResult product;
+    {
+        HardwareCounterScope base_counters(CounterPhase::BaseMultiply);
+        product = gemm(Transpose::None, Transpose::None, 1.0, A, B, 0.0, C, options);
+    }
+    auto end_chrono = std::chrono::high_resolution_clock::now();
+    long long end_qpc = readPerformanceCounter();
+
+    result_obj.coresDetected = product.coresDetected;
+    result_obj.threadsUsed = product.threadsUsed;
+    result_obj.durationSeconds_chrono = std::chrono::duration<double>(end_chrono - start_chrono).count();
+    result_obj.durationSeconds_qpc = performanceCounterSeconds(start_qpc, end_qpc);
+    result_obj.compute_rss_delta_mb = residentDeltaMB(rss_start, getCurrentResidentKB());
+    counter_run.finish(result_obj.hardwareCounters);
+    result_obj.resultMatrix = std::move(C);
+    result_obj.allocationStats = matrixAllocationsSince(alloc_start);
+    result_obj.memoryInfo = getProcessMemoryUsage();
+    return result_obj;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "Common.h"
+#include "Matrix.h"
+
+// --- BLAS-Style GEMM ---
+// C = alpha * op(A) * op(B) + beta * C, written into caller-owned storage.
+// op(X) is X or X^T; transposed operands are read in place through their strides and are
+// never materialized (the SIMD engine packs one cache block at a time). As in BLAS, C is
+// not read when beta == 0, so it may hold garbage. C must not overlap A or B.
+// A Matrix converts to a view implicitly, so gemm(..., A, B, 1.0, C) works on matrices too.
+
+enum class Transpose { None, Transposed };
+
+enum class GemmEngine {
+    Auto,     // Pick from the problem shape (see selectGemmEngine)
+    Fixed,    // Compile-time kernels; square sizes from FixedMatrix.h, no transposes, alpha = 1, beta = 0
+    Tiled,    // Cache-blocked scalar loops
+    Simd,     // Packed blocks with an AVX register micro-kernel (falls back to Tiled without AVX)
+    Strassen, // Pads op(A), op(B) to a power of two and runs the parallel Strassen engine
+    Shape     // Streaming kernels for the degenerate shapes of classifyGemmShape; never pads
+};
+
+// Shapes the blocked engines handle badly: Strassen pads them to a large square, the SIMD
+// engine packs 1-wide operands into 8-wide slivers, and splitting C by rows starves threads
+// when C has few of them. Each has a kernel that reads its operands once, without padding.
+enum class GemmShape {
+    General,
+    MatrixVector,   // N == 1: y = op(A) x
+    VectorMatrix,   // M == 1: y^T = x^T op(B)
+    OuterProduct,   // K == 1: C = a b^T
+    TallSkinny      // Smallest dimension <= GEMM_SKINNY_MAX_DIM and GEMM_SKINNY_MIN_ASPECT times below the largest
+};
+
+const int GEMM_SKINNY_MAX_DIM = 16;
+const int GEMM_SKINNY_MIN_ASPECT = 64;
+
+// Auto only picks Strassen for problems at least this large in every dimension.
+const int GEMM_STRASSEN_MIN_SIZE = 1024;
+const int GEMM_DEFAULT_STRASSEN_THRESHOLD = 128;
+
+// Dense kernel Auto uses below the Strassen sizes (Simd or Tiled); set by the auto-tuner.
+extern GemmEngine G_TUNED_GEMM_KERNEL;
+
+// Register block of the SIMD micro-kernel: MR rows of C times NR columns.
+const int GEMM_SIMD_MR = 4;
+const int GEMM_SIMD_NR = 8;
+
+struct GemmOptions {
+    GemmEngine engine = GemmEngine::Auto;
+    int tileSize = 0;               // 0 = G_OPTIMAL_TILE_SIZE
+    int mc = 0;                     // SIMD cache blocks (rows of A, depth, columns of B);
+    int kc = 0;                     //   0 = derived from the cache topology (getAnalyticBlocking)
+    int nc = 0;
+    int strassenThreshold = 0;      // 0 = G_OPTIMAL_STRASSEN_THRESHOLD
+    unsigned int threads = 0;       // 0 = getDefaultThreadCount()
+    // Set by another thread to abandon the product: the SIMD engine checks it before each
+    // packed panel and throws std::runtime_error, leaving C partly written. Other engines
+    // only check it before starting.
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+// Runs on the shared thread pool (Strassen uses its own), so it must not be called from a task
+// already running on the shared pool.
+GemmResult gemm(Transpose transA, Transpose transB, double alpha, ConstMatrixView A, ConstMatrixView B,
+    double beta, MatrixView C, const GemmOptions& options = GemmOptions());
+
+// The engine Auto resolves to for an M x K times K x N product.
+GemmEngine selectGemmEngine(int M, int N, int K, Transpose transA, Transpose transB, double alpha, double beta);
+string getGemmEngineName(GemmEngine engine);
+
+GemmShape classifyGemmShape(int M, int N, int K);
+string getGemmShapeName(GemmShape shape);   // "general", "matrix-vector", "vector-matrix", "outer product", "tall-skinny"
+
+// A degenerate-shape product run by the shape kernels with the bookkeeping of the other
+// MultiplicationResult entry points, which hand such shapes to it instead of padding them.
+// algorithm_type reads "<requested> -> <shape> kernel" ("<shape> kernel" when requested is empty).
+MultiplicationResult multiplyByShape(const Matrix& A, const Matrix& B, unsigned int num_threads_request, const string& requested);
@@ -0,0 +1,269 @@
+#define NOMINMAX
+#include "HardwareCounters.h"
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char* getCounterPhaseName(CounterPhase phase) {
+    switch (phase) {
+    case CounterPhase::Total: return "Total";
+    case CounterPhase::Padding: return "Padding";
+    case CounterPhase::Split: return "Split";
+    case CounterPhase::BaseMultiply: return "BaseMultiply";
+    case CounterPhase::Combine: return "Combine";
+    case CounterPhase::Unpad: return "Unpad";
+    }
+    return "Unknown";
+}
+
+namespace {
+std::atomic<bool> g_countersEnabled{ [] {
+    const char* env = std::getenv("FLUMINUM_HW_COUNTERS");
+    return env == nullptr || std::strcmp(env, "0") != 0;
+}() };
+std::atomic<HardwareCounterRun*> g_activeRun{ nullptr };
+
+thread_local int t_phaseDepth = 0;
+thread_local bool t_runThread = false;  // The thread that owns the active run (counted in Total already)
+
+#ifdef __linux__
+// Indices into HardwareCounterSnapshot, in HardwareCounterValues field order.
+enum HardwareEvent { EVENT_CYCLES, EVENT_INSTRUCTIONS, EVENT_L1D_MISSES, EVENT_LLC_MISSES, EVENT_DTLB_MISSES, EVENT_FP_OPS };
+
+std::mutex g_statusMutex;
+string g_status = "not probed yet";
+
+long openEvent(uint32_t type, uint64_t config, int group_fd) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;  // Allowed up to perf_event_paranoid = 2
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(__NR_perf_event_open, &attr, 0 /* this thread */, -1, group_fd, 0);
+}
+
+uint64_t cacheMissConfig(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+bool isIntelCpu() {
+    static const bool intel = [] {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        string line;
+        while (std::getline(cpuinfo, line)) {
+            if (line.compare(0, 9, "vendor_id") == 0) return line.find("GenuineIntel") != string::npos;
+        }
+        return false;
+    }();
+    return intel;
+}
+
+// A perf group read in one syscall. `event` and `weight` map each member onto snapshot fields:
+// the FP group sums scalar/128/256/512-bit double retirements weighted by lanes.
+struct CounterGroup {
+    int leader = -1;
+    std::vector<int> fds;
+    std::vector<int> event;
+    std::vector<double> weight;
+
+    void add(uint32_t type, uint64_t config, int snapshot_event, double w) {
+        long fd = openEvent(type, config, leader);
+        if (fd < 0) return;
+        if (leader < 0) leader = static_cast<int>(fd);
+        fds.push_back(static_cast<int>(fd));
+        event.push_back(snapshot_event);
+        weight.push_back(w);
+    }
+
+    void read(HardwareCounterSnapshot& snapshot) const {
+        if (leader < 0) return;
+        uint64_t buffer[3 + 8] = {};
+        if (::read(leader, buffer, sizeof(buffer)) <= 0 || buffer[0] != fds.size() || buffer[2] == 0) return;
+        // Scale up when the kernel multiplexed the group with others.
+        const double scale = static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]);
+        for (size_t i = 0; i < fds.size(); ++i) {
+            snapshot.value[event[i]] += static_cast<double>(buffer[3 + i]) * scale * weight[i];
+            snapshot.present[event[i]] = true;
+        }
+    }
+
+    ~CounterGroup() {
+        for (int fd : fds) close(fd);
+    }
+};
+
+struct ThreadCounters {
+    bool opened = false;
+    CounterGroup main;
+    CounterGroup fp;
+
+    bool usable() {
+        if (!opened) open();
+        return main.leader >= 0;
+    }
+
+    void open() {
+        opened = true;
+        main.add(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, EVENT_CYCLES, 1.0);
+        if (main.leader < 0) {
+            const int error = errno;
+            std::lock_guard<std::mutex> lock(g_statusMutex);
+            g_status = string("perf_event_open failed: ") + std::strerror(error);
+            if (error == EACCES || error == EPERM) g_status += " (check /proc/sys/kernel/perf_event_paranoid)";
+            return;
+        }
+        main.add(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, EVENT_INSTRUCTIONS, 1.0);
+        main.add(PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_L1D), EVENT_L1D_MISSES, 1.0);
+        main.add(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, EVENT_LLC_MISSES, 1.0);
+        main.add(PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_DTLB), EVENT_DTLB_MISSES, 1.0);
+        if (isIntelCpu()) {
+            // FP_ARITH_INST_RETIRED (event 0xC7): scalar, 128-, 256- and 512-bit packed double.
+            fp.add(PERF_TYPE_RAW, 0x01C7, EVENT_FP_OPS, 1.0);
+            fp.add(PERF_TYPE_RAW, 0x04C7, EVENT_FP_OPS, 2.0);
+            fp.add(PERF_TYPE_RAW, 0x10C7, EVENT_FP_OPS, 4.0);
+            fp.add(PERF_TYPE_RAW, 0x40C7, EVENT_FP_OPS, 8.0);
+        }
+
+        static const char* names[HARDWARE_EVENT_COUNT] = { "cycles", "instructions", "L1D misses", "LLC misses", "dTLB misses", "FP ops" };
+        bool have[HARDWARE_EVENT_COUNT] = {};
+        for (int e : main.event) have[e] = true;
+        for (int e : fp.event) have[e] = true;
+        string measured;
+        for (int e = 0; e < HARDWARE_EVENT_COUNT; ++e) {
+            if (have[e]) measured += (measured.empty() ? "" : ", ") + string(names[e]);
+        }
+        std::lock_guard<std::mutex> lock(g_statusMutex);
+        g_status = measured;
+    }
+
+    HardwareCounterSnapshot read() {
+        HardwareCounterSnapshot snapshot;
+        if (usable()) {
+            main.read(snapshot);
+            fp.read(snapshot);
+        }
+        return snapshot;
+    }
+};
+
+thread_local ThreadCounters t_counters;
+
+HardwareCounterSnapshot readThreadCounters() { return t_counters.read(); }
+bool threadCountersUsable() { return t_counters.usable(); }
+#else
+HardwareCounterSnapshot readThreadCounters() { return HardwareCounterSnapshot(); }
+bool threadCountersUsable() { return false; }
+#endif
+}
+
+void setHardwareCountersEnabled(bool enabled) {
+    g_countersEnabled.store(enabled);
+}
+
+bool hardwareCountersEnabled() {
+    return g_countersEnabled.load();
+}
+
+bool hardwareCountersAvailable() {
+    return threadCountersUsable();
+}
+
+string getHardwareCounterStatus() {
+#ifdef __linux__
+    threadCountersUsable();
+    std::lock_guard<std::mutex> lock(g_statusMutex);
+    return g_status;
+#else
+    return "not supported on this platform";
+#endif
+}
+
+
+// --- Runs ---
+HardwareCounterRun::HardwareCounterRun() {
+    if (!hardwareCountersEnabled()) return;
+    if (!threadCountersUsable()) {
+#ifdef __linux__
+        static std::once_flag warned;
+        std::call_once(warned, [] {
+            cout << YELLOW << "Note: hardware counters unavailable (" << getHardwareCounterStatus()
+                << "); results will not include them." << RESET << endl;
+        });
+#endif
+        return;
+    }
+    HardwareCounterRun* expected = nullptr;
+    if (!g_activeRun.compare_exchange_strong(expected, this)) return;
+    active_ = true;
+    t_runThread = true;
+    start_ = readThreadCounters();
+}
+
+HardwareCounterRun::~HardwareCounterRun() {
+    if (active_) {
+        HardwareCounterValues discarded[COUNTER_PHASE_COUNT];
+        finish(discarded);
+    }
+}
+
+void HardwareCounterRun::add(CounterPhase phase, const HardwareCounterSnapshot& start, const HardwareCounterSnapshot& end, bool add_to_total) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int e = 0; e < HARDWARE_EVENT_COUNT; ++e) {
+        if (!start.present[e] || !end.present[e]) continue;
+        const double delta = std::max(0.0, end.value[e] - start.value[e]);
+        sums_[static_cast<int>(phase)][e] += delta;
+        seen_[static_cast<int>(phase)][e] = true;
+        if (add_to_total) {
+            sums_[static_cast<int>(CounterPhase::Total)][e] += delta;
+            seen_[static_cast<int>(CounterPhase::Total)][e] = true;
+        }
+    }
+}
+
+void HardwareCounterRun::finish(HardwareCounterValues (&out)[COUNTER_PHASE_COUNT]) {
+    if (active_) {
+        add(CounterPhase::Total, start_, readThreadCounters(), false);
+        t_runThread = false;
+        g_activeRun.store(nullptr);
+        active_ = false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int p = 0; p < COUNTER_PHASE_COUNT; ++p) {
+        long long* fields[HARDWARE_EVENT_COUNT] = { &out[p].cycles, &out[p].instructions, &out[p].l1dMisses,
+            &out[p].llcMisses, &out[p].dtlbMisses, &out[p].fpOps };
+        out[p].valid = false;
+        for (int e = 0; e < HARDWARE_EVENT_COUNT; ++e) {
+            *fields[e] = seen_[p][e] ? std::llround(sums_[p][e]) : -1;
+            out[p].valid |= seen_[p][e];
+        }
+    }
+}
+
+
+// --- Phase Scopes ---
+HardwareCounterScope::HardwareCounterScope(CounterPhase phase) : phase_(phase) {
+    run_ = g_activeRun.load(std::memory_order_acquire);
+    if (run_ == nullptr) return;
+    outermost_ = (t_phaseDepth++ == 0);
+    if (outermost_) start_ = readThreadCounters();
+}
+
+HardwareCounterScope::~HardwareCounterScope() {
+    stop();
+}
+
+void HardwareCounterScope::stop() {
+    if (run_ == nullptr) return;
+    --t_phaseDepth;
+    // Work on the run's own thread is already part of its Total; other threads only report here.
+    if (outermost_) run_->add(phase_, start_, readThreadCounters(), !t_runThread);
+    run_ = nullptr;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "Common.h"
+
+// --- Hardware Performance Counters ---
+// Linux only: every thread that takes part in a run opens its own perf_event_open groups
+// (user-space events of that thread), and phases add their deltas to the active run.
+// Without permission (perf_event_paranoid, containers) or on Windows, runs simply carry no
+// counter data. Set FLUMINUM_HW_COUNTERS=0 to switch collection off.
+
+const char* getCounterPhaseName(CounterPhase phase);
+
+void setHardwareCountersEnabled(bool enabled);
+bool hardwareCountersEnabled();
+
+// True when the calling thread could open at least the cycle counter.
+bool hardwareCountersAvailable();
+// Events being measured, or why nothing is.
+string getHardwareCounterStatus();
+
+// Scaled cumulative counts of the calling thread, indexed like the HardwareCounterValues fields.
+const int HARDWARE_EVENT_COUNT = 6;
+struct HardwareCounterSnapshot {
+    double value[HARDWARE_EVENT_COUNT] = {};
+    bool present[HARDWARE_EVENT_COUNT] = {};
+};
+
+// One per multiplication call, on the calling thread. Only one run collects at a time;
+// a run started while another is active stays empty.
+class HardwareCounterRun {
+public:
+    HardwareCounterRun();
+    ~HardwareCounterRun();
+
+    HardwareCounterRun(const HardwareCounterRun&) = delete;
+    HardwareCounterRun& operator=(const HardwareCounterRun&) = delete;
+
+    // Stops collecting and writes all phases (Total included) into `out`.
+    void finish(HardwareCounterValues (&out)[COUNTER_PHASE_COUNT]);
+
+private:
+    friend class HardwareCounterScope;
+    void add(CounterPhase phase, const HardwareCounterSnapshot& start, const HardwareCounterSnapshot& end, bool add_to_total);
+
+    bool active_ = false;
+    HardwareCounterSnapshot start_;
+    std::mutex mutex_;
+    double sums_[COUNTER_PHASE_COUNT][HARDWARE_EVENT_COUNT] = {};
+    bool seen_[COUNTER_PHASE_COUNT][HARDWARE_EVENT_COUNT] = {};
+};
+
+// Charges the enclosed work of the current thread to `phase` of the active run. Nested scopes
+// on one thread are ignored, so a phase never counts the same events twice.
+class HardwareCounterScope {
+public:
+    explicit HardwareCounterScope(CounterPhase phase);
+    ~HardwareCounterScope();
+
+    // Ends the phase before the scope closes (e.g. when its results must outlive it).
+    void stop();
+
+    HardwareCounterScope(const HardwareCounterScope&) = delete;
+    HardwareCounterScope& operator=(const HardwareCounterScope&) = delete;
+
+private:
+    HardwareCounterRun* run_ = nullptr;
+    bool outermost_ = false;
+    CounterPhase phase_;
+    HardwareCounterSnapshot start_;
+};
@@ -1,6 +1,12 @@
 #define NOMINMAX
 #include "IO.h"
 #include "Matrix.h" // For Matrix object interactions
+#include "Sparse.h" // For sparsity detection on load
+#include "HardwareCounters.h" // For counter column names
+#include "CostModel.h" // For algorithm names in plans
+#include "System.h" // For the memory budget in plans
+#include "Roofline.h" // For achieved GFLOP/s and the roofline bound
+#include "Morton.h" // For layout names
 
 // --- Console Formatting ---
 
@@ -25,7 +31,7 @@ void print_hline(int width) {
     for (int i = 0; i < width; ++i) cout << BOX_HLINE;
 }
 
-void print_separator_line(int width = 80) {
+void print_separator_line(int width) {
     cout << BOX_LTEE; print_hline(width - 2); cout << BOX_RTEE << endl;
 }
 
@@ -181,7 +187,7 @@ string get_valid_input<string>(const std::string& prompt_text) {
 
 
 // --- File I/O ---
-Matrix readMatrixFromFile(const std::string& filename) {
+Matrix readMatrixFromFile(const std::string& filename, MatrixFileInfo* info, bool verbose) {
     std::ifstream infile(filename);
     if (!infile.is_open()) throw std::runtime_error("Could not open file: " + filename);
 
@@ -197,9 +203,10 @@ Matrix readMatrixFromFile(const std::string& filename) {
     int expected_cols = -1;
     int line_num = 0;
     int spinner_idx = 0;
+    long long non_zero_count = 0;
     const char separator = ',';
 
-    cout << CYAN << "Reading formatted matrix from file: " << filename << RESET;
+    if (verbose) cout << CYAN << "Reading formatted matrix from file: " << filename << RESET;
     auto last_update_time = std::chrono::steady_clock::now();
 
     while (std::getline(infile, line)) {
@@ -219,9 +226,11 @@ Matrix readMatrixFromFile(const std::string& filename) {
         for (size_t i = 1; i < segments.size() - 1; ++i) {
             try {
                 row_vec.push_back(std::stod(segments[i]));
+                if (row_vec.back() != 0.0) non_zero_count++;
             }
             catch (const std::exception&) {
-                cout << "\r" << string(80, ' ') << "\r"; infile.close();
+                if (verbose) cout << "\r" << string(80, ' ') << "\r";
+                infile.close();
                 throw std::invalid_argument("Malformed number '" + segments[i] + "' in " + filename + " at line " + std::to_string(line_num));
             }
         }
@@ -229,41 +238,58 @@ Matrix readMatrixFromFile(const std::string& filename) {
             expected_cols = static_cast<int>(row_vec.size());
         }
         else if (static_cast<int>(row_vec.size()) != expected_cols) {
-            cout << "\r" << string(80, ' ') << "\r"; infile.close();
+            if (verbose) cout << "\r" << string(80, ' ') << "\r";
+            infile.close();
             throw std::invalid_argument("Inconsistent columns in " + filename + " at line " + std::to_string(line_num));
         }
 
         temp_data.push_back(row_vec);
 
         auto current_time = std::chrono::steady_clock::now();
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(current_time - last_update_time).count() > 100) {
+        if (verbose && std::chrono::duration_cast<std::chrono::milliseconds>(current_time - last_update_time).count() > 100) {
             show_loading_animation_step(spinner_idx, "Reading data rows: " + std::to_string(temp_data.size()));
             last_update_time = current_time;
         }
     }
-    cout << "\r" << string(80, ' ') << "\r";
+    if (verbose) cout << "\r" << string(80, ' ') << "\r";
     infile.close();
 
     if (temp_data.empty()) {
-        cout << YELLOW << "Warning: File '" << filename << "' contained no valid data rows. Creating 0x0 matrix." << RESET << endl;
+        if (verbose) cout << YELLOW << "Warning: File '" << filename << "' contained no valid data rows. Creating 0x0 matrix." << RESET << endl;
+        if (info) *info = MatrixFileInfo();
         return Matrix(0, 0);
     }
-    cout << GREEN << "Successfully read " << temp_data.size() << " data rows from file." << RESET << endl;
+    if (verbose) cout << GREEN << "Successfully read " << temp_data.size() << " data rows from file." << RESET << endl;
+
+    long long total_elements = static_cast<long long>(temp_data.size()) * expected_cols;
+    double density = (total_elements > 0) ? static_cast<double>(non_zero_count) / total_elements : 0.0;
+    bool sparse_candidate = isSparseCandidate(non_zero_count, total_elements);
+    if (sparse_candidate && verbose) {
+        cout << CYAN << "Sparse input detected: " << non_zero_count << " non-zeros ("
+            << std::fixed << std::setprecision(2) << density * 100.0 << "% dense). Sparse engines will be preferred." << RESET << endl;
+    }
+    if (info) {
+        info->nonZeroCount = non_zero_count;
+        info->totalElements = total_elements;
+        info->density = density;
+        info->sparseCandidate = sparse_candidate;
+    }
     return Matrix(temp_data);
 }
 
-void saveMatrixToFile(const Matrix& matrix, const std::string& filename) {
+void saveMatrixToFile(const Matrix& matrix, const std::string& filename, bool verbose) {
     std::ofstream outfile(filename, std::ios::binary);
     if (!outfile.is_open()) throw std::runtime_error("Could not open file for writing: " + filename);
 
     outfile << (char)0xEF << (char)0xBB << (char)0xBF; // UTF-8 BOM
 
-    print_header_box("Saving to " + filename, 80);
+    if (verbose) print_header_box("Saving to " + filename, 80);
 
     if (matrix.isEmpty()) {
-        print_line_in_box(YELLOW + "Matrix is empty. Saving header-only CSV file." + RESET, 80);
         outfile << "Y-Axis,X-Axis" << endl;
         outfile.close();
+        if (!verbose) return;
+        print_line_in_box(YELLOW + "Matrix is empty. Saving header-only CSV file." + RESET, 80);
         print_footer_box(80);
         cout << GREEN << "Empty matrix info saved to " << filename << RESET << endl << endl;
         return;
@@ -283,7 +309,7 @@ void saveMatrixToFile(const Matrix& matrix, const std::string& filename) {
     for (int i = 0; i < matrix.rows(); ++i) {
         outfile << "\"" << arrow_r << " " << format_coord(i) << " " << arrow_r << "\"" << separator;
         for (int j = 0; j < matrix.cols(); ++j) outfile << matrix(i, j) << separator;
-        outfile << "\"" << arrow_l << " " << format_coord(i) << " " << arrow_l << "\"" << endl;
+        outfile << "\"" << arrow_l << " " << format_coord(i) << " " << arrow_l << "\"" << '\n';
     }
 
     // Bottom Header
@@ -293,12 +319,44 @@ void saveMatrixToFile(const Matrix& matrix, const std::string& filename) {
 
     outfile.close();
 
+    if (!verbose) {
+        if (outfile.fail()) throw std::runtime_error("Error writing or closing file: " + filename);
+        return;
+    }
     print_footer_box(80);
     if (outfile.fail()) cerr << RED << "Error writing or closing file: " << filename << RESET << endl;
     else cout << GREEN << "Matrix successfully saved to " << filename << RESET << endl << endl;
 }
 
 // --- Logging ---
+// Appends the five allocation columns (with their leading separators) to a result row.
+static void logAllocationStatsCSV(std::ofstream& logfile, const MatrixAllocationStats& stats) {
+    const double bytes_per_mb = 1024.0 * 1024.0;
+    logfile << std::fixed << std::setprecision(3) << ","
+        << stats.allocations << "," << stats.allocatedBytes / bytes_per_mb << ","
+        << stats.copies << "," << stats.copiedBytes / bytes_per_mb << "," << stats.moves;
+}
+
+// Six columns per counter phase; events that were not measured are left empty.
+static const char* HARDWARE_COUNTER_CSV_FIELDS[] = { "Cycles", "Instructions", "L1DMisses", "LLCMisses", "DTLBMisses", "FPOps" };
+
+static void logHardwareCounterHeaderCSV(std::ofstream& logfile) {
+    for (int p = 0; p < COUNTER_PHASE_COUNT; ++p) {
+        for (const char* field : HARDWARE_COUNTER_CSV_FIELDS) {
+            logfile << ",HW_" << getCounterPhaseName(static_cast<CounterPhase>(p)) << "_" << field;
+        }
+    }
+}
+
+static void logHardwareCountersCSV(std::ofstream& logfile, const HardwareCounterValues (&counters)[COUNTER_PHASE_COUNT]) {
+    for (const HardwareCounterValues& c : counters) {
+        for (long long value : { c.cycles, c.instructions, c.l1dMisses, c.llcMisses, c.dtlbMisses, c.fpOps }) {
+            logfile << ",";
+            if (value >= 0) logfile << value;
+        }
+    }
+}
+
 void logMultiplicationResultToCSV(const MultiplicationResult& result, const std::string& filename) {
     std::ofstream logfile(filename, std::ios::out | std::ios::app);
     if (!logfile.is_open()) {
@@ -310,7 +368,16 @@ void logMultiplicationResultToCSV(const MultiplicationResult& result, const std:
             << "DurationSeconds_Chrono,DurationNanoseconds_Chrono,DurationSeconds_QPC,"
             << "ThreadsUsed,CoresDetected,PeakMemoryMB,StrassenThreshold,"
             << "StrassenAppliedTopLevel,Padding_sec,Unpadding_sec,"
-            << "Split_L1_sec,S_Calc_L1_sec,P_Tasks_L1_Wall_sec,C_Quad_Calc_L1_sec,Final_Combine_L1_sec\n";
+            << "Split_L1_sec,S_Calc_L1_sec,P_Tasks_L1_Wall_sec,C_Quad_Calc_L1_sec,Final_Combine_L1_sec,"
+            << "SparsePath,NnzA,NnzB,NnzResult,EffectiveFLOPs,"
+            << "MatrixAllocations,MatrixAllocatedMB,MatrixCopies,MatrixCopiedMB,MatrixMoves,"
+            << "CurrentMemoryMB,PageFaults,MajorPageFaults,PadRSSDeltaMB,ComputeRSSDeltaMB,UnpadRSSDeltaMB,"
+            << "AlgorithmType,ShapePath,RandomSeed,Layout,PredictedSeconds,PredictedPeakMemoryMB,MemoryBudgetMB,MemoryAdaptation,"
+            << "CacheStatus,CacheKey,CacheLookupSeconds,CachedComputeSeconds,"
+            << "RooflineFLOPs,GFLOPS,PeakGFLOPS,PeakFraction,BytesMoved,BytesSource,ArithmeticIntensity,"
+            << "AchievedGBs,StreamGBs,RooflineBound,RooflineEfficiency";
+        logHardwareCounterHeaderCSV(logfile);
+        logfile << "\n";
     }
 
     logfile << std::fixed << std::setprecision(10);
@@ -334,6 +401,27 @@ void logMultiplicationResultToCSV(const MultiplicationResult& result, const std:
     else {
         logfile << "0.0,0.0,0.0,0.0,0.0";
     }
+    logfile << "," << (result.sparse_path_used ? "Yes" : "No") << ","
+        << result.nnzA << "," << result.nnzB << "," << result.nnzResult << "," << result.effective_flops;
+    logAllocationStatsCSV(logfile, result.allocationStats);
+    logfile << "," << result.memoryInfo.currentWorkingSetMB << "," << result.memoryInfo.pageFaults << ","
+        << result.memoryInfo.majorPageFaults << "," << result.padding_rss_delta_mb << ","
+        << result.compute_rss_delta_mb << "," << result.unpadding_rss_delta_mb << ","
+        << result.algorithm_type << "," << (result.shape_path.empty() ? "general" : result.shape_path) << ","
+        << (result.random_operands ? std::to_string(result.random_seed) : string("none")) << ","
+        << getMatrixLayoutName(result.layout) << ","
+        << std::setprecision(6) << result.predicted_seconds << ","
+        << std::setprecision(3) << result.predicted_peak_memory_mb << "," << std::setprecision(1) << result.memory_budget_mb << ","
+        << (result.memory_adaptation.empty() ? "none" : result.memory_adaptation) << ","
+        << (result.cache_status.empty() ? "off" : result.cache_status) << "," << result.cache_key << ","
+        << std::setprecision(6) << result.cache_lookup_seconds << "," << result.cached_compute_seconds;
+    const RooflineMetrics roofline = computeRooflineMetrics(result);
+    logfile << "," << std::setprecision(0) << roofline.flops << "," << std::setprecision(3) << roofline.gflops << ","
+        << roofline.peakGflops << "," << std::setprecision(4) << roofline.peakFraction << ","
+        << std::setprecision(0) << roofline.bytes << "," << roofline.bytesSource << ","
+        << std::setprecision(4) << roofline.arithmeticIntensity << "," << std::setprecision(3) << roofline.bandwidthGBs << ","
+        << getMachinePeak().bandwidthGBs << "," << roofline.bound << "," << std::setprecision(4) << roofline.efficiency;
+    logHardwareCountersCSV(logfile, result.hardwareCounters);
     logfile << "\n";
     logfile.close();
     cout << GREEN << "Multiplication result logged to " << filename << RESET << endl;
@@ -348,7 +436,8 @@ void logComparisonResultToCSV(const ComparisonResult& result, const std::string&
     if (logfile.tellp() == 0) {
         logfile << "Operation,Rows,Cols,TotalElements,MatchCount,MismatchCount,MatchPercentage,"
             << "DurationSeconds_Chrono,DurationNanoseconds_Chrono,DurationSeconds_QPC,"
-            << "ThreadsUsed,CoresDetected,PeakMemoryMB,ComparisonThreshold,Epsilon\n";
+            << "ThreadsUsed,CoresDetected,PeakMemoryMB,ComparisonThreshold,Epsilon,"
+            << "MatrixAllocations,MatrixAllocatedMB,MatrixCopies,MatrixCopiedMB,MatrixMoves\n";
     }
 
     long long total_elements = static_cast<long long>(result.originalRows) * result.originalCols;
@@ -362,12 +451,82 @@ void logComparisonResultToCSV(const ComparisonResult& result, const std::string&
         << result.durationNanoseconds_chrono << "," << result.durationSeconds_qpc << ","
         << result.threadsUsed << "," << result.coresDetected << ","
         << result.memoryInfo.peakWorkingSetMB << "," << result.comparisonThreshold << ","
-        << std::scientific << std::setprecision(10) << result.epsilon << "\n";
+        << std::scientific << std::setprecision(10) << result.epsilon;
+    logAllocationStatsCSV(logfile, result.allocationStats);
+    logfile << "\n";
 
     logfile.close();
     cout << GREEN << "Comparison result logged to " << filename << RESET << endl;
 }
 
+// --- Reports ---
+void displayChainMultiplicationReport(const ChainMultiplicationResult& result) {
+    print_header_box("Matrix Chain Plan", 80);
+    std::stringstream ss;
+
+    // The plan can be long; wrap it to the box width.
+    const size_t plan_width = 64;
+    for (size_t pos = 0; pos < result.plan.size(); pos += plan_width) {
+        ss.str("");
+        ss << (pos == 0 ? " Plan        : " : "               ") << CYAN << result.plan.substr(pos, plan_width);
+        print_line_in_box(ss.str(), 80);
+    }
+
+    ss.str(""); ss << std::fixed << std::setprecision(3)
+        << " FLOPs       : " << result.plannedFlops / 1e9 << " GFLOP (left-to-right: " << result.leftToRightFlops / 1e9 << " GFLOP)";
+    print_line_in_box(ss.str(), 80);
+    ss.str(""); ss << std::fixed << std::setprecision(4)
+        << " Predicted   : " << result.predictedSeconds << "s (left-to-right: " << result.leftToRightPredictedSeconds << "s)";
+    print_line_in_box(ss.str(), 80);
+    ss.str(""); ss << std::fixed << std::setprecision(4)
+        << " Actual      : " << GREEN << result.durationSeconds_chrono << "s" << RESET << " (planning " << result.planningSeconds << "s)";
+    print_line_in_box(ss.str(), 80);
+    ss.str(""); ss << " Buffers     : " << result.buffersAllocated << " allocated, " << result.buffersReused << " reused";
+    print_line_in_box(ss.str(), 80);
+
+    if (!result.steps.empty()) {
+        print_separator_line(80);
+        ss.str(""); ss << std::left << " " << std::setw(22) << "Step" << std::setw(18) << "Shape (MxNxK)" << std::setw(10) << "Engine"
+            << std::setw(13) << "Predicted" << "Actual";
+        print_line_in_box(ss.str(), 80);
+        for (const ChainStepReport& step : result.steps) {
+            string expression = step.expression.size() > 21 ? step.expression.substr(0, 18) + "..." : step.expression;
+            string shape = std::to_string(step.M) + "x" + std::to_string(step.N) + "x" + std::to_string(step.K);
+            ss.str(""); ss << std::left << std::fixed << std::setprecision(4) << " " << std::setw(22) << expression << std::setw(18) << shape
+                << std::setw(10) << step.engine << std::setw(13) << step.predictedSeconds << step.actualSeconds;
+            print_line_in_box(ss.str(), 80);
+        }
+    }
+    print_footer_box(80); cout << endl;
+}
+
+void displayAlgorithmPlan(const AlgorithmPlan& plan) {
+    print_header_box("Automatic Algorithm Selection", 80);
+    std::stringstream ss;
+    ss << " Problem     : " << plan.M << "x" << plan.K << " * " << plan.K << "x" << plan.N
+        << std::fixed << std::setprecision(0) << " (memory limit " << plan.memoryLimitMB << " MB"
+        << (getMemoryBudget().enforcedMB > 0.0 ? ", from the budget)" : ")");
+    print_line_in_box(ss.str(), 80);
+    print_separator_line(80);
+    ss.str(""); ss << std::left << " " << std::setw(16) << "Algorithm" << std::setw(11) << "Threshold" << std::setw(9) << "Threads"
+        << std::setw(15) << "Predicted" << "Peak memory";
+    print_line_in_box(ss.str(), 80);
+    for (const AlgorithmCandidate& candidate : plan.candidates) {
+        const bool chosen = candidate.algorithm == plan.chosen.algorithm && candidate.strassenThreshold == plan.chosen.strassenThreshold
+            && candidate.strassenAsyncDepth == plan.chosen.strassenAsyncDepth && candidate.depthFirst == plan.chosen.depthFirst;
+        std::stringstream seconds_ss;
+        seconds_ss << std::fixed << std::setprecision(4) << candidate.predictedSeconds << "s";
+        ss.str(""); ss << std::left << std::fixed << (chosen ? GREEN + ">" : (candidate.feasible ? " " : RED + "x"))
+            << std::setw(16) << getMultiplyAlgorithmName(candidate.algorithm)
+            << std::setw(11) << (candidate.algorithm == MultiplyAlgorithm::Strassen ? std::to_string(candidate.strassenThreshold) : "-")
+            << std::setw(9) << candidate.threads << std::setw(15) << seconds_ss.str()
+            << std::setprecision(1) << candidate.predictedPeakMemoryMB << " MB";
+        print_line_in_box(ss.str(), 80);
+        if (!candidate.memoryAdaptation.empty()) print_line_in_box(string(18, ' ') + YELLOW + "fitted: " + candidate.memoryAdaptation + RESET, 80);
+    }
+    print_footer_box(80); cout << endl;
+}
+
 // --- UI Feedback ---
 void show_loading_animation_step(int& spinner_idx, const std::string& message) {
     string display_message = message;
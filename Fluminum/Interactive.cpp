@@ -3,6 +3,9 @@
 #include "IO.h"
 #include "Algorithms.h"
 #include "Matrix.h"
+#include "HardwareCounters.h"
+#include "CacheTopology.h"
+#include "Roofline.h"
 
 // --- Helper for displaying detailed timings ---
 void display_detailed_timings_ascii_chart(const MultiplicationResult& result) {
@@ -18,11 +21,13 @@ void display_detailed_timings_ascii_chart(const MultiplicationResult& result) {
     double total_timed_sec = 0;
 
     if (result.strassen_applied_at_top_level) {
-        // NOTE: The detailed first-level timings from the original code are not easily available in the new recursive structure.
-        // This chart is simplified to show the major phases.
+        // Phases of the top Strassen node; the 7 sub-products run (possibly in parallel) inside "L1 P Tasks".
         timings.push_back({ "Padding", result.padding_duration_sec });
-        double compute_sec = result.durationSeconds_chrono - result.padding_duration_sec - result.unpadding_duration_sec;
-        timings.push_back({ "Total Compute", std::max(0.0, compute_sec) });
+        timings.push_back({ "L1 Split", result.first_level_split_sec });
+        timings.push_back({ "L1 S Calc", result.first_level_S_calc_sec });
+        timings.push_back({ "L1 P Tasks (wall)", result.first_level_P_tasks_wall_sec });
+        timings.push_back({ "L1 C Quad Calc", result.first_level_C_quad_calc_sec });
+        timings.push_back({ "L1 Final Combine", result.first_level_final_combine_sec });
         timings.push_back({ "Unpadding", result.unpadding_duration_sec });
         for (const auto& t : timings) total_timed_sec += t.time_sec;
     }
@@ -50,6 +55,71 @@ void display_detailed_timings_ascii_chart(const MultiplicationResult& result) {
         line_ss << " (" << std::fixed << std::setprecision(4) << entry.time_sec << "s)";
         print_line_in_box(line_ss.str(), 80, false);
     }
+
+    const MatrixAllocationStats& alloc = result.allocationStats;
+    std::stringstream alloc_ss;
+    alloc_ss << std::fixed << std::setprecision(1)
+        << " Matrix buffers: " << alloc.allocations << " allocated (" << alloc.allocatedBytes / (1024.0 * 1024.0) << " MB), "
+        << (alloc.copies > 0 ? YELLOW : GREEN) << alloc.copies << " copied (" << alloc.copiedBytes / (1024.0 * 1024.0) << " MB)" << RESET
+        << ", " << alloc.moves << " moved";
+    print_line_in_box(alloc_ss.str(), 80, false);
+
+    std::stringstream rss_ss;
+    rss_ss << std::fixed << std::setprecision(1) << std::showpos
+        << " RSS change: pad " << result.padding_rss_delta_mb << " MB, compute " << result.compute_rss_delta_mb
+        << " MB, unpad " << result.unpadding_rss_delta_mb << " MB" << std::noshowpos
+        << " (peak " << result.memoryInfo.peakWorkingSetMB << " MB)";
+    print_line_in_box(rss_ss.str(), 80, false);
+    if (!result.shape_path.empty()) {
+        print_line_in_box(" Shape: " + CYAN + result.shape_path + RESET + " product, streaming kernel without padding", 80, false);
+    }
+
+    const RooflineMetrics roofline = computeRooflineMetrics(result);
+    if (roofline.bound != "n/a") {
+        std::stringstream flops_ss;
+        flops_ss << std::fixed << std::setprecision(2)
+            << " Roofline: " << roofline.gflops << " GFLOP/s, " << (roofline.peakFraction >= 0.5 ? GREEN : YELLOW)
+            << std::setprecision(1) << 100.0 * roofline.peakFraction << "%" << RESET << " of " << roofline.peakGflops
+            << " peak; AI " << std::setprecision(2) << roofline.arithmeticIntensity << " FLOP/B, " << roofline.bound
+            << ", " << std::setprecision(0) << 100.0 * roofline.efficiency << "% of attainable";
+        print_line_in_box(flops_ss.str(), 80, false);
+        std::stringstream bytes_ss;
+        bytes_ss << std::fixed << std::setprecision(1)
+            << " Traffic: " << roofline.bytes / (1024.0 * 1024.0) << " MB (" << roofline.bytesSource << "), "
+            << roofline.bandwidthGBs << " GB/s achieved vs " << getMachinePeak().bandwidthGBs << " GB/s STREAM";
+        print_line_in_box(bytes_ss.str(), 80, false);
+    }
+
+    // Hardware counters per phase; misses are per 1000 instructions so phases compare directly.
+    if (result.hardwareCounters[static_cast<int>(CounterPhase::Total)].valid) {
+        print_line_in_box("", 80, false);
+        std::stringstream head_ss;
+        head_ss << BLUE << " " << std::left << std::setw(14) << "Phase" << std::right << std::setw(11) << "Mcycles"
+            << std::setw(7) << "IPC" << std::setw(10) << "L1D/kI" << std::setw(10) << "LLC/kI"
+            << std::setw(10) << "dTLB/kI" << std::setw(10) << "GFLOP" << RESET;
+        print_line_in_box(head_ss.str(), 80, false);
+        auto per_kilo = [](long long events, long long instructions) {
+            return (events >= 0 && instructions > 0) ? 1000.0 * events / instructions : -1.0;
+        };
+        for (int p = 0; p < COUNTER_PHASE_COUNT; ++p) {
+            const HardwareCounterValues& c = result.hardwareCounters[p];
+            if (!c.valid) continue;
+            const double values[] = {
+                c.cycles >= 0 ? c.cycles / 1e6 : -1.0,
+                (c.cycles > 0 && c.instructions >= 0) ? static_cast<double>(c.instructions) / c.cycles : -1.0,
+                per_kilo(c.l1dMisses, c.instructions), per_kilo(c.llcMisses, c.instructions),
+                per_kilo(c.dtlbMisses, c.instructions), c.fpOps >= 0 ? c.fpOps / 1e9 : -1.0 };
+            const int widths[] = { 11, 7, 10, 10, 10, 10 };
+            std::stringstream row_ss;
+            row_ss << " " << std::left << std::setw(14) << getCounterPhaseName(static_cast<CounterPhase>(p)) << std::right
+                << std::fixed << std::setprecision(2);
+            for (int v = 0; v < 6; ++v) {
+                if (values[v] < 0) row_ss << std::setw(widths[v]) << "-";
+                else row_ss << std::setw(widths[v]) << values[v];
+            }
+            print_line_in_box(row_ss.str(), 80, false);
+        }
+    }
     print_footer_box(80); cout << endl;
 }
 
@@ -64,6 +134,7 @@ void run_one_operation() {
     ss_line.str(""); ss_line << std::left << std::setw(info_label_width) << " Total Physical RAM :" << PURPLE << sysMemInfo.totalPhysicalMB << " MB"; print_line_in_box(ss_line.str(), 80, false);
     ss_line.str(""); ss_line << std::left << std::setw(info_label_width) << " Available Physical RAM :" << GREEN << sysMemInfo.availablePhysicalMB << " MB"; print_line_in_box(ss_line.str(), 80, false);
     ss_line.str(""); ss_line << std::left << std::setw(info_label_width) << " Logical CPU Cores :" << BLUE << coreCount; print_line_in_box(ss_line.str(), 80, false);
+    ss_line.str(""); ss_line << std::left << std::setw(info_label_width) << " Caches :" << BLUE << describeCacheTopology(getCacheTopology()); print_line_in_box(ss_line.str(), 80, false);
     check_simd_support();
     ss_line.str(""); ss_line << std::left << std::setw(info_label_width) << " SIMD Support :";
     if (has_avx_global) ss_line << GREEN << "AVX Enabled";
@@ -1,6 +1,8 @@
 #define NOMINMAX
 #include "Matrix.h"
 #include "System.h" // For getSystemMemoryInfo in nextPowerOf2
+#include "Random.h"
+#include "Algorithm.h" // Shared pool for expression evaluation
 
 // Helper to format coordinates for CSV axes
 std::string format_coord(int n) {
@@ -9,31 +11,79 @@ std::string format_coord(int n) {
     return ss.str();
 }
 
+// --- Allocation Accounting ---
+namespace {
+std::atomic<long long> g_matrixAllocations(0);
+std::atomic<long long> g_matrixAllocatedBytes(0);
+std::atomic<long long> g_matrixCopies(0);
+std::atomic<long long> g_matrixCopiedBytes(0);
+std::atomic<long long> g_matrixMoves(0);
+
+void recordAllocation(size_t numElements) {
+    if (numElements == 0) return;
+    g_matrixAllocations.fetch_add(1, std::memory_order_relaxed);
+    g_matrixAllocatedBytes.fetch_add(static_cast<long long>(numElements * sizeof(double)), std::memory_order_relaxed);
+}
+
+void recordCopy(size_t numElements) {
+    g_matrixCopies.fetch_add(1, std::memory_order_relaxed);
+    g_matrixCopiedBytes.fetch_add(static_cast<long long>(numElements * sizeof(double)), std::memory_order_relaxed);
+}
+}
+
+MatrixAllocationStats getMatrixAllocationStats() {
+    MatrixAllocationStats stats;
+    stats.allocations = g_matrixAllocations.load(std::memory_order_relaxed);
+    stats.allocatedBytes = g_matrixAllocatedBytes.load(std::memory_order_relaxed);
+    stats.copies = g_matrixCopies.load(std::memory_order_relaxed);
+    stats.copiedBytes = g_matrixCopiedBytes.load(std::memory_order_relaxed);
+    stats.moves = g_matrixMoves.load(std::memory_order_relaxed);
+    return stats;
+}
+
+MatrixAllocationStats matrixAllocationsSince(const MatrixAllocationStats& start) {
+    MatrixAllocationStats now = getMatrixAllocationStats();
+    now.allocations -= start.allocations;
+    now.allocatedBytes -= start.allocatedBytes;
+    now.copies -= start.copies;
+    now.copiedBytes -= start.copiedBytes;
+    now.moves -= start.moves;
+    return now;
+}
+
+
 // --- Constructors ---
-Matrix::Matrix() : rows_(0), cols_(0) {}
+void Matrix::allocate(size_t numElements, double initialValue) {
+    data_.resize(numElements, initialValue);
+    recordAllocation(numElements);
+}
 
-Matrix::Matrix(int rows, int cols) : rows_(rows), cols_(cols) {
+static size_t checkedElementCount(int rows, int cols) {
     if (rows < 0 || cols < 0) throw std::invalid_argument("Matrix dimensions cannot be negative.");
     unsigned long long numElements_ull = static_cast<unsigned long long>(rows) * static_cast<unsigned long long>(cols);
     if (rows > 0 && cols > 0 && numElements_ull / static_cast<unsigned long long>(rows) != static_cast<unsigned long long>(cols)) {
         throw std::bad_alloc(); // Overflow check
     }
-    if (numElements_ull > std::vector<double>().max_size()) {
+    if (numElements_ull > MatrixStorage().max_size()) {
         throw std::bad_alloc();
     }
-    data_.resize(static_cast<size_t>(numElements_ull), 0.0);
+    return static_cast<size_t>(numElements_ull);
+}
+
+Matrix::Matrix() : rows_(0), cols_(0) {}
+
+Matrix::Matrix(int rows, int cols) : rows_(rows), cols_(cols) {
+    allocate(checkedElementCount(rows, cols), 0.0);
 }
 
 Matrix::Matrix(int rows, int cols, double initialValue) : rows_(rows), cols_(cols) {
-    if (rows < 0 || cols < 0) throw std::invalid_argument("Matrix dimensions cannot be negative.");
-    unsigned long long numElements_ull = static_cast<unsigned long long>(rows) * static_cast<unsigned long long>(cols);
-    if (rows > 0 && cols > 0 && numElements_ull / static_cast<unsigned long long>(rows) != static_cast<unsigned long long>(cols)) {
-        throw std::bad_alloc();
-    }
-    if (numElements_ull > std::vector<double>().max_size()) {
-        throw std::bad_alloc();
-    }
-    data_.resize(static_cast<size_t>(numElements_ull), initialValue);
+    allocate(checkedElementCount(rows, cols), initialValue);
+}
+
+Matrix::Matrix(int rows, int cols, Uninitialized) : rows_(rows), cols_(cols) {
+    const size_t numElements = checkedElementCount(rows, cols);
+    data_.resize(numElements);
+    recordAllocation(numElements);
 }
 
 Matrix::Matrix(const std::vector<std::vector<double>>& data_2d) {
@@ -51,14 +101,7 @@ Matrix::Matrix(const std::vector<std::vector<double>>& data_2d) {
         }
     }
 
-    unsigned long long numElements_ull = static_cast<unsigned long long>(rows_) * static_cast<unsigned long long>(cols_);
-    if (rows_ > 0 && cols_ > 0 && numElements_ull / static_cast<unsigned long long>(rows_) != static_cast<unsigned long long>(cols_)) {
-        throw std::bad_alloc();
-    }
-    if (numElements_ull > std::vector<double>().max_size()) {
-        throw std::bad_alloc();
-    }
-    data_.resize(static_cast<size_t>(numElements_ull));
+    allocate(checkedElementCount(rows_, cols_), 0.0);
 
     for (int i = 0; i < rows_; ++i) {
         for (int j = 0; j < cols_; ++j) {
@@ -67,6 +110,36 @@ Matrix::Matrix(const std::vector<std::vector<double>>& data_2d) {
     }
 }
 
+Matrix::Matrix(const Matrix& other) : rows_(other.rows_), cols_(other.cols_), data_(other.data_) {
+    recordAllocation(data_.size());
+    recordCopy(data_.size());
+}
+
+Matrix::Matrix(Matrix&& other) noexcept : rows_(other.rows_), cols_(other.cols_), data_(std::move(other.data_)) {
+    other.rows_ = 0; other.cols_ = 0;
+    other.data_.clear();
+    g_matrixMoves.fetch_add(1, std::memory_order_relaxed);
+}
+
+Matrix& Matrix::operator=(const Matrix& other) {
+    if (this == &other) return *this;
+    if (data_.capacity() < other.data_.size()) recordAllocation(other.data_.size());
+    data_ = other.data_;
+    rows_ = other.rows_; cols_ = other.cols_;
+    recordCopy(data_.size());
+    return *this;
+}
+
+Matrix& Matrix::operator=(Matrix&& other) noexcept {
+    if (this == &other) return *this;
+    data_ = std::move(other.data_);
+    rows_ = other.rows_; cols_ = other.cols_;
+    other.rows_ = 0; other.cols_ = 0;
+    other.data_.clear();
+    g_matrixMoves.fetch_add(1, std::memory_order_relaxed);
+    return *this;
+}
+
 // --- Accessors ---
 int Matrix::rows() const { return rows_; }
 int Matrix::cols() const { return cols_; }
@@ -84,20 +157,6 @@ double Matrix::operator()(int r, int c) const {
     return data_[static_cast<size_t>(r) * cols_ + c];
 }
 
-Matrix Matrix::operator+(const Matrix& other) const {
-    if (rows_ != other.rows_ || cols_ != other.cols_) throw std::invalid_argument("Matrix dimensions must match for addition.");
-    Matrix result(rows_, cols_);
-    for (size_t i = 0; i < data_.size(); ++i) result.data_[i] = data_[i] + other.data_[i];
-    return result;
-}
-
-Matrix Matrix::operator-(const Matrix& other) const {
-    if (rows_ != other.rows_ || cols_ != other.cols_) throw std::invalid_argument("Matrix dimensions must match for subtraction.");
-    Matrix result(rows_, cols_);
-    for (size_t i = 0; i < data_.size(); ++i) result.data_[i] = data_[i] - other.data_[i];
-    return result;
-}
-
 // --- Core Algorithms ---
 Matrix Matrix::multiply_naive(const Matrix& other) const {
     if (cols_ != other.rows_) throw std::invalid_argument("Matrix dimensions incompatible for multiplication (A.cols != B.rows).");
@@ -177,20 +236,14 @@ long long Matrix::compare_naive(const Matrix& other, double epsilon) const {
 
 // --- Static Factory & Utility Methods ---
 Matrix Matrix::generateRandom(int rows, int cols) {
-    if (rows < 0 || cols < 0) throw std::invalid_argument("Matrix dimensions cannot be negative for random generation.");
-    if (rows == 0 || cols == 0) return Matrix(rows, cols);
-
-    constexpr double minVal = -10.0;
-    constexpr double maxVal = 10.0;
-
-    Matrix result(rows, cols);
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<double> distrib(minVal, maxVal);
-    for (size_t i = 0; i < result.data_.size(); ++i) {
-        result.data_[i] = distrib(gen);
-    }
-    return result;
+    return generateRandom(rows, cols, newRandomSeed());
+}
+
+Matrix Matrix::generateRandom(int rows, int cols, unsigned long long seed, unsigned int stream) {
+    RandomMatrixSpec spec;
+    spec.rows = rows;
+    spec.cols = cols;
+    return generateRandomMatrix(spec, seed, stream);
 }
 
 Matrix Matrix::identity(int n) {
@@ -213,6 +266,11 @@ Matrix Matrix::pad(const Matrix& A, int targetSize) {
     return padded;
 }
 
+Matrix Matrix::pad(Matrix&& A, int targetSize) {
+    if (targetSize == A.rows() && targetSize == A.cols()) return std::move(A);
+    return pad(static_cast<const Matrix&>(A), targetSize);
+}
+
 Matrix Matrix::unpad(const Matrix& A, int originalRows, int originalCols) {
     if (originalRows == A.rows() && originalCols == A.cols()) return A;
     if (originalRows == 0 || originalCols == 0) {
@@ -230,6 +288,11 @@ Matrix Matrix::unpad(const Matrix& A, int originalRows, int originalCols) {
     return unpadded;
 }
 
+Matrix Matrix::unpad(Matrix&& A, int originalRows, int originalCols) {
+    if (originalRows == A.rows() && originalCols == A.cols()) return std::move(A);
+    return unpad(static_cast<const Matrix&>(A), originalRows, originalCols);
+}
+
 // --- Splitting and Combining for Strassen ---
 void Matrix::split(Matrix& A11, Matrix& A12, Matrix& A21, Matrix& A22) const {
     if (rows_ != cols_ || rows_ % 2 != 0 || rows_ == 0) throw std::logic_error("Internal Error: Matrix for split must be non-empty, square, and even-dimensioned.");
@@ -264,26 +327,121 @@ void Matrix::split(const Matrix& A, const Matrix& B,
 }
 
 Matrix Matrix::combine(const Matrix& C11, const Matrix& C12, const Matrix& C21, const Matrix& C22) {
+    Matrix C;
+    combine(C11, C12, C21, C22, C);
+    return C;
+}
+
+void Matrix::combine(const Matrix& C11, const Matrix& C12, const Matrix& C21, const Matrix& C22, Matrix& C) {
     int n2 = C11.rows();
     if (C11.cols() != n2 || C12.rows() != n2 || C12.cols() != n2 ||
         C21.rows() != n2 || C21.cols() != n2 || C22.rows() != n2 || C22.cols() != n2 || n2 == 0)
         throw std::invalid_argument("Quadrants for combining must be non-empty, square, and same dimensions.");
     int n = n2 * 2;
-    Matrix C(n, n);
+    if (C.rows() != n || C.cols() != n) C = Matrix(n, n);
     for (int i = 0; i < n2; ++i) {
         for (int j = 0; j < n2; ++j) {
             C(i, j) = C11(i, j);        C(i, j + n2) = C12(i, j);
             C(i + n2, j) = C21(i, j);   C(i + n2, j + n2) = C22(i, j);
         }
     }
-    return C;
 }
 
 
-const std::vector<double>& Matrix::getRawData() const {
+const MatrixStorage& Matrix::getRawData() const {
     return data_;
 }
 
+MatrixStorage& Matrix::getRawData() {
+    return data_;
+}
+
+
+// --- Non-owning Views ---
+static void checkViewBlock(int row, int col, int rows, int cols, int parentRows, int parentCols) {
+    if (row < 0 || col < 0 || rows < 0 || cols < 0 || row + rows > parentRows || col + cols > parentCols) {
+        throw std::out_of_range("Matrix view block out of range.");
+    }
+}
+
+ConstMatrixView::ConstMatrixView() : data_(nullptr), rows_(0), cols_(0), stride_(0) {}
+
+ConstMatrixView::ConstMatrixView(const double* data, int rows, int cols, long long stride)
+    : data_(data), rows_(rows), cols_(cols), stride_(stride) {
+    if (rows < 0 || cols < 0) throw std::invalid_argument("Matrix view dimensions cannot be negative.");
+    if (rows > 1 && stride < cols) throw std::invalid_argument("Matrix view stride must be at least the column count.");
+}
+
+ConstMatrixView::ConstMatrixView(const Matrix& m)
+    : data_(m.getRawData().data()), rows_(m.rows()), cols_(m.cols()), stride_(m.cols()) {
+}
+
+ConstMatrixView ConstMatrixView::block(int row, int col, int rows, int cols) const {
+    checkViewBlock(row, col, rows, cols, rows_, cols_);
+    return ConstMatrixView(data_ + row * stride_ + col, rows, cols, stride_);
+}
+
+MatrixView::MatrixView() : data_(nullptr), rows_(0), cols_(0), stride_(0) {}
+
+MatrixView::MatrixView(double* data, int rows, int cols, long long stride)
+    : data_(data), rows_(rows), cols_(cols), stride_(stride) {
+    if (rows < 0 || cols < 0) throw std::invalid_argument("Matrix view dimensions cannot be negative.");
+    if (rows > 1 && stride < cols) throw std::invalid_argument("Matrix view stride must be at least the column count.");
+}
+
+MatrixView::MatrixView(Matrix& m)
+    : data_(m.getRawData().data()), rows_(m.rows()), cols_(m.cols()), stride_(m.cols()) {
+}
+
+MatrixView MatrixView::block(int row, int col, int rows, int cols) const {
+    checkViewBlock(row, col, rows, cols, rows_, cols_);
+    return MatrixView(data_ + row * stride_ + col, rows, cols, stride_);
+}
+
+
+// --- Lazy Expression Evaluation ---
+static thread_local bool t_allowParallelEvaluation = true;
+
+void setThreadAllowsParallelEvaluation(bool allowed) {
+    t_allowParallelEvaluation = allowed;
+}
+
+void evaluateMatrixExprChunks(size_t n, const std::function<void(size_t, size_t)>& body) {
+    size_t num_threads = t_allowParallelEvaluation ? getCpuCoreCount() : 1;
+    num_threads = std::min(num_threads, std::max<size_t>(1, n / (MATRIX_EXPR_PARALLEL_THRESHOLD / 4)));
+    if (num_threads <= 1) {
+        body(0, n);
+        return;
+    }
+
+    // Chunk boundaries are multiples of 4 so every chunk but the last runs whole AVX packets.
+    // The other chunks go to the shared pool; its workers never evaluate in parallel
+    // themselves, so waiting on them from here cannot deadlock.
+    size_t chunk = ((n + num_threads - 1) / num_threads + 3) & ~size_t(3);
+    ThreadPool& pool = getSharedThreadPool();
+    std::vector<std::future<void>> helpers;
+    for (size_t begin = chunk; begin < n; begin += chunk) {
+        helpers.emplace_back(pool.enqueue([&body, begin, chunk, n] { body(begin, std::min(n, begin + chunk)); }));
+    }
+    // Every chunk must finish before body (and the operands it refers to) goes out of scope.
+    std::exception_ptr error;
+    try {
+        body(0, std::min(n, chunk));
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    for (auto& helper : helpers) {
+        try {
+            helper.get();
+        }
+        catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+}
+
 
 // --- Helper Functions related to Matrix dimensions ---
 int nextPowerOf2(int n) {
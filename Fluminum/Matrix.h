@@ -4,6 +4,26 @@
 // Helper to format coordinates for CSV axes
 std::string format_coord(int n);
 
+template<class E> struct MatrixExpr;
+
+// std::allocator whose value-less construct default-initialises, so resize(n) on a vector of
+// doubles leaves the new elements unset instead of zero-filling them.
+template<class T>
+struct DefaultInitAllocator : std::allocator<T> {
+    template<class U> struct rebind { using other = DefaultInitAllocator<U>; };
+
+    DefaultInitAllocator() noexcept = default;
+    template<class U> DefaultInitAllocator(const DefaultInitAllocator<U>&) noexcept {}
+
+    template<class U>
+    void construct(U* p) noexcept(std::is_nothrow_default_constructible<U>::value) { ::new (static_cast<void*>(p)) U; }
+    template<class U, class... Args>
+    void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+};
+
+// Row-major element storage of a Matrix.
+using MatrixStorage = std::vector<double, DefaultInitAllocator<double>>;
+
 class Matrix {
 public:
     // --- Constructors ---
@@ -12,6 +32,16 @@ public:
     Matrix(int rows, int cols, double initialValue);
     Matrix(const std::vector<std::vector<double>>& data_2d);
 
+    // Copies and moves are spelled out so they can be counted (see getMatrixAllocationStats).
+    Matrix(const Matrix& other);
+    Matrix(Matrix&& other) noexcept;
+    Matrix& operator=(const Matrix& other);
+    Matrix& operator=(Matrix&& other) noexcept;
+
+    // Evaluates a lazy expression (see MatrixExpr.h) in one fused pass.
+    template<class E> Matrix(const MatrixExpr<E>& expr);
+    template<class E> Matrix& operator=(const MatrixExpr<E>& expr);
+
     // --- Accessors ---
     int rows() const;
     int cols() const;
@@ -21,8 +51,7 @@ public:
     // --- Operators ---
     double& operator()(int r, int c);
     double operator()(int r, int c) const;
-    Matrix operator+(const Matrix& other) const;
-    Matrix operator-(const Matrix& other) const;
+    // +, -, scalar scaling and the cwise* operations are lazy; see MatrixExpr.h.
 
     // --- Core Algorithms ---
     Matrix multiply_naive(const Matrix& other) const;
@@ -33,10 +62,15 @@ public:
     long long compare_naive(const Matrix& other, double epsilon = 0.0) const;
 
     // --- Static Factory & Utility Methods ---
+    // Uniform in [-10, 10) under a fresh seed, or under the given one (see Random.h).
     static Matrix generateRandom(int rows, int cols);
+    static Matrix generateRandom(int rows, int cols, unsigned long long seed, unsigned int stream = 0);
     static Matrix identity(int n);
     static Matrix pad(const Matrix& A, int targetSize);
     static Matrix unpad(const Matrix& A, int originalRows, int originalCols);
+    // Rvalue overloads hand the buffer over instead of copying it when no resize is needed.
+    static Matrix pad(Matrix&& A, int targetSize);
+    static Matrix unpad(Matrix&& A, int originalRows, int originalCols);
 
     // --- Splitting and Combining for Strassen ---
     void split(Matrix& A11, Matrix& A12, Matrix& A21, Matrix& A22) const;
@@ -44,15 +78,83 @@ public:
         Matrix& A11, Matrix& A12, Matrix& A21, Matrix& A22,
         Matrix& B11, Matrix& B12, Matrix& B21, Matrix& B22);
     static Matrix combine(const Matrix& C11, const Matrix& C12, const Matrix& C21, const Matrix& C22);
+    // Same, into C; its storage is reused when it already has the combined size.
+    static void combine(const Matrix& C11, const Matrix& C12, const Matrix& C21, const Matrix& C22, Matrix& C);
 
     // --- Public Member for Direct Data Access (if needed) ---
-    const std::vector<double>& getRawData() const;
+    const MatrixStorage& getRawData() const;
+    MatrixStorage& getRawData();
 
 private:
+    // Tag for a matrix whose every element is about to be written (expression evaluation).
+    struct Uninitialized {};
+    Matrix(int rows, int cols, Uninitialized);
+
+    template<class E> void evaluateExpression(const MatrixExpr<E>& expr);
+    void allocate(size_t numElements, double initialValue);
+
     int rows_;
     int cols_;
-    std::vector<double> data_;
+    MatrixStorage data_;
+};
+
+// --- Non-owning Views ---
+// A strided window over row-major storage: element (r, c) lives at data()[r * stride() + c].
+// Views never allocate and never check bounds in operator(); they are meant for kernels.
+class ConstMatrixView {
+public:
+    ConstMatrixView();
+    ConstMatrixView(const double* data, int rows, int cols, long long stride);
+    ConstMatrixView(const Matrix& m);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    long long stride() const { return stride_; }
+    const double* data() const { return data_; }
+    double operator()(int r, int c) const { return data_[r * stride_ + c]; }
+
+    ConstMatrixView block(int row, int col, int rows, int cols) const;
+
+private:
+    const double* data_;
+    int rows_;
+    int cols_;
+    long long stride_;
+};
+
+class MatrixView {
+public:
+    MatrixView();
+    MatrixView(double* data, int rows, int cols, long long stride);
+    MatrixView(Matrix& m);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    long long stride() const { return stride_; }
+    double* data() const { return data_; }
+    double& operator()(int r, int c) const { return data_[r * stride_ + c]; }
+
+    MatrixView block(int row, int col, int rows, int cols) const;
+    operator ConstMatrixView() const { return ConstMatrixView(data_, rows_, cols_, stride_); }
+
+private:
+    double* data_;
+    int rows_;
+    int cols_;
+    long long stride_;
 };
 
 // --- Helper Functions related to Matrix dimensions ---
-int nextPowerOf2(int n);
\ No newline at end of file
+int nextPowerOf2(int n);
+
+// --- Allocation Accounting ---
+// Process-wide totals since startup. Runs on other threads are included, so take the
+// difference around a single run with matrixAllocationsSince.
+MatrixAllocationStats getMatrixAllocationStats();
+MatrixAllocationStats matrixAllocationsSince(const MatrixAllocationStats& start);
+
+// Large expression evaluations are split across threads unless the calling thread has opted
+// out. ThreadPool workers opt out, since they already run one task per core.
+void setThreadAllowsParallelEvaluation(bool allowed);
+
+#include "MatrixExpr.h"
\ No newline at end of file
@@ -0,0 +1,232 @@
+#pragma once
+// Included at the end of Matrix.h; not meant to be included on its own.
+
+// --- Lazy Matrix Expressions ---
+// Element-wise arithmetic on matrices builds a tree of small expression objects instead of
+// allocating a temporary per operator. The tree is evaluated in one fused pass (AVX packets
+// where available, split across threads when large) when it is assigned to a Matrix:
+//
+//     Matrix C11 = P1 + P4 - P5 + P7;   // one allocation, one sweep over memory
+//
+// Expressions refer to their Matrix operands, so keep them only within the full expression
+// that produces a Matrix; `auto e = A + B;` must not outlive A or B.
+
+// Evaluations with at least this many elements are split across threads.
+const size_t MATRIX_EXPR_PARALLEL_THRESHOLD = size_t(1) << 20;
+
+// Runs body(begin, end) over [0, n) in contiguous chunks on up to getCpuCoreCount() threads.
+void evaluateMatrixExprChunks(size_t n, const std::function<void(size_t, size_t)>& body);
+
+template<class E>
+struct MatrixExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+// Leaf node referring to an existing Matrix.
+class MatrixTerminal : public MatrixExpr<MatrixTerminal> {
+public:
+    explicit MatrixTerminal(const Matrix& m) : data_(m.getRawData().data()), rows_(m.rows()), cols_(m.cols()) {}
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    double eval(size_t i) const { return data_[i]; }
+#ifdef HAS_AVX
+    __m256d packet(size_t i) const { return _mm256_loadu_pd(data_ + i); }
+#endif
+
+private:
+    const double* data_;
+    int rows_;
+    int cols_;
+};
+
+// --- Element-wise Operations ---
+namespace matrix_ops {
+struct Add {
+    static double apply(double a, double b) { return a + b; }
+#ifdef HAS_AVX
+    static __m256d apply(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+#endif
+    static const char* name() { return "addition"; }
+};
+struct Sub {
+    static double apply(double a, double b) { return a - b; }
+#ifdef HAS_AVX
+    static __m256d apply(__m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+#endif
+    static const char* name() { return "subtraction"; }
+};
+struct Mul {
+    static double apply(double a, double b) { return a * b; }
+#ifdef HAS_AVX
+    static __m256d apply(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+#endif
+    static const char* name() { return "element-wise product"; }
+};
+struct Div {
+    static double apply(double a, double b) { return a / b; }
+#ifdef HAS_AVX
+    static __m256d apply(__m256d a, __m256d b) { return _mm256_div_pd(a, b); }
+#endif
+    static const char* name() { return "element-wise quotient"; }
+};
+struct Min {
+    static double apply(double a, double b) { return (b < a) ? b : a; }
+#ifdef HAS_AVX
+    static __m256d apply(__m256d a, __m256d b) { return _mm256_min_pd(b, a); }
+#endif
+    static const char* name() { return "element-wise minimum"; }
+};
+struct Max {
+    static double apply(double a, double b) { return (a < b) ? b : a; }
+#ifdef HAS_AVX
+    static __m256d apply(__m256d a, __m256d b) { return _mm256_max_pd(b, a); }
+#endif
+    static const char* name() { return "element-wise maximum"; }
+};
+} // namespace matrix_ops
+
+template<class L, class R, class Op>
+class MatrixBinaryExpr : public MatrixExpr<MatrixBinaryExpr<L, R, Op>> {
+public:
+    MatrixBinaryExpr(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {
+        if (lhs.rows() != rhs.rows() || lhs.cols() != rhs.cols()) {
+            throw std::invalid_argument(string("Matrix dimensions must match for ") + Op::name() + ".");
+        }
+    }
+
+    int rows() const { return lhs_.rows(); }
+    int cols() const { return lhs_.cols(); }
+    double eval(size_t i) const { return Op::apply(lhs_.eval(i), rhs_.eval(i)); }
+#ifdef HAS_AVX
+    __m256d packet(size_t i) const { return Op::apply(lhs_.packet(i), rhs_.packet(i)); }
+#endif
+
+private:
+    L lhs_;
+    R rhs_;
+};
+
+// s * e (also used for negation with s = -1).
+template<class E>
+class MatrixScaledExpr : public MatrixExpr<MatrixScaledExpr<E>> {
+public:
+    MatrixScaledExpr(const E& expr, double scale) : expr_(expr), scale_(scale) {}
+
+    int rows() const { return expr_.rows(); }
+    int cols() const { return expr_.cols(); }
+    double eval(size_t i) const { return scale_ * expr_.eval(i); }
+#ifdef HAS_AVX
+    __m256d packet(size_t i) const { return _mm256_mul_pd(_mm256_set1_pd(scale_), expr_.packet(i)); }
+#endif
+
+private:
+    E expr_;
+    double scale_;
+};
+
+// e / s. Divides rather than scaling by 1 / s, which rounds differently.
+template<class E>
+class MatrixDividedExpr : public MatrixExpr<MatrixDividedExpr<E>> {
+public:
+    MatrixDividedExpr(const E& expr, double divisor) : expr_(expr), divisor_(divisor) {}
+
+    int rows() const { return expr_.rows(); }
+    int cols() const { return expr_.cols(); }
+    double eval(size_t i) const { return expr_.eval(i) / divisor_; }
+#ifdef HAS_AVX
+    __m256d packet(size_t i) const { return _mm256_div_pd(expr_.packet(i), _mm256_set1_pd(divisor_)); }
+#endif
+
+private:
+    E expr_;
+    double divisor_;
+};
+
+// --- Operand Adaptation ---
+template<class T>
+struct is_matrix_operand : std::integral_constant<bool,
+    std::is_same<T, Matrix>::value || std::is_base_of<MatrixExpr<T>, T>::value> {};
+
+inline MatrixTerminal as_matrix_expr(const Matrix& m) { return MatrixTerminal(m); }
+template<class E>
+inline const E& as_matrix_expr(const MatrixExpr<E>& e) { return e.self(); }
+
+template<class T>
+using matrix_expr_t = std::decay_t<decltype(as_matrix_expr(std::declval<const T&>()))>;
+
+template<class Op, class L, class R>
+inline MatrixBinaryExpr<matrix_expr_t<L>, matrix_expr_t<R>, Op> make_matrix_binary(const L& l, const R& r) {
+    return MatrixBinaryExpr<matrix_expr_t<L>, matrix_expr_t<R>, Op>(as_matrix_expr(l), as_matrix_expr(r));
+}
+
+#define FLUMINUM_MATRIX_OPERANDS(L, R) \
+    typename = std::enable_if_t<is_matrix_operand<L>::value && is_matrix_operand<R>::value>
+
+// --- Operators ---
+template<class L, class R, FLUMINUM_MATRIX_OPERANDS(L, R)>
+inline auto operator+(const L& l, const R& r) { return make_matrix_binary<matrix_ops::Add>(l, r); }
+
+template<class L, class R, FLUMINUM_MATRIX_OPERANDS(L, R)>
+inline auto operator-(const L& l, const R& r) { return make_matrix_binary<matrix_ops::Sub>(l, r); }
+
+template<class L, class R, FLUMINUM_MATRIX_OPERANDS(L, R)>
+inline auto cwiseProduct(const L& l, const R& r) { return make_matrix_binary<matrix_ops::Mul>(l, r); }
+
+template<class L, class R, FLUMINUM_MATRIX_OPERANDS(L, R)>
+inline auto cwiseQuotient(const L& l, const R& r) { return make_matrix_binary<matrix_ops::Div>(l, r); }
+
+template<class L, class R, FLUMINUM_MATRIX_OPERANDS(L, R)>
+inline auto cwiseMin(const L& l, const R& r) { return make_matrix_binary<matrix_ops::Min>(l, r); }
+
+template<class L, class R, FLUMINUM_MATRIX_OPERANDS(L, R)>
+inline auto cwiseMax(const L& l, const R& r) { return make_matrix_binary<matrix_ops::Max>(l, r); }
+
+template<class E, typename = std::enable_if_t<is_matrix_operand<E>::value>>
+inline auto operator*(double s, const E& e) { return MatrixScaledExpr<matrix_expr_t<E>>(as_matrix_expr(e), s); }
+
+template<class E, typename = std::enable_if_t<is_matrix_operand<E>::value>>
+inline auto operator*(const E& e, double s) { return MatrixScaledExpr<matrix_expr_t<E>>(as_matrix_expr(e), s); }
+
+template<class E, typename = std::enable_if_t<is_matrix_operand<E>::value>>
+inline auto operator/(const E& e, double s) { return MatrixDividedExpr<matrix_expr_t<E>>(as_matrix_expr(e), s); }
+
+template<class E, typename = std::enable_if_t<is_matrix_operand<E>::value>>
+inline auto operator-(const E& e) { return MatrixScaledExpr<matrix_expr_t<E>>(as_matrix_expr(e), -1.0); }
+
+#undef FLUMINUM_MATRIX_OPERANDS
+
+// --- Evaluation ---
+template<class E>
+void Matrix::evaluateExpression(const MatrixExpr<E>& expr) {
+    const E& e = expr.self();
+    double* out = data_.data();
+    auto run = [&e, out](size_t begin, size_t end) {
+        size_t i = begin;
+#ifdef HAS_AVX
+        for (; i + 4 <= end; i += 4) _mm256_storeu_pd(out + i, e.packet(i));
+#endif
+        for (; i < end; ++i) out[i] = e.eval(i);
+    };
+    size_t n = data_.size();
+    if (n >= MATRIX_EXPR_PARALLEL_THRESHOLD) evaluateMatrixExprChunks(n, run);
+    else run(0, n);
+}
+
+template<class E>
+Matrix::Matrix(const MatrixExpr<E>& expr) : Matrix(expr.self().rows(), expr.self().cols(), Uninitialized()) {
+    evaluateExpression(expr);
+}
+
+template<class E>
+Matrix& Matrix::operator=(const MatrixExpr<E>& expr) {
+    // Every element depends only on the same index of the operands, so evaluating in place is
+    // safe even when this matrix is one of them (A = A + B).
+    if (rows_ != expr.self().rows() || cols_ != expr.self().cols()) {
+        Matrix result(expr);
+        *this = std::move(result);
+        return *this;
+    }
+    evaluateExpression(expr);
+    return *this;
+}
@@ -0,0 +1,372 @@
+#define NOMINMAX
+#include "Morton.h"
+#include "Matrix.h"
+#include "FixedMatrix.h" // fixed_kernels::fmadd
+#include "HardwareCounters.h"
+#include "Trace.h"
+
+// --- Morton Matrix ---
+MortonMatrix::MortonMatrix() : size_(0), leaf_(1) {}
+
+MortonMatrix::MortonMatrix(int size, int leaf) : size_(size), leaf_(leaf) {
+    if (leaf <= 0 || size < leaf || size % leaf != 0 || nextPowerOf2(size / leaf) != size / leaf) {
+        throw std::invalid_argument("Morton matrix size must be a power-of-two multiple of its leaf size.");
+    }
+    data_.reset(new double[elementCount()]);
+}
+
+double MortonMatrix::at(int r, int c) const {
+    if (r < 0 || r >= size_ || c < 0 || c >= size_) throw std::out_of_range("Morton matrix index out of range.");
+    const size_t tile = mortonIndex(r / leaf_, c / leaf_);
+    return data_[tile * leaf_ * leaf_ + static_cast<size_t>(r % leaf_) * leaf_ + c % leaf_];
+}
+
+size_t mortonIndex(int tile_row, int tile_col) {
+    size_t index = 0;
+    for (int bit = 0; (tile_row >> bit) != 0 || (tile_col >> bit) != 0; ++bit) {
+        index |= static_cast<size_t>((tile_col >> bit) & 1) << (2 * bit);
+        index |= static_cast<size_t>((tile_row >> bit) & 1) << (2 * bit + 1);
+    }
+    return index;
+}
+
+int chooseMortonLeaf(int min_size, int tile_size) {
+    int leaf = MORTON_MIN_LEAF;
+    while (leaf * 2 <= std::min(tile_size, MORTON_MAX_LEAF)) leaf *= 2;
+    return std::min(leaf, nextPowerOf2(std::max(1, min_size)));
+}
+
+int mortonPaddedSize(int min_size, int leaf) {
+    return leaf * nextPowerOf2((std::max(1, min_size) + leaf - 1) / leaf);
+}
+
+namespace {
+// Inverse of mortonIndex.
+void mortonCoordinates(size_t index, int& tile_row, int& tile_col) {
+    tile_row = tile_col = 0;
+    for (int bit = 0; index != 0; ++bit, index >>= 2) {
+        tile_col |= static_cast<int>(index & 1) << bit;
+        tile_row |= static_cast<int>((index >> 1) & 1) << bit;
+    }
+}
+
+// Runs body(0 ... count - 1) on the pool's threads, handing out items one at a time, and waits.
+void forEachItem(ThreadPool& pool, long long count, const std::function<void(long long)>& body) {
+    const long long workers = std::min<long long>(count, static_cast<long long>(pool.size()));
+    if (workers <= 1) {
+        for (long long i = 0; i < count; ++i) body(i);
+        return;
+    }
+    std::atomic<long long> next(0);
+    std::vector<std::future<void>> futures;
+    futures.reserve(workers);
+    for (long long w = 0; w < workers; ++w) {
+        futures.emplace_back(pool.enqueue([&] {
+            for (long long i = next++; i < count; i = next++) body(i);
+            }));
+    }
+    waitForAll(futures);
+    for (auto& f : futures) f.get();
+}
+
+
+// --- Blocked Kernel ---
+// c += a * b for leaf x leaf row-major tiles. Leaves are powers of two, so with AVX every leaf
+// of at least 8 splits into 4 x 8 blocks of C held in registers across the whole k loop.
+void leafMultiplyAdd(const double* a, const double* b, double* c, int leaf) {
+#ifdef HAS_AVX
+    if (leaf % 8 == 0) {
+        for (int i = 0; i < leaf; i += 4) {
+            for (int j = 0; j < leaf; j += 8) {
+                __m256d acc[4][2];
+                for (int r = 0; r < 4; ++r) {
+                    acc[r][0] = _mm256_loadu_pd(c + (i + r) * leaf + j);
+                    acc[r][1] = _mm256_loadu_pd(c + (i + r) * leaf + j + 4);
+                }
+                for (int k = 0; k < leaf; ++k) {
+                    const __m256d b0 = _mm256_loadu_pd(b + k * leaf + j);
+                    const __m256d b1 = _mm256_loadu_pd(b + k * leaf + j + 4);
+                    for (int r = 0; r < 4; ++r) {
+                        const __m256d av = _mm256_broadcast_sd(a + (i + r) * leaf + k);
+                        acc[r][0] = fixed_kernels::fmadd(av, b0, acc[r][0]);
+                        acc[r][1] = fixed_kernels::fmadd(av, b1, acc[r][1]);
+                    }
+                }
+                for (int r = 0; r < 4; ++r) {
+                    _mm256_storeu_pd(c + (i + r) * leaf + j, acc[r][0]);
+                    _mm256_storeu_pd(c + (i + r) * leaf + j + 4, acc[r][1]);
+                }
+            }
+        }
+        return;
+    }
+#endif
+    for (int i = 0; i < leaf; ++i) {
+        for (int k = 0; k < leaf; ++k) {
+            const double a_ik = a[i * leaf + k];
+            for (int j = 0; j < leaf; ++j) c[i * leaf + j] += a_ik * b[k * leaf + j];
+        }
+    }
+}
+
+// The logical product inside the padded operands; blocks entirely outside it are skipped.
+struct ProductExtent {
+    int M, N, K;
+};
+
+const ProductExtent UNBOUNDED_EXTENT = { std::numeric_limits<int>::max(), std::numeric_limits<int>::max(), std::numeric_limits<int>::max() };
+
+// C += A * B for n x n Morton blocks whose top-left corners sit at row `row` of C, column `col`
+// of C and `inner` along the shared dimension.
+void blockMultiplyAdd(const double* A, const double* B, double* C, int n, int leaf, int row, int col, int inner,
+    const ProductExtent& extent) {
+    if (row >= extent.M || col >= extent.N || inner >= extent.K) return;
+    if (n <= leaf) {
+        leafMultiplyAdd(A, B, C, n);
+        return;
+    }
+    const int h = n / 2;
+    const size_t q = static_cast<size_t>(h) * h;
+    blockMultiplyAdd(A, B, C, h, leaf, row, col, inner, extent);                                // C11 += A11 B11
+    blockMultiplyAdd(A + q, B + 2 * q, C, h, leaf, row, col, inner + h, extent);                //      + A12 B21
+    blockMultiplyAdd(A, B + q, C + q, h, leaf, row, col + h, inner, extent);                    // C12 += A11 B12
+    blockMultiplyAdd(A + q, B + 3 * q, C + q, h, leaf, row, col + h, inner + h, extent);        //      + A12 B22
+    blockMultiplyAdd(A + 2 * q, B, C + 2 * q, h, leaf, row + h, col, inner, extent);            // C21 += A21 B11
+    blockMultiplyAdd(A + 3 * q, B + 2 * q, C + 2 * q, h, leaf, row + h, col, inner + h, extent);//      + A22 B21
+    blockMultiplyAdd(A + 2 * q, B + q, C + 3 * q, h, leaf, row + h, col + h, inner, extent);    // C22 += A21 B12
+    blockMultiplyAdd(A + 3 * q, B + 3 * q, C + 3 * q, h, leaf, row + h, col + h, inner + h, extent); // + A22 B22
+}
+
+
+// --- Strassen on Quadrant Slices ---
+struct MortonStrassenRun {
+    ThreadPool& pool;
+    int leaf;
+    int threshold;
+    int maxAsyncDepth;
+    std::atomic<int>& progress;
+};
+
+// Element-wise kernels over contiguous slices of `count` doubles.
+void sumSlices(double* out, const double* x, const double* y, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] = x[i] + y[i];
+}
+
+void differenceSlices(double* out, const double* x, const double* y, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] = x[i] - y[i];
+}
+
+void addToSlice(double* out, const double* x, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] += x[i];
+}
+
+void subtractFromSlice(double* out, const double* x, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] -= x[i];
+}
+
+void mortonStrassenNode(const MortonStrassenRun& run, const double* A, const double* B, double* C, int n, int depth,
+    MultiplicationResult* first_level_timings) {
+    TraceScope node_trace("StrassenNode", depth, n);
+    const size_t elements = static_cast<size_t>(n) * n;
+    if (n <= run.threshold || n <= run.leaf) {
+        run.progress.fetch_add(1, std::memory_order_relaxed);
+        HardwareCounterScope base_counters(CounterPhase::BaseMultiply);
+        TraceScope base_trace("BaseMultiply", depth, n);
+        std::fill(C, C + elements, 0.0);
+        blockMultiplyAdd(A, B, C, n, run.leaf, 0, 0, 0, UNBOUNDED_EXTENT);
+        return;
+    }
+
+    using Clock = std::chrono::high_resolution_clock;
+    const int h = n / 2;
+    const size_t q = elements / 4;
+    const double* A11 = A; const double* A12 = A + q; const double* A21 = A + 2 * q; const double* A22 = A + 3 * q;
+    const double* B11 = B; const double* B12 = B + q; const double* B21 = B + 2 * q; const double* B22 = B + 3 * q;
+    double* C11 = C; double* C12 = C + q; double* C21 = C + 2 * q; double* C22 = C + 3 * q;
+
+    auto s_calc_start = Clock::now();
+    auto p_tasks_start = s_calc_start, c_quad_start = s_calc_start;
+    if (depth < run.maxAsyncDepth) {
+        // All ten sums, then the seven products at once on the pool.
+        HardwareCounterScope split_counters(CounterPhase::Split);
+        TraceScope s_calc_trace("SCalc", depth, n);
+        std::unique_ptr<double[]> work(new double[17 * q]);
+        double* S[10];
+        double* P[7];
+        for (int i = 0; i < 10; ++i) S[i] = work.get() + i * q;
+        for (int i = 0; i < 7; ++i) P[i] = work.get() + (10 + i) * q;
+        differenceSlices(S[0], B12, B22, q); sumSlices(S[1], A11, A12, q); sumSlices(S[2], A21, A22, q);
+        differenceSlices(S[3], B21, B11, q); sumSlices(S[4], A11, A22, q); sumSlices(S[5], B11, B22, q);
+        differenceSlices(S[6], A12, A22, q); sumSlices(S[7], B21, B22, q); differenceSlices(S[8], A21, A11, q);
+        sumSlices(S[9], B11, B12, q);
+        s_calc_trace.stop();
+        split_counters.stop();
+
+        p_tasks_start = Clock::now();
+        TraceScope products_trace("Products", depth, n);
+        const double* operands[7][2] = { { S[4], S[5] }, { S[2], B11 }, { A11, S[0] }, { A22, S[3] },
+            { S[1], B22 }, { S[8], S[9] }, { S[6], S[7] } };
+        std::vector<std::future<void>> products;
+        for (int i = 0; i < 7; ++i) {
+            products.emplace_back(run.pool.enqueue([&run, &operands, &P, i, h, depth] {
+                mortonStrassenNode(run, operands[i][0], operands[i][1], P[i], h, depth + 1, nullptr);
+                }));
+        }
+        waitForAll(products);
+        for (auto& f : products) f.get();
+        products_trace.stop();
+
+        c_quad_start = Clock::now();
+        HardwareCounterScope combine_counters(CounterPhase::Combine);
+        TraceScope c_quad_trace("CQuadCalc", depth, n);
+        for (size_t i = 0; i < q; ++i) {
+            C11[i] = P[0][i] + P[3][i] - P[4][i] + P[6][i];
+            C12[i] = P[2][i] + P[4][i];
+            C21[i] = P[1][i] + P[3][i];
+            C22[i] = P[0][i] - P[1][i] + P[2][i] + P[5][i];
+        }
+    }
+    else {
+        // Memory-lean order: one pair of operand sums and one product at a time, each product
+        // folded into the C quadrants as soon as it exists (as strassenDepthFirstNode does).
+        p_tasks_start = Clock::now();
+        TraceScope products_trace("Products", depth, n);
+        std::unique_ptr<double[]> work(new double[3 * q]);
+        double* X = work.get();
+        double* Y = X + q;
+        double* P = Y + q;
+        auto product = [&](const double* x, const double* y) { mortonStrassenNode(run, x, y, P, h, depth + 1, nullptr); };
+
+        sumSlices(X, A11, A22, q); sumSlices(Y, B11, B22, q); product(X, Y);
+        std::copy(P, P + q, C11); std::copy(P, P + q, C22);
+        sumSlices(X, A21, A22, q); product(X, B11);
+        subtractFromSlice(C22, P, q); std::copy(P, P + q, C21);
+        differenceSlices(Y, B12, B22, q); product(A11, Y);
+        addToSlice(C22, P, q); std::copy(P, P + q, C12);
+        differenceSlices(Y, B21, B11, q); product(A22, Y);
+        addToSlice(C11, P, q); addToSlice(C21, P, q);
+        sumSlices(X, A11, A12, q); product(X, B22);
+        subtractFromSlice(C11, P, q); addToSlice(C12, P, q);
+        differenceSlices(X, A21, A11, q); sumSlices(Y, B11, B12, q); product(X, Y);
+        addToSlice(C22, P, q);
+        differenceSlices(X, A12, A22, q); sumSlices(Y, B21, B22, q); product(X, Y);
+        addToSlice(C11, P, q);
+        c_quad_start = Clock::now();
+    }
+    run.progress.fetch_add(1, std::memory_order_relaxed);
+
+    if (first_level_timings) {
+        auto end = Clock::now();
+        first_level_timings->first_level_split_sec = 0.0;
+        first_level_timings->first_level_S_calc_sec = std::chrono::duration<double>(p_tasks_start - s_calc_start).count();
+        first_level_timings->first_level_P_tasks_wall_sec = std::chrono::duration<double>(c_quad_start - p_tasks_start).count();
+        first_level_timings->first_level_C_quad_calc_sec = std::chrono::duration<double>(end - c_quad_start).count();
+        first_level_timings->first_level_final_combine_sec = 0.0;
+    }
+}
+
+void requireMatchingOperands(const MortonMatrix& A, const MortonMatrix& B, const MortonMatrix& C) {
+    if (A.size() != B.size() || A.size() != C.size() || A.leaf() != B.leaf() || A.leaf() != C.leaf() || A.size() == 0) {
+        throw std::invalid_argument("Morton operands must share their size and leaf size.");
+    }
+}
+}
+
+// --- Conversions ---
+MortonMatrix toMortonLayout(const Matrix& A, int size, int leaf, ThreadPool& pool) {
+    if (size < A.rows() || size < A.cols()) throw std::invalid_argument("Morton size must be >= the matrix dimensions.");
+    MortonMatrix M(size, leaf);
+    const int tiles_per_side = size / leaf;
+    const int rows = A.rows(), cols = A.cols();
+    const double* src = A.getRawData().data();
+    double* dst = M.data();
+    forEachItem(pool, static_cast<long long>(tiles_per_side) * tiles_per_side, [&](long long t) {
+        int tile_row, tile_col;
+        mortonCoordinates(static_cast<size_t>(t), tile_row, tile_col);
+        const int r0 = tile_row * leaf, c0 = tile_col * leaf;
+        const int valid_cols = std::max(0, std::min(leaf, cols - c0));
+        double* tile = dst + static_cast<size_t>(t) * leaf * leaf;
+        for (int r = 0; r < leaf; ++r) {
+            double* out = tile + r * leaf;
+            int copied = 0;
+            if (r0 + r < rows) {
+                copied = valid_cols;
+                std::copy(src + static_cast<size_t>(r0 + r) * cols + c0, src + static_cast<size_t>(r0 + r) * cols + c0 + copied, out);
+            }
+            std::fill(out + copied, out + leaf, 0.0);
+        }
+        });
+    return M;
+}
+
+Matrix fromMortonLayout(const MortonMatrix& M, int rows, int cols, ThreadPool& pool) {
+    if (rows < 0 || cols < 0 || rows > M.size() || cols > M.size()) throw std::invalid_argument("Requested block exceeds the Morton matrix.");
+    Matrix result(rows, cols);
+    if (result.isEmpty()) return result;
+    const int leaf = M.leaf();
+    const int tiles_per_side = M.size() / leaf;
+    const double* src = M.data();
+    double* dst = result.getRawData().data();
+    forEachItem(pool, static_cast<long long>(tiles_per_side) * tiles_per_side, [&](long long t) {
+        int tile_row, tile_col;
+        mortonCoordinates(static_cast<size_t>(t), tile_row, tile_col);
+        const int r0 = tile_row * leaf, c0 = tile_col * leaf;
+        const int valid_rows = std::min(leaf, rows - r0), valid_cols = std::min(leaf, cols - c0);
+        if (valid_rows <= 0 || valid_cols <= 0) return;
+        const double* tile = src + static_cast<size_t>(t) * leaf * leaf;
+        for (int r = 0; r < valid_rows; ++r) {
+            std::copy(tile + r * leaf, tile + r * leaf + valid_cols, dst + static_cast<size_t>(r0 + r) * cols + c0);
+        }
+        });
+    return result;
+}
+
+
+// --- Products ---
+void multiplyMortonTiled(ThreadPool& pool, const MortonMatrix& A, const MortonMatrix& B, MortonMatrix& C, int M, int N, int K) {
+    requireMatchingOperands(A, B, C);
+    const int n = A.size(), leaf = A.leaf();
+    // Blocks of C small enough that every thread gets a few, but never below a leaf.
+    int block = n;
+    while (block > leaf && static_cast<long long>(n / block) * (n / block) < 4LL * static_cast<long long>(pool.size())) block /= 2;
+    const int blocks_per_side = n / block;
+    const size_t block_elements = static_cast<size_t>(block) * block;
+    const ProductExtent extent = { M, N, K };
+    forEachItem(pool, static_cast<long long>(blocks_per_side) * blocks_per_side, [&](long long t) {
+        HardwareCounterScope base_counters(CounterPhase::BaseMultiply);
+        TraceScope trace("MortonBlock", 0, t);
+        int block_row, block_col;
+        mortonCoordinates(static_cast<size_t>(t), block_row, block_col);
+        double* c = C.data() + static_cast<size_t>(t) * block_elements;
+        std::fill(c, c + block_elements, 0.0);
+        for (int k = 0; k < blocks_per_side; ++k) {
+            blockMultiplyAdd(A.data() + mortonIndex(block_row, k) * block_elements, B.data() + mortonIndex(k, block_col) * block_elements,
+                c, block, leaf, block_row * block, block_col * block, k * block, extent);
+        }
+        });
+}
+
+void multiplyMortonStrassen(ThreadPool& pool, const MortonMatrix& A, const MortonMatrix& B, MortonMatrix& C, int threshold,
+    std::atomic<int>* progress_counter, MultiplicationResult* first_level_timings, const StrassenSchedule& schedule) {
+    requireMatchingOperands(A, B, C);
+    if (nextPowerOf2(A.size()) != A.size()) throw std::invalid_argument("Strassen operands must be square with the same power-of-two size.");
+    const size_t num_threads = pool.size();
+    int max_depth_async = (num_threads > 1) ? static_cast<int>(std::floor(std::log(static_cast<double>(num_threads)) / std::log(7.0))) : 0;
+    if (max_depth_async < 0) max_depth_async = 0;
+    if (schedule.maxAsyncDepth >= 0) max_depth_async = std::min(max_depth_async, schedule.maxAsyncDepth);
+
+    std::atomic<int> unused_counter(0);
+    const MortonStrassenRun run = { pool, A.leaf(), threshold, max_depth_async, progress_counter ? *progress_counter : unused_counter };
+    mortonStrassenNode(run, A.data(), B.data(), C.data(), A.size(), 0, first_level_timings);
+}
+
+string getMatrixLayoutName(MatrixLayout layout) {
+    return (layout == MatrixLayout::Morton) ? "morton" : "row-major";
+}
+
+bool parseMatrixLayout(const string& name, MatrixLayout& layout) {
+    if (name == "row-major") layout = MatrixLayout::RowMajor;
+    else if (name == "morton") layout = MatrixLayout::Morton;
+    else return false;
+    return true;
+}
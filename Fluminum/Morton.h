@@ -0,0 +1,73 @@
+#pragma once
+#include "Common.h"
+#include "Algorithm.h"
+#include <memory>
+
+// --- Morton (Z-Order) Layout ---
+// A MortonMatrix stores a square matrix as a quadtree. Every block holds its quadrants 11, 12,
+// 21, 22 one after the other, down to leaf x leaf tiles kept row-major, so a quadrant at any
+// level is one contiguous slice. Strassen and the blocked kernels recurse with pointer offsets
+// instead of split copies or strided views. No access pattern then walks a power-of-two leading
+// dimension, whose columns collide in a handful of cache sets and TLB entries.
+
+// Leaf tiles are the tuned tile size rounded down to a power of two, within these bounds.
+const int MORTON_MIN_LEAF = 16;
+const int MORTON_MAX_LEAF = 128;
+
+class MortonMatrix {
+public:
+    MortonMatrix();
+    // size must be a power-of-two multiple of leaf. The storage is left uninitialized; the
+    // conversions and kernels write every element.
+    MortonMatrix(int size, int leaf);
+
+    int size() const { return size_; }
+    int leaf() const { return leaf_; }
+    size_t elementCount() const { return static_cast<size_t>(size_) * size_; }
+    double* data() { return data_.get(); }
+    const double* data() const { return data_.get(); }
+
+    // Element (r, c), for checks; the kernels work on quadrant slices.
+    double at(int r, int c) const;
+
+private:
+    int size_;
+    int leaf_;
+    std::unique_ptr<double[]> data_;
+};
+
+// Position of leaf tile (tile_row, tile_col) in Z-order: the bits of the two interleaved, with
+// the row bit above the column bit at every level. Blocks of any power-of-two size use the same
+// index at their own granularity.
+size_t mortonIndex(int tile_row, int tile_col);
+
+// The leaf for a Morton matrix of at least min_size rows: tile_size rounded down to a power of
+// two, clamped to [MORTON_MIN_LEAF, MORTON_MAX_LEAF] and to nextPowerOf2(min_size).
+int chooseMortonLeaf(int min_size, int tile_size);
+
+// Smallest power-of-two multiple of leaf that holds min_size rows.
+int mortonPaddedSize(int min_size, int leaf);
+
+// Row-major to Morton, zero-padded to size x size, and back (the top-left rows x cols). Leaf
+// tiles are shared out over the pool's threads; neither may be called from one of its tasks.
+MortonMatrix toMortonLayout(const Matrix& A, int size, int leaf, ThreadPool& pool);
+Matrix fromMortonLayout(const MortonMatrix& M, int rows, int cols, ThreadPool& pool);
+
+// C = A * B by blocked recursion down to the leaves: the tiled engine on this layout. Only the
+// leaves overlapping the logical M x N x K product are multiplied, so the padding costs memory
+// but no arithmetic. Blocks of C are shared out over the pool's threads.
+void multiplyMortonTiled(ThreadPool& pool, const MortonMatrix& A, const MortonMatrix& B, MortonMatrix& C,
+    int M, int N, int K);
+
+// C = A * B by Strassen on quadrant slices; blocks of at most `threshold` rows (and never less
+// than a leaf) use the blocked kernel. The top schedule.maxAsyncDepth levels (-1 = log7 of the
+// pool size) run their seven products on the pool. Below them every node keeps only one pair
+// of operand sums and one product alive and folds each product into C at once, whatever
+// schedule.depthFirst says. first_level_timings as for multiplyStrassenPadded; its split time
+// is zero, since nothing is copied.
+void multiplyMortonStrassen(ThreadPool& pool, const MortonMatrix& A, const MortonMatrix& B, MortonMatrix& C, int threshold,
+    std::atomic<int>* progress_counter = nullptr, MultiplicationResult* first_level_timings = nullptr,
+    const StrassenSchedule& schedule = StrassenSchedule());
+
+string getMatrixLayoutName(MatrixLayout layout);   // "row-major" or "morton"
+bool parseMatrixLayout(const string& name, MatrixLayout& layout);
@@ -6,22 +6,36 @@
 #include <algorithm>
 #include <sstream>
 #include <chrono>
+#ifdef _WIN32
 #include <PdhMsg.h>
+#endif
 #include <algorithm> //  std::clamp
 
+#ifdef _WIN32
 #pragma comment(lib, "pdh.lib")
 #undef max
 #undef min
+#else
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
 
 // ---   ---
 enum ConsoleColor { DARK_BLUE = 1, DARK_GREEN = 2, DARK_CYAN = 3, DARK_RED = 4, DARK_MAGENTA = 5, DARK_YELLOW = 6, GRAY = 7, DARK_GRAY = 8, BLUE = 9, GREEN = 10, CYAN = 11, RED = 12, MAGENTA = 13, YELLOW = 14, WHITE = 15 };
 
+#ifdef _WIN32
 PerformanceMonitor::PerformanceMonitor()
     : activeBufferIndex_(0), charBuffer_(nullptr), queryHandle_(nullptr), bufferCoord_({ 0, 0 })
 {
     QueryStaticInfo();
     InitConsole();
-    InitPdhQueries();
+    InitQueries();
 }
 
 PerformanceMonitor::~PerformanceMonitor() {
@@ -55,6 +69,8 @@ void PerformanceMonitor::InitConsole() {
     short windowHeight = static_cast<short>(8 + logicalCoreCount_);
     if (windowHeight > 40) windowHeight = 40;
     bufferSize_ = { 100, windowHeight };
+    width_ = bufferSize_.X;
+    height_ = bufferSize_.Y;
 
     SetConsoleScreenBufferSize(consoleHandles_[0], bufferSize_);
     SMALL_RECT windowSize = { 0, 0, bufferSize_.X - 1, bufferSize_.Y - 1 };
@@ -69,7 +85,7 @@ void PerformanceMonitor::InitConsole() {
     SetConsoleCursorInfo(consoleHandles_[1], &cursorInfo);
 }
 
-void PerformanceMonitor::InitPdhQueries() {
+void PerformanceMonitor::InitQueries() {
     PDH_STATUS status;
     if (PdhOpenQuery(NULL, 0, &queryHandle_) != ERROR_SUCCESS) throw std::runtime_error("PDH Open Query failed.");
 
@@ -110,32 +126,252 @@ void PerformanceMonitor::CollectDynamicData() {
 }
 
 void PerformanceMonitor::PrintToBuffer(int x, int y, const std::string& text) { if (y >= bufferSize_.Y || x < 0) return; WORD attribute = GRAY; bool in_escape = false; std::string code; int current_x = x; for (char c : text) { if (current_x >= bufferSize_.X) break; if (c == '\033') { in_escape = true; code.clear(); } else if (in_escape) { if (c == 'm') { in_escape = false; if (code == "[1;31") attribute = RED; else if (code == "[1;32") attribute = GREEN; else if (code == "[1;33") attribute = YELLOW; else if (code == "[1;34") attribute = BLUE; else if (code == "[1;35") attribute = MAGENTA; else if (code == "[1;36") attribute = CYAN; else if (code == "[0;37") attribute = GRAY; else if (code == "[1;90") attribute = DARK_GRAY; else if (code == "[0") attribute = GRAY; else if (code == "[1;97") attribute = WHITE; } else { code += c; } } else { if (current_x >= 0) { if (static_cast<unsigned char>(c) >= 0x80) charBuffer_[y * bufferSize_.X + current_x].Char.UnicodeChar = c; else charBuffer_[y * bufferSize_.X + current_x].Char.AsciiChar = c; charBuffer_[y * bufferSize_.X + current_x].Attributes = attribute; } current_x++; } } }
-void PerformanceMonitor::PrintBar(int x, int y, double percentage, const std::string& label) { const int width = 10; std::stringstream ss; double clamped_val = std::clamp(percentage, 0.0, 100.0); std::stringstream label_ss; label_ss << label << " (" << std::fixed << std::setprecision(1) << std::setw(4) << clamped_val << "%)"; ss << "\033[1;97m" << std::left << std::setw(22) << label_ss.str() << "\033[0;37m["; int bar_fill = static_cast<int>(clamped_val / 10.0 + 0.5); if (clamped_val >= 75.0) ss << "\033[1;31m"; else if (clamped_val >= 40.0) ss << "\033[1;33m"; else ss << "\033[1;32m"; for (int i = 0; i < bar_fill; ++i) ss << "\u2588"; ss << "\033[1;90m"; for (int i = bar_fill; i < width; ++i) ss << "\u2588"; ss << "\033[0;37m]"; PrintToBuffer(x, y, ss.str()); }
-
-void PerformanceMonitor::Render() {
+void PerformanceMonitor::ClearFrame() {
     for (int i = 0; i < bufferSize_.X * bufferSize_.Y; ++i) {
         charBuffer_[i].Char.AsciiChar = ' ';
         charBuffer_[i].Attributes = 0;
     }
+}
+
+void PerformanceMonitor::PresentFrame() {
+    WriteConsoleOutputA(consoleHandles_[activeBufferIndex_], charBuffer_, bufferSize_, bufferCoord_, &consoleWriteArea_);
+    SetConsoleActiveScreenBuffer(consoleHandles_[activeBufferIndex_]);
+    activeBufferIndex_ = 1 - activeBufferIndex_;
+}
+
+void PerformanceMonitor::Run() {
+    while (true) {
+        HWND console_wnd = GetConsoleWindow();
+        if (console_wnd == NULL || !IsWindowVisible(console_wnd)) { break; }
+        CollectDynamicData();
+        Render();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    }
+}
+
+#else
+// --- Linux backend: /proc and sysfs for the data, ANSI escapes for the screen ---
+static volatile std::sig_atomic_t g_monitorStopRequested = 0;
+static void requestMonitorStop(int) { g_monitorStopRequested = 1; }
+
+// Value of a "Key:  1234 kB" line of /proc/meminfo in MB, 0 if missing.
+static unsigned long long readMeminfoMB(const std::string& key) {
+    std::ifstream file("/proc/meminfo");
+    std::string name;
+    unsigned long long kb = 0;
+    while (file >> name >> kb) {
+        if (name == key + ":") return kb / 1024;
+        file.ignore(256, '\n');
+    }
+    return 0;
+}
+
+PerformanceMonitor::PerformanceMonitor() {
+    const char* owner = std::getenv("FLUMINUM_MONITOR_PARENT");
+    if (owner) ownerPid_ = std::atol(owner);
+    QueryStaticInfo();
+    InitConsole();
+    InitQueries();
+}
+
+PerformanceMonitor::~PerformanceMonitor() {
+    // Leave the alternate screen and give the cursor back.
+    const char restore[] = "\033[0m\033[?25h\033[?1049l";
+    if (write(outputFd_, restore, sizeof(restore) - 1) < 0) { /* terminal already gone */ }
+}
+
+void PerformanceMonitor::ReadCpuTimes(std::vector<CpuTimes>& times) const {
+    times.clear();
+    std::ifstream file("/proc/stat");
+    std::string line;
+    while (std::getline(file, line) && line.compare(0, 3, "cpu") == 0) {
+        std::istringstream fields(line.substr(line.find(' ')));
+        // user nice system idle iowait irq softirq steal (guest time is already part of user)
+        unsigned long long value[8] = {};
+        for (int i = 0; i < 8 && (fields >> value[i]); ++i) {}
+        CpuTimes t;
+        t.idle = value[3] + value[4];
+        for (unsigned long long v : value) t.total += v;
+        times.push_back(t);
+    }
+}
+
+void PerformanceMonitor::ReadCoreFrequencies() {
+    std::vector<double>& mhz = perfData_.coreFrequencyMHz;
+    mhz.assign(logicalCoreCount_, 0.0);
+    bool from_sysfs = true;
+    for (int i = 0; i < logicalCoreCount_ && from_sysfs; ++i) {
+        std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(i) + "/cpufreq/scaling_cur_freq");
+        double khz = 0.0;
+        if (file >> khz) mhz[i] = khz / 1000.0;
+        else from_sysfs = false;
+    }
+    if (from_sysfs) return;
+
+    // No cpufreq driver (VMs, some containers): fall back to the per-processor "cpu MHz" lines.
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    int core = 0;
+    while (std::getline(cpuinfo, line) && core < logicalCoreCount_) {
+        if (line.compare(0, 7, "cpu MHz") == 0) mhz[core++] = std::atof(line.c_str() + line.find(':') + 1);
+    }
+    if (core == 0) mhz.clear();
+}
+
+bool PerformanceMonitor::OwnerAlive() const {
+    if (ownerPid_ <= 0) return true;
+    return kill(static_cast<pid_t>(ownerPid_), 0) == 0 || errno == EPERM;
+}
+
+void PerformanceMonitor::QueryStaticInfo() {
+    ReadCpuTimes(prevCpuTimes_);
+    logicalCoreCount_ = std::max(1, static_cast<int>(prevCpuTimes_.size()) - 1);
+    perfData_.totalRamMB = readMeminfoMB("MemTotal");
+}
+
+void PerformanceMonitor::InitConsole() {
+    width_ = 100;
+    height_ = std::min(std::max(8 + logicalCoreCount_, 15), 40);
+    // Alternate screen plays the role of the second console buffer; the title works in xterm and tmux.
+    const char init[] = "\033]0;Real-Time Performance Monitor\007\033[?1049h\033[?25l";
+    if (write(outputFd_, init, sizeof(init) - 1) < 0) throw std::runtime_error("Failed to write to the terminal.");
+}
+
+void PerformanceMonitor::InitQueries() {
+    // Baselines for the counters that are turned into rates; the first frame follows after a short interval.
+    perfData_.coreUsage.resize(logicalCoreCount_);
+    CollectDynamicData();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+}
+
+void PerformanceMonitor::CollectDynamicData() {
+    std::vector<CpuTimes> now;
+    ReadCpuTimes(now);
+    if (now.size() == prevCpuTimes_.size()) {
+        for (size_t i = 0; i < now.size(); ++i) {
+            unsigned long long total = now[i].total - prevCpuTimes_[i].total;
+            unsigned long long idle = now[i].idle - prevCpuTimes_[i].idle;
+            double usage = (total > 0) ? 100.0 * (1.0 - static_cast<double>(idle) / total) : 0.0;
+            if (i == 0) perfData_.totalCpuUsage = usage;
+            else if (static_cast<int>(i) <= logicalCoreCount_) perfData_.coreUsage[i - 1] = usage;
+        }
+    }
+    prevCpuTimes_ = std::move(now);
+
+    perfData_.availableRamMB = readMeminfoMB("MemAvailable");
+
+    unsigned long long faults = 0, major_faults = 0;
+    std::ifstream vmstat("/proc/vmstat");
+    std::string key;
+    unsigned long long value = 0;
+    while (vmstat >> key >> value) {
+        if (key == "pgfault") faults = value;
+        else if (key == "pgmajfault") major_faults = value;
+    }
+    auto sample_time = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(sample_time - prevSampleTime_).count();
+    if (prevPageFaults_ != 0 && elapsed > 0.0) {
+        perfData_.pageFaultsPerSec = (faults - prevPageFaults_) / elapsed;
+        perfData_.majorFaultsPerSec = (major_faults - prevMajorFaults_) / elapsed;
+    }
+    prevPageFaults_ = faults;
+    prevMajorFaults_ = major_faults;
+    prevSampleTime_ = sample_time;
+
+    ReadCoreFrequencies();
+}
+
+void PerformanceMonitor::PrintToBuffer(int x, int y, const std::string& text) {
+    if (y >= height_ || x < 0) return;
+    frame_ += "\033[" + std::to_string(y + 1) + ";" + std::to_string(x + 1) + "H";
+    // Clip to the frame width, counting neither escape sequences nor UTF-8 continuation bytes.
+    int column = x;
+    bool in_escape = false;
+    for (char c : text) {
+        if (c == '\033') in_escape = true;
+        else if (in_escape) { if (c == 'm') in_escape = false; }
+        else if ((static_cast<unsigned char>(c) & 0xC0) != 0x80 && column++ >= width_) break;
+        frame_ += c;
+    }
+    frame_ += "\033[0m";
+}
+
+void PerformanceMonitor::ClearFrame() {
+    winsize size{};
+    if (ioctl(outputFd_, TIOCGWINSZ, &size) == 0 && size.ws_col > 0) {
+        width_ = std::min(100, static_cast<int>(size.ws_col));
+        height_ = std::min({ std::max(8 + logicalCoreCount_, 15), 40, static_cast<int>(size.ws_row) });
+    }
+    frame_ = "\033[H\033[2J";
+}
+
+void PerformanceMonitor::PresentFrame() {
+    const char* data = frame_.data();
+    size_t left = frame_.size();
+    while (left > 0) {
+        ssize_t written = write(outputFd_, data, left);
+        if (written < 0) { if (errno == EINTR) continue; g_monitorStopRequested = 1; return; }
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+}
+
+void PerformanceMonitor::Run() {
+    struct sigaction action {};
+    action.sa_handler = requestMonitorStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGHUP, &action, nullptr);
+
+    while (!g_monitorStopRequested && OwnerAlive()) {
+        CollectDynamicData();
+        Render();
+        for (int i = 0; i < 10 && !g_monitorStopRequested; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+int RunPerformanceMonitorOnTerminal(const std::string& ttyPath, long ownerPid) {
+    int fd = open(ttyPath.c_str(), O_WRONLY | O_NOCTTY);
+    if (fd < 0) {
+        std::cerr << "Monitor: cannot open " << ttyPath << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+    setenv("FLUMINUM_MONITOR_PARENT", std::to_string(ownerPid).c_str(), 1);
+    return RunPerformanceMonitorEntry();
+}
+#endif
+
+void PerformanceMonitor::PrintBar(int x, int y, double percentage, const std::string& label) { const int width = 10; std::stringstream ss; double clamped_val = std::clamp(percentage, 0.0, 100.0); std::stringstream label_ss; label_ss << label << " (" << std::fixed << std::setprecision(1) << std::setw(4) << clamped_val << "%)"; ss << "\033[1;97m" << std::left << std::setw(22) << label_ss.str() << "\033[0;37m["; int bar_fill = static_cast<int>(clamped_val / 10.0 + 0.5); if (clamped_val >= 75.0) ss << "\033[1;31m"; else if (clamped_val >= 40.0) ss << "\033[1;33m"; else ss << "\033[1;32m"; for (int i = 0; i < bar_fill; ++i) ss << "\u2588"; ss << "\033[1;90m"; for (int i = bar_fill; i < width; ++i) ss << "\u2588"; ss << "\033[0;37m]"; PrintToBuffer(x, y, ss.str()); }
+
+void PerformanceMonitor::Render() {
+    ClearFrame();
 
     std::string title = " REAL-TIME MONITOR ";
-    PrintToBuffer((bufferSize_.X - title.length()) / 2, 1, "\033[1;35m" + title);
+    PrintToBuffer((width_ - static_cast<int>(title.length())) / 2, 1, "\033[1;35m" + title);
 
     int y = 3;
     int col1_x = 4;
-    int col2_x = bufferSize_.X / 2 + 5;
+    int col2_x = width_ / 2 + 5;
+    const bool has_frequencies = static_cast<int>(perfData_.coreFrequencyMHz.size()) == logicalCoreCount_;
 
     PrintToBuffer(col1_x, y, "\033[1;32mCPU USAGE");
     PrintToBuffer(col2_x, y, "\033[1;34mMEMORY");
     y += 2;
 
-    int max_rows = logicalCoreCount_ + 1;
+    int max_rows = std::max(logicalCoreCount_ + 1, 6);
     for (int i = 0; i < max_rows; ++i) {
-        if (y + i >= bufferSize_.Y - 1) break;
+        if (y + i >= height_ - 1) break;
         int current_y = y + i;
 
         if (i == 0) PrintBar(col1_x, current_y, perfData_.totalCpuUsage, "CPU Total");
-        else if ((i - 1) < logicalCoreCount_) PrintBar(col1_x + 2, current_y, perfData_.coreUsage[i - 1], "Core " + std::to_string(i - 1));
+        else if ((i - 1) < logicalCoreCount_) {
+            PrintBar(col1_x + 2, current_y, perfData_.coreUsage[i - 1], "Core " + std::to_string(i - 1));
+            if (has_frequencies) {
+                PrintToBuffer(col1_x + 37, current_y, "\033[1;90m" + std::to_string(static_cast<int>(perfData_.coreFrequencyMHz[i - 1])) + " MHz");
+            }
+        }
 
         if (i == 0) {
             double ramUsagePercent = (perfData_.totalRamMB > 0) ? (((double)perfData_.totalRamMB - perfData_.availableRamMB) / perfData_.totalRamMB) * 100.0 : 0.0;
@@ -149,21 +385,20 @@ void PerformanceMonitor::Render() {
         else if (i == 3) {
             PrintToBuffer(col2_x, current_y, "\033[1;97mPage Faults\033[0;37m: \033[1;36m" + std::to_string(static_cast<int>(perfData_.pageFaultsPerSec)) + "/s");
         }
+#ifndef _WIN32
+        else if (i == 4) {
+            PrintToBuffer(col2_x, current_y, "\033[1;97mMajor Faults\033[0;37m: \033[1;36m" + std::to_string(static_cast<int>(perfData_.majorFaultsPerSec)) + "/s");
+        }
+#endif
+        else if (i == 5 && has_frequencies && logicalCoreCount_ > 0) {
+            auto range = std::minmax_element(perfData_.coreFrequencyMHz.begin(), perfData_.coreFrequencyMHz.end());
+            std::stringstream clock;
+            clock << "\033[1;97mCPU Clock\033[0;37m: \033[1;36m" << static_cast<int>(*range.first) << "-" << static_cast<int>(*range.second) << " MHz";
+            PrintToBuffer(col2_x, current_y, clock.str());
+        }
     }
 
-    WriteConsoleOutputA(consoleHandles_[activeBufferIndex_], charBuffer_, bufferSize_, bufferCoord_, &consoleWriteArea_);
-    SetConsoleActiveScreenBuffer(consoleHandles_[activeBufferIndex_]);
-    activeBufferIndex_ = 1 - activeBufferIndex_;
-}
-
-void PerformanceMonitor::Run() {
-    while (true) {
-        HWND console_wnd = GetConsoleWindow();
-        if (console_wnd == NULL || !IsWindowVisible(console_wnd)) { break; }
-        CollectDynamicData();
-        Render();
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-    }
+    PresentFrame();
 }
 
 int RunPerformanceMonitorEntry() {
@@ -173,7 +408,9 @@ int RunPerformanceMonitorEntry() {
     }
     catch (const std::exception& e) {
         std::cerr << "A critical error occurred in Monitor: " << e.what() << std::endl;
-        std::cin.get();
+#ifdef _WIN32
+        std::cin.get();  // Keep the monitor console open so the message can be read
+#endif
         return 1;
     }
     return 0;
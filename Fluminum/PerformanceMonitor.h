@@ -1,9 +1,12 @@
 #pragma once
 
-#include <windows.h>
 #include <string>
 #include <vector>
+#include <chrono>
+#ifdef _WIN32
+#include <windows.h>
 #include <pdh.h>
+#endif
 
 // ---     ---
 
@@ -13,7 +16,17 @@ struct PerformanceData {
     unsigned long long totalRamMB = 0;
     unsigned long long availableRamMB = 0;
     double pageFaultsPerSec = 0.0;
+    double majorFaultsPerSec = 0.0;      // Linux only (/proc/vmstat pgmajfault)
+    std::vector<double> coreFrequencyMHz; // Linux only, empty when the kernel does not expose it
+};
+
+#ifndef _WIN32
+// Jiffies of one "cpu" line of /proc/stat, kept between samples to turn counters into usage.
+struct CpuTimes {
+    unsigned long long idle = 0;
+    unsigned long long total = 0;
 };
+#endif
 
 // ---     ---
 
@@ -31,14 +44,25 @@ private:
     // ---      ---
     void InitConsole();
     void QueryStaticInfo();
-    void InitPdhQueries();
+    void InitQueries();
     void CollectDynamicData();
+#ifndef _WIN32
+    void ReadCpuTimes(std::vector<CpuTimes>& times) const;
+    void ReadCoreFrequencies();
+    bool OwnerAlive() const;
+#endif
 
     // ---   ---
     void Render();
     void PrintToBuffer(int x, int y, const std::string& text);
     void PrintBar(int x, int y, double percentage, const std::string& label);
+    void ClearFrame();
+    void PresentFrame();
+
+    int width_ = 100;
+    int height_ = 40;
 
+#ifdef _WIN32
     // ---     ---
     HANDLE consoleHandles_[2];
     int activeBufferIndex_;
@@ -46,17 +70,35 @@ private:
     COORD bufferSize_;
     COORD bufferCoord_;
     SMALL_RECT consoleWriteArea_;
+#else
+    // Whole frame as ANSI text, written with one write() so the terminal never shows half a frame.
+    std::string frame_;
+    int outputFd_ = 1;
+    long ownerPid_ = 0;  // Monitor exits once this process is gone (0 = run until interrupted)
+    std::vector<CpuTimes> prevCpuTimes_;  // [0] is the aggregate line, [i + 1] is core i
+    unsigned long long prevPageFaults_ = 0;
+    unsigned long long prevMajorFaults_ = 0;
+    std::chrono::steady_clock::time_point prevSampleTime_;
+#endif
 
     // ---   ---
     PerformanceData perfData_;
     int logicalCoreCount_ = 0;
 
+#ifdef _WIN32
     // ---  PDH    ---
     PDH_HQUERY queryHandle_;
     PDH_HCOUNTER totalCpuCounter_;
     std::vector<PDH_HCOUNTER> coreCounters_;
     PDH_HCOUNTER availableMemoryCounter_;
     PDH_HCOUNTER pageFaultsCounter_;
+#endif
 };
 
-int RunPerformanceMonitorEntry();
\ No newline at end of file
+// Runs the monitor in the current console/terminal until it is closed (`--monitor`).
+int RunPerformanceMonitorEntry();
+
+#ifndef _WIN32
+// Forked-child mode: the child renders into the terminal opened from `ttyPath` and exits together with `ownerPid`.
+int RunPerformanceMonitorOnTerminal(const std::string& ttyPath, long ownerPid);
+#endif
\ No newline at end of file
@@ -0,0 +1,264 @@
+#define NOMINMAX
+#include "Power.h"
+#include "Matrix.h"
+#include "Algorithm.h"
+#include "Gemm.h"
+#include "CostModel.h"
+#include "System.h"
+#include "HardwareCounters.h"
+#include "Roofline.h"
+#include <memory>
+
+bool isSymmetric(const Matrix& A) {
+    if (A.rows() != A.cols()) return false;
+    const int n = A.rows();
+    const double* a = A.getRawData().data();
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 1; j < n; ++j) {
+            if (a[static_cast<size_t>(i) * n + j] != a[static_cast<size_t>(j) * n + i]) return false;
+        }
+    }
+    return true;
+}
+
+
+// --- Symmetric Products ---
+// Rows of C handed to one gemm call on the symmetric path.
+const int POWER_SYMMETRIC_BLOCK = 64;
+
+// C = X * Y for a product known to be symmetric (powers of one symmetric matrix commute).
+// Each block row only computes the columns from its diagonal onwards; the rest is mirrored.
+static void multiplySymmetricProduct(const Matrix& X, const Matrix& Y, Matrix& C, unsigned int threads, ThreadPool& pool) {
+    const int n = C.rows();
+    const int blocks = (n + POWER_SYMMETRIC_BLOCK - 1) / POWER_SYMMETRIC_BLOCK;
+    GemmOptions options;
+    options.engine = GemmEngine::Simd;
+    options.threads = 1;
+
+    // Block rows shrink towards the bottom, so workers take every `step`-th one to stay balanced.
+    auto run_blocks = [&](int first, int step) {
+        for (int b = first; b < blocks; b += step) {
+            const int row = b * POWER_SYMMETRIC_BLOCK;
+            const int rows = std::min(POWER_SYMMETRIC_BLOCK, n - row);
+            gemm(Transpose::None, Transpose::None, 1.0,
+                ConstMatrixView(X).block(row, 0, rows, n), ConstMatrixView(Y).block(0, row, n, n - row),
+                0.0, MatrixView(C).block(row, row, rows, n - row), options);
+        }
+    };
+
+    const int workers = static_cast<int>(std::min<unsigned int>(threads, static_cast<unsigned int>(blocks)));
+    if (workers <= 1) {
+        run_blocks(0, 1);
+    }
+    else {
+        std::vector<std::future<void>> futures;
+        for (int w = 0; w < workers; ++w) futures.emplace_back(pool.enqueue(run_blocks, w, workers));
+        waitForAll(futures);
+        for (auto& f : futures) f.get();
+    }
+
+    // Mirror the upper triangle, tile by tile to keep the column reads cache friendly.
+    double* c = C.getRawData().data();
+    const int tile = 32;
+    for (int ib = 0; ib < n; ib += tile) {
+        for (int jb = 0; jb <= ib; jb += tile) {
+            for (int i = ib; i < std::min(ib + tile, n); ++i) {
+                for (int j = jb; j < std::min(jb + tile, i); ++j) {
+                    c[static_cast<size_t>(i) * n + j] = c[static_cast<size_t>(j) * n + i];
+                }
+            }
+        }
+    }
+}
+
+
+// C = X * Y on a caller's pool: one stripe of C's rows per thread, each a single-threaded gemm
+// (gemm itself only runs on the shared pool).
+static void multiplyRowStripes(const Matrix& X, const Matrix& Y, Matrix& C, const GemmOptions& options, ThreadPool& pool) {
+    const int n = C.rows();
+    const int workers = static_cast<int>(std::min<size_t>(pool.size(), static_cast<size_t>(n)));
+    GemmOptions stripe_options = options;
+    stripe_options.threads = 1;
+    std::vector<std::future<void>> futures;
+    for (int w = 0; w < workers; ++w) {
+        const int row = static_cast<int>(static_cast<long long>(n) * w / workers);
+        const int rows = static_cast<int>(static_cast<long long>(n) * (w + 1) / workers) - row;
+        futures.emplace_back(pool.enqueue([&, row, rows] {
+            gemm(Transpose::None, Transpose::None, 1.0, ConstMatrixView(X).block(row, 0, rows, n), Y,
+                0.0, MatrixView(C).block(row, 0, rows, n), stripe_options);
+            }));
+    }
+    waitForAll(futures);
+    for (auto& f : futures) f.get();
+}
+
+
+// --- Matrix Power ---
+MultiplicationResult matrixPowerParallel(const Matrix& A, long long k, int threshold,
+    bool use_tiling_for_base, int tile_size_for_base,
+    unsigned int num_threads_request, ThreadPool* pool) {
+    MultiplicationResult result_obj;
+    result_obj.originalRowsA = A.rows();
+    result_obj.originalColsA = A.cols();
+    result_obj.originalRowsB = A.rows();
+    result_obj.originalColsB = A.cols();
+    result_obj.tiling_enabled = use_tiling_for_base;
+    result_obj.tile_size = tile_size_for_base;
+    result_obj.power_exponent = k;
+    result_obj.algorithm_type = "Matrix Power";
+    MatrixAllocationStats alloc_start = getMatrixAllocationStats();
+
+    if (A.rows() != A.cols()) throw std::invalid_argument("Matrix power requires a square matrix.");
+    if (k < 0) throw std::invalid_argument("Matrix power exponent cannot be negative.");
+
+    unsigned int hardware_cores = getCpuCoreCount();
+    result_obj.coresDetected = hardware_cores;
+    result_obj.threadsUsed = pool ? static_cast<unsigned int>(pool->size())
+        : (num_threads_request == 0) ? getDefaultThreadCount() : std::min(num_threads_request, hardware_cores);
+    if (result_obj.threadsUsed == 0) result_obj.threadsUsed = 1;
+
+    const int n = A.rows();
+    auto total_op_start_chrono = std::chrono::high_resolution_clock::now();
+    long long total_op_start_qpc = readPerformanceCounter();
+    if (A.isEmpty() || k == 0) {
+        result_obj.resultMatrix = A.isEmpty() ? Matrix(n, n) : Matrix::identity(n);
+        result_obj.durationSeconds_chrono = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - total_op_start_chrono).count();
+        result_obj.allocationStats = matrixAllocationsSince(alloc_start);
+        result_obj.memoryInfo = getProcessMemoryUsage();
+        return result_obj;
+    }
+
+    // Strassen only for large, non-symmetric inputs that pad cheaply; the padding then stays
+    // in place for every step, since zero padding is preserved by multiplication.
+    result_obj.symmetric_path_used = isSymmetric(A);
+    const int padded_size = nextPowerOf2(n);
+    bool use_strassen = !result_obj.symmetric_path_used && threshold > 0 && padded_size > threshold && n >= GEMM_STRASSEN_MIN_SIZE &&
+        static_cast<double>(padded_size) * padded_size * padded_size <= 1.5 * static_cast<double>(n) * n * n;
+
+    // Under a memory budget: the gemm path holds the input and three step buffers; Strassen adds
+    // the padded input and the workspace of one product (its prediction counts the buffers), and
+    // gives way to the in-place gemm when that does not fit.
+    const double mb = sizeof(double) / (1024.0 * 1024.0);
+    const double input_mb = static_cast<double>(n) * n * mb;
+    if (hasMemoryBudget()) {
+        result_obj.memory_budget_mb = productMemoryLimitMB(input_mb);
+        if (use_strassen) {
+            double strassen_mb = input_mb + predictAlgorithmPeakMemoryMB(MultiplyAlgorithm::Strassen, padded_size, padded_size, padded_size,
+                result_obj.threadsUsed, threshold);
+            if (padded_size != n) strassen_mb += static_cast<double>(padded_size) * padded_size * mb;
+            if (strassen_mb > result_obj.memory_budget_mb) {
+                use_strassen = false;
+                result_obj.memory_adaptation = "Strassen -> in-place gemm";
+            }
+        }
+        if (!use_strassen) requireMemoryBudget(4.0 * input_mb, input_mb, "Matrix power");
+    }
+    const int size = use_strassen ? padded_size : n;
+    result_obj.strassen_applied_at_top_level = use_strassen;
+    result_obj.strassenThreshold = use_strassen ? threshold : 0;
+    if (use_strassen) result_obj.algorithm_type += " (Strassen)";
+    else if (result_obj.symmetric_path_used) result_obj.algorithm_type += " (Symmetric)";
+
+    HardwareCounterRun counter_run;
+    auto pad_start = std::chrono::high_resolution_clock::now();
+    long long rss_pad_start = getCurrentResidentKB();
+    HardwareCounterScope padding_counters(CounterPhase::Padding);
+    Matrix padded_input = (size != n) ? Matrix::pad(A, size) : Matrix();
+    padding_counters.stop();
+    const Matrix& input = (size != n) ? padded_input : A;
+    auto pad_end = std::chrono::high_resolution_clock::now();
+    long long rss_pad_end = getCurrentResidentKB();
+    result_obj.padding_duration_sec = std::chrono::duration<double>(pad_end - pad_start).count();
+    result_obj.padding_rss_delta_mb = residentDeltaMB(rss_pad_start, rss_pad_end);
+
+    // Three resident buffers: the running product, the current square and the step output.
+    // INPUT stands for the (padded) input itself, which is never written.
+    const int INPUT = -1;
+    Matrix buffers[3];
+    auto operand = [&](int index) -> const Matrix& { return (index == INPUT) ? input : buffers[index]; };
+
+    std::unique_ptr<ThreadPool> own_pool;
+    ThreadPool* strassen_pool = pool;
+    if (use_strassen && !strassen_pool) {
+        own_pool = std::make_unique<ThreadPool>(result_obj.threadsUsed);
+        strassen_pool = own_pool.get();
+    }
+    GemmOptions gemm_options;
+    gemm_options.engine = GemmEngine::Simd;
+    gemm_options.threads = result_obj.threadsUsed;
+    gemm_options.tileSize = tile_size_for_base;
+
+    auto multiply_into = [&](int x, int y, int out) {
+        const Matrix& X = operand(x);
+        const Matrix& Y = operand(y);
+        HardwareCounterScope base_counters(CounterPhase::BaseMultiply);
+        if (buffers[out].rows() != size) buffers[out] = Matrix(size, size);
+        if (use_strassen) {
+            multiplyStrassenPaddedInto(*strassen_pool, X, Y, buffers[out], threshold, use_tiling_for_base, tile_size_for_base);
+            return;
+        }
+        if (result_obj.symmetric_path_used) multiplySymmetricProduct(X, Y, buffers[out], result_obj.threadsUsed, pool ? *pool : getSharedThreadPool());
+        else if (pool && result_obj.threadsUsed > 1) multiplyRowStripes(X, Y, buffers[out], gemm_options, *pool);
+        else gemm(Transpose::None, Transpose::None, 1.0, X, Y, 0.0, buffers[out], gemm_options);
+    };
+
+    int acc = -2;  // No factor yet
+    int base = INPUT;
+    auto free_buffer = [&]() {
+        for (int b = 0; b < 3; ++b) if (b != acc && b != base) return b;
+        throw std::logic_error("Internal Error: no free buffer in matrix power.");
+    };
+
+    for (long long e = k; e > 0; e >>= 1) {
+        if (e & 1) {
+            if (acc == -2) {
+                acc = base;  // First factor: share the square, no copy.
+            }
+            else {
+                int out = free_buffer();
+                multiply_into(acc, base, out);
+                acc = out;
+                ++result_obj.power_multiplies;
+            }
+        }
+        if ((e >> 1) > 0) {
+            int out = free_buffer();
+            multiply_into(base, base, out);
+            base = out;
+            ++result_obj.power_squarings;
+        }
+    }
+
+    // Work per product: Strassen on the padded size, the upper block triangle, or a full product.
+    long long product_flops = 2LL * n * n * n;
+    if (use_strassen) product_flops = strassenFlopCount(size, threshold);
+    else if (result_obj.symmetric_path_used) {
+        product_flops = 0;
+        for (int row = 0; row < n; row += POWER_SYMMETRIC_BLOCK) {
+            product_flops += 2LL * std::min(POWER_SYMMETRIC_BLOCK, n - row) * n * (n - row);
+        }
+    }
+    result_obj.effective_flops = product_flops * (result_obj.power_squarings + result_obj.power_multiplies);
+
+    auto unpad_start = std::chrono::high_resolution_clock::now();
+    long long rss_unpad_start = getCurrentResidentKB();
+    result_obj.compute_rss_delta_mb = residentDeltaMB(rss_pad_end, rss_unpad_start);
+    HardwareCounterScope unpad_counters(CounterPhase::Unpad);
+    Matrix product;
+    if (acc != INPUT) product = std::move(buffers[acc]);
+    else if (size != n) product = std::move(padded_input);
+    else product = A;  // k == 1
+    result_obj.resultMatrix = Matrix::unpad(std::move(product), n, n);
+    unpad_counters.stop();
+    auto unpad_end = std::chrono::high_resolution_clock::now();
+    result_obj.unpadding_duration_sec = std::chrono::duration<double>(unpad_end - unpad_start).count();
+    result_obj.unpadding_rss_delta_mb = residentDeltaMB(rss_unpad_start, getCurrentResidentKB());
+
+    result_obj.durationSeconds_chrono = std::chrono::duration<double>(unpad_end - total_op_start_chrono).count();
+    result_obj.durationNanoseconds_chrono = std::chrono::duration_cast<std::chrono::nanoseconds>(unpad_end - total_op_start_chrono).count();
+    result_obj.durationSeconds_qpc = performanceCounterSeconds(total_op_start_qpc, readPerformanceCounter());
+    counter_run.finish(result_obj.hardwareCounters);
+    result_obj.allocationStats = matrixAllocationsSince(alloc_start);
+    result_obj.memoryInfo = getProcessMemoryUsage();
+    return result_obj;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "Common.h"
+
+class ThreadPool;
+
+// --- Matrix Power ---
+// A^k by binary exponentiation: about log2(k) squarings plus one multiply per set bit.
+// The operands stay resident for the whole run: the matrix is padded once (only when the
+// Strassen engine is used), every step writes into a preallocated buffer, and the buffers
+// are swapped instead of reallocated. When A is symmetric every power is symmetric too, so
+// only the upper triangle of each product is computed and then mirrored.
+// With a pool, every step runs on it (and its size is the thread count) instead of on the
+// shared pool or one built for the Strassen steps.
+MultiplicationResult matrixPowerParallel(const Matrix& A, long long k, int threshold,
+    bool use_tiling_for_base, int tile_size_for_base,
+    unsigned int num_threads_request = 0, ThreadPool* pool = nullptr);
+
+bool isSymmetric(const Matrix& A);
@@ -0,0 +1,364 @@
+#define NOMINMAX
+#include "Random.h"
+#include "Algorithm.h"
+#include "System.h"
+#include "Trace.h"
+#include <cstdint>
+#include <memory>
+
+// --- Philox4x32-10 ---
+// One call maps a 128-bit counter to 128 random bits under a 64-bit key (the seed). The
+// counter of block b is (b low, b high, stream, lane), and block b holds the elements 2b and
+// 2b + 1 of that lane: each element takes 64 bits, of which a double uses the top 52.
+namespace {
+const uint32_t PHILOX_M0 = 0xD2511F53u;
+const uint32_t PHILOX_M1 = 0xCD9E8D57u;
+const uint32_t PHILOX_W0 = 0x9E3779B9u;    // Key schedule (golden ratio, sqrt(3) - 1)
+const uint32_t PHILOX_W1 = 0xBB67AE85u;
+const int PHILOX_ROUNDS = 10;
+
+// Lane 0 holds the values; the sparse distribution draws its pattern from lane 1.
+const uint32_t RANDOM_VALUE_LANE = 0;
+const uint32_t RANDOM_PATTERN_LANE = 1;
+
+const std::vector<std::pair<RandomDistribution, string>> RANDOM_DISTRIBUTION_NAMES = {
+    { RandomDistribution::Uniform, "uniform" }, { RandomDistribution::Normal, "normal" },
+    { RandomDistribution::Integer, "integer" }, { RandomDistribution::Sparse, "sparse" },
+    { RandomDistribution::Symmetric, "symmetric" }, { RandomDistribution::DiagonallyDominant, "diagonal-dominant" } };
+
+struct PhiloxKey {
+    uint32_t k0, k1;
+};
+
+void philox(uint32_t x[4], PhiloxKey key) {
+    uint32_t k0 = key.k0, k1 = key.k1;
+    for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+        const uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * x[0];
+        const uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * x[2];
+        const uint32_t y0 = static_cast<uint32_t>(p1 >> 32) ^ x[1] ^ k0;
+        const uint32_t y2 = static_cast<uint32_t>(p0 >> 32) ^ x[3] ^ k1;
+        x[1] = static_cast<uint32_t>(p1);
+        x[3] = static_cast<uint32_t>(p0);
+        x[0] = y0;
+        x[2] = y2;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+}
+
+// [0, 1) from the top 52 of 64 bits: they become the mantissa of a double in [1, 2).
+inline double unitInterval(uint32_t low, uint32_t high) {
+    const uint64_t bits = ((static_cast<uint64_t>(high) << 32 | low) >> 12) | 0x3FF0000000000000ULL;
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value - 1.0;
+}
+
+#if defined(__AVX2__)
+// The same rounds on eight consecutive blocks, one block per 32-bit lane of each register.
+inline void mulhilo(__m256i a, __m256i m, __m256i& hi, __m256i& lo) {
+    const __m256i even = _mm256_mul_epu32(a, m);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+    hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+}
+
+inline __m256d unitInterval(__m256i bits) {
+    const __m256i exponent = _mm256_set1_epi64x(0x3FF0000000000000LL);
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 12), exponent)), _mm256_set1_pd(1.0));
+}
+
+// Elements 2 * block ... 2 * block + 15 into out. The low counter word must not wrap.
+void philoxUnit8(uint64_t block, uint32_t stream, uint32_t lane, PhiloxKey key, double* out) {
+    __m256i x0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(block))), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i x1 = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(block >> 32)));
+    __m256i x2 = _mm256_set1_epi32(static_cast<int>(stream));
+    __m256i x3 = _mm256_set1_epi32(static_cast<int>(lane));
+    const __m256i m0 = _mm256_set1_epi32(static_cast<int>(PHILOX_M0));
+    const __m256i m1 = _mm256_set1_epi32(static_cast<int>(PHILOX_M1));
+    uint32_t k0 = key.k0, k1 = key.k1;
+    for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+        __m256i hi0, lo0, hi1, lo1;
+        mulhilo(x0, m0, hi0, lo0);
+        mulhilo(x2, m1, hi1, lo1);
+        x0 = _mm256_xor_si256(_mm256_xor_si256(hi1, x1), _mm256_set1_epi32(static_cast<int>(k0)));
+        x2 = _mm256_xor_si256(_mm256_xor_si256(hi0, x3), _mm256_set1_epi32(static_cast<int>(k1)));
+        x1 = lo1;
+        x3 = lo0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    // The unpacks pair the words per 128-bit half: blocks 0, 1, 4, 5 in the low results and
+    // 2, 3, 6, 7 in the high ones; the permutes put the elements back in block order.
+    const __m256d first_a = unitInterval(_mm256_unpacklo_epi32(x0, x1));
+    const __m256d second_a = unitInterval(_mm256_unpacklo_epi32(x2, x3));
+    const __m256d first_b = unitInterval(_mm256_unpackhi_epi32(x0, x1));
+    const __m256d second_b = unitInterval(_mm256_unpackhi_epi32(x2, x3));
+    const __m256d blocks04 = _mm256_unpacklo_pd(first_a, second_a);
+    const __m256d blocks15 = _mm256_unpackhi_pd(first_a, second_a);
+    const __m256d blocks26 = _mm256_unpacklo_pd(first_b, second_b);
+    const __m256d blocks37 = _mm256_unpackhi_pd(first_b, second_b);
+    _mm256_storeu_pd(out, _mm256_permute2f128_pd(blocks04, blocks15, 0x20));
+    _mm256_storeu_pd(out + 4, _mm256_permute2f128_pd(blocks26, blocks37, 0x20));
+    _mm256_storeu_pd(out + 8, _mm256_permute2f128_pd(blocks04, blocks15, 0x31));
+    _mm256_storeu_pd(out + 12, _mm256_permute2f128_pd(blocks26, blocks37, 0x31));
+}
+#endif
+
+// Elements [first, first + count) of a lane as [0, 1) values; first must be even.
+void fillUnit(PhiloxKey key, uint32_t stream, uint32_t lane, long long first, long long count, double* out) {
+    uint64_t block = static_cast<uint64_t>(first) / 2;
+    long long e = 0;
+#if defined(__AVX2__)
+    while (count - e >= 16 && static_cast<uint32_t>(block) <= 0xFFFFFFF8u) {
+        philoxUnit8(block, stream, lane, key, out + e);
+        block += 8;
+        e += 16;
+    }
+#endif
+    for (; e < count; ++block) {
+        uint32_t x[4] = { static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32), stream, lane };
+        philox(x, key);
+        out[e++] = unitInterval(x[0], x[1]);
+        if (e < count) out[e++] = unitInterval(x[2], x[3]);
+    }
+}
+
+
+// --- Distributions ---
+// Element range [first, first + count) of the matrix, written in place.
+void fillChunk(const RandomMatrixSpec& spec, PhiloxKey key, uint32_t stream, long long first, long long count, double* out) {
+    fillUnit(key, stream, RANDOM_VALUE_LANE, first, count, out);
+    const double low = spec.low, width = spec.high - spec.low;
+    switch (spec.distribution) {
+    case RandomDistribution::Uniform:
+    case RandomDistribution::Symmetric:
+    case RandomDistribution::DiagonallyDominant:
+        for (long long e = 0; e < count; ++e) out[e] = low + width * out[e];
+        break;
+    case RandomDistribution::Normal: {
+        constexpr double two_pi = 6.283185307179586476925;
+        for (long long e = 0; e < count; e += 2) {
+            const double radius = spec.stddev * std::sqrt(-2.0 * std::log(1.0 - out[e]));
+            const double angle = two_pi * ((e + 1 < count) ? out[e + 1] : 0.0);
+            out[e] = spec.mean + radius * std::cos(angle);
+            if (e + 1 < count) out[e + 1] = spec.mean + radius * std::sin(angle);
+        }
+        break;
+    }
+    case RandomDistribution::Integer: {
+        const double min_value = std::ceil(spec.low), max_value = std::floor(spec.high);
+        const double values = max_value - min_value + 1.0;
+        for (long long e = 0; e < count; ++e) out[e] = std::min(max_value, min_value + std::floor(values * out[e]));
+        break;
+    }
+    case RandomDistribution::Sparse: {
+        thread_local std::vector<double> pattern;
+        pattern.resize(static_cast<size_t>(count));
+        fillUnit(key, stream, RANDOM_PATTERN_LANE, first, count, pattern.data());
+        for (long long e = 0; e < count; ++e) out[e] = (pattern[e] < spec.density) ? low + width * out[e] : 0.0;
+        break;
+    }
+    }
+}
+
+// Runs body(0 ... items - 1) on up to `threads` threads, the calling thread included. The
+// caller never waits on a queued task, so a call from inside a pool task cannot deadlock.
+// After an item throws, the items not yet started are skipped and the first exception is
+// rethrown on the caller once every running item has returned.
+void parallelItems(long long items, unsigned int threads, const std::function<void(long long)>& body) {
+    if (threads <= 1 || items <= 1) {
+        for (long long i = 0; i < items; ++i) body(i);
+        return;
+    }
+    struct Work {
+        std::function<void(long long)> body;
+        long long items = 0;
+        std::atomic<long long> next{ 0 };
+        std::mutex mutex;
+        std::condition_variable finished;
+        long long done = 0;
+        std::atomic<bool> failed{ false };
+        std::exception_ptr error;
+
+        void run() {
+            long long completed = 0;
+            std::exception_ptr thrown;
+            for (long long i = next++; i < items; i = next++) {
+                // Skipped items still count, so the caller's wait ends.
+                if (!failed.load(std::memory_order_relaxed)) {
+                    try {
+                        body(i);
+                    }
+                    catch (...) {
+                        if (!thrown) thrown = std::current_exception();
+                        failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+                ++completed;
+            }
+            if (completed == 0) return;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (thrown && !error) error = thrown;
+            done += completed;
+            if (done == items) finished.notify_all();
+        }
+    };
+    auto work = std::make_shared<Work>();
+    work->body = body;
+    work->items = items;
+    ThreadPool& pool = getSharedThreadPool();
+    const long long helpers = std::min<long long>(items, threads) - 1;
+    for (long long h = 0; h < helpers; ++h) pool.enqueue([work] { work->run(); });
+    work->run();
+    std::unique_lock<std::mutex> lock(work->mutex);
+    work->finished.wait(lock, [&] { return work->done == work->items; });
+    if (work->error) std::rethrow_exception(work->error);
+}
+
+// A(j, i) = A(i, j) below the diagonal, in square tiles so both sides stay in cache.
+void mirrorUpperTriangle(double* data, int n, unsigned int threads) {
+    const int tile = 64;
+    const int tiles = (n + tile - 1) / tile;
+    parallelItems(tiles, threads, [=](long long t) {
+        const int row_begin = static_cast<int>(t) * tile;
+        const int row_end = std::min(n, row_begin + tile);
+        for (int col_begin = 0; col_begin < row_end; col_begin += tile) {
+            for (int i = row_begin; i < row_end; ++i) {
+                const int col_end = std::min(i, col_begin + tile);
+                for (int j = col_begin; j < col_end; ++j) data[static_cast<size_t>(i) * n + j] = data[static_cast<size_t>(j) * n + i];
+            }
+        }
+        });
+}
+
+void validateSpec(const RandomMatrixSpec& spec) {
+    if (spec.rows < 0 || spec.cols < 0) throw std::invalid_argument("Matrix dimensions cannot be negative for random generation.");
+    const bool structured = spec.distribution == RandomDistribution::Symmetric || spec.distribution == RandomDistribution::DiagonallyDominant;
+    if (structured && spec.rows != spec.cols) {
+        throw std::invalid_argument(getRandomDistributionName(spec.distribution) + " random matrices must be square");
+    }
+    switch (spec.distribution) {
+    case RandomDistribution::Normal:
+        if (!(spec.stddev >= 0.0)) throw std::invalid_argument("normal random matrices need a non-negative standard deviation");
+        break;
+    case RandomDistribution::Integer:
+        if (std::ceil(spec.low) > std::floor(spec.high)) throw std::invalid_argument("integer random matrices need a whole number in [low, high]");
+        break;
+    default:
+        if (!(spec.low < spec.high)) throw std::invalid_argument("random matrices need low < high");
+        break;
+    }
+    if (spec.distribution == RandomDistribution::Sparse && !(spec.density >= 0.0 && spec.density <= 1.0)) {
+        throw std::invalid_argument("sparse random matrices need a density in [0, 1]");
+    }
+}
+}
+
+unsigned long long newRandomSeed() {
+    std::random_device rd;
+    return static_cast<unsigned long long>(rd()) << 32 | rd();
+}
+
+unsigned long long parseRandomSeed(const string& text) {
+    try {
+        size_t used = 0;
+        if (!text.empty() && std::isdigit(static_cast<unsigned char>(text[0]))) {
+            unsigned long long seed = std::stoull(text, &used, 0);
+            if (used == text.size()) return seed;
+        }
+    }
+    catch (const std::exception&) {}
+    throw std::invalid_argument("invalid seed '" + text + "'");
+}
+
+Matrix generateRandomMatrix(const RandomMatrixSpec& spec, unsigned long long seed, unsigned int stream, unsigned int threads) {
+    validateSpec(spec);
+    Matrix result(spec.rows, spec.cols);
+    if (result.isEmpty()) return result;
+
+    const PhiloxKey key = { static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) };
+    const long long elements = static_cast<long long>(result.elementCount());
+    const long long chunks = (elements + RANDOM_FILL_CHUNK_ELEMENTS - 1) / RANDOM_FILL_CHUNK_ELEMENTS;
+    if (threads == 0) threads = getDefaultThreadCount();
+    double* data = result.getRawData().data();
+    parallelItems(chunks, threads, [&](long long chunk) {
+        TraceScope trace("RandomFill", 0, chunk);
+        const long long first = chunk * RANDOM_FILL_CHUNK_ELEMENTS;
+        fillChunk(spec, key, stream, first, std::min(RANDOM_FILL_CHUNK_ELEMENTS, elements - first), data + first);
+        });
+
+    const int n = spec.rows;
+    if (spec.distribution == RandomDistribution::Symmetric) mirrorUpperTriangle(data, n, threads);
+    if (spec.distribution == RandomDistribution::DiagonallyDominant) {
+        parallelItems(n, threads, [&](long long i) {
+            double* row = data + i * n;
+            double off_diagonal = 0.0;
+            for (int j = 0; j < n; ++j) if (j != i) off_diagonal += std::abs(row[j]);
+            row[i] = off_diagonal + 1.0;
+            });
+    }
+    return result;
+}
+
+bool isRandomMatrixSource(const string& source) {
+    return source.rfind("random:", 0) == 0;
+}
+
+RandomMatrixSpec parseRandomMatrixSource(const string& source) {
+    if (!isRandomMatrixSource(source)) throw std::invalid_argument("'" + source + "' is not a random:ROWSxCOLS source");
+    std::vector<string> fields;
+    std::stringstream ss(source.substr(7));
+    string field;
+    while (std::getline(ss, field, ':')) fields.push_back(field);
+    auto fail = [&](const string& reason) { return std::invalid_argument("invalid random matrix '" + source + "': " + reason); };
+    if (fields.empty() || fields.size() > 3) throw fail("expected random:ROWSxCOLS[:DISTRIBUTION[:DENSITY]]");
+
+    RandomMatrixSpec spec;
+    const size_t x = fields[0].find('x');
+    try {
+        size_t used_rows = 0, used_cols = 0;
+        if (x == string::npos) throw std::invalid_argument("no 'x'");
+        spec.rows = std::stoi(fields[0].substr(0, x), &used_rows);
+        spec.cols = std::stoi(fields[0].substr(x + 1), &used_cols);
+        if (used_rows != x || used_cols != fields[0].size() - x - 1) throw std::invalid_argument("trailing characters");
+    }
+    catch (const std::exception&) {
+        throw fail("expected ROWSxCOLS, got '" + fields[0] + "'");
+    }
+    if (spec.rows <= 0 || spec.cols <= 0) throw fail("dimensions must be positive");
+    if (fields.size() > 1 && !parseRandomDistribution(fields[1], spec.distribution)) throw fail("unknown distribution '" + fields[1] + "'");
+    if (fields.size() > 2) {
+        if (spec.distribution != RandomDistribution::Sparse) throw fail("only sparse takes a density");
+        try {
+            size_t used = 0;
+            spec.density = std::stod(fields[2], &used);
+            if (used != fields[2].size()) throw std::invalid_argument("trailing characters");
+        }
+        catch (const std::exception&) {
+            throw fail("invalid density '" + fields[2] + "'");
+        }
+    }
+    try {
+        validateSpec(spec);
+    }
+    catch (const std::invalid_argument& e) {
+        throw fail(e.what());
+    }
+    return spec;
+}
+
+string getRandomDistributionName(RandomDistribution distribution) {
+    for (const auto& entry : RANDOM_DISTRIBUTION_NAMES) if (entry.first == distribution) return entry.second;
+    return "unknown";
+}
+
+bool parseRandomDistribution(const string& name, RandomDistribution& distribution) {
+    for (const auto& entry : RANDOM_DISTRIBUTION_NAMES) {
+        if (entry.second == name) {
+            distribution = entry.first;
+            return true;
+        }
+    }
+    return false;
+}
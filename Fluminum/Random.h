@@ -0,0 +1,55 @@
+#pragma once
+#include "Common.h"
+
+// --- Random Matrices ---
+// Counter-based generation with Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy
+// as 1, 2, 3"): element e of a matrix is a pure function of (seed, stream, e). Blocks of the
+// matrix fill in any order on any number of threads, and one seed gives the same matrix whatever
+// the thread count (across builds, floating-point contraction may change the last bit).
+
+enum class RandomDistribution {
+    Uniform,            // [low, high)
+    Normal,             // mean, stddev (Box-Muller)
+    Integer,            // Whole numbers in [ceil(low), floor(high)]
+    Sparse,             // Uniform [low, high) with probability density, zero otherwise
+    Symmetric,          // Uniform [low, high) with A(i, j) == A(j, i); square only
+    DiagonallyDominant  // Uniform [low, high) off the diagonal, A(i, i) = sum of |A(i, j)| + 1; square only
+};
+
+struct RandomMatrixSpec {
+    int rows = 0, cols = 0;
+    RandomDistribution distribution = RandomDistribution::Uniform;
+    double low = -10.0, high = 10.0;
+    double mean = 0.0, stddev = 1.0;    // Normal only
+    double density = 0.1;               // Sparse only
+};
+
+// Seed of the operands the auto-tuner, the calibrations and the benchmark suite generate, so
+// their timings are taken on the same data from run to run.
+const unsigned long long RANDOM_BENCHMARK_SEED = 0x464C554D494E554DULL;
+
+// Elements per work item of a parallel fill. Even, so no Box-Muller pair straddles two items.
+const long long RANDOM_FILL_CHUNK_ELEMENTS = 1 << 16;
+
+// A fresh seed from std::random_device, for runs that do not ask for one.
+unsigned long long newRandomSeed();
+
+// Decimal or 0x-prefixed hexadecimal; throws std::invalid_argument otherwise.
+unsigned long long parseRandomSeed(const string& text);
+
+// Streams under one seed are independent of each other (e.g. stream 0 for A and 1 for B).
+// threads = 0 uses getDefaultThreadCount(); the result does not depend on it. Safe to call from
+// a shared pool task: the calling thread fills whatever the pool has not picked up.
+// Throws std::invalid_argument for negative dimensions, empty ranges, a density outside [0, 1]
+// and structured distributions on non-square shapes.
+Matrix generateRandomMatrix(const RandomMatrixSpec& spec, unsigned long long seed,
+    unsigned int stream = 0, unsigned int threads = 0);
+
+// Operand sources of the form random:ROWSxCOLS[:DISTRIBUTION[:DENSITY]], such as
+// random:2000x2000, random:500x800:normal or random:4000x4000:sparse:0.01.
+bool isRandomMatrixSource(const string& source);
+RandomMatrixSpec parseRandomMatrixSource(const string& source); // Throws std::invalid_argument
+
+// "uniform", "normal", "integer", "sparse", "symmetric" or "diagonal-dominant".
+string getRandomDistributionName(RandomDistribution distribution);
+bool parseRandomDistribution(const string& name, RandomDistribution& distribution);
@@ -0,0 +1,355 @@
+#define NOMINMAX
+#include "ResultCache.h"
+#include "Algorithm.h"
+#include "System.h"
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+// --- Hashing ---
+namespace {
+const uint64_t HASH_PRIME_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t HASH_PRIME_3 = 0x165667B19E3779F9ULL;
+
+inline uint64_t rotateLeft(uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+// Final avalanche of MurmurHash3.
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Four independent lanes over the 64-bit words, as in xxHash64, folded two different ways.
+MatrixHash hashWords(const double* data, size_t count, uint64_t seed) {
+    uint64_t lanes[4] = { seed + HASH_PRIME_1, seed ^ HASH_PRIME_2, seed - HASH_PRIME_3, seed };
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        for (int l = 0; l < 4; ++l) {
+            uint64_t word;
+            std::memcpy(&word, data + i + l, sizeof(word));
+            lanes[l] = rotateLeft(lanes[l] + word * HASH_PRIME_2, 31) * HASH_PRIME_1;
+        }
+    }
+    for (; i < count; ++i) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        lanes[i % 4] = rotateLeft(lanes[i % 4] ^ (word * HASH_PRIME_2), 27) * HASH_PRIME_1 + HASH_PRIME_3;
+    }
+    MatrixHash hash;
+    hash.first = mix64(rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18) + count);
+    hash.second = mix64((lanes[0] ^ mix64(lanes[2])) * HASH_PRIME_3 + (lanes[1] ^ mix64(lanes[3])) + count);
+    return hash;
+}
+
+inline void combineHash(MatrixHash& into, const MatrixHash& value) {
+    into.first = mix64(into.first ^ (value.first + HASH_PRIME_1 + (into.first << 6) + (into.first >> 2)));
+    into.second = mix64(into.second * HASH_PRIME_3 + value.second);
+}
+
+string toHex(const MatrixHash& hash) {
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(16) << hash.first << std::setw(16) << hash.second;
+    return ss.str();
+}
+
+
+// --- Storage ---
+const char RESULT_FILE_MAGIC[4] = { 'F', 'L', 'R', 'C' };
+const uint32_t RESULT_FILE_VERSION = 1;
+
+struct CachedResult {
+    std::shared_ptr<const Matrix> matrix;
+    string algorithm;
+    double computeSeconds = 0.0;
+};
+
+struct MemoryEntry {
+    string key;
+    CachedResult result;
+    size_t bytes = 0;
+};
+
+double toMB(size_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+class ResultStore {
+public:
+    void configure(const ResultCacheSettings& settings) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        settings_ = settings;
+        lru_.clear();
+        index_.clear();
+        memoryBytes_ = 0;
+    }
+
+    const ResultCacheSettings& settings() const { return settings_; }
+
+    ResultCacheStats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ResultCacheStats copy = stats_;
+        copy.memoryMB = toMB(memoryBytes_);
+        return copy;
+    }
+
+    bool find(const string& key, CachedResult& found) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            found = it->second->result;
+            ++stats_.hits;
+            ++stats_.memoryHits;
+            return true;
+        }
+        if (settings_.diskLimitMB > 0.0 && readFile(key, found)) {
+            insertInMemory(key, found);
+            ++stats_.hits;
+            ++stats_.diskHits;
+            return true;
+        }
+        ++stats_.misses;
+        return false;
+    }
+
+    void store(const string& key, const CachedResult& result) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        insertInMemory(key, result);
+        if (settings_.diskLimitMB > 0.0) {
+            writeFile(key, result);
+            trimDisk();
+        }
+    }
+
+private:
+    // Caller holds mutex_.
+    void insertInMemory(const string& key, const CachedResult& result) {
+        const size_t bytes = result.matrix->elementCount() * sizeof(double);
+        if (toMB(bytes) > settings_.memoryLimitMB) return;
+        auto existing = index_.find(key);
+        if (existing != index_.end()) {
+            memoryBytes_ -= existing->second->bytes;
+            lru_.erase(existing->second);
+        }
+        lru_.push_front({ key, result, bytes });
+        index_[key] = lru_.begin();
+        memoryBytes_ += bytes;
+        while (toMB(memoryBytes_) > settings_.memoryLimitMB && !lru_.empty()) {
+            memoryBytes_ -= lru_.back().bytes;
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+    }
+
+    std::filesystem::path filePath(const string& key) const {
+        return std::filesystem::path(settings_.directory) / (key + ".fmr");
+    }
+
+    bool readFile(const string& key, CachedResult& found) {
+        const std::filesystem::path path = filePath(key);
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) return false;
+        char magic[4];
+        uint32_t version = 0, algorithm_length = 0;
+        int32_t rows = 0, cols = 0;
+        double compute_seconds = 0.0;
+        in.read(magic, sizeof(magic));
+        in.read(reinterpret_cast<char*>(&version), sizeof(version));
+        in.read(reinterpret_cast<char*>(&rows), sizeof(rows));
+        in.read(reinterpret_cast<char*>(&cols), sizeof(cols));
+        in.read(reinterpret_cast<char*>(&compute_seconds), sizeof(compute_seconds));
+        in.read(reinterpret_cast<char*>(&algorithm_length), sizeof(algorithm_length));
+        if (!in || std::memcmp(magic, RESULT_FILE_MAGIC, sizeof(magic)) != 0 || version != RESULT_FILE_VERSION ||
+            rows < 0 || cols < 0 || algorithm_length > 4096) {
+            cerr << RED << "Warning: Ignoring unreadable result cache file " << path.string() << "." << RESET << endl;
+            return false;
+        }
+        string algorithm(algorithm_length, '\0');
+        in.read(&algorithm[0], algorithm_length);
+        auto matrix = std::make_shared<Matrix>(rows, cols);
+        in.read(reinterpret_cast<char*>(matrix->getRawData().data()), static_cast<std::streamsize>(matrix->elementCount() * sizeof(double)));
+        if (!in) {
+            cerr << RED << "Warning: Ignoring truncated result cache file " << path.string() << "." << RESET << endl;
+            return false;
+        }
+        // The modification time doubles as the last use for the disk LRU.
+        std::error_code error;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+        found.matrix = matrix;
+        found.algorithm = algorithm;
+        found.computeSeconds = compute_seconds;
+        return true;
+    }
+
+    void writeFile(const string& key, const CachedResult& result) {
+        std::error_code error;
+        std::filesystem::create_directories(settings_.directory, error);
+        const std::filesystem::path path = filePath(key);
+        const std::filesystem::path temporary = path.string() + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                cerr << RED << "Warning: Could not write result cache file " << path.string() << "." << RESET << endl;
+                return;
+            }
+            const int32_t rows = result.matrix->rows();
+            const int32_t cols = result.matrix->cols();
+            const uint32_t algorithm_length = static_cast<uint32_t>(result.algorithm.size());
+            out.write(RESULT_FILE_MAGIC, sizeof(RESULT_FILE_MAGIC));
+            out.write(reinterpret_cast<const char*>(&RESULT_FILE_VERSION), sizeof(RESULT_FILE_VERSION));
+            out.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+            out.write(reinterpret_cast<const char*>(&cols), sizeof(cols));
+            out.write(reinterpret_cast<const char*>(&result.computeSeconds), sizeof(result.computeSeconds));
+            out.write(reinterpret_cast<const char*>(&algorithm_length), sizeof(algorithm_length));
+            out.write(result.algorithm.data(), algorithm_length);
+            out.write(reinterpret_cast<const char*>(result.matrix->getRawData().data()),
+                static_cast<std::streamsize>(result.matrix->elementCount() * sizeof(double)));
+            if (!out) {
+                out.close();
+                std::filesystem::remove(temporary, error);
+                cerr << RED << "Warning: Could not write result cache file " << path.string() << "." << RESET << endl;
+                return;
+            }
+        }
+        // Readers never see a half-written file.
+        std::filesystem::rename(temporary, path, error);
+        if (error) std::filesystem::remove(temporary, error);
+    }
+
+    // Removes the least recently used files until the directory fits the limit.
+    void trimDisk() {
+        struct CacheFile {
+            std::filesystem::path path;
+            std::filesystem::file_time_type lastUse;
+            uintmax_t bytes;
+        };
+        std::vector<CacheFile> files;
+        uintmax_t total = 0;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(settings_.directory, error)) {
+            if (entry.path().extension() != ".fmr") continue;
+            std::error_code file_error;
+            CacheFile file = { entry.path(), entry.last_write_time(file_error), entry.file_size(file_error) };
+            if (file_error) continue;
+            total += file.bytes;
+            files.push_back(file);
+        }
+        std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.lastUse < b.lastUse; });
+        for (const CacheFile& file : files) {
+            if (toMB(static_cast<size_t>(total)) <= settings_.diskLimitMB) break;
+            if (std::filesystem::remove(file.path, error)) total -= file.bytes;
+        }
+    }
+
+    std::mutex mutex_;
+    ResultCacheSettings settings_;
+    ResultCacheStats stats_;
+    std::list<MemoryEntry> lru_;
+    std::unordered_map<string, std::list<MemoryEntry>::iterator> index_;
+    size_t memoryBytes_ = 0;
+};
+
+ResultStore& getResultStore() {
+    static ResultStore store;
+    return store;
+}
+}
+
+
+// --- Public Interface ---
+void configureResultCache(const ResultCacheSettings& settings) {
+    getResultStore().configure(settings);
+}
+
+const ResultCacheSettings& getResultCacheSettings() {
+    return getResultStore().settings();
+}
+
+ResultCacheStats getResultCacheStats() {
+    return getResultStore().stats();
+}
+
+MatrixHash hashMatrixContents(const Matrix& m, unsigned int num_threads_request) {
+    const double* data = m.getRawData().data();
+    const size_t count = m.elementCount();
+    const size_t chunks = (count + RESULT_CACHE_HASH_CHUNK - 1) / RESULT_CACHE_HASH_CHUNK;
+    std::vector<MatrixHash> chunk_hashes(chunks);
+    auto hash_chunk = [&](size_t c) {
+        const size_t begin = c * RESULT_CACHE_HASH_CHUNK;
+        chunk_hashes[c] = hashWords(data + begin, std::min(RESULT_CACHE_HASH_CHUNK, count - begin), c);
+    };
+
+    unsigned int threads = (num_threads_request == 0) ? getDefaultThreadCount() : std::min(num_threads_request, getCpuCoreCount());
+    threads = static_cast<unsigned int>(std::min<size_t>(std::max(1u, threads), chunks));
+    if (threads <= 1) {
+        for (size_t c = 0; c < chunks; ++c) hash_chunk(c);
+    }
+    else {
+        ThreadPool& pool = getSharedThreadPool();
+        std::vector<std::future<void>> futures;
+        for (unsigned int t = 0; t < threads; ++t) {
+            futures.emplace_back(pool.enqueue([&, t] { for (size_t c = t; c < chunks; c += threads) hash_chunk(c); }));
+        }
+        for (auto& f : futures) f.get();
+    }
+
+    MatrixHash hash;
+    hash.first = mix64(static_cast<uint64_t>(m.rows()) * HASH_PRIME_1 + static_cast<uint64_t>(m.cols()));
+    hash.second = mix64(static_cast<uint64_t>(m.cols()) * HASH_PRIME_2 + static_cast<uint64_t>(m.rows()));
+    for (const MatrixHash& chunk : chunk_hashes) combineHash(hash, chunk);
+    return hash;
+}
+
+MultiplicationResult computeWithResultCache(const std::vector<const Matrix*>& operands, const string& parameters,
+    const std::function<MultiplicationResult()>& compute, unsigned int num_threads_request) {
+    if (!getResultCacheSettings().enabled || operands.empty()) return compute();
+
+    auto lookup_start = std::chrono::high_resolution_clock::now();
+    long long qpc_start = readPerformanceCounter();
+    MatrixHash key_hash = hashWords(nullptr, 0, operands.size());
+    for (const Matrix* operand : operands) combineHash(key_hash, hashMatrixContents(*operand, num_threads_request));
+    for (char c : parameters) combineHash(key_hash, { static_cast<uint64_t>(static_cast<unsigned char>(c)), static_cast<uint64_t>(c) * HASH_PRIME_3 });
+    const string key = toHex(key_hash);
+
+    CachedResult cached;
+    if (getResultStore().find(key, cached)) {
+        MultiplicationResult result_obj;
+        result_obj.resultMatrix = *cached.matrix;
+        auto lookup_end = std::chrono::high_resolution_clock::now();
+        result_obj.durationSeconds_chrono = std::chrono::duration<double>(lookup_end - lookup_start).count();
+        result_obj.durationNanoseconds_chrono = std::chrono::duration_cast<std::chrono::nanoseconds>(lookup_end - lookup_start).count();
+        result_obj.durationSeconds_qpc = performanceCounterSeconds(qpc_start, readPerformanceCounter());
+        result_obj.coresDetected = getCpuCoreCount();
+        result_obj.threadsUsed = (num_threads_request == 0) ? getDefaultThreadCount() : std::min(num_threads_request, result_obj.coresDetected);
+        result_obj.memoryInfo = getProcessMemoryUsage();
+        result_obj.algorithm_type = cached.algorithm;
+        result_obj.originalRowsA = operands.front()->rows();
+        result_obj.originalColsA = operands.front()->cols();
+        result_obj.originalRowsB = operands.back()->rows();
+        result_obj.originalColsB = operands.back()->cols();
+        result_obj.cache_status = "hit";
+        result_obj.cache_key = key;
+        result_obj.cache_lookup_seconds = result_obj.durationSeconds_chrono;
+        result_obj.cached_compute_seconds = cached.computeSeconds;
+        return result_obj;
+    }
+    const double lookup_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - lookup_start).count();
+
+    MultiplicationResult result_obj = compute();
+    result_obj.cache_status = "miss";
+    result_obj.cache_key = key;
+    result_obj.cache_lookup_seconds = lookup_seconds;
+    cached.matrix = std::make_shared<const Matrix>(result_obj.resultMatrix);
+    cached.algorithm = result_obj.algorithm_type;
+    cached.computeSeconds = result_obj.durationSeconds_chrono;
+    getResultStore().store(key, cached);
+    return result_obj;
+}
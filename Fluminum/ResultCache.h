@@ -0,0 +1,49 @@
+#pragma once
+#include "Common.h"
+#include "Matrix.h"
+#include <cstdint>
+
+// --- Result Cache ---
+// Optional memoization of products. A result is keyed by a 128-bit hash of every operand's
+// shape and raw bytes (hashed in parallel chunks) and of the parameters the caller passes in,
+// and is kept in an in-memory LRU and as a binary file in a cache directory. Both levels are
+// bounded in MB; the least recently used results go first. Hits are bit-identical copies of
+// the stored result, so the parameters must name everything that can change the bits.
+
+const char* const RESULT_CACHE_DEFAULT_DIRECTORY = "fluminum_result_cache";
+
+// Elements per hashed chunk. Fixed, so the hash does not depend on the thread count.
+const size_t RESULT_CACHE_HASH_CHUNK = 1 << 16;
+
+struct ResultCacheSettings {
+    bool enabled = false;
+    double memoryLimitMB = 1024.0;      // 0 turns the in-memory level off
+    double diskLimitMB = 8192.0;        // 0 turns the on-disk level off
+    string directory = RESULT_CACHE_DEFAULT_DIRECTORY;
+};
+
+struct ResultCacheStats {
+    long long hits = 0;
+    long long memoryHits = 0;           // Part of hits
+    long long diskHits = 0;             // Part of hits
+    long long misses = 0;
+    double memoryMB = 0.0;              // Held by the in-memory level
+};
+
+// Replaces the settings and drops the in-memory level (the disk level is trimmed on the next store).
+void configureResultCache(const ResultCacheSettings& settings);
+const ResultCacheSettings& getResultCacheSettings();
+ResultCacheStats getResultCacheStats();
+
+// Two independent 64-bit hashes of the shape and the raw bytes of m.
+struct MatrixHash {
+    uint64_t first = 0;
+    uint64_t second = 0;
+};
+MatrixHash hashMatrixContents(const Matrix& m, unsigned int num_threads_request = 0);
+
+// Returns a stored result for these operands and parameters, or runs compute() and stores
+// what it returns. The cache_* fields of the result record the outcome; with the cache off
+// this is compute() alone.
+MultiplicationResult computeWithResultCache(const std::vector<const Matrix*>& operands, const string& parameters,
+    const std::function<MultiplicationResult()>& compute, unsigned int num_threads_request = 0);
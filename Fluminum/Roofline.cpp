@@ -0,0 +1,236 @@
+#define NOMINMAX
+#include "Roofline.h"
+#include "Algorithm.h"
+#include "AutoTune.h"
+#include "CacheTopology.h"
+#include "Matrix.h"
+#include "System.h"
+#include <set>
+
+// --- Machine Peak ---
+namespace {
+unsigned int countPhysicalCores() {
+    const unsigned int logical = getCpuCoreCount();
+#ifdef _WIN32
+    DWORD length = 0;
+    GetLogicalProcessorInformation(nullptr, &length);
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (info.empty() || !GetLogicalProcessorInformation(info.data(), &length)) return logical;
+    unsigned int cores = 0;
+    for (const auto& entry : info) if (entry.Relationship == RelationProcessorCore) ++cores;
+    return (cores > 0) ? cores : logical;
+#else
+    // One (package, core) pair per physical core; SMT siblings share it.
+    std::set<std::pair<int, int>> cores;
+    for (unsigned int cpu = 0; cpu < logical; ++cpu) {
+        const string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        std::ifstream package_file(base + "physical_package_id");
+        std::ifstream core_file(base + "core_id");
+        int package = 0, core = 0;
+        if (!(package_file >> package) || !(core_file >> core)) return logical;
+        cores.insert({ package, core });
+    }
+    return cores.empty() ? logical : static_cast<unsigned int>(cores.size());
+#endif
+}
+
+double detectFrequencyGHz(string& source) {
+#ifdef _WIN32
+    DWORD mhz = 0;
+    DWORD size = sizeof(mhz);
+    if (RegGetValueW(HKEY_LOCAL_MACHINE, L"HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0", L"~MHz",
+        RRF_RT_REG_DWORD, nullptr, &mhz, &size) == ERROR_SUCCESS && mhz > 0) {
+        source = "registry";
+        return mhz / 1000.0;
+    }
+#else
+    std::ifstream max_freq("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+    long long khz = 0;
+    if (max_freq >> khz && khz > 0) {
+        source = "cpufreq";
+        return khz / 1e6;
+    }
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 7, "cpu MHz") == 0) {
+            double mhz = std::atof(line.c_str() + line.find(':') + 1);
+            if (mhz > 0.0) {
+                source = "cpuinfo";
+                return mhz / 1000.0;
+            }
+        }
+    }
+#endif
+    // Brand strings such as "... CPU @ 2.10GHz".
+    const string model = getCpuModelName();
+    size_t at = model.find('@');
+    if (at != string::npos) {
+        double ghz = std::atof(model.c_str() + at + 1);
+        if (ghz > 0.0) {
+            source = "model name";
+            return ghz;
+        }
+    }
+    source = "assumed";
+    return 3.0;
+}
+}
+
+double measureStreamBandwidth(unsigned int num_threads_request) {
+    // Each array four times the last-level cache, within 16..64 MB.
+    const CacheTopology& topology = getCacheTopology();
+    long long llc_bytes = 0;
+    for (const CacheLevel& cache : topology.levels) if (cache.type != "Instruction") llc_bytes = std::max(llc_bytes, cache.sizeBytes);
+    long long array_bytes = std::min(64LL << 20, std::max(16LL << 20, 4 * llc_bytes));
+    // Under a memory budget the three arrays shrink to what it leaves; below 16 MB each they
+    // would measure the cache rather than memory, so nothing is measured.
+    if (hasMemoryBudget()) {
+        array_bytes = std::min(array_bytes, static_cast<long long>(productMemoryLimitMB(0.0) / 3.0 * (1 << 20)));
+        if (array_bytes < (16LL << 20)) return 0.0;
+    }
+    const size_t n = static_cast<size_t>(array_bytes / sizeof(double));
+    std::vector<double> a(n), b(n), c(n);
+
+    unsigned int threads = (num_threads_request == 0) ? getDefaultThreadCount() : std::min(num_threads_request, getCpuCoreCount());
+    threads = std::max(1u, threads);
+    // Every thread touches the same slice in every pass, so pages stay local to it.
+    auto over_slices = [&](const std::function<void(size_t, size_t)>& body) {
+        if (threads == 1) {
+            body(0, n);
+            return;
+        }
+        ThreadPool& pool = getSharedThreadPool();
+        std::vector<std::future<void>> futures;
+        for (unsigned int t = 0; t < threads; ++t) {
+            futures.emplace_back(pool.enqueue([&, t] { body(n * t / threads, n * (t + 1) / threads); }));
+        }
+        for (auto& f : futures) f.get();
+    };
+    over_slices([&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) { a[i] = 0.0; b[i] = 1.0; c[i] = 2.0; }
+    });
+
+    const double scalar = 3.0;
+    double best = std::numeric_limits<double>::max();
+    for (int pass = 0; pass < 5; ++pass) {
+        auto start = std::chrono::high_resolution_clock::now();
+        over_slices([&](size_t begin, size_t end) {
+            double* __restrict out = a.data();
+            const double* __restrict x = b.data();
+            const double* __restrict y = c.data();
+            for (size_t i = begin; i < end; ++i) out[i] = x[i] + scalar * y[i];
+        });
+        best = std::min(best, std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return (best > 0.0) ? 3.0 * sizeof(double) * n / best / 1e9 : 0.0;
+}
+
+const MachinePeak& getMachinePeak() {
+    // Every entry point loads or runs the tuner before the first product, so the bandwidth is
+    // settled here once; the static initializer also keeps concurrent first calls safe.
+    static const MachinePeak peak = [] {
+        MachinePeak detected;
+        detected.physicalCores = countPhysicalCores();
+        detected.frequencyGHz = detectFrequencyGHz(detected.frequencySource);
+        detected.simdDoubles = SIMD_VECTOR_SIZE_DOUBLE;
+#if defined(__FMA__) || defined(__AVX2__)
+        detected.flopsPerCycle = detected.simdDoubles * 2 * 2;  // Two FMA ports
+#else
+        detected.flopsPerCycle = detected.simdDoubles * 2;      // One add and one multiply port
+#endif
+        detected.peakGflops = detected.physicalCores * detected.frequencyGHz * detected.flopsPerCycle;
+        detected.bandwidthGBs = getTunedParameters().streamBandwidthGBs;
+        if (detected.bandwidthGBs <= 0.0) detected.bandwidthGBs = measureStreamBandwidth();
+        return detected;
+    }();
+    return peak;
+}
+
+
+// --- Work and Traffic Models ---
+long long strassenFlopCount(long long n, int threshold) {
+    if (n <= std::max(1, threshold)) return 2 * n * n * n;
+    const long long half = n / 2;
+    return 7 * strassenFlopCount(half, threshold) + 18 * half * half;
+}
+
+namespace {
+const double BYTES_PER_DOUBLE = sizeof(double);
+
+// A tiled product re-reads A once per tile column of C and B once per tile row of C.
+double tiledTrafficBytes(double M, double K, double N, double tile) {
+    tile = std::max(1.0, tile);
+    return BYTES_PER_DOUBLE * (M * K * std::ceil(N / tile) + K * N * std::ceil(M / tile) + 2.0 * M * N);
+}
+
+// Each level reads and writes the operands of its 18 quadrant additions and copies the eight
+// input quadrants; the base cases are tiled products.
+double strassenTrafficBytes(long long n, int threshold, double tile) {
+    if (n <= std::max(1, threshold)) return tiledTrafficBytes(n, n, n, tile);
+    const double quadrant = static_cast<double>(n / 2) * (n / 2);
+    return 7.0 * strassenTrafficBytes(n / 2, threshold, tile) + BYTES_PER_DOUBLE * quadrant * (18 * 3 + 8 * 2);
+}
+
+// The same product repeated (matrix powers) or a single one.
+int productCount(const MultiplicationResult& result) {
+    return (result.power_exponent > 0) ? std::max(1, result.power_squarings + result.power_multiplies) : 1;
+}
+}
+
+RooflineMetrics computeRooflineMetrics(const MultiplicationResult& result) {
+    RooflineMetrics metrics;
+    const MachinePeak& peak = getMachinePeak();
+    const unsigned int threads = std::max(1u, std::min(result.threadsUsed, peak.physicalCores));
+    metrics.peakGflops = peak.peakGflops * threads / peak.physicalCores;
+
+    const double M = result.originalRowsA, K = result.originalColsA, N = result.originalColsB;
+    const double seconds = result.durationSeconds_chrono;
+    const bool no_products = result.power_exponent > 0 && result.power_squarings + result.power_multiplies == 0;
+    if (result.cache_status == "hit" || no_products || seconds <= 0.0 || M * K * N <= 0.0) {
+        metrics.bound = "n/a";
+        return metrics;
+    }
+
+    const double tile = (result.tile_size > 0) ? result.tile_size : std::max(1, G_OPTIMAL_TILE_SIZE);
+    const long long padded = nextPowerOf2(static_cast<int>(std::max({ M, K, N })));
+    const bool strassen = result.strassen_applied_at_top_level && result.strassenThreshold > 0;
+    metrics.flops = (result.effective_flops > 0) ? static_cast<double>(result.effective_flops)
+        : strassen ? static_cast<double>(strassenFlopCount(padded, result.strassenThreshold)) * productCount(result)
+        : 2.0 * M * K * N * productCount(result);
+
+    const HardwareCounterValues& counters = result.hardwareCounters[static_cast<int>(CounterPhase::Total)];
+    if (counters.valid && counters.llcMisses > 0) {
+        const CacheLevel* l1 = getCacheTopology().dataCache(1);
+        metrics.bytes = static_cast<double>(counters.llcMisses) * (l1 ? l1->lineBytes : 64);
+        metrics.bytesSource = "LLC misses";
+    }
+    else {
+        if (result.sparse_path_used) {
+            // Value plus column index per stored non-zero.
+            metrics.bytes = 12.0 * (result.nnzA + result.nnzB + result.nnzResult);
+        }
+        else if (strassen) {
+            metrics.bytes = strassenTrafficBytes(padded, result.strassenThreshold, tile) * productCount(result);
+        }
+        else if (result.algorithm_type.find("Naive") != string::npos) {
+            metrics.bytes = BYTES_PER_DOUBLE * (M * K + M * K * N + M * N);
+        }
+        else {
+            metrics.bytes = tiledTrafficBytes(M, K, N, tile) * productCount(result);
+        }
+        metrics.bytesSource = "model";
+    }
+
+    metrics.gflops = metrics.flops / seconds / 1e9;
+    metrics.peakFraction = (metrics.peakGflops > 0.0) ? metrics.gflops / metrics.peakGflops : 0.0;
+    metrics.bandwidthGBs = metrics.bytes / seconds / 1e9;
+    metrics.arithmeticIntensity = (metrics.bytes > 0.0) ? metrics.flops / metrics.bytes : 0.0;
+    // Without a STREAM figure (the memory budget left no room to measure it) only the compute
+    // roof is known.
+    const double memory_roof = metrics.arithmeticIntensity * peak.bandwidthGBs;
+    metrics.attainableGflops = (peak.bandwidthGBs > 0.0) ? std::min(metrics.peakGflops, memory_roof) : metrics.peakGflops;
+    metrics.bound = (peak.bandwidthGBs <= 0.0) ? "n/a" : (memory_roof < metrics.peakGflops) ? "memory-bound" : "compute-bound";
+    metrics.efficiency = (metrics.attainableGflops > 0.0) ? metrics.gflops / metrics.attainableGflops : 0.0;
+    return metrics;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "Common.h"
+
+// --- Roofline ---
+// Places a run on the roofline of this machine: achieved GFLOP/s against the theoretical
+// peak (physical cores x SIMD doubles x FMA x FMA ports x frequency), and arithmetic
+// intensity against the STREAM triad bandwidth measured by the tuner.
+
+struct MachinePeak {
+    unsigned int physicalCores = 1;
+    double frequencyGHz = 0.0;
+    string frequencySource;             // "cpufreq", "cpuinfo", "registry", "model name" or "assumed"
+    int simdDoubles = 1;                // Doubles per vector register the build uses
+    int flopsPerCycle = 2;              // Per core: SIMD doubles x 2 (FMA or add + mul) x 2 ports
+    double peakGflops = 0.0;            // All physical cores
+    double bandwidthGBs = 0.0;          // STREAM triad, all cores (0 when the memory budget left no room to measure)
+};
+
+struct RooflineMetrics {
+    double flops = 0.0;                 // Arithmetic actually performed (Strassen: 7 products per level)
+    double bytes = 0.0;                 // Memory traffic
+    string bytesSource;                 // "LLC misses" (hardware counters) or "model"
+    double gflops = 0.0;
+    double peakGflops = 0.0;            // For the threads the run used
+    double peakFraction = 0.0;
+    double arithmeticIntensity = 0.0;   // FLOPs per byte
+    double bandwidthGBs = 0.0;          // Achieved
+    double attainableGflops = 0.0;      // min(peak, intensity x STREAM bandwidth)
+    double efficiency = 0.0;            // Achieved / attainable
+    string bound;                       // "compute-bound", "memory-bound", or "n/a" (cache hits, empty runs, no STREAM figure)
+};
+
+// Computed once, thread-safely; the bandwidth comes from the tuning cache or is measured on first use.
+const MachinePeak& getMachinePeak();
+
+// STREAM triad (a = b + s * c) over arrays well beyond the last-level cache, best of several
+// passes, in GB/s counting 24 bytes per element as STREAM does. The arrays shrink to fit the
+// memory budget; 0 when it leaves less than 16 MB for each.
+double measureStreamBandwidth(unsigned int num_threads_request = 0);
+
+// Multiply-add FLOPs of Strassen on padded size n: 7 sub-products and 18 quadrant
+// additions per level, and 2 m^3 for each base case of size m <= threshold.
+long long strassenFlopCount(long long n, int threshold);
+
+RooflineMetrics computeRooflineMetrics(const MultiplicationResult& result);
@@ -0,0 +1,67 @@
+#pragma once
+#include "Common.h"
+
+// Inputs at or below this fraction of non-zeros are routed to the sparse engines.
+const double SPARSE_DENSITY_THRESHOLD = 0.05;
+
+enum class SparseFormat { CSR, CSC };
+
+// --- Compressed Sparse Matrix ---
+// CSR stores rows contiguously (pointers_ are row offsets, indices_ are column indices).
+// CSC stores columns contiguously (pointers_ are column offsets, indices_ are row indices).
+class SparseMatrix {
+public:
+    // --- Constructors ---
+    SparseMatrix();
+    SparseMatrix(int rows, int cols, SparseFormat format = SparseFormat::CSR);
+
+    // --- Conversion ---
+    static SparseMatrix fromDense(const Matrix& dense, SparseFormat format = SparseFormat::CSR, double dropTolerance = 0.0);
+    static SparseMatrix fromComponents(int rows, int cols, SparseFormat format,
+        std::vector<long long> pointers, std::vector<int> indices, std::vector<double> values);
+    Matrix toDense() const;
+    SparseMatrix convertTo(SparseFormat format) const;
+
+    // --- Accessors ---
+    int rows() const;
+    int cols() const;
+    SparseFormat format() const;
+    long long nonZeroCount() const;
+    double density() const;
+
+    const std::vector<long long>& pointers() const;
+    const std::vector<int>& indices() const;
+    const std::vector<double>& values() const;
+
+private:
+    int rows_;
+    int cols_;
+    SparseFormat format_;
+    std::vector<long long> pointers_;
+    std::vector<int> indices_;
+    std::vector<double> values_;
+};
+
+// --- Density Helpers ---
+long long countNonZeros(const Matrix& m);
+bool isSparseCandidate(long long nonZeroCount, long long totalElements);
+
+// --- Raw Kernels ---
+// SpGEMM (Gustavson, CSR x CSR -> CSR) with one dense accumulator per worker thread.
+SparseMatrix multiplySparseSparse(const SparseMatrix& A, const SparseMatrix& B, unsigned int num_threads, long long* flop_count = nullptr);
+
+// --- Sparse Algorithms ---
+// Sparse (CSR) x Dense, parallel over row blocks of the result.
+MultiplicationResult multiplySparseDenseParallel(const SparseMatrix& A, const Matrix& B, unsigned int num_threads_request = 0);
+
+// Dense x Sparse (CSC), parallel over row blocks of the result.
+MultiplicationResult multiplyDenseSparseParallel(const Matrix& A, const SparseMatrix& B, unsigned int num_threads_request = 0);
+
+// Sparse x Sparse, result densified for the common MultiplicationResult interface.
+MultiplicationResult multiplySparseParallel(const SparseMatrix& A, const SparseMatrix& B, unsigned int num_threads_request = 0);
+
+// Picks SpGEMM, SpMM or the dense tiled engine from the operands' density.
+// The file infos are optional; when absent the density is measured directly.
+MultiplicationResult multiplySparsityAware(const Matrix& A, const Matrix& B, int tileSize,
+    unsigned int num_threads_request = 0,
+    const MatrixFileInfo* infoA = nullptr, const MatrixFileInfo* infoB = nullptr);
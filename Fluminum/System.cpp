@@ -1,15 +1,41 @@
 #include "System.h"
-#include "PerformanceMonitor.h" // For RunPerformanceMonitorEntry
 #include "Matrix.h" // Needed for auto-tuning
+#include "PerformanceMonitor.h" // For the forked monitor child on Linux
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
 
 // --- Global Variables ---
-LARGE_INTEGER g_performanceFrequency = { 0 };
+long long g_performanceFrequency = 0;
 bool has_avx_global = false;
 bool has_sse2_global = false;
 int G_OPTIMAL_TILE_SIZE = 32; // Default, will be overwritten by auto-tuner
+int G_OPTIMAL_STRASSEN_THRESHOLD = 128;
+unsigned int G_OPTIMAL_THREAD_COUNT = 0;
+static double g_memoryBudgetMB = 0.0; // --memory-budget, 0 = none
+
+#ifndef _WIN32
+// Returns the value of a "Key:   1234 kB" line from a /proc file, or -1 if it is missing.
+static long long readProcKBField(const char* path, const string& key) {
+    std::ifstream file(path);
+    string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':') {
+            return std::atoll(line.c_str() + key.size() + 1);
+        }
+    }
+    return -1;
+}
+#endif
 
 // --- System Information ---
 SystemMemoryInfo getSystemMemoryInfo() {
+#ifdef _WIN32
     MEMORYSTATUSEX statex;
     statex.dwLength = sizeof(statex);
     if (!GlobalMemoryStatusEx(&statex)) {
@@ -18,6 +44,21 @@ SystemMemoryInfo getSystemMemoryInfo() {
         return { 0, 0 };
     }
     return { statex.ullTotalPhys / (1024 * 1024), statex.ullAvailPhys / (1024 * 1024) };
+#else
+    long long total_kb = readProcKBField("/proc/meminfo", "MemTotal");
+    long long available_kb = readProcKBField("/proc/meminfo", "MemAvailable");
+    if (available_kb < 0) {
+        // Kernels before 3.14 have no MemAvailable; free + page cache is the usual estimate.
+        long long free_kb = readProcKBField("/proc/meminfo", "MemFree");
+        long long cached_kb = readProcKBField("/proc/meminfo", "Cached");
+        if (free_kb >= 0) available_kb = free_kb + std::max(0LL, cached_kb);
+    }
+    if (total_kb < 0 || available_kb < 0) {
+        cerr << RED << "Warning: Failed to read /proc/meminfo. Reporting 0 MB." << RESET << endl;
+        return { 0, 0 };
+    }
+    return { static_cast<unsigned long long>(total_kb) / 1024, static_cast<unsigned long long>(available_kb) / 1024 };
+#endif
 }
 
 unsigned int getCpuCoreCount() {
@@ -25,26 +66,147 @@ unsigned int getCpuCoreCount() {
     return (cores == 0) ? 1 : cores;
 }
 
+unsigned int getDefaultThreadCount() {
+    unsigned int cores = getCpuCoreCount();
+    return (G_OPTIMAL_THREAD_COUNT == 0) ? cores : std::min(G_OPTIMAL_THREAD_COUNT, cores);
+}
+
+string getCpuModelName() {
+    string name;
+#if defined(_MSC_VER)
+    int cpuInfo[4] = { 0 };
+    __cpuid(cpuInfo, 0x80000000);
+    if (static_cast<unsigned int>(cpuInfo[0]) >= 0x80000004) {
+        char brand[49] = { 0 };
+        for (int leaf = 0; leaf < 3; ++leaf) {
+            __cpuid(cpuInfo, 0x80000002 + leaf);
+            std::memcpy(brand + 16 * leaf, cpuInfo, sizeof(cpuInfo));
+        }
+        name = brand;
+    }
+#else
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            name = line.substr(line.find(':') + 1);
+            break;
+        }
+    }
+#endif
+    // Trim the padding some CPUs put around the brand string.
+    size_t first = name.find_first_not_of(" \t");
+    size_t last = name.find_last_not_of(" \t");
+    return (first == string::npos) ? string("Unknown CPU") : name.substr(first, last - first + 1);
+}
+
+string getExecutablePath() {
+#ifdef _WIN32
+    char path[MAX_PATH];
+    DWORD length = GetModuleFileNameA(NULL, path, MAX_PATH);
+    return (length == 0 || length == MAX_PATH) ? string() : string(path, length);
+#else
+    char path[4096];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    return (length <= 0) ? string() : string(path, static_cast<size_t>(length));
+#endif
+}
+
 ProcessMemoryInfo getProcessMemoryUsage() {
+#ifdef _WIN32
     PROCESS_MEMORY_COUNTERS pmc;
     ZeroMemory(&pmc, sizeof(pmc));
     pmc.cb = sizeof(pmc);
     if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
-        return { pmc.PeakWorkingSetSize / (1024 * 1024) };
+        ProcessMemoryInfo info = { pmc.PeakWorkingSetSize / (1024 * 1024) };
+        info.currentWorkingSetMB = pmc.WorkingSetSize / (1024 * 1024);
+        info.pageFaults = pmc.PageFaultCount;
+        return info;
     }
     else {
         DWORD error = GetLastError();
         cerr << RED << "Warning: Failed to get process memory info (Error " << error << "). Reporting 0 MB." << RESET << endl;
         return { 0 };
     }
+#else
+    ProcessMemoryInfo info = { 0 };
+    struct rusage usage;
+    bool have_rusage = (getrusage(RUSAGE_SELF, &usage) == 0);
+    if (have_rusage) {
+        info.pageFaults = usage.ru_minflt + usage.ru_majflt;
+        info.majorPageFaults = usage.ru_majflt;
+    }
+
+    long long peak_kb = readProcKBField("/proc/self/status", "VmHWM");
+    long long current_kb = readProcKBField("/proc/self/status", "VmRSS");
+    if (peak_kb < 0 && have_rusage) peak_kb = usage.ru_maxrss; // Also KB on Linux
+    if (peak_kb < 0) {
+        cerr << RED << "Warning: Failed to get process memory info from /proc/self/status. Reporting 0 MB." << RESET << endl;
+        return info;
+    }
+    info.peakWorkingSetMB = static_cast<size_t>(peak_kb / 1024);
+    info.currentWorkingSetMB = static_cast<size_t>(std::max(0LL, current_kb) / 1024);
+    return info;
+#endif
+}
+
+long long getCurrentResidentKB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    ZeroMemory(&pmc, sizeof(pmc));
+    pmc.cb = sizeof(pmc);
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return static_cast<long long>(pmc.WorkingSetSize / 1024);
+#else
+    // statm holds sizes in pages: total, resident, shared, ...
+    std::ifstream statm("/proc/self/statm");
+    long long total_pages = 0, resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages)) return 0;
+    return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+}
+
+double residentDeltaMB(long long startKB, long long endKB) {
+    return static_cast<double>(endKB - startKB) / 1024.0;
 }
 
 // --- Performance Counter ---
 void initializePerformanceCounter() {
-    if (!QueryPerformanceFrequency(&g_performanceFrequency)) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    if (!QueryPerformanceFrequency(&frequency)) {
         cerr << RED << "Warning: QueryPerformanceFrequency failed. High-resolution timing may be unavailable." << RESET << endl;
-        g_performanceFrequency.QuadPart = 0;
+        g_performanceFrequency = 0;
+        return;
+    }
+    g_performanceFrequency = frequency.QuadPart;
+#else
+    struct timespec resolution;
+    if (clock_getres(CLOCK_MONOTONIC_RAW, &resolution) != 0) {
+        cerr << RED << "Warning: CLOCK_MONOTONIC_RAW is unavailable. High-resolution timing may be unavailable." << RESET << endl;
+        g_performanceFrequency = 0;
+        return;
     }
+    g_performanceFrequency = 1000000000LL;
+#endif
+}
+
+long long readPerformanceCounter() {
+    if (g_performanceFrequency == 0) return 0;
+#ifdef _WIN32
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    return ticks.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return static_cast<long long>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+#endif
+}
+
+double performanceCounterSeconds(long long startTicks, long long endTicks) {
+    if (g_performanceFrequency <= 0) return 0.0;
+    return static_cast<double>(endTicks - startTicks) / static_cast<double>(g_performanceFrequency);
 }
 
 // --- SIMD Support ---
@@ -78,44 +240,6 @@ void check_simd_support() {
 }
 
 
-// --- NEW: Tiling Auto-Tuner Implementation ---
-void autoTuneTileSize() {
-    cout << CYAN << "Performing one-time hardware tuning for optimal tile size..." << RESET << endl;
-
-    const int test_dim = 256; // Small enough to be fast, large enough to be meaningful
-    const int num_runs = 3; // Number of runs to average for each tile size
-    Matrix A = Matrix::generateRandom(test_dim, test_dim);
-    Matrix B = Matrix::generateRandom(test_dim, test_dim);
-
-    std::vector<int> tile_sizes_to_test = { 16, 24, 32, 48, 64, 96, 128 };
-    double best_time = std::numeric_limits<double>::max();
-    int best_tile_size = 32;
-
-    cout << "Benchmarking tile sizes: ";
-    for (int size : tile_sizes_to_test) {
-        cout << size << "... " << std::flush;
-        if (size > test_dim) continue;
-
-        double total_duration = 0;
-        for (int i = 0; i < num_runs; ++i) {
-            auto start = std::chrono::high_resolution_clock::now();
-            A.multiply_tiled(B, size); // Use the actual tiled method
-            auto end = std::chrono::high_resolution_clock::now();
-            total_duration += std::chrono::duration<double>(end - start).count();
-        }
-        double avg_time = total_duration / num_runs;
-
-        if (avg_time < best_time) {
-            best_time = avg_time;
-            best_tile_size = size;
-        }
-    }
-
-    G_OPTIMAL_TILE_SIZE = best_tile_size;
-    cout << endl << GREEN << "Auto-tuning complete. Optimal tile size for this system: " << G_OPTIMAL_TILE_SIZE << "x" << G_OPTIMAL_TILE_SIZE << RESET << endl << endl;
-}
-
-
 // --- Memory Estimation ---
 unsigned long long estimateStrassenMemoryMB(int n_padded) {
     if (n_padded <= 0) return 0;
@@ -138,8 +262,127 @@ unsigned long long estimateComparisonMemoryMB(int n_padded) {
 }
 
 
+// --- Memory Budget ---
+#ifndef _WIN32
+// The cgroup (v2, then v1) memory limit of this process in MB, or 0 when there is none.
+static double cgroupMemoryLimitMB() {
+    for (const char* path : { "/sys/fs/cgroup/memory.max", "/sys/fs/cgroup/memory/memory.limit_in_bytes" }) {
+        std::ifstream file(path);
+        string value;
+        if (!(file >> value) || value == "max") continue;
+        double bytes = std::atof(value.c_str());
+        // v1 reports "unlimited" as a huge page-aligned number.
+        if (bytes > 0.0 && bytes < 1e18) return bytes / (1024.0 * 1024.0);
+    }
+    return 0.0;
+}
+#endif
+
+double parseMemorySizeMB(const string& text) {
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || !(value > 0.0)) throw std::invalid_argument("Invalid memory size '" + text + "' (expected e.g. 4096, 512M or 8G).");
+    string unit(end);
+    for (char& c : unit) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    if (unit.empty() || unit == "M" || unit == "MB") return value;
+    if (unit == "G" || unit == "GB") return value * 1024.0;
+    if (unit == "T" || unit == "TB") return value * 1024.0 * 1024.0;
+    throw std::invalid_argument("Invalid memory size unit in '" + text + "' (use M, G or T).");
+}
+
+void setMemoryBudgetMB(double mb) {
+    g_memoryBudgetMB = std::max(0.0, mb);
+}
+
+bool hasMemoryBudget() {
+    return g_memoryBudgetMB > 0.0;
+}
+
+MemoryBudget getMemoryBudget() {
+    MemoryBudget budget;
+    budget.requestedMB = g_memoryBudgetMB;
+    if (budget.requestedMB <= 0.0) return budget;
+    budget.enforcedMB = budget.requestedMB;
+    budget.limitedBy = "--memory-budget";
+#ifndef _WIN32
+    double cgroup_mb = cgroupMemoryLimitMB();
+    if (cgroup_mb > 0.0 && cgroup_mb < budget.enforcedMB) {
+        budget.enforcedMB = cgroup_mb;
+        budget.limitedBy = "cgroup limit";
+    }
+#endif
+    double physical_mb = static_cast<double>(getSystemMemoryInfo().totalPhysicalMB);
+    if (physical_mb > 0.0 && physical_mb < budget.enforcedMB) {
+        budget.enforcedMB = physical_mb;
+        budget.limitedBy = "physical memory";
+    }
+    return budget;
+}
+
+string describeMemoryBudget(const MemoryBudget& budget) {
+    if (budget.requestedMB <= 0.0) return "none";
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(0) << budget.enforcedMB << " MB enforced";
+    if (budget.enforcedMB < budget.requestedMB) ss << " (" << budget.requestedMB << " MB requested, capped by the " << budget.limitedBy << ")";
+    return ss.str();
+}
+
+double productMemoryLimitMB(double operands_mb) {
+    MemoryBudget budget = getMemoryBudget();
+    // The operands are already resident and part of every prediction; everything else the
+    // process holds (other matrices, caches, the runtime) is not.
+    double other_mb = std::max(0.0, getCurrentResidentKB() / 1024.0 - operands_mb);
+    return std::max(0.0, budget.enforcedMB - other_mb);
+}
+
+void requireMemoryBudget(double required_mb, double operands_mb, const string& what) {
+    if (!hasMemoryBudget()) return;
+    double limit_mb = productMemoryLimitMB(operands_mb);
+    if (required_mb > limit_mb) {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1) << what << " needs about " << required_mb << " MB but the memory budget leaves "
+            << limit_mb << " MB (" << describeMemoryBudget(getMemoryBudget()) << ").";
+        throw std::runtime_error(ss.str());
+    }
+}
+
+
 // --- Process Management ---
 void LaunchMonitorProcess() {
+#ifndef _WIN32
+    // Linux: a forked child draws on the terminal named by FLUMINUM_MONITOR_TTY, or, inside tmux,
+    // `<self> --monitor` is started in a new pane. Both exit when this process does.
+    const char* tty = std::getenv("FLUMINUM_MONITOR_TTY");
+    const bool use_tty = tty != nullptr && *tty != '\0';
+    if (!use_tty && std::getenv("TMUX") == nullptr) {
+        cout << YELLOW << "Note: run inside tmux or set FLUMINUM_MONITOR_TTY=/dev/pts/N to open the live performance monitor "
+            << "(or start it yourself with --monitor)." << RESET << endl;
+        return;
+    }
+
+    const string selfPath = getExecutablePath();
+    if (selfPath.empty()) {
+        cerr << RED << "Error: cannot resolve /proc/self/exe. Cannot launch monitor." << RESET << endl;
+        return;
+    }
+    const long owner = static_cast<long>(getpid());
+    const string command = "FLUMINUM_MONITOR_PARENT=" + std::to_string(owner) + " exec '" + selfPath + "' --monitor";
+
+    cout.flush();
+    pid_t child = fork();
+    if (child < 0) {
+        cerr << RED << "Error: fork failed (" << std::strerror(errno) << "). Cannot launch monitor." << RESET << endl;
+        return;
+    }
+    if (child == 0) {
+        // Second fork detaches the monitor, so it is never left behind as a zombie of this process.
+        if (fork() != 0) _exit(0);
+        if (use_tty) _exit(RunPerformanceMonitorOnTerminal(tty, owner));
+        execlp("tmux", "tmux", "split-window", "-d", "-h", "-l", "60", command.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    waitpid(child, nullptr, 0);
+#else
     STARTUPINFOA si;
     PROCESS_INFORMATION pi;
 
@@ -179,4 +422,5 @@ void LaunchMonitorProcess() {
 
     CloseHandle(pi.hProcess);
     CloseHandle(pi.hThread);
+#endif
 }
\ No newline at end of file
@@ -9,24 +9,56 @@ extern bool has_sse2_global;
 // This will be set by the auto-tuner on startup.
 extern int G_OPTIMAL_TILE_SIZE;
 
+// --- Tuned Defaults (AutoTune.h) ---
+extern int G_OPTIMAL_STRASSEN_THRESHOLD;
+extern unsigned int G_OPTIMAL_THREAD_COUNT; // 0 = all cores
+
 // --- System Information ---
 SystemMemoryInfo getSystemMemoryInfo();
 unsigned int getCpuCoreCount();
+// Threads used when a caller asks for 0: the tuned count, capped at the core count.
+unsigned int getDefaultThreadCount();
+string getCpuModelName();
+string getExecutablePath(); // Empty if it cannot be determined
 ProcessMemoryInfo getProcessMemoryUsage();
 
+// Resident set size right now, in KB. Cheap enough to call around every phase of a run.
+long long getCurrentResidentKB();
+double residentDeltaMB(long long startKB, long long endKB);
+
 // --- Performance Counter ---
+// Ticks of the platform's high-resolution clock: QueryPerformanceCounter on Windows,
+// clock_gettime(CLOCK_MONOTONIC_RAW) in nanoseconds elsewhere (not slewed by NTP).
 void initializePerformanceCounter();
-extern LARGE_INTEGER g_performanceFrequency;
+long long readPerformanceCounter();
+double performanceCounterSeconds(long long startTicks, long long endTicks); // 0 if the counter is unavailable
+extern long long g_performanceFrequency; // Ticks per second, 0 until initialized
 
 // --- SIMD Support ---
 void check_simd_support();
 
-// --- NEW: Tiling Auto-Tuner ---
-void autoTuneTileSize();
 
 // --- Memory Estimation ---
 unsigned long long estimateStrassenMemoryMB(int n_padded);
 unsigned long long estimateComparisonMemoryMB(int n_padded);
 
+// --- Memory Budget ---
+// --memory-budget caps what a run may use. Planners check it before any work starts and shrink
+// or replace an algorithm whose predicted peak would not fit (see fitCandidateToMemory), so the
+// process never grows into swap; what cannot fit at all is rejected up front.
+double parseMemorySizeMB(const string& text);   // "4096" (MB), "512M", "8G", "1.5T"; throws std::invalid_argument
+void setMemoryBudgetMB(double mb);              // 0 removes the budget
+bool hasMemoryBudget();
+MemoryBudget getMemoryBudget();
+string describeMemoryBudget(const MemoryBudget& budget);
+
+// What one product may use, operands and result included: the enforced budget less what the
+// process holds besides those operands (0 when that is all used up). Only meaningful when
+// hasMemoryBudget().
+double productMemoryLimitMB(double operands_mb);
+
+// Throws std::runtime_error when `required_mb` (operands included) cannot fit the budget.
+void requireMemoryBudget(double required_mb, double operands_mb, const string& what);
+
 // --- Process Management ---
 void LaunchMonitorProcess();
\ No newline at end of file
@@ -0,0 +1,152 @@
+#define NOMINMAX
+#include "Trace.h"
+#include <cstdlib>
+#include <memory>
+
+// --- Trace State ---
+namespace {
+struct ThreadTraceBuffer {
+    int workerId = 0;
+    std::vector<TraceEvent> events;
+    std::atomic<size_t> written{ 0 };  // Total pushed; the newest event is at (written - 1) % capacity
+
+    void push(const TraceEvent& event) {
+        size_t index = written.load(std::memory_order_relaxed);
+        events[index % TRACE_BUFFER_CAPACITY] = event;
+        written.store(index + 1, std::memory_order_release);
+    }
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers;  // Kept after their threads exit
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    string exitFilename;
+};
+
+std::atomic<bool> g_tracingEnabled{ false };
+
+TraceRegistry& registry() {
+    static TraceRegistry state;
+    return state;
+}
+
+long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry().epoch).count();
+}
+
+// Allocated on the first event of a thread, so threads that never trace cost nothing.
+ThreadTraceBuffer& threadBuffer() {
+    thread_local std::shared_ptr<ThreadTraceBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadTraceBuffer>();
+        buffer->events.resize(TRACE_BUFFER_CAPACITY);
+        TraceRegistry& state = registry();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        buffer->workerId = static_cast<int>(state.buffers.size());
+        state.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void writeTraceAtExit() {
+    writeChromeTrace(registry().exitFilename);
+}
+}
+
+void setTracingEnabled(bool enabled) {
+    if (enabled && !g_tracingEnabled.load()) {
+        TraceRegistry& state = registry();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.buffers.empty()) state.epoch = std::chrono::steady_clock::now();
+    }
+    g_tracingEnabled.store(enabled, std::memory_order_release);
+}
+
+bool isTracingEnabled() {
+    return g_tracingEnabled.load(std::memory_order_relaxed);
+}
+
+void startTracingFromEnvironment() {
+    const char* filename = std::getenv("FLUMINUM_TRACE");
+    if (filename == nullptr || *filename == '\0') return;
+    registry().exitFilename = filename;
+    setTracingEnabled(true);
+    std::atexit(writeTraceAtExit);
+    cout << CYAN << "Tracing enabled; the trace will be written to " << filename << " at exit." << RESET << endl;
+}
+
+void clearTrace() {
+    TraceRegistry& state = registry();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (auto& buffer : state.buffers) buffer->written.store(0, std::memory_order_release);
+}
+
+size_t getTraceEventCount() {
+    TraceRegistry& state = registry();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    size_t count = 0;
+    for (auto& buffer : state.buffers) count += std::min(buffer->written.load(std::memory_order_acquire), TRACE_BUFFER_CAPACITY);
+    return count;
+}
+
+size_t getDroppedTraceEventCount() {
+    TraceRegistry& state = registry();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    size_t dropped = 0;
+    for (auto& buffer : state.buffers) {
+        size_t written = buffer->written.load(std::memory_order_acquire);
+        if (written > TRACE_BUFFER_CAPACITY) dropped += written - TRACE_BUFFER_CAPACITY;
+    }
+    return dropped;
+}
+
+
+// --- Chrome Trace Export ---
+bool writeChromeTrace(const string& filename) {
+    std::ofstream out(filename, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        cerr << RED << "Error: Could not open trace file: " << filename << RESET << endl;
+        return false;
+    }
+
+    TraceRegistry& state = registry();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&]() -> std::ostream& { out << (first ? "" : ",\n"); first = false; return out; };
+    out << std::fixed << std::setprecision(3);
+    size_t total = 0;
+    for (auto& buffer : state.buffers) {
+        separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->workerId
+            << ",\"args\":{\"name\":\"worker " << buffer->workerId << "\"}}";
+        const size_t written = buffer->written.load(std::memory_order_acquire);
+        const size_t begin = (written > TRACE_BUFFER_CAPACITY) ? written - TRACE_BUFFER_CAPACITY : 0;
+        for (size_t i = begin; i < written; ++i) {
+            const TraceEvent& e = buffer->events[i % TRACE_BUFFER_CAPACITY];
+            separator() << "{\"name\":\"" << e.name << "\",\"cat\":\"fluminum\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->workerId
+                << ",\"ts\":" << e.beginNs / 1000.0 << ",\"dur\":" << (e.endNs - e.beginNs) / 1000.0
+                << ",\"args\":{\"depth\":" << e.depth << ",\"size\":" << e.size << "}}";
+        }
+        total += written - begin;
+    }
+    out << "\n]}\n";
+    cout << GREEN << "Trace with " << total << " events written to " << filename << RESET << endl;
+    return true;
+}
+
+
+// --- Scopes ---
+TraceScope::TraceScope(const char* name, int depth, long long size) : name_(name), depth_(depth), size_(size) {
+    if (isTracingEnabled()) beginNs_ = nowNs();
+}
+
+TraceScope::~TraceScope() {
+    stop();
+}
+
+void TraceScope::stop() {
+    if (beginNs_ < 0) return;
+    threadBuffer().push({ name_, beginNs_, nowNs(), depth_, size_ });
+    beginNs_ = -1;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Common.h"
+
+// --- Execution Tracing ---
+// Every thread records begin/end pairs into its own ring buffer, so recording takes no lock.
+// The buffers can be written out as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+// Tracing is off by default; a disabled TraceScope costs one atomic load.
+
+// Events kept per thread; older ones are overwritten once a buffer is full.
+const size_t TRACE_BUFFER_CAPACITY = 1 << 16;
+
+struct TraceEvent {
+    const char* name;     // Must be a string literal (only the pointer is stored)
+    long long beginNs;    // Relative to the moment tracing was enabled
+    long long endNs;
+    int depth;            // Recursion depth, 0 for flat tasks
+    long long size;       // Problem size of the node, or the first row of a task
+};
+
+void setTracingEnabled(bool enabled);
+bool isTracingEnabled();
+
+// Enables tracing when FLUMINUM_TRACE names an output file and writes that file at exit.
+void startTracingFromEnvironment();
+
+// Drops all recorded events (buffers of finished threads included).
+void clearTrace();
+
+// Events recorded so far and the number lost to ring-buffer wrap-around.
+size_t getTraceEventCount();
+size_t getDroppedTraceEventCount();
+
+// Writes every buffer as Chrome trace JSON; tid is the worker ID. Call while no run is in progress.
+bool writeChromeTrace(const string& filename);
+
+// Records one complete event for the current thread from construction to destruction (or stop()).
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, int depth = 0, long long size = 0);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    void stop();
+
+private:
+    const char* name_;
+    int depth_;
+    long long size_;
+    long long beginNs_ = -1;  // -1 while tracing was off at construction
+};
@@ -5,9 +5,16 @@
 #include "Interactive.h"
 #include "ArgParser.h"
 #include "IO.h"
+#include "Trace.h"
+#include "AutoTune.h"
+#include "Batch.h"
+#include "Bench.h"
+#include "Daemon.h"
+#include "Distributed.h"
 
 // Basic console setup
 void setup_console() {
+#ifdef _WIN32
     SetConsoleTitle(L"Fluminum Matrix Operations");
     SetConsoleOutputCP(CP_UTF8);
     HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -18,16 +25,16 @@ void setup_console() {
             SetConsoleMode(hOut, dwMode);
         }
     }
+#endif
+    // Other terminals understand the ANSI colour codes and UTF-8 output natively.
 }
 
-// Non-interactive mode handler (placeholder for cmd line logic)
-void run_command_line_mode(const ArgParser& parser) {
-    cout << "Command-line mode is not yet implemented." << endl;
-    // Here you would parse options from the `parser` object
-    // and call the appropriate functions from Algorithms.h
-    // Example:
-    // if (parser.optionExists("multiply")) { ... }
-    // if (parser.optionExists("compare")) { ... }
+// Non-interactive mode handler: headless jobs, no monitor window and no tuning run
+int run_command_line_mode(const ArgParser& parser) {
+    // Cached or analytic parameters only, unless a re-tune is asked for explicitly
+    if (parser.optionExists("--retune")) autoTuneParameters(true);
+    else loadTunedParameters();
+    return runBatchMode(parser);
 }
 
 
@@ -39,29 +46,57 @@ int main(int argc, char* argv[]) {
 
     // 2. Standard Program Initialization
     setup_console();
-    LaunchMonitorProcess();
     initializePerformanceCounter();
-
-    // --- NEW: Run the tile size auto-tuner ---
-    autoTuneTileSize();
-
+    startTracingFromEnvironment();
 
     ArgParser parser(argc, argv);
 
+    // --memory-budget caps every mode; planners fit their algorithms to it (see System.h).
+    if (parser.optionExists("--memory-budget")) {
+        try {
+            setMemoryBudgetMB(parseMemorySizeMB(parser.getOption("--memory-budget")));
+        }
+        catch (const std::invalid_argument& e) {
+            cerr << RED << "Error: " << e.what() << RESET << endl;
+            return 2;
+        }
+        cout << CYAN << "Memory budget: " << describeMemoryBudget(getMemoryBudget()) << "." << RESET << endl;
+    }
+
     // 3. Decide execution mode
-    // If more than one argument is passed (program name + something else),
-    // assume command-line mode. Otherwise, interactive.
-    if (argc > 1) {
-        // NOTE: Full command-line operation logic would be extensive.
-        // This structure enables it. For now, it will launch interactive mode.
-        cout << YELLOW << "Command-line arguments detected. "
-            << "For this version, launching interactive mode." << RESET << endl << endl;
-        run_interactive_mode();
+    // --daemon serves requests over a local socket; --daemon-command talks to a running one.
+    if (parser.optionExists("--daemon")) {
+        return runDaemonMode(parser);
     }
-    else {
-        // Launch the standard interactive menu
-        run_interactive_mode();
+    if (parser.optionExists("--daemon-command")) {
+        return runDaemonCommand(parser.optionExists("--socket") ? parser.getOption("--socket") : DAEMON_DEFAULT_SOCKET,
+            parser.getOption("--daemon-command"));
+    }
+
+    // --distributed N runs one product as SUMMA across N local worker processes.
+    if (parser.optionExists("--distributed")) {
+        return runDistributedMode(parser);
     }
 
+    // --bench runs the benchmark suite with the cached (or analytic) tuned parameters.
+    if (parser.optionExists("--bench")) {
+        if (parser.optionExists("--retune")) autoTuneParameters(true);
+        else loadTunedParameters();
+        return runBenchmarkSuite(parser);
+    }
+
+    // --jobs, --op or --help run headless and exit with the batch status.
+    if (isBatchInvocation(parser)) {
+        return run_command_line_mode(parser);
+    }
+
+    LaunchMonitorProcess();
+
+    // Load tuned parameters from the cache, or tune them (--retune forces a fresh run)
+    autoTuneParameters(parser.optionExists("--retune"));
+
+    // Launch the standard interactive menu
+    run_interactive_mode();
+
     return 0;
 }
\ No newline at end of file